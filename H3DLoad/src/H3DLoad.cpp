@@ -38,6 +38,8 @@
 #include <iostream>
 
 #include <H3D/VrmlParser.h>
+#include <H3D/X3DBinary.h>
+#include <H3D/SceneSnapshotCache.h>
 #include <H3D/GLUTWindow.h>
 #include <H3D/Group.h>
 #include <H3D/Transform.h>
@@ -344,6 +346,14 @@ int main(int argc, char* argv[]) {
   help_message += "    --rendermode=<mode> Use stereo render mode <mode>\n";
   help_message += " -s --spacemouse        Use 3DConnexion space mouse to\n";
   help_message += "                        navigate scene.\n";
+  help_message += "    --binary=<file>     Write the scene to <file> in the\n";
+  help_message += "                        binary encoding and exit.\n";
+  help_message += "    --binary-compress   Compress arrays in the binary file\n";
+  help_message += "    --binary-quantize   Store float arrays in the binary\n";
+  help_message += "                        file with 16 bits per component\n";
+  help_message += "    --snapshot-cache=<dir> Store parsed scenes in <dir>\n";
+  help_message += "                        and load them from there when\n";
+  help_message += "                        the files have not changed\n";
   help_message += "\n";
   help_message += " -h --help              This help message\n";
   help_message += "\n";
@@ -514,6 +524,9 @@ int main(int argc, char* argv[]) {
 
   bool use_space_mouse = false;
   bool antialiasing = true;
+  string binary_file = "";
+  bool binary_compress = false;
+  bool binary_quantize = false;
   // Command line arguments ---
 
   for( int i = 1 ; i < argc ; ++i ){
@@ -582,6 +595,20 @@ int main(int argc, char* argv[]) {
 
       else if( !strcmp(argv[i]+2,"spacemouse") ){
         use_space_mouse = true; }
+
+      else if( !strncmp(argv[i]+2,"binary=",
+        strlen("binary=")) ){
+          binary_file = strstr(argv[i],"=")+1; }
+
+      else if( !strcmp(argv[i]+2,"binary-compress") ){
+        binary_compress = true; }
+
+      else if( !strcmp(argv[i]+2,"binary-quantize") ){
+        binary_quantize = true; }
+
+      else if( !strncmp(argv[i]+2,"snapshot-cache=",
+        strlen("snapshot-cache=")) ){
+          SceneSnapshotCache::setCacheDirectory( strstr(argv[i],"=")+1 ); }
       else {
         Console(LogLevel::Error) << "Unknown argument "
           << "'" << argv[i] << "'" << endl; }
@@ -628,6 +655,37 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
+  // Converting X3D file to the binary encoding ---
+  if( binary_file.size() ) {
+    if( xml_files.size() > 1 ) {
+      Console(LogLevel::Warning) << "Warning: Only the first file is written "
+        << "to \"" << binary_file << "\"" << endl;
+    }
+    try {
+      X3D::DEFNodes dn;
+      X3D::PrototypeVector prototypes;
+      AutoRef< Group > g( X3D::createX3DFromURL( xml_files[0], &dn, NULL,
+                                                 &prototypes ) );
+      // the Group is only added when loading, write what is in it.
+      Node *root = g.get();
+      if( g->children->size() == 1 )
+        root = g->children->getValueByIndex( 0 );
+      ofstream os( binary_file.c_str(), ios::binary );
+      if( !os.good() ) {
+        Console(LogLevel::Error) << "Could not open \"" << binary_file
+          << "\" for writing" << endl;
+        return 1;
+      }
+      X3D::writeNodeAsX3DBinary( os, root, &prototypes,
+                                 binary_compress, binary_quantize );
+      Console(LogLevel::Info) << "Wrote " << binary_file << endl;
+    } catch( const Exception::H3DException &e ) {
+      Console(LogLevel::Error) << e << endl;
+      return 1;
+    }
+    return 0;
+  }
+
 
   // Loading X3D file and setting up VR environment ---
   AutoRef< Scene > scene( new Scene );
@@ -0,0 +1,208 @@
+from UnitTestUtil import *
+from H3DInterface import *
+from H3DUtils import *
+
+import random
+import struct
+import time as py_time
+
+"""
+Tests of the parser for numeric MF field values.
+  The values are generated from fixed seeds so the custom output is the same
+  on every run.
+"""
+
+def toFloat32( value ):
+  """ The value rounded to the closest single precision float. """
+  return struct.unpack( 'f', struct.pack( 'f', value ) )[0]
+
+def randomFloat32( rand ):
+  """ A random finite single precision float from all exponents. """
+  while True:
+    value = struct.unpack( 'f', struct.pack( 'I', rand.getrandbits( 32 ) ) )[0]
+    if value == value and abs( value ) != float( 'inf' ):
+      return value
+
+def randomFloat64( rand ):
+  """ A random finite double precision float from all exponents. """
+  while True:
+    value = struct.unpack( 'd', struct.pack( 'Q', rand.getrandbits( 64 ) ) )[0]
+    if value == value and abs( value ) != float( 'inf' ):
+      return value
+
+separators = [ ' ', ',', ', ', '\n', '\t', ' ,\n    ', '   ' ]
+
+def joinValues( rand, strings ):
+  """ Join the strings with random combinations of separators. """
+  return ''.join( [ s + rand.choice( separators ) for s in strings ] )
+
+def randomNumberString( rand ):
+  """ A number string in one of the forms accepted by Convert::getValue,
+  [sign][digits][.digits][ {d | D | e | E }[sign]digits], with at most 9
+  fraction digits which the old parser handles without overflow. """
+  sign = rand.choice( [ '', '', '-', '+' ] )
+  integer = ''.join( [ rand.choice( '0123456789' ) for i in range( rand.randint( 0, 8 ) ) ] )
+  fraction = ''.join( [ rand.choice( '0123456789' ) for i in range( rand.randint( 0, 9 ) ) ] )
+  if integer == '' and fraction == '':
+    integer = rand.choice( '0123456789' )
+  number = sign + integer
+  if fraction != '' or rand.random() < 0.2:
+    number += '.' + fraction
+  if rand.random() < 0.4:
+    number += rand.choice( 'eEdD' ) + rand.choice( [ '', '-', '+' ] ) + str( rand.randint( 0, 20 ) )
+  return number
+
+def closeEnough( value, reference ):
+  return abs( value - reference ) <= 1e-6 * max( 1.0, abs( reference ) )
+
+@custom()
+def testFloatRoundTrip():
+  """ Single precision values printed with 9 significant digits must be
+  parsed to exactly the same value. """
+  rand = random.Random( 4711 )
+  values = [ randomFloat32( rand ) for i in range( 20000 ) ]
+  values += [ 0.0, -0.0, 1.0, -1.0, 0.1, 1e-45, 3.4028234664e38, 1.17549435e-38 ]
+  strings = []
+  for v in values:
+    s = '%.9g' % v
+    if rand.random() < 0.5:
+      s = s.replace( 'e', rand.choice( 'EdD' ) )
+    strings.append( s )
+  field = MFFloat()
+  field.setValueFromString( joinValues( rand, strings ) )
+  parsed = field.getValue()
+  exact = len( [ 1 for v, p in zip( values, parsed ) if v == p ] )
+  printCustom( "MFFloat values: %d of %d" % ( len( parsed ), len( values ) ) )
+  printCustom( "MFFloat exact round trips: %d of %d" % ( exact, len( values ) ) )
+
+@custom()
+def testDoubleRoundTrip():
+  """ Double precision values printed with repr must be parsed to exactly
+  the same value. """
+  rand = random.Random( 4712 )
+  values = [ randomFloat64( rand ) for i in range( 20000 ) ]
+  values += [ 0.0, -0.0, 1.0, -1.0, 0.1, 5e-324, 1.7976931348623157e308 ]
+  strings = [ repr( v ) for v in values ]
+  field = MFDouble()
+  field.setValueFromString( joinValues( rand, strings ) )
+  parsed = field.getValue()
+  exact = len( [ 1 for v, p in zip( values, parsed ) if v == p ] )
+  printCustom( "MFDouble values: %d of %d" % ( len( parsed ), len( values ) ) )
+  printCustom( "MFDouble exact round trips: %d of %d" % ( exact, len( values ) ) )
+
+  field = MFTime()
+  field.setValueFromString( joinValues( rand, strings ) )
+  parsed = field.getValue()
+  exact = len( [ 1 for v, p in zip( values, parsed ) if v == p ] )
+  printCustom( "MFTime exact round trips: %d of %d" % ( exact, len( values ) ) )
+
+@custom()
+def testAgainstOldParser():
+  """ Compare the MF parser with Convert::getValue, which the SF fields use
+  and which the MF fields used before. The old parser does not round
+  correctly so the values are only compared up to rounding errors. """
+  rand = random.Random( 4713 )
+  strings = [ randomNumberString( rand ) for i in range( 5000 ) ]
+  sf_float = SFFloat()
+  old_values = []
+  for s in strings:
+    sf_float.setValueFromString( s )
+    old_values.append( sf_float.getValue() )
+
+  mf_float = MFFloat()
+  mf_float.setValueFromString( joinValues( rand, strings ) )
+  new_values = mf_float.getValue()
+  same = len( [ 1 for o, n in zip( old_values, new_values ) if closeEnough( n, o ) ] )
+  printCustom( "MFFloat values: %d of %d" % ( len( new_values ), len( strings ) ) )
+  printCustom( "MFFloat same as SFFloat: %d of %d" % ( same, len( strings ) ) )
+
+  sf_double = SFDouble()
+  old_values = []
+  for s in strings:
+    sf_double.setValueFromString( s )
+    old_values.append( sf_double.getValue() )
+  mf_double = MFDouble()
+  mf_double.setValueFromString( joinValues( rand, strings ) )
+  new_values = mf_double.getValue()
+  same = len( [ 1 for o, n in zip( old_values, new_values ) if closeEnough( n, o ) ] )
+  printCustom( "MFDouble same as SFDouble: %d of %d" % ( same, len( strings ) ) )
+
+  sf_vec3f = SFVec3f()
+  old_values = []
+  for i in range( 0, len( strings ) - 2, 3 ):
+    sf_vec3f.setValueFromString( ' '.join( strings[i:i+3] ) )
+    old_values.append( sf_vec3f.getValue() )
+  mf_vec3f = MFVec3f()
+  mf_vec3f.setValueFromString( joinValues( rand, strings[ : len( old_values ) * 3 ] ) )
+  new_values = mf_vec3f.getValue()
+  same = len( [ 1 for o, n in zip( old_values, new_values )
+                if closeEnough( n.x, o.x ) and closeEnough( n.y, o.y ) and closeEnough( n.z, o.z ) ] )
+  printCustom( "MFVec3f same as SFVec3f: %d of %d" % ( same, len( old_values ) ) )
+
+  integers = [ rand.choice( [ '', '-', '+' ] ) + str( rand.randint( 0, 2147483647 ) ) for i in range( 5000 ) ]
+  sf_int = SFInt32()
+  old_values = []
+  for s in integers:
+    sf_int.setValueFromString( s )
+    old_values.append( sf_int.getValue() )
+  mf_int = MFInt32()
+  mf_int.setValueFromString( joinValues( rand, integers ) )
+  new_values = mf_int.getValue()
+  same = len( [ 1 for o, n in zip( old_values, new_values ) if o == n ] )
+  printCustom( "MFInt32 same as SFInt32: %d of %d" % ( same, len( integers ) ) )
+
+@custom()
+def testInvalidValues():
+  """ Strings that are not numbers must be rejected by both parsers. """
+  for s in [ 'abc', '+', '-', '.', '-.', 'e5', '--1', '+-1', 'x1' ]:
+    sf_field = SFFloat()
+    mf_field = MFFloat()
+    sf_error = False
+    mf_error = False
+    try:
+      sf_field.setValueFromString( s )
+    except ValueError:
+      sf_error = True
+    try:
+      mf_field.setValueFromString( '1 2 ' + s )
+    except ValueError:
+      mf_error = True
+    printCustom( "'%s': SFFloat error %s, MFFloat error %s" % ( s, sf_error, mf_error ) )
+
+def largeVec3fString( nr_values ):
+  rand = random.Random( 4714 )
+  lines = []
+  for i in range( nr_values ):
+    lines.append( '%.6f %.6f %.6f' % ( rand.uniform( -10, 10 ),
+                                       rand.uniform( -10, 10 ),
+                                       rand.uniform( -10, 10 ) ) )
+  return ',\n          '.join( lines )
+
+class ParseEachFrame( AutoUpdate( SFTime ) ):
+  """ Parses value_string into values every time the scene time changes,
+  i.e. once per frame. """
+  def __init__( self, value_string ):
+    AutoUpdate( SFTime ).__init__( self )
+    self.value_string = value_string
+    self.values = MFVec3f()
+
+  def update( self, event ):
+    self.values.setValueFromString( self.value_string )
+    return event.getValue()
+
+large_vec3f_string = largeVec3fString( 300000 )
+parse_each_frame = None
+
+@custom()
+@performance( run_time = 10 )
+def testLargeMFVec3fPerformance():
+  """ Parses an MFVec3f with 300000 values every frame for 10 seconds. The
+  framerate is recorded, the time of one parse is printed to the console. """
+  global parse_each_frame
+  field = MFVec3f()
+  start = py_time.time()
+  field.setValueFromString( large_vec3f_string )
+  print "Parsed 300000 Vec3f values in %f s" % ( py_time.time() - start )
+  printCustom( "MFVec3f values: %d" % len( field.getValue() ) )
+  parse_each_frame = ParseEachFrame( large_vec3f_string )
+  time.route( parse_each_frame )
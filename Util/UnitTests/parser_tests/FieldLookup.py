@@ -0,0 +1,99 @@
+from UnitTestUtil import *
+from H3DInterface import *
+from H3DUtils import *
+
+import time as py_time
+
+"""
+Tests of field lookup by name.
+"""
+
+def attributeScene( nr_nodes ):
+  """ A scene with nr_nodes nodes with several field attributes each. """
+  nodes = []
+  for i in range( nr_nodes ):
+    nodes.append( "<Transform translation='%d 0 0' rotation='0 1 0 0.5' scale='1 1 1' center='0 0 0'>"
+                  "<Shape><Appearance><Material diffuseColor='1 0 0' transparency='0.5' shininess='0.2' /></Appearance>"
+                  "<Box size='0.1 0.1 0.1' solid='true' /></Shape></Transform>" % i )
+  return "<Group>" + "".join( nodes ) + "</Group>"
+
+def routeScene( nr_nodes, routes_per_node ):
+  """ A scene with nr_nodes + routes_per_node Transforms where each of the
+  first nr_nodes ones is routed to the next routes_per_node ones. The routes
+  use both the _changed and the set_ form of the field names. """
+  total = nr_nodes + routes_per_node
+  elements = [ "<Transform DEF='T%d' />" % i for i in range( total ) ]
+  for i in range( nr_nodes ):
+    for j in range( i + 1, i + 1 + routes_per_node ):
+      elements.append( "<ROUTE fromNode='T%d' fromField='translation_changed' toNode='T%d' toField='set_translation' />" % ( i, j ) )
+  return "<Group>" + "".join( elements ) + "</Group>"
+
+@custom()
+def testFieldNames():
+  """ The field name forms that must be found. """
+  t = createNode( "Transform" )
+  for name in [ "translation", "set_translation", "translation_changed",
+                "Translation", "children", "addChildren", "removeChildren",
+                "bboxCenter", "set_bboxCenter", "noSuchField",
+                "set_noSuchField", "noSuchField_changed" ]:
+    printCustom( "%s: %s" % ( name, t.getField( name ) is not None ) )
+
+class ParseEachFrame( AutoUpdate( SFTime ) ):
+  """ Parses scene_string every time the scene time changes, i.e. once per
+  frame. """
+  def __init__( self, scene_string ):
+    AutoUpdate( SFTime ).__init__( self )
+    self.scene_string = scene_string
+
+  def update( self, event ):
+    createX3DFromString( self.scene_string )
+    return event.getValue()
+
+attribute_scene = attributeScene( 2000 )
+parse_each_frame = None
+
+@custom()
+@performance( run_time = 10 )
+def testAttributeParsePerformance():
+  """ Parses a scene with 2000 Transforms with 16000 field attributes every
+  frame for 10 seconds. """
+  global parse_each_frame
+  start = py_time.time()
+  group, dn = createX3DFromString( attribute_scene )
+  print "Parsed 2000 Transforms in %f s" % ( py_time.time() - start )
+  printCustom( "Transforms: %d" % len( group.children.getValue() ) )
+  parse_each_frame = ParseEachFrame( attribute_scene )
+  time.route( parse_each_frame )
+
+@custom()
+def testRouteParsePerformance():
+  """ Parses a scene with 100000 ROUTE elements. The time is printed to the
+  console. """
+  global parse_each_frame
+  if parse_each_frame:
+    time.unroute( parse_each_frame )
+    parse_each_frame = None
+  scene = routeScene( 1000, 100 )
+  start = py_time.time()
+  group, dn = createX3DFromString( scene )
+  print "Parsed 100000 ROUTEs in %f s" % ( py_time.time() - start )
+  nr_routes = 0
+  for i in range( 1000 ):
+    nr_routes += len( dn[ "T%d" % i ].translation.getRoutesOut() )
+  printCustom( "ROUTEs: %d" % nr_routes )
+
+@custom()
+def testRouteLookupPerformance():
+  """ Sets up 100000 routes from Python with fields looked up by name. The
+  time is printed to the console. """
+  nodes = [ createNode( "Transform" ) for i in range( 1100 ) ]
+  start = py_time.time()
+  for i in range( 1000 ):
+    source = nodes[i].getField( "translation_changed" )
+    for j in range( i + 1, i + 101 ):
+      source.route( nodes[j].getField( "set_translation" ) )
+  print "Routed 100000 fields in %f s" % ( py_time.time() - start )
+  nr_routes = 0
+  for i in range( 1000 ):
+    nr_routes += len( nodes[i].translation.getRoutesOut() )
+  printCustom( "Routes: %d" % nr_routes )
@@ -0,0 +1,92 @@
+from UnitTestUtil import *
+from H3DInterface import *
+from H3DUtils import *
+
+import time as py_time
+
+"""
+Tests of the parsing of numeric field values in VRML files.
+"""
+
+def meshVrml( size, comment ):
+  """ A VRML IndexedFaceSet grid with size * size vertices. If comment is
+  True there is a comment at the start of each array, which makes the
+  parser use the previous code path for the values. """
+  points = []
+  normals = []
+  for i in range( size ):
+    for j in range( size ):
+      points.append( "%.6f %.6f %.6f" % ( i * 0.01, j * 0.01, ( i * j % 17 ) * 0.001 ) )
+      normals.append( "0 0 1" )
+  indices = []
+  for i in range( size - 1 ):
+    for j in range( size - 1 ):
+      v = i * size + j
+      indices.append( "%d %d %d %d -1" % ( v, v + 1, v + size + 1, v + size ) )
+  start = "[ # values\n" if comment else "[ "
+  return ( "#VRML V2.0 utf8\n"
+           "Shape {\n"
+           "  geometry IndexedFaceSet {\n"
+           "    coord Coordinate { point " + start + ",\n".join( points ) + " ] }\n"
+           "    normal Normal { vector " + start + ",\n".join( normals ) + " ] }\n"
+           "    coordIndex " + start + ",\n".join( indices ) + " ]\n"
+           "  }\n"
+           "}\n" )
+
+mesh_size = 300
+mesh = meshVrml( mesh_size, False )
+mesh_with_comments = meshVrml( mesh_size, True )
+
+def meshValues( group ):
+  geometry = group.children.getValue()[0].geometry.getValue()
+  return ( geometry.coord.getValue().point.getValue(),
+           geometry.normal.getValue().vector.getValue(),
+           geometry.coordIndex.getValue() )
+
+@custom()
+def testSameValues():
+  """ Both code paths must give the same values. """
+  new_values = meshValues( createVRMLFromString( mesh )[0] )
+  old_values = meshValues( createVRMLFromString( mesh_with_comments )[0] )
+  printCustom( "points: %d" % len( new_values[0] ) )
+  printCustom( "normals: %d" % len( new_values[1] ) )
+  printCustom( "coordIndex: %d" % len( new_values[2] ) )
+  for name, new, old in zip( [ "points", "normals", "coordIndex" ], new_values, old_values ):
+    printCustom( "%s same: %s" % ( name, new == old ) )
+
+class ParseEachFrame( AutoUpdate( SFTime ) ):
+  """ Parses vrml_string every time the scene time changes, i.e. once per
+  frame. """
+  def __init__( self, vrml_string ):
+    AutoUpdate( SFTime ).__init__( self )
+    self.vrml_string = vrml_string
+
+  def update( self, event ):
+    createVRMLFromString( self.vrml_string )
+    return event.getValue()
+
+parse_each_frame = None
+
+def parseEachFrame( vrml_string, description ):
+  global parse_each_frame
+  if parse_each_frame:
+    time.unroute( parse_each_frame )
+  start = py_time.time()
+  group, dn = createVRMLFromString( vrml_string )
+  print "Parsed %s in %f s" % ( description, py_time.time() - start )
+  printCustom( "points: %d" % len( meshValues( group )[0] ) )
+  parse_each_frame = ParseEachFrame( vrml_string )
+  time.route( parse_each_frame )
+
+@custom()
+@performance( run_time = 10 )
+def testMeshPerformance():
+  """ Parses a 90000 vertex mesh every frame for 10 seconds. """
+  parseEachFrame( mesh, "mesh" )
+
+@custom()
+@performance( run_time = 10 )
+def testPreviousParserMeshPerformance():
+  """ Parses the same mesh with comments, which uses the previous code
+  path, every frame for 10 seconds. """
+  parseEachFrame( mesh_with_comments, "mesh with comments" )
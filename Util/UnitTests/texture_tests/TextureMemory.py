@@ -0,0 +1,101 @@
+from UnitTestUtil import *
+from H3DInterface import *
+from H3DUtils import *
+
+import os
+import tempfile
+
+"""
+Measures the memory saved by releasing texture image data.
+  The memory numbers depend on the system and the graphics driver, so they
+  are printed to the console and not validated.
+"""
+
+volume_size = 256
+
+def residentBytes():
+  """ The resident memory of the process in bytes, 0 if not known. """
+  try:
+    for line in open( '/proc/self/status' ):
+      if line.startswith( 'VmRSS:' ):
+        return int( line.split()[1] ) * 1024
+  except IOError:
+    pass
+  try:
+    import ctypes
+    import ctypes.wintypes
+    class PROCESS_MEMORY_COUNTERS( ctypes.Structure ):
+      _fields_ = [ ( 'cb', ctypes.wintypes.DWORD ),
+                   ( 'PageFaultCount', ctypes.wintypes.DWORD ),
+                   ( 'PeakWorkingSetSize', ctypes.c_size_t ),
+                   ( 'WorkingSetSize', ctypes.c_size_t ),
+                   ( 'QuotaPeakPagedPoolUsage', ctypes.c_size_t ),
+                   ( 'QuotaPagedPoolUsage', ctypes.c_size_t ),
+                   ( 'QuotaPeakNonPagedPoolUsage', ctypes.c_size_t ),
+                   ( 'QuotaNonPagedPoolUsage', ctypes.c_size_t ),
+                   ( 'PagefileUsage', ctypes.c_size_t ),
+                   ( 'PeakPagefileUsage', ctypes.c_size_t ) ]
+    counters = PROCESS_MEMORY_COUNTERS()
+    counters.cb = ctypes.sizeof( counters )
+    ctypes.windll.psapi.GetProcessMemoryInfo( ctypes.windll.kernel32.GetCurrentProcess(),
+                                              ctypes.byref( counters ),
+                                              counters.cb )
+    return counters.WorkingSetSize
+  except Exception:
+    return 0
+
+def writeVolume( filename, seed ):
+  """ Write a volume_size^3 8 bit volume. """
+  data = bytearray( volume_size * volume_size * volume_size )
+  for i in range( 0, len( data ), 4096 ):
+    data[i] = ( i / 4096 + seed ) % 256
+  f = open( filename, 'wb' )
+  f.write( data )
+  f.close()
+
+def volumeScene( filename, release_image ):
+  return ( "<Group><Shape><Appearance>"
+           "<Image3DTexture url='\"%s\"'>"
+           "<RawImageLoader containerField='imageLoader' width='%d' height='%d' depth='%d' "
+           "pixelType='LUMINANCE' bitsPerPixel='8' />"
+           "<TextureProperties containerField='textureProperties' releaseImage='%s' />"
+           "</Image3DTexture></Appearance>"
+           "<Box size='1 1 1' /></Shape></Group>" %
+           ( filename.replace( '\\', '/' ), volume_size, volume_size, volume_size, release_image ) )
+
+release_file = os.path.join( tempfile.gettempdir(), 'TextureMemory_release.raw' )
+keep_file = os.path.join( tempfile.gettempdir(), 'TextureMemory_keep.raw' )
+writeVolume( release_file, 0 )
+writeVolume( keep_file, 1 )
+
+memory = {}
+
+def addScene( filename, release_image ):
+  group, dn = createX3DFromString( volumeScene( filename, release_image ) )
+  getNamedNode( 'G' ).children.push_back( group )
+
+@custom()
+def testAddReleasedVolume():
+  memory['start'] = residentBytes()
+  addScene( release_file, 'RELEASE' )
+  printCustom( "Volume data: %d MB" % ( volume_size ** 3 / ( 1024 * 1024 ) ) )
+
+@custom( start_time = 5 )
+def testAddKeptVolume():
+  memory['released'] = residentBytes()
+  addScene( keep_file, 'KEEP' )
+  printCustom( "Volumes: %d" % len( getNamedNode( 'G' ).children.getValue() ) )
+
+@screenshot( start_time = 5 )
+def testMemorySaved():
+  kept = residentBytes()
+  released_increase = memory['released'] - memory['start']
+  kept_increase = kept - memory['released']
+  print "Memory increase with released image data: %d MB" % ( released_increase / ( 1024 * 1024 ) )
+  print "Memory increase with kept image data: %d MB" % ( kept_increase / ( 1024 * 1024 ) )
+  print "Memory saved: %d MB" % ( ( kept_increase - released_increase ) / ( 1024 * 1024 ) )
+  for filename in [ release_file, keep_file ]:
+    try:
+      os.remove( filename )
+    except OSError:
+      pass
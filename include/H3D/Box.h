@@ -30,6 +30,7 @@
 #define __BOX_H__
 
 #include <H3D/X3DGeometryNode.h>
+#include <H3D/PrimitiveMeshCache.h>
 
 namespace H3D {
 
@@ -92,6 +93,9 @@ namespace H3D {
          Inst< SFVec3f >  _size     = 0,
          Inst< SFBool  >  _solid    = 0 );
 
+    /// Destructor.
+    ~Box();
+
     /// Renders the Box using OpenGL.
     virtual void render();
 
@@ -100,6 +104,12 @@ namespace H3D {
       return 12;
     }
 
+    /// Get the triangles of the Box from the shared mesh.
+    virtual bool getTriangles( vector< HAPI::Collision::Triangle > &triangles );
+
+    /// Render instances of the Box from the shared mesh.
+    virtual bool renderInstanced( GLsizei nr_instances );
+
     // Traverse the scenegraph. See X3DGeometryNode::traverseSG
     // for more info.
     virtual void traverseSG( TraverseInfo &ti );  
@@ -123,6 +133,16 @@ namespace H3D {
 
     /// The H3DNodeDatabase for this node.
     static H3DNodeDatabase database;
+
+  protected:
+    /// Get the mesh shared by all Box nodes with the same size, fetching
+    /// it from the PrimitiveMeshCache if it has changed.
+    PrimitiveMeshCache::Mesh *getMesh();
+
+    // Internal field used to know if the mesh has to be fetched again.
+    auto_ptr< Field > meshFieldsUpToDate;
+    // The mesh currently used by this node.
+    PrimitiveMeshCache::Mesh *mesh;
   };
 }
 
@@ -0,0 +1,301 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file BrickedVolumeTexture.h
+/// \brief Header file for BrickedVolumeTexture.
+///
+//
+//////////////////////////////////////////////////////////////////////////////
+#ifndef __BRICKEDVOLUMETEXTURE_H__
+#define __BRICKEDVOLUMETEXTURE_H__
+
+#include <H3D/X3DTexture3DNode.h>
+#include <H3D/Pixel3DTexture.h>
+#include <H3D/DependentNodeFields.h>
+#include <H3D/SFInt32.h>
+#include <H3D/SFFloat.h>
+#include <H3D/SFVec3f.h>
+
+namespace H3D {
+  /// \ingroup H3DNodes 
+  /// \class BrickedVolumeTexture
+  /// \brief The BrickedVolumeTexture node streams the image of a 3D
+  /// texture to the graphics card in bricks, so that volumes larger than
+  /// the graphics card memory or the maximum 3D texture size can be
+  /// rendered.
+  ///
+  /// The image of the texture field, e.g. an Image3DTexture or a
+  /// Composed3DTexture, is divided into bricks of brickSize voxels along
+  /// each side. The texture field node itself is never installed. The
+  /// bricks are copied from the image when they are needed, so if the
+  /// image data is memory mapped only the parts of the file that are used
+  /// are read. Bricks are installed in a brick cache, which is the 3D
+  /// texture of this node, using at most cacheMemory megabytes. Each
+  /// brick is stored with a border of one voxel from its neighbours so
+  /// that linear interpolation works across bricks.
+  ///
+  /// Bricks nearer to the viewer are installed first, at most
+  /// brickUploadBudget per frame. The volume is assumed to be centered at
+  /// the origin of the local coordinate system with the size given by
+  /// textureSize(), as for volume rendering nodes. When the cache is full,
+  /// bricks farther away are replaced by nearer ones. Bricks whose values
+  /// are all at most emptyThreshold are empty and are never installed.
+  ///
+  /// Shaders look up bricks in the pageTable texture, which has one
+  /// RGBA texel per brick. Its alpha is 1 if the brick is installed in
+  /// the cache, 0.5 if it is empty and 0 if it has not been installed
+  /// yet. The rgb components are the position of the brick in the cache,
+  /// in bricks, divided by 255. The brickRange texture has one texel per
+  /// brick with the minimum value of the brick in the luminance and the
+  /// maximum in the alpha component, which can be used to skip empty
+  /// space in ray casting. The range is (0, 1) for bricks that have not
+  /// been read yet. The value of a voxel is its alpha component if it has
+  /// one and otherwise its largest component, normalized as when sampled
+  /// from a texture and clamped to [0, 1]. Both textures use nearest
+  /// filtering. A value is sampled as follows, with the textures and the
+  /// output fields of the node as uniforms:
+  ///
+  /// \code
+  /// vec3 voxel = tc * volumeSize;
+  /// vec3 brick = min( floor( voxel / brickSize ), brickCount - 1.0 );
+  /// vec4 entry = texture3D( pageTable, ( brick + 0.5 ) / brickCount );
+  /// if( entry.a > 0.75 ) {
+  ///   vec3 slot = floor( entry.rgb * 255.0 + 0.5 );
+  ///   vec3 cache_voxel = slot * ( brickSize + 2.0 ) + 1.0 +
+  ///                      voxel - brick * brickSize;
+  ///   value = texture3D( brickCache,
+  ///                      cache_voxel / ( cacheBrickCount * ( brickSize + 2.0 ) ) );
+  /// }
+  /// \endcode
+  ///
+  /// Mipmaps are not supported for the brick cache.
+  ///
+  /// \par Internal routes:
+  /// \dotfile BrickedVolumeTexture.dot
+  class H3DAPI_API BrickedVolumeTexture : public X3DTexture3DNode {
+  public:
+
+    /// The SFTexture3DNode field is dependent on the displayList field
+    /// of the containing X3DTexture3DNode node.
+    typedef DependentSFNode< X3DTexture3DNode, 
+                             FieldRef< H3DDisplayListObject,
+                                       H3DDisplayListObject::DisplayList,
+                                       &H3DDisplayListObject::displayList >, 
+                             true >
+    SFTexture3DNode;
+
+    /// Constructor.
+    BrickedVolumeTexture( 
+                 Inst< DisplayList     > _displayList = 0,
+                 Inst< SFNode          > _metadata  = 0,
+                 Inst< SFBool          > _repeatS   = 0,
+                 Inst< SFBool          > _repeatT   = 0,
+                 Inst< SFBool          > _repeatR   = 0,
+                 Inst< SFBool          > _scaleToP2 = 0,
+                 Inst< SFImage         > _image     = 0,
+                 Inst< SFTextureProperties > _textureProperties = 0,
+                 Inst< SFTexture3DNode > _texture   = 0,
+                 Inst< SFInt32         > _brickSize = 0,
+                 Inst< SFInt32         > _cacheMemory = 0,
+                 Inst< SFInt32         > _brickUploadBudget = 0,
+                 Inst< SFFloat         > _emptyThreshold = 0,
+                 Inst< SFNode          > _pageTable = 0,
+                 Inst< SFNode          > _brickRange = 0,
+                 Inst< SFVec3f         > _volumeSize = 0,
+                 Inst< SFVec3f         > _brickCount = 0,
+                 Inst< SFVec3f         > _cacheBrickCount = 0 );
+
+    /// Installs the bricks needed this frame in the brick cache and binds
+    /// it.
+    virtual void render();
+
+    /// The brick cache is managed by the node itself.
+    virtual bool evictTexture() { return false; }
+
+    /// Returns the size of the volume of the texture field.
+    virtual Vec3f textureSize();
+
+    /// The texture with the volume to divide into bricks.
+    /// 
+    /// <b>Access type:</b> inputOutput \n
+    /// 
+    /// \dotfile BrickedVolumeTexture_texture.dot
+    auto_ptr< SFTexture3DNode > texture;
+
+    /// The number of voxels along each side of a brick.
+    /// 
+    /// <b>Access type:</b> initializeOnly \n
+    /// <b>Default value:</b> 32 \n
+    /// 
+    /// \dotfile BrickedVolumeTexture_brickSize.dot
+    auto_ptr< SFInt32 > brickSize;
+
+    /// The maximum size of the brick cache in megabytes. The cache is
+    /// also limited by the maximum 3D texture size of the graphics card.
+    /// 
+    /// <b>Access type:</b> initializeOnly \n
+    /// <b>Default value:</b> 256 \n
+    /// 
+    /// \dotfile BrickedVolumeTexture_cacheMemory.dot
+    auto_ptr< SFInt32 > cacheMemory;
+
+    /// The maximum number of bricks to install each frame. A value <= 0
+    /// means no limit.
+    /// 
+    /// <b>Access type:</b> inputOutput \n
+    /// <b>Default value:</b> 8 \n
+    /// 
+    /// \dotfile BrickedVolumeTexture_brickUploadBudget.dot
+    auto_ptr< SFInt32 > brickUploadBudget;
+
+    /// Bricks whose values are all less than or equal to emptyThreshold
+    /// are empty and are not installed. When the value changes, bricks
+    /// that have been read are checked again with their known ranges.
+    /// Installed bricks that become empty are removed from the cache.
+    /// 
+    /// <b>Access type:</b> inputOutput \n
+    /// <b>Default value:</b> 0 \n
+    /// 
+    /// \dotfile BrickedVolumeTexture_emptyThreshold.dot
+    auto_ptr< SFFloat > emptyThreshold;
+
+    /// The Pixel3DTexture with the page table of the bricks.
+    /// 
+    /// <b>Access type:</b> outputOnly \n
+    /// 
+    /// \dotfile BrickedVolumeTexture_pageTable.dot
+    auto_ptr< SFNode > pageTable;
+
+    /// The Pixel3DTexture with the minimum and maximum value of each
+    /// brick.
+    /// 
+    /// <b>Access type:</b> outputOnly \n
+    /// 
+    /// \dotfile BrickedVolumeTexture_brickRange.dot
+    auto_ptr< SFNode > brickRange;
+
+    /// The size of the volume in voxels.
+    /// 
+    /// <b>Access type:</b> outputOnly \n
+    /// 
+    /// \dotfile BrickedVolumeTexture_volumeSize.dot
+    auto_ptr< SFVec3f > volumeSize;
+
+    /// The number of bricks along each axis of the volume.
+    /// 
+    /// <b>Access type:</b> outputOnly \n
+    /// 
+    /// \dotfile BrickedVolumeTexture_brickCount.dot
+    auto_ptr< SFVec3f > brickCount;
+
+    /// The number of bricks along each axis of the brick cache.
+    /// 
+    /// <b>Access type:</b> outputOnly \n
+    /// 
+    /// \dotfile BrickedVolumeTexture_cacheBrickCount.dot
+    auto_ptr< SFVec3f > cacheBrickCount;
+
+    /// The H3DNodeDatabase for this node.
+    static H3DNodeDatabase database;
+
+  protected:
+    /// Information about a brick.
+    struct Brick {
+      Brick() : min_value( 0 ), max_value( 1 ), read( false ),
+                empty( false ), slot( -1 ) {}
+
+      /// The minimum value in the brick.
+      H3DFloat min_value;
+      /// The maximum value in the brick.
+      H3DFloat max_value;
+      /// True if the brick has been read from the image, i.e. if the
+      /// range is known.
+      bool read;
+      /// True if the brick has been read and all values are at most
+      /// empty_threshold.
+      bool empty;
+      /// The position of the brick in the cache, -1 if not installed.
+      int slot;
+    };
+
+    /// Divide the image into bricks and create the page table and brick
+    /// range textures. Returns false if the image can not be divided
+    /// into bricks.
+    bool initBricks( Image *image );
+
+    /// Allocate the brick cache texture.
+    void initCache( Image *image );
+
+    /// Install the bricks nearest to the viewer within the budget.
+    /// Returns true if there are bricks that are not installed, which
+    /// may have to be installed when the viewer moves.
+    bool streamBricks( Image *image, const Vec3f &viewer_pos );
+
+    /// Read the brick with the given index from the image into the given
+    /// cache slot. Returns false if the brick is empty, in which case it
+    /// is not installed.
+    bool installBrick( Image *image, unsigned int index, unsigned int slot );
+
+    /// Set the page table and brick range texels of a brick.
+    void updateBrickTexels( unsigned int index );
+
+    /// Update the empty flags of the bricks that have been read if 
+    /// emptyThreshold has changed since they were set.
+    void updateEmptyBricks();
+
+    /// The image the bricks are read from.
+    AutoRef< Image > source_image;
+
+    /// All bricks, x index varying fastest.
+    vector< Brick > bricks;
+
+    /// The free cache slots.
+    vector< unsigned int > free_slots;
+
+    /// The number of bricks along each axis.
+    unsigned int nr_bricks[3];
+
+    /// The number of cache slots along each axis.
+    unsigned int nr_slots[3];
+
+    /// The size of a brick in voxels, without the border.
+    unsigned int brick_size;
+
+    /// The viewer position used when the bricks were last ordered.
+    Vec3f last_viewer_pos;
+
+    /// True if no brick could be installed the last time the bricks were
+    /// ordered, i.e. the cache holds the nearest bricks that fit.
+    bool stalled;
+
+    /// True if the page table or brick range textures have changed since
+    /// they were last updated.
+    bool texels_changed;
+
+    /// The value of emptyThreshold the empty flags of the bricks were
+    /// set with.
+    H3DFloat empty_threshold;
+  };
+}
+
+#endif
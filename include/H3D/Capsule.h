@@ -15,6 +15,7 @@
 
 #include <H3D/X3DGeometryNode.h>
 #include <H3D/SFFloat.h>
+#include <H3D/PrimitiveMeshCache.h>
 
 namespace H3D {
   /// \ingroup H3DNodes
@@ -87,6 +88,12 @@ namespace H3D {
   /// The number of triangles rendered by this geometry.
   virtual int nrTriangles();
 
+  /// Get the triangles of the Capsule from the shared mesh.
+  virtual bool getTriangles( vector< HAPI::Collision::Triangle > &triangles );
+
+  /// Render instances of the Capsule from the shared mesh.
+  virtual bool renderInstanced( GLsizei nr_instances );
+
   /// Specifies if the bottom of the Capsule should be rendered or not.
   ///
   /// <b>Access type:</b> inputOutput \n
@@ -143,10 +150,23 @@ namespace H3D {
   static H3DNodeDatabase database;
 
   protected:
-  // Internal field used to know if vertex buffer object can be created.
-  auto_ptr< Field > vboFieldsUpToDate;
-  // The index for the vertex buffer object
-  GLuint *vbo_id;
+  /// Get the mesh shared by all Capsule nodes with the same radius and
+  /// height, fetching it from the PrimitiveMeshCache if it has changed.
+  PrimitiveMeshCache::Mesh *getMesh();
+
+  /// Bitmask of the mesh parts that are enabled by the side, top and
+  /// bottom fields.
+  unsigned int getPartMask();
+
+  /// Build the mesh for a capsule. params[0] is the radius and params[1]
+  /// is the height.
+  static void buildMesh( const vector< H3DFloat > &params,
+                         PrimitiveMeshCache::Mesh &mesh );
+
+  // Internal field used to know if the mesh has to be fetched again.
+  auto_ptr< Field > meshFieldsUpToDate;
+  // The mesh currently used by this node.
+  PrimitiveMeshCache::Mesh *mesh;
 
   // the number of parts around the cylinder and along the equator of the end-cap half-spheres
   static const unsigned int theta_parts = 10;
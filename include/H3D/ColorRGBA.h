@@ -33,6 +33,7 @@
 #include <H3D/FieldTemplates.h>
 #include <GL/glew.h>
 #include <H3D/MFColorRGBA.h>
+#include <H3D/GLStateTracker.h>
 
 namespace H3D {
   /// \ingroup X3DNodes
@@ -89,14 +90,14 @@ namespace H3D {
     /// Enable state needed before rendering the color.
     virtual void preRender() {
       X3DColorNode::preRender();
-      glEnable( GL_BLEND );
+      GLStateTracker::enable( GL_BLEND );
       glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     }
 
     /// Disable state set in preRender() function.
     virtual void postRender() {
       X3DColorNode::postRender();
-      glDisable( GL_BLEND );
+      GLStateTracker::disable( GL_BLEND );
     }
 
     /// Returns the number of color this color node can render.
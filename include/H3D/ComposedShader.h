@@ -38,6 +38,7 @@
 #include <string>
 #include <H3D/ShaderFunctions.h>
 #include <H3D/H3DSingleTextureNode.h>
+#include <H3DUtil/AutoPtrVector.h>
 
 namespace H3D {
 
@@ -114,7 +115,8 @@ namespace H3D {
                     Inst< SFInt32      > _geometryVerticesOut = 0,
                     Inst< SFString     > _transparencyDetectMode = 0,
                     Inst< MFString     > _transformFeedbackVaryings = 0,
-                    Inst< SFBool       > _printShaderWarnings = 0
+                    Inst< SFBool       > _printShaderWarnings = 0,
+                    Inst< SFBool       > _packUniformsInBuffers = 0
 #ifdef EXPORT_SHADER
                     ,
                     Inst< UpdateSaveShadersToUrl > _saveShadersToUrl = 0
@@ -265,6 +267,32 @@ namespace H3D {
     /// <b>Default value:</b> false \n
     auto_ptr< SFBool > printShaderWarnings;
 
+    /// If true, fields whose names match members of named uniform blocks
+    /// in the shader program are written to one uniform buffer object per
+    /// block instead of being set with glUniform. Each buffer is updated
+    /// with a single call when any of its values has changed, which is
+    /// much cheaper than setting many uniforms one by one. Fields that do
+    /// not match a block member are set as normal uniforms. Requires
+    /// support for GL_ARB_uniform_buffer_object.
+    ///
+    /// <b>Access type:</b> inputOutput \n
+    /// <b>Default value:</b> false \n
+    auto_ptr< SFBool > packUniformsInBuffers;
+
+    /// The time it took to build a shader program.
+    struct H3DAPI_API ProgramBuildTime {
+      /// The name of the node the program was built for.
+      string name;
+      /// The time in seconds spent compiling the shader parts.
+      H3DTime compile_time;
+      /// The time in seconds spent linking the program.
+      H3DTime link_time;
+    };
+
+    /// The compile and link times of the most recently built shader
+    /// programs, oldest first. Shown in the profiling output of Scene.
+    static vector< ProgramBuildTime > program_build_times;
+
     /// The H3DNodeDatabase for this node.
     static H3DNodeDatabase database;
   protected:
@@ -283,6 +311,26 @@ namespace H3D {
     /// The handle to the program object used for the shader in OpenGL.
     GLhandleARB program_handle;
 
+    /// If true, the program of another node with the same shader parts
+    /// is used also when the program is relinked, instead of always
+    /// linking a new program. Set by H3DGeneratedShaderNode, whose
+    /// shader parts share compiled shader objects with other nodes
+    /// generating the same source.
+    bool share_relinked_program;
+
+    /// Create uniform_blocks for the uniform blocks of the current
+    /// program if packUniformsInBuffers is true, and assign fields to
+    /// them.
+    void setupUniformBlocks();
+
+    /// Set the value of a uniform field, either with glUniform or by
+    /// writing it to its uniform block buffer.
+    bool setUniformValue( const string &name, Shaders::UniformInfo &ui,
+                          bool force );
+
+    /// The uniform buffers used when packUniformsInBuffers is true.
+    AutoPtrVector< Shaders::UniformBlockBuffer > uniform_blocks;
+
     /// A vector of the handles to all shader objects that are currently
     /// linked into the program object.
     vector< GLhandleARB > current_shaders;
@@ -291,12 +339,82 @@ namespace H3D {
     static map<string, GLhandleARB> phandles_map;
     static map<GLhandleARB, int> phandle_counts;
 
-    // create program handle for a shader
-    static GLhandleARB createHandle(ComposedShader* shader);
+    /// Create a program handle for a shader and start linking it.
+    /// binary_file is set to the file of the program in the program
+    /// binary cache, binary_key to its key and loaded_binary to true if
+    /// the program was loaded from it. Returns 0 if there are no parts.
+    static GLhandleARB linkProgram( ComposedShader* shader,
+                                    string &binary_file,
+                                    string &binary_key,
+                                    bool &loaded_binary );
+
+    /// Check the result of linking a program created by linkProgram(),
+    /// printing the log if needed, and save it to the program binary
+    /// cache. Returns the program, or 0 if linking failed in which case
+    /// the program is deleted.
+    static GLhandleARB checkLinkStatus( ComposedShader* shader,
+                                        GLhandleARB program_handle,
+                                        const string &binary_file,
+                                        const string &binary_key,
+                                        bool loaded_binary );
+
+    /// Release program_handle, deleting the program if no other node
+    /// uses it, and set it to 0.
+    void releaseProgram();
+
+    /// Set program_handle to a program for the current shader parts. If
+    /// share is true the program of another node with the same parts is
+    /// used if there is one, and a new program can be used by other
+    /// nodes. Returns false if the program is being linked
+    /// asynchronously and is not ready yet.
+    bool setupProgram( bool share );
+
+    /// Add the compile and link time of the program just linked to
+    /// program_build_times.
+    void addProgramBuildTime( H3DTime link_time );
+
+    /// A program that is being linked.
+    struct PendingLink {
+      GLhandleARB program;
+      string binary_file;
+      string binary_key;
+      bool loaded_binary;
+      TimeStamp start_time;
+    };
+
+    /// The programs being linked asynchronously. Shared programs are
+    /// identified by the key from genKeyFromShader(), others also by the
+    /// node linking them.
+    static map< string, PendingLink > pending_links;
+
+    /// True if setupProgram() is waiting for a program to be linked.
+    bool link_pending;
+
+    /// The share argument to use with setupProgram().
+    bool share_link;
+
+    /// The maximum number of entries in program_build_times.
+    static const unsigned int max_program_build_times = 50;
 
     // try to find existing handle (with the same signature), if not, go create one
     static std::string genKeyFromShader(ComposedShader* shader);
 
+    /// Returns the name of the file in the program binary cache for the
+    /// program of the shader, or "" if the cache is not used. key is set
+    /// to the source of all parts, the settings that affect linking and
+    /// the OpenGL driver. The name is a hash of key.
+    static string getProgramBinaryFile( ComposedShader *shader, string &key );
+
+    /// Replace the program with the binary stored in the given file.
+    /// Returns true if the file was saved with the same key and the binary
+    /// was accepted by the driver.
+    static bool loadProgramBinary( GLhandleARB program, const string &file,
+                                   const string &key );
+
+    /// Save the binary of a linked program and its key to the given file.
+    static void saveProgramBinary( GLhandleARB program, const string &file,
+                                   const string &key );
+
     /// Sets geometry shader paramters based on fields.
     void setGeometryShaderParameters( GLenum _program_handle);
 
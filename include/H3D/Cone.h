@@ -31,6 +31,7 @@
 
 #include <H3D/X3DGeometryNode.h>
 #include <H3D/SFFloat.h>
+#include <H3D/PrimitiveMeshCache.h>
 
 namespace H3D {
 
@@ -102,6 +103,9 @@ namespace H3D {
           Inst< SFBool  > _side         = 0,
           Inst< SFBool  > _solid        = 0 );
 
+    /// Destructor.
+    ~Cone();
+
     /// Renders the Box using OpenGL.
     virtual void render();
 
@@ -110,6 +114,12 @@ namespace H3D {
       return 560;
     }
 
+    /// Get the triangles of the Cone from the shared mesh.
+    virtual bool getTriangles( vector< HAPI::Collision::Triangle > &triangles );
+
+    /// Render instances of the Cone from the shared mesh.
+    virtual bool renderInstanced( GLsizei nr_instances );
+
     /// Traverse the scenegraph. 
     virtual void traverseSG( TraverseInfo &ti ); 
 
@@ -148,6 +158,21 @@ namespace H3D {
 
     /// The H3DNodeDatabase for this node.
     static H3DNodeDatabase database;
+
+  protected:
+    /// Get the mesh shared by all Cone nodes with the same bottomRadius
+    /// and height, fetching it from the PrimitiveMeshCache if it has
+    /// changed.
+    PrimitiveMeshCache::Mesh *getMesh();
+
+    /// Bitmask of the mesh parts that are enabled by the side and bottom
+    /// fields.
+    unsigned int getPartMask();
+
+    // Internal field used to know if the mesh has to be fetched again.
+    auto_ptr< Field > meshFieldsUpToDate;
+    // The mesh currently used by this node.
+    PrimitiveMeshCache::Mesh *mesh;
   };
 }
 
@@ -31,6 +31,7 @@
 
 #include <H3D/X3DGeometryNode.h>
 #include <H3D/SFFloat.h>
+#include <H3D/PrimitiveMeshCache.h>
 
 namespace H3D {
 
@@ -119,6 +120,13 @@ namespace H3D {
     virtual int nrTriangles() {
       return 720;
     }
+
+    /// Get the triangles of the Cylinder from the shared mesh.
+    virtual bool getTriangles( vector< HAPI::Collision::Triangle > &triangles );
+
+    /// Render instances of the Cylinder from the shared mesh.
+    virtual bool renderInstanced( GLsizei nr_instances );
+
     /// Specifies if the bottom of the Cylinder should be rendered or not.
     ///
     /// <b>Access type:</b> inputOutput \n
@@ -173,10 +181,18 @@ namespace H3D {
 
     static H3DNodeDatabase database;
   protected:
-    // Internal field used to know if vertex buffer object can be created.
-    auto_ptr< Field > vboFieldsUpToDate;
-    // The index for the vertex buffer object
-    GLuint *vbo_id;
+    /// Get the mesh shared by all Cylinder nodes with the same radius and
+    /// height, fetching it from the PrimitiveMeshCache if it has changed.
+    PrimitiveMeshCache::Mesh *getMesh();
+
+    /// Bitmask of the mesh parts that are enabled by the side, top and
+    /// bottom fields.
+    unsigned int getPartMask();
+
+    // Internal field used to know if the mesh has to be fetched again.
+    auto_ptr< Field > meshFieldsUpToDate;
+    // The mesh currently used by this node.
+    PrimitiveMeshCache::Mesh *mesh;
   };
 }
 
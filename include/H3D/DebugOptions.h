@@ -51,7 +51,8 @@ namespace H3D {
                   Inst< SFBool  > _drawBound = 0,
                   Inst< SFInt32 > _drawBoundTree = 0,
                   Inst< SFBool  > _drawHapticTriangles = 0,
-                  Inst< SFBool  > _printShaderWarnings = 0 );
+                  Inst< SFBool  > _printShaderWarnings = 0,
+                  Inst< SFBool  > _validateGLState = 0 );
     
     /// If true the outline of the bounding box in the bound field of
     /// X3DGeometryNodes will be rendered.
@@ -81,6 +82,16 @@ namespace H3D {
     /// <b>Access type: </b> inputOutput \n
     auto_ptr< SFBool  > printShaderWarnings;
 
+    /// If true, every OpenGL call skipped by GLStateTracker is checked
+    /// against the real OpenGL state and a warning is printed if they
+    /// differ. Slow, only meant for finding code that changes OpenGL
+    /// state without GLStateTracker when
+    /// GraphicsOptions::filterRedundantStateChanges is used.
+    ///
+    /// <b>Default value: </b> false \n
+    /// <b>Access type: </b> inputOutput \n
+    auto_ptr< SFBool  > validateGLState;
+
     /// The H3DNodeDatabase for this node.
     static H3DNodeDatabase database;
   };
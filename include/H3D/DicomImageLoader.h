@@ -32,7 +32,12 @@
 
 #include <H3D/H3DImageLoaderNode.h>
 #include <H3D/SFBool.h>
+#include <H3D/SFFloat.h>
+#include <H3D/Scene.h>
 #include <H3DUtil/LoadImageFunctions.h>
+#include <H3DUtil/Threads.h>
+
+#include <set>
 
 #ifdef HAVE_DCMTK
 
@@ -41,6 +46,14 @@ namespace H3D {
   /// \class DicomImageLoader
   /// DicomImageLoader uses the DCMTK library to load a DICOM image file.
   ///
+  /// Unless loadSingleFile is true, all files in the directory of the url
+  /// that belong to the same series are loaded as the slices of a 3D
+  /// image. The slices are sorted by their position along the slice
+  /// normal, or by instance number if the position is not given, and
+  /// decoded in parallel by a number of worker threads directly into the
+  /// 3D image. Series of color or multi-frame images are loaded one
+  /// slice at a time.
+  ///
   /// <b>Examples:</b>
   ///   - <a href="../../../H3DAPI/examples/All/ImageLoaders.x3d">ImageLoaders.x3d</a>
   ///     ( <a href="examples/ImageLoaders.x3d.html">Source</a> )
@@ -49,6 +62,9 @@ namespace H3D {
     /// Constructor.
     DicomImageLoader();
 
+    /// Destructor.
+    ~DicomImageLoader();
+
     /// Load the image using the DCMTK library. A new DicomImage
     /// is returned. NULL if not successfully loaded.
     virtual Image *loadImage( const string &url );
@@ -67,6 +83,44 @@ namespace H3D {
     /// specified url instead of trying to find all files that belongs to the
     /// dataset. Default value is false.
     auto_ptr< SFBool > loadSingleFile;
+
+    /// The fraction of the slices of the series being loaded that have
+    /// been decoded, from 0 to 1. Updated in the scene graph thread as
+    /// slices are decoded.
+    ///
+    /// <b>Access type:</b> outputOnly \n
+    auto_ptr< SFFloat > progress;
+
+  protected:
+    /// The state of a series being loaded, shared by the worker threads.
+    struct SeriesLoad;
+
+    /// Load all slices of the series of the DICOM file url into one
+    /// image. Returns NULL if the series can not be loaded this way.
+    Image *loadSeries( const string &url );
+
+    /// Thread function decoding slices of a SeriesLoad until there are no
+    /// more slices left.
+    static void *decodeSlicesThreadFunc( void *data );
+
+    /// Set the progress field to value in the scene graph thread.
+    void setProgress( H3DFloat value );
+
+    /// Callback setting the progress field.
+    static Scene::CallbackCode progressCB( void *data );
+
+    /// The progress value to set in progressCB().
+    H3DFloat pending_progress;
+
+    /// True if a progressCB() call is pending for this node.
+    bool progress_pending;
+
+    /// All DicomImageLoader instances, used to check that a node still
+    /// exists when a progressCB() call is executed.
+    static std::set< DicomImageLoader * > loaders;
+
+    /// Lock for loaders and the pending progress of all instances.
+    static H3DUtil::MutexLock loaders_lock;
   };
 }
 
@@ -31,6 +31,7 @@
 
 #include <H3D/X3DGeometryNode.h>
 #include <H3D/SFFloat.h>
+#include <H3D/PrimitiveMeshCache.h>
 
 namespace H3D {
 
@@ -92,10 +93,21 @@ namespace H3D {
             Inst< SFFloat     > _innerRadius = 0,
             Inst< SFFloat     > _outerRadius = 0,
             Inst< SFBool      > _solid = 0 );
+
+    /// Destructor.
+    ~Disk2D();
    
     /// Renders the Disk2D using OpenGL.
     virtual void render();
 
+    /// Get the triangles of the Disk2D from the shared mesh. Returns false
+    /// if the Disk2D is rendered as a circle of lines.
+    virtual bool getTriangles( vector< HAPI::Collision::Triangle > &triangles );
+
+    /// Render instances of the Disk2D from the shared mesh. Returns
+    /// false if the Disk2D is rendered as a circle of lines.
+    virtual bool renderInstanced( GLsizei nr_instances );
+
     // Traverse the scenegraph. See X3DGeometryNode::traverseSG
     // for more info.
     virtual void traverseSG( TraverseInfo &ti );  
@@ -148,6 +160,17 @@ namespace H3D {
     
     /// The H3DNodeDatabase for this node.
     static H3DNodeDatabase database;
+
+  protected:
+    /// Get the mesh shared by all Disk2D nodes with the same innerRadius
+    /// and outerRadius, fetching it from the PrimitiveMeshCache if it has
+    /// changed.
+    PrimitiveMeshCache::Mesh *getMesh();
+
+    // Internal field used to know if the mesh has to be fetched again.
+    auto_ptr< Field > meshFieldsUpToDate;
+    // The mesh currently used by this node.
+    PrimitiveMeshCache::Mesh *mesh;
   };
 }
 
@@ -328,6 +328,12 @@ namespace H3D {
   /// parser. All ParsableFields values can be specified in X3D files.
   class H3DAPI_API ParsableField: public Field {
   public:
+    /// Constructor.
+    ParsableField() : value_string( NULL ) {}
+
+    /// Destructor.
+    virtual ~ParsableField();
+
     /// Set the value of the field given a string. By default
     /// we try to parse the values according to the X3D/XML 
     /// specification.
@@ -337,6 +343,37 @@ namespace H3D {
     inline virtual string getValueAsString( const string& separator = " " ) {
       return "";
     }
+
+    /// Keep the string and set the value of the field from it with
+    /// setValueFromString() the first time the value is used, i.e. the
+    /// first time upToDate() is called. If the field gets a new value
+    /// before that the string is discarded. Since the string is converted
+    /// later, conversion errors are printed as warnings instead of being
+    /// thrown.
+    void setValueFromStringOnUse( const string &s );
+
+    /// Returns true if the field has a string given by
+    /// setValueFromStringOnUse() that has not been converted yet.
+    inline bool hasValueString() {
+      return value_string != NULL;
+    }
+
+    /// Converts a string given by setValueFromStringOnUse() before making
+    /// the field up-to-date.
+    virtual void upToDate();
+
+  protected:
+    /// Discards a string given by setValueFromStringOnUse() since the
+    /// field gets a new value.
+    virtual void startEvent();
+
+    /// Set the value from the string given by setValueFromStringOnUse().
+    /// The field has had the value since the string was given so no event
+    /// is generated.
+    void convertValueString();
+
+    /// The string given by setValueFromStringOnUse(), NULL if none.
+    string *value_string;
   };
 
   /// This is a field which value can be set by a string from the X3D 
@@ -0,0 +1,209 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file GLStateTracker.h
+/// \brief Header file for GLStateTracker, a shadow copy of parts of the
+/// OpenGL state used to skip redundant state changes.
+///
+//
+//////////////////////////////////////////////////////////////////////////////
+#ifndef __GLSTATETRACKER_H__
+#define __GLSTATETRACKER_H__
+
+#include <H3D/H3DApi.h>
+#include <H3D/X3DTypes.h>
+#include <GL/glew.h>
+
+namespace H3D {
+
+  /// \class GLStateTracker
+  /// \brief Keeps a shadow copy of the OpenGL state that is changed most
+  /// often when rendering and skips calls that would not change it.
+  ///
+  /// All rendering code in H3D API uses the functions of this class
+  /// instead of glEnable, glDisable, glPushAttrib, glPopAttrib,
+  /// glActiveTexture, glBindTexture and glUseProgramObjectARB. The
+  /// shadow state covers the most common capabilities, the texture
+  /// bindings of each texture unit, the active texture unit and the
+  /// current shader program. Calls for other state are always issued.
+  ///
+  /// Redundant calls are only skipped if filtering is enabled with
+  /// GraphicsOptions::filterRedundantStateChanges. A state is unknown
+  /// until it has been set through this class, and all state becomes
+  /// unknown at the start of each window render and after each cached
+  /// display list call, since the list may change it. Calls are never
+  /// skipped while a display list is being built. Code outside H3D API
+  /// that changes the tracked state while rendering must call
+  /// invalidate().
+  ///
+  /// If DebugOptions::validateGLState is true, each skipped call is
+  /// checked against the real OpenGL state. Mismatches are reported and
+  /// the call is issued anyway.
+  class H3DAPI_API GLStateTracker {
+  public:
+    /// The number of state changing calls made through the tracker.
+    struct H3DAPI_API Statistics {
+      Statistics() { reset(); }
+
+      /// Set all counters to 0.
+      void reset() {
+        nr_issued = 0;
+        nr_skipped = 0;
+        nr_validation_errors = 0;
+      }
+
+      /// The number of calls passed on to OpenGL.
+      unsigned int nr_issued;
+      /// The number of calls skipped since they would not change state.
+      unsigned int nr_skipped;
+      /// The number of skipped calls found to not match the real OpenGL
+      /// state when validating.
+      unsigned int nr_validation_errors;
+    };
+
+    /// Same as glEnable.
+    static void enable( GLenum cap );
+
+    /// Same as glDisable.
+    static void disable( GLenum cap );
+
+    /// Same as glPushAttrib.
+    static void pushAttrib( GLbitfield mask );
+
+    /// Same as glPopAttrib.
+    static void popAttrib();
+
+    /// Same as glActiveTextureARB.
+    static void activeTexture( GLenum texture );
+
+    /// Same as glBindTexture.
+    static void bindTexture( GLenum target, GLuint texture );
+
+    /// Same as glUseProgramObjectARB.
+    static void useProgram( GLhandleARB program_handle );
+
+    /// Same as glDeleteTextures. Textures that are deleted are unbound
+    /// by OpenGL, which is reflected in the shadow state.
+    static void deleteTextures( GLsizei n, const GLuint *textures );
+
+    /// Mark all tracked state as unknown.
+    static void invalidate();
+
+    /// Called when a window starts rendering. Updates the filtering and
+    /// validation options from the active GlobalSettings and invalidates
+    /// the state, since another context may have been made current.
+    static void beginRender();
+
+    /// Called before building a display list. No calls are skipped
+    /// until the matching endDisplayList(), since the list must contain
+    /// all calls.
+    static void beginDisplayList();
+
+    /// Called after building a display list.
+    static void endDisplayList();
+
+    /// Returns true if a display list is being built.
+    inline static bool isBuildingDisplayList() {
+      return display_list_depth > 0;
+    }
+
+    /// Start a new frame. The statistics of the current frame are moved
+    /// to last_frame and current_frame is reset.
+    static void beginFrame();
+
+    /// Statistics for the frame being rendered.
+    static Statistics current_frame;
+
+    /// Statistics for the last complete frame.
+    static Statistics last_frame;
+
+  protected:
+    /// The maximum number of texture units tracked.
+    static const unsigned int max_texture_units = 32;
+
+    /// The number of tracked texture targets.
+    static const unsigned int nr_texture_targets = 6;
+
+    /// The number of tracked capabilities.
+    static const unsigned int nr_capabilities = 14;
+
+    /// The shadow state. -1 means unknown.
+    struct H3DAPI_API State {
+      GLint enabled[ nr_capabilities ];
+      GLint active_texture;
+      GLint texture_binding[ max_texture_units ][ nr_texture_targets ];
+    };
+
+    /// Set the state of a capability, skipping the call if possible.
+    static void setCapability( GLenum cap, bool enabled );
+
+    /// Returns true if calls can be skipped at the moment.
+    inline static bool filtering() {
+      return filter_redundant && display_list_depth == 0;
+    }
+
+    /// Report that the shadow state of the given OpenGL state did not
+    /// match the real state when validating a skipped call.
+    static void reportMismatch( const char *state_name, GLint shadow_value,
+                                GLint real_value );
+
+    /// Report a mismatch of a handle. GLhandleARB is a pointer on some
+    /// platforms so it can not be given as a GLint.
+    static void reportMismatch( const char *state_name,
+                                GLhandleARB shadow_value,
+                                GLhandleARB real_value );
+
+    /// Index of a capability in State::enabled, -1 if not tracked.
+    static int capabilityIndex( GLenum cap );
+
+    /// Index of a texture target in State::texture_binding, -1 if not
+    /// tracked.
+    static int textureTargetIndex( GLenum target );
+
+    /// The current shadow state.
+    static State state;
+
+    /// The shader program in use.
+    static GLhandleARB program;
+
+    /// True if program is known.
+    static bool program_known;
+
+    /// The attribute masks given to pushAttrib().
+    static vector< GLbitfield > attrib_masks;
+
+    /// The shadow states saved by pushAttrib().
+    static vector< State > attrib_states;
+
+    /// The depth of display lists being built.
+    static int display_list_depth;
+
+    /// True if redundant calls should be skipped.
+    static bool filter_redundant;
+
+    /// True if skipped calls should be validated.
+    static bool validate;
+  };
+}
+
+#endif
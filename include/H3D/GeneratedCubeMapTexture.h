@@ -37,6 +37,7 @@
 #include <H3D/H3DMultiPassRenderObject.h>
 #include <list>
 #include <H3D/SFInt32.h>
+#include <H3D/GLStateTracker.h>
 
 namespace H3D {
 
@@ -112,7 +113,7 @@ namespace H3D {
     virtual void preRender() {
       X3DEnvironmentTextureNode::preRender();
       if( generating_textures ) {
-        glEnable( GL_ALPHA_TEST );
+        GLStateTracker::enable( GL_ALPHA_TEST );
         glAlphaFunc( GL_NEVER, 0 );
       }
     }
@@ -33,6 +33,7 @@
 #include <H3D/SFString.h>
 #include <H3D/SFBool.h>
 #include <H3D/SFFloat.h>
+#include <H3D/SFInt32.h>
 #include <H3D/H3DOptionNode.h>
 #include <H3D/GraphicsOptions.h>
 #include <H3D/MFNode.h>
@@ -56,6 +57,12 @@ namespace H3D {
   /// are loaded versus having to wait for all textures to be read before
   /// program starts.
   ///
+  /// The loadInlinesInThread field controls if the scenes of Inline nodes
+  /// should be fetched in separate threads and added to the scene graph
+  /// when loaded instead of being loaded before the program continues.
+  /// maxInlineLoadThreads is the maximum number of Inline scenes that are
+  /// fetched at the same time.
+  ///
   /// Controls the render mode of all geometries in the scene. The possible 
   /// values are:
   /// <table>
@@ -97,7 +104,9 @@ namespace H3D {
                     Inst< SFBool       > _x3dROUTESendsEvent   = 0,
                     Inst< SFBool       > _loadTexturesInThread = 0,
                     Inst< SFString     > _renderMode           = 0,
-                    Inst< SFBool       > _multiThreadedPython  = 0);
+                    Inst< SFBool       > _multiThreadedPython  = 0,
+                    Inst< SFBool       > _loadInlinesInThread  = 0,
+                    Inst< SFInt32      > _maxInlineLoadThreads = 0 );
     
     /// Destructor.
     ~GlobalSettings() {
@@ -186,6 +195,25 @@ namespace H3D {
     /// <b>Access type: </b> inputOutput \n
     /// <b>Default value: </b> false
     auto_ptr< SFBool > multiThreadedPython;
+
+    /// The loadInlinesInThread field controls if the scenes of Inline
+    /// nodes should be fetched in separate threads. The Inline nodes
+    /// are then loaded in the order of their distance to the viewer and
+    /// their scenes added to the scene graph between frames as they
+    /// become available, instead of the program waiting for all of them
+    /// to be loaded. Each Inline node can override this with its
+    /// loadInThread field.
+    ///
+    /// <b>Access type: </b> inputOutput \n
+    /// <b>Default value: </b> false \n
+    auto_ptr< SFBool > loadInlinesInThread;
+
+    /// The maximum number of Inline scenes that are fetched in separate
+    /// threads at the same time.
+    ///
+    /// <b>Access type: </b> inputOutput \n
+    /// <b>Default value: </b> 4 \n
+    auto_ptr< SFInt32 > maxInlineLoadThreads;
     
     /// The H3DNodeDatabase for this node.
     static H3DNodeDatabase database;
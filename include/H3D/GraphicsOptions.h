@@ -65,7 +65,18 @@ namespace H3D {
                      Inst< SFTime > _bindlessTexturesUnusedTime = 0,
                      Inst< SFBool > _shareTextures = 0,
                      Inst< SFInt32 > _maxTextureDimension = 0,
-                     Inst< SFString > _textureCompression = 0 );
+                     Inst< SFString > _textureCompression = 0,
+                     Inst< SFBool > _useInstancing = 0,
+                     Inst< SFInt32 > _instancingThreshold = 0,
+                     Inst< SFBool > _sortShapes = 0,
+                     Inst< SFBool > _filterRedundantStateChanges = 0,
+                     Inst< SFString > _shaderProgramCacheDirectory = 0,
+                     Inst< SFBool > _asyncShaderCompilation = 0,
+                     Inst< SFBool > _asyncTextureUpload = 0,
+                     Inst< SFInt32 > _textureUploadBudget = 0,
+                     Inst< SFTime > _textureUploadTimeBudget = 0,
+                     Inst< SFInt32 > _textureMemoryBudget = 0,
+                     Inst< SFBool > _releaseImagesAfterUpload = 0 );
     
     bool cacheNode( Node *n ) {
       if( !useCaching->getValue() ) return false;
@@ -219,6 +230,130 @@ namespace H3D {
     ///                          "BC5", "BC6", "BC7" \n
     auto_ptr < SFString > textureCompression;
 
+    /// If true, grouping nodes render children that only differ in their
+    /// transformation as instances of one shape. A child is a candidate
+    /// if it is a Transform or MatrixTransform with a single Shape as
+    /// child and no lights or clip planes. Candidates with the same
+    /// geometry and appearance are rendered with the appearance set up
+    /// only once. If the geometry supports it and the active shader has
+    /// a mat4 attribute named "instanceMatrix" all instances are drawn
+    /// with a single glDrawElementsInstanced call. Transparent shapes and
+    /// transforms with negative scaling are always rendered normally.
+    ///
+    /// <b>Default value: </b> false \n
+    /// <b>Access type: </b> inputOutput \n
+    auto_ptr < SFBool > useInstancing;
+
+    /// The minimum number of children in a grouping node that must share
+    /// geometry and appearance for them to be rendered as instances.
+    /// Grouping nodes that render instances are not cached in display
+    /// lists, so small batches are better left to the normal path.
+    ///
+    /// <b>Default value: </b> 8 \n
+    /// <b>Access type: </b> inputOutput \n
+    auto_ptr < SFInt32 > instancingThreshold;
+
+    /// If true, grouping nodes render their Shape children, and
+    /// Transform or MatrixTransform children with only a Shape as child,
+    /// sorted by render state instead of in scene graph order. Opaque
+    /// shapes are ordered by shader, texture, material and appearance and
+    /// consecutive shapes with the same appearance only set it up once.
+    /// Transparent shapes are rendered after them from back to front.
+    /// Use this when many siblings share a few appearances and the scene
+    /// does not depend on the order its shapes are drawn in.
+    ///
+    /// <b>Default value: </b> false \n
+    /// <b>Access type: </b> inputOutput \n
+    auto_ptr < SFBool > sortShapes;
+
+    /// If true, calls that set OpenGL state to the value it already has
+    /// are skipped. Covers the most common capabilities, texture bindings
+    /// and shader programs, see GLStateTracker. Only use this if all
+    /// nodes and plugins in the scene change OpenGL state through
+    /// GLStateTracker, since changes made behind its back are not seen.
+    /// DebugOptions::validateGLState can be used to check that.
+    ///
+    /// <b>Default value: </b> false \n
+    /// <b>Access type: </b> inputOutput \n
+    auto_ptr < SFBool > filterRedundantStateChanges;
+
+    /// The directory to store linked shader programs in. If not empty,
+    /// the binary of each program linked by a ComposedShader is saved in
+    /// this directory and loaded the next time a program with the same
+    /// shader source is needed, instead of linking it again. The binaries
+    /// are identified by the shader source, the geometry shader and
+    /// transform feedback settings and the OpenGL driver, so a driver
+    /// update makes the old binaries unused. If the driver rejects a
+    /// binary the program is linked as normal. The directory must exist.
+    /// Requires support for GL_ARB_get_program_binary.
+    ///
+    /// <b>Default value: </b> "" \n
+    /// <b>Access type: </b> inputOutput \n
+    auto_ptr < SFString > shaderProgramCacheDirectory;
+
+    /// If true, shaders are compiled and linked without waiting for the
+    /// result, so that loading a scene with many shaders does not stall
+    /// rendering. A ComposedShader is not used until its program is
+    /// ready, so the shapes using it are rendered without the shader
+    /// until then. Requires support for GL_ARB_parallel_shader_compile
+    /// or GL_KHR_parallel_shader_compile, without it shaders are compiled
+    /// as normal.
+    ///
+    /// <b>Default value: </b> false \n
+    /// <b>Access type: </b> inputOutput \n
+    auto_ptr < SFBool > asyncShaderCompilation;
+
+    /// If true, texture images are uploaded to the graphics card in
+    /// slices over several frames instead of all at once when they
+    /// become available, see TextureUploadManager. A texture is not used
+    /// until all of its image has been uploaded. Only uncompressed 2D
+    /// textures that do not need to be scaled on the CPU are uploaded in
+    /// slices.
+    ///
+    /// <b>Default value: </b> false \n
+    /// <b>Access type: </b> inputOutput \n
+    auto_ptr < SFBool > asyncTextureUpload;
+
+    /// The maximum number of bytes of texture images to upload each frame
+    /// when asyncTextureUpload is true. At least one row of an image is
+    /// uploaded each frame. A value <= 0 means no limit.
+    ///
+    /// <b>Default value: </b> 4194304 \n
+    /// <b>Access type: </b> inputOutput \n
+    auto_ptr < SFInt32 > textureUploadBudget;
+
+    /// The maximum time in seconds to spend uploading texture images each
+    /// frame when asyncTextureUpload is true. A value <= 0 means no limit.
+    ///
+    /// <b>Default value: </b> 0.002 \n
+    /// <b>Access type: </b> inputOutput \n
+    auto_ptr < SFTime > textureUploadTimeBudget;
+
+    /// The maximum amount of graphics card memory in megabytes to use for
+    /// the textures of X3DTexture2DNode and X3DTexture3DNode nodes. When
+    /// more is used, the textures that were used least recently are
+    /// removed from the graphics card and installed again from their
+    /// image when they are needed, see TextureMemoryManager. The memory
+    /// used is estimated from the size of the images. A value <= 0 means
+    /// no limit.
+    ///
+    /// <b>Default value: </b> 0 \n
+    /// <b>Access type: </b> inputOutput \n
+    auto_ptr < SFInt32 > textureMemoryBudget;
+
+    /// If true, X3DTexture2DNode and X3DTexture3DNode nodes release the
+    /// pixel data of their image once it has been installed as a texture,
+    /// so that large images are not kept both in main memory and on the
+    /// graphics card. The image keeps its size and format and the data is
+    /// loaded again the first time it is needed, by decoding the url again
+    /// for ImageTexture and Image3DTexture and by reading it back from the
+    /// texture for other textures, see ReloadableImage. Can be overridden
+    /// per texture with TextureProperties::releaseImage.
+    ///
+    /// <b>Default value: </b> FALSE \n
+    /// <b>Access type: </b> inputOutput \n
+    auto_ptr < SFBool > releaseImagesAfterUpload;
+
     /// The H3DNodeDatabase for this node.
     static H3DNodeDatabase database;
   };
@@ -106,6 +106,12 @@ namespace H3D {
   /// uniqueShaderName( base_name ) that provides such a name. This name should then be used
   /// throughout the generated code. Local variables in generated shader code are ok since
   /// the calls are encapsulated with {} in its own space.
+  ///
+  /// While a shader is built the names are based on the order in which
+  /// the nodes taking part are used and not on the nodes themselves. Nodes
+  /// with the same configuration therefore generate identical source, and
+  /// share one compiled and linked shader program. Each node still keeps
+  /// its own uniform values.
   /// 
   /// \par Internal routes:
   /// \dotfile H3DGeneratedShaderNode.dot
@@ -305,6 +311,10 @@ namespace H3D {
 
     string shader_id;
 
+    /// The names used for the nodes taking part in the shader currently
+    /// being built by buildShader(), NULL if no shader is being built.
+    static map< H3DGeneratedShaderNode *, string > *build_shader_ids;
+
     /// Return a string that is placed at the beginning of a fragment shader
     /// to specify minimum required version of the shader as well as enabled
     /// extensions.
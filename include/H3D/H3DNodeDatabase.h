@@ -37,6 +37,7 @@
 #include <string>
 #include <map>
 #include <list>
+#include <vector>
 #include <typeinfo>
 
 /// Useful macro for cleaner field definitions.
@@ -78,6 +79,11 @@ namespace H3D {
       return name;
     }
 
+    /// Get the id of the field name, see H3DNodeDatabase::getFieldId().
+    unsigned int getId() const {
+      return id;
+    }
+
     /// Get the access type of the field.
     const Field::AccessType getAccessType() {
       return access;
@@ -91,6 +97,7 @@ namespace H3D {
     H3DNodeDatabase *container;
     string name;   
     const Field::AccessType access;
+    unsigned int id;
   };
   
   /// The DynamicFieldDBElement is a FieldDBElement for fields that
@@ -370,6 +377,23 @@ namespace H3D {
     /// getField() will search the node's field database for a field matching
     /// the given name and returning a pointer to the field if found.
     Field *getField( const Node * n, const string& f ) const;
+
+    /// getField() will search the node's field database for a field with
+    /// the given field name id and returning a pointer to the field if found.
+    /// Gives the same result as getField() with the name of the id but
+    /// without any string handling, so callers that look up the same field
+    /// many times can get the id once with getFieldId() and use this instead.
+    Field *getField( const Node * n, unsigned int field_id ) const;
+
+    /// Get the id of a field name. Every field name, converted to lower
+    /// case, is given a unique id the first time it is used. The ids are
+    /// the same for all node types and stay the same during the life of
+    /// the program.
+    static unsigned int getFieldId( const string &name );
+
+    /// Get the field name with the given id.
+    /// \param field_id A value returned by getFieldId().
+    static const string &getFieldName( unsigned int field_id );
     
     /// initialise the given Node using the contents of the database - 
     /// initialise field names, field owner pointers and access restrictors.
@@ -383,8 +407,38 @@ namespace H3D {
     void clearDynamicFields( Node *n );
     
   private:
-    /// Help function for getField.
-    Field *getFieldHelp( const Node * n, const string& f ) const;
+    /// Help function for getField. Returns the FieldDBElement with the 
+    /// given field name id from this database or the databases it inherits
+    /// from, NULL if none.
+    FieldDBElement *getFieldHelp( unsigned int field_id ) const;
+
+    /// Mark the fields of this database as changed. Any field tables of
+    /// this database or the databases inheriting from it will be rebuilt
+    /// on next use.
+    void fieldsChanged();
+
+    /// Build field_table if any of the fields of this database or the 
+    /// databases it inherits from have changed since it was built.
+    /// Must only be called with the field table lock held.
+    void updateFieldTable() const;
+
+    /// Hash table with the FieldDBElements of this database and all
+    /// databases it inherits from with the field name id as key. Each
+    /// field name is only in the table once, with the element getField()
+    /// would find first by walking up the parent databases. The size is 
+    /// a power of two and collisions are resolved by trying the next slot.
+    mutable vector< FieldDBElement * > field_table;
+
+    /// The value of fields_generation when field_table was built,
+    /// 0 if never built.
+    mutable unsigned int field_table_generation;
+
+    /// The value of fields_generation when the fields of this database
+    /// last changed.
+    unsigned int fields_changed_generation;
+
+    /// Counter increased every time the fields of any database change.
+    static unsigned int fields_generation;
 
     /// The string name for this node, used by the X3D parser
     string name;
@@ -33,6 +33,7 @@
 #include <H3D/H3DImageObject.h>
 #include <H3D/TextureProperties.h>
 #include <H3D/DependentNodeFields.h>
+#include <H3D/ReloadableImage.h>
 
 namespace H3D {
   /// \ingroup AbstractNodes
@@ -127,9 +128,35 @@ namespace H3D {
 
     ///}
 
+    /// Marks the texture as used in this frame for TextureMemoryManager.
+    virtual void traverseSG( TraverseInfo &ti );
+
+    /// Remove the texture from the graphics card to free memory. It
+    /// must be installed again the next time the node is rendered.
+    /// Returns false if the texture can not be removed, which is the
+    /// default. Called by TextureMemoryManager.
+    virtual bool evictTexture() { return false; }
+
   protected:
     typedef std::vector < H3DSingleTextureNode* > TextureVector;
 
+    /// Returns true if the pixel data of the image of the texture should be
+    /// released once it has been installed, see
+    /// TextureProperties::releaseImage and
+    /// GraphicsOptions::releaseImagesAfterUpload.
+    static bool releaseImageAfterUpload( TextureProperties *texture_properties );
+
+    /// Returns true if the installed texture holds all the data of the
+    /// image, so that the image can be read back from it with
+    /// glGetTexImage. The texture must be bound.
+    bool textureHoldsImage( Image *image,
+                            TextureProperties *texture_properties );
+
+    /// Set the ReloadableImage this texture has replaced its image with.
+    /// The one set before, if any, is detached since its data can no
+    /// longer be loaded from this texture.
+    void setReloadableImage( ReloadableImage *image );
+
     /// The texture handle (GPU)
     GLuint64 texture_handle;
 
@@ -150,6 +177,14 @@ namespace H3D {
 
     /// True if this texture is currently resident
     bool is_resident;
+
+    /// True if releasing the data of the image has been tried since the
+    /// texture was last installed.
+    bool release_image_checked;
+
+    /// The ReloadableImage this texture has replaced its image with, NULL
+    /// if none.
+    AutoRef< ReloadableImage > reloadable_image;
     
     /// List of all currently resident textures
     static TextureVector resident_textures;
@@ -0,0 +1,173 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file ImageLoadPool.h
+/// \brief Header file for ImageLoadPool, a fixed number of threads shared
+/// by all textures loading images in a separate thread.
+///
+//
+//////////////////////////////////////////////////////////////////////////////
+#ifndef __IMAGELOADPOOL_H__
+#define __IMAGELOADPOOL_H__
+
+#include <H3D/H3DApi.h>
+#include <H3D/Scene.h>
+#include <H3DUtil/Image.h>
+#include <H3DUtil/Threads.h>
+
+namespace H3D {
+
+  /// \class ImageLoadPool
+  /// \brief A fixed number of threads that load images for textures with
+  /// loadInThread "SEPARATE", instead of one thread per texture.
+  ///
+  /// The number of threads is the number of cores minus one core for the
+  /// main thread and one for each haptics device, but at least one.
+  /// Queued requests are loaded in priority order, lowest value first.
+  /// Textures set the priority to their distance from the viewer each
+  /// time they are rendered while waiting for their image, so visible
+  /// textures close to the viewer are loaded first. Requests for textures
+  /// that have not been rendered are loaded last.
+  ///
+  /// Requests with the same key, e.g. the same urls, are loaded once and
+  /// the image is given to all requesters. The image is handed over in
+  /// the main thread through Scene::addCallback. A request can be
+  /// cancelled at any time without waiting for the image being loaded.
+  class H3DAPI_API ImageLoadPool {
+  public:
+    /// The input needed to load the image of a request. It must not refer
+    /// to the requester, since the requester can be destroyed while the
+    /// image is loaded. It is deleted in the main thread.
+    struct H3DAPI_API LoadData {
+      /// Destructor.
+      virtual ~LoadData() {}
+
+      /// Load the image. Called in a pool thread. url_used is to be set to
+      /// the url the image was loaded from. Returns NULL if it could not
+      /// be loaded.
+      virtual Image *load( string &url_used ) = 0;
+    };
+
+    /// Function called in the main thread when the image of a request has
+    /// been loaded, with the data given to load().
+    typedef void (*DoneFunc)( void *data, Image *image,
+                              const string &url_used );
+
+    /// The priority of requests for textures that have not been rendered.
+    static const H3DFloat default_priority;
+
+    /// Request an image to be loaded. data identifies the requester and
+    /// any previous request with the same data is cancelled. If a request
+    /// with the same key is queued or being loaded, the image of that
+    /// request is used instead of loading it again. An empty key is never
+    /// shared. The pool takes ownership of load_data.
+    static void load( const string &key, LoadData *load_data,
+                      DoneFunc done_func, void *data,
+                      H3DFloat priority = default_priority );
+
+    /// Cancel the request of data. done_func will not be called for it.
+    /// If the image is being loaded for it, it is discarded when loaded
+    /// unless other requests share it.
+    static void cancel( void *data );
+
+    /// Set the priority of the request of data. Requests with lower values
+    /// are loaded first.
+    static void setPriority( void *data, H3DFloat priority );
+
+    /// Returns the number of threads used for loading.
+    static unsigned int getNrThreads();
+
+    /// Stop the threads and wait for them to finish. Images being loaded
+    /// are discarded and queued requests are not loaded. Called at exit.
+    static void stopThreads();
+
+  protected:
+    /// A requester of an image.
+    struct Listener {
+      /// NULL if it is used by the job.
+      LoadData *load_data;
+      DoneFunc done_func;
+      void *data;
+      H3DFloat priority;
+    };
+
+    /// An image to load, and all requesters of it.
+    struct Job {
+      Job() : loading_data( NULL ), loaded( false ), image( NULL ) {}
+
+      /// Destructor. Deletes the load data of the job and its listeners.
+      ~Job();
+
+      /// Returns the lowest priority of the listeners.
+      H3DFloat getPriority();
+
+      string key;
+      vector< Listener > listeners;
+      /// The load data of the listener the image is being loaded for, NULL
+      /// if not loading. Kept when the listener is removed.
+      LoadData *loading_data;
+      /// True when the image has been loaded and is waiting to be handed
+      /// over to the listeners.
+      bool loaded;
+      Image *image;
+      string url_used;
+    };
+
+    /// Start the threads if not started.
+    static void startThreads();
+
+    /// Remove data from the listeners of its job. Must be called with
+    /// lock locked in the main thread.
+    static void removeListener( void *data );
+
+    /// The function run by the pool threads.
+    static void *loadThreadFunc( void *data );
+
+    /// Scene callback handing over the image of a loaded job.
+    static Scene::CallbackCode loadedCB( void *data );
+
+    /// Lock for all members.
+    static H3DUtil::ConditionLock lock;
+
+    /// The jobs that are not being loaded yet.
+    static vector< Job * > queued;
+
+    /// The jobs with a key that are queued, loading or loaded but not
+    /// handed over.
+    static map< string, Job * > shared_jobs;
+
+    /// The job of each listener.
+    static map< void *, Job * > listener_jobs;
+
+    /// The pool threads.
+    static vector< H3DUtil::SimpleThread * > threads;
+
+    /// The number of pool threads that have not finished.
+    static unsigned int nr_running;
+
+    /// True when the threads are to finish.
+    static bool stopping;
+  };
+}
+
+#endif
@@ -34,6 +34,7 @@
 #include <H3D/X3DUrlObject.h>
 #include <H3D/MFNode.h>
 #include <H3D/Scene.h>
+#include <H3D/ImageLoadPool.h>
 
 namespace H3D {
   /// \ingroup X3DNodes 
@@ -74,9 +75,10 @@ namespace H3D {
     ///
     /// If X3DTextureNode::load_images_in_separate_thread is true, the image 
     /// field will not be set directly. Instead it will be set to NULL, and
-    /// the image downloaded and created in a separate thread. When it has 
-    /// been created a callback function is set to execute with 
-    /// Scene::setCallback that sets the image field to the new image.
+    /// the image downloaded and created by the threads of ImageLoadPool.
+    /// When it has been created the image field is set to the new image
+    /// in the main thread. Textures with the same urls and image loaders
+    /// share one load.
     /// This allows the program to continue to execute and run without textures
     /// while the textures are loaded and the textures will then be applied
     /// as they are available.
@@ -96,43 +98,65 @@ namespace H3D {
       /// of the ImageTexture
       virtual void update();
       
-      /// Tries to create an image. All urls are tested agains all
-      /// image loaders until one that works is found. Returns NULL
-      /// if it could not load the image, and the new image on success.
-      Image * loadImage( ImageTexture *texture,
-                         const vector< string > &urls,
-                         const NodeVector &image_loader ); 
-
-      /// struct for storing input needed to the thread function
-      struct ThreadFuncData {
-        ImageTexture *texture;
+      /// struct for storing input needed to the thread function. It does
+      /// not refer to the texture, so a load in ImageLoadPool can go on
+      /// when the texture is destroyed.
+      struct ThreadFuncData : public ImageLoadPool::LoadData {
+        /// The url base of the texture.
+        string url_base;
         vector< string > urls;
         NodeVector image_loaders;
-        MutexLock load_thread_mutex;
-      };
-      
-      /// struct for storing input needed for the callback function.
-      struct CBData {
-        CBData():texture(NULL), image(NULL){}
-        ImageTexture *texture;
-        Image *image;
+        /// The name of the texture, used in error messages.
+        string texture_name;
+
+        /// Load the image with loadImage().
+        virtual Image *load( string &url_used );
       };
 
+      /// Tries to create an image. All urls are tested agains all
+      /// image loaders until one that works is found. Returns NULL
+      /// if it could not load the image, and the new image on success.
+      ///
+      /// \param input The urls and image loaders to use.
+      /// \param url_used Set to the url the image was loaded from.
+      static Image *loadImage( const ThreadFuncData &input,
+                               string &url_used );
+
       /// data used for the thread function
       ThreadFuncData thread_data;
 
-      /// data used for the callback function.
-      CBData cb_data;
-      
-      /// Callback function for setting the image field when thread 
-      /// has finished downloading
-      static Scene::CallbackCode loadImageCB( void *data );
+      /// True while the image is being loaded by ImageLoadPool.
+      bool load_pending;
+
+      /// The image last loaded from the urls, NULL if none.
+      Image *url_image;
 
-      /// Function to use in the thread for downloading and creating an
-      /// Image object.
-      static void *loadImageThreadFunc( void * );
+      /// Called by ImageLoadPool in the main thread to set the image field
+      /// when the image has been loaded.
+      static void loadImageDone( void *data, Image *image,
+                                 const string &url_used );
     public:
+      /// Constructor.
+      SFImage() : load_pending( false ), url_image( NULL ) {}
+
       virtual ~SFImage();
+
+      /// Returns true while the image is being loaded in a separate thread.
+      inline bool isLoadPending() { return load_pending; }
+
+      /// Set the priority of the pending load. Loads with lower values
+      /// are started first.
+      void setLoadPriority( H3DFloat priority );
+
+      /// Returns true if the image is the one last loaded from the urls.
+      inline bool isLoadedFromURL( Image *image ) {
+        return image && image == url_image;
+      }
+
+      /// Load the image from the urls again, e.g. when its data has been
+      /// released. The value of the field is not changed. Can be called
+      /// from any thread.
+      Image *reloadImage();
     };
       
     /// Constructor.
@@ -264,6 +288,14 @@ namespace H3D {
     static H3DNodeDatabase database;
   protected:
 
+    /// Returns a ReloadableImage that decodes the url again if the image
+    /// was loaded from it.
+    virtual ReloadableImage *newReloadableImage( Image *_image );
+
+    /// ReloadableImage::ReloadFunc loading the image of the ImageTexture
+    /// given as data from its url again.
+    static Image *reloadImage( Image *_image, void *data );
+
     /// Returns true if texture sharing should be enabled
     bool useSharing ();
 
@@ -274,9 +306,6 @@ namespace H3D {
     /// Add a reference to, or create as needed, a shared texture with this url
     void addSharedImage ( std::vector < std::string > _urls );
 
-    /// The thread used for downloading images when 
-    /// load_images_in_separate_thread is true.
-    auto_ptr< H3DUtil::SimpleThread > load_thread;
 
     /// A shared texture
     struct SharedImage {
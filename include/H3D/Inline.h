@@ -35,6 +35,7 @@
 #include <H3D/H3DDisplayListObject.h>
 #include <H3D/Group.h>
 #include <H3D/DEFNodes.h>
+#include <H3D/InlineLoadPool.h>
 
 namespace H3D {
 
@@ -105,6 +106,11 @@ namespace H3D {
   /// the bboxCenter and bboxSize fields. This is a hint to the browser and
   /// could be used for optimization purposes such as culling. 
   ///
+  /// The loadInThread field controls if the scene is loaded before the
+  /// program continues or fetched in a separate thread by InlineLoadPool
+  /// and added to the scene graph between two frames when it is
+  /// available. A LoadSensor can be used to detect when that happens.
+  ///
   ///  
   ///
   /// <b>Examples:</b>
@@ -187,9 +193,11 @@ namespace H3D {
             Inst< SFBool      >  _load       = 0,
             Inst< LoadedScene > _loadedScene = 0,
             Inst< SFString    > _importMode  = 0,
-            Inst< SFBool      > _traverseOn  = 0 );
+            Inst< SFBool      > _traverseOn  = 0,
+            Inst< SFString    > _loadInThread = 0 );
 
     virtual ~Inline() {
+      InlineLoadPool::cancel( this );
       exported_nodes.clear();
       DEF_nodes.clear();
     }
@@ -254,6 +262,26 @@ namespace H3D {
                                         const Vec3f &to,
                                         NodeIntersectResult &result );
 
+    /// Returns LOADING while the scene is fetched in a separate thread.
+    virtual LoadStatus loadStatus() {
+      if( load_pending ) return X3DUrlObject::LOADING;
+      return X3DUrlObject::loadStatus();
+    }
+
+    /// Called by InlineLoadPool in the main thread when the urls have been
+    /// resolved in a separate thread. Parses the scene and adds it to the
+    /// loadedScene field.
+    /// \param _url The url that was resolved, empty if none of them could
+    /// be.
+    /// \param url_contents The contents of the url if it was resolved as a
+    /// string.
+    /// \param file_name The local file name of the url otherwise.
+    /// \param is_tmp_file True if file_name is a temporary file.
+    void loadedInThread( const string &_url,
+                         const string &url_contents,
+                         const string &file_name,
+                         bool is_tmp_file );
+
     /// If the load field is set to TRUE (the default field value), 
     /// the X3D file specified by the url field is loaded immediately. 
     /// If the load field is set to FALSE, no action is taken.
@@ -294,6 +322,22 @@ namespace H3D {
     /// \dotfile Inline_traverseOn.dot
     auto_ptr< SFBool > traverseOn;
 
+    /// Specifies the thread to use to load the scene.
+    ///
+    /// If "DEFAULT" then the setting in GlobalSettings will be used.
+    /// If "MAIN" then the scene is loaded in the main thread when the
+    /// loadedScene field is updated.
+    /// If "SEPARATE" then the urls are resolved and fetched by the threads
+    /// of InlineLoadPool, and the scene is added to the loadedScene field
+    /// between two frames when available.
+    /// 
+    /// <b>Access type:</b> inputOutput \n
+    /// <b>Default value:</b> "DEFAULT" \n
+    /// <b>Valid values:</b> "DEFAULT", "MAIN", "SEPARATE"
+    /// 
+    /// \dotfile Inline_loadInThread.dot
+    auto_ptr< SFString > loadInThread;
+
     // if true a route will be set up between the bound field of the
     // loadedScene field and the bound field of the inline node. 
     bool use_union_bound;
@@ -308,6 +352,29 @@ namespace H3D {
     /// A DEFNodes structure from the name of nodes named with the DEF statement
     /// in the url of the Inline node, to the actual node.
     X3D::DEFNodes DEF_nodes;
+
+  protected:
+    /// Returns true if the scene should be loaded in a separate thread
+    /// according to the loadInThread field and GlobalSettings.
+    bool loadInSeparateThread();
+
+    /// Parse the scene of a resolved url and set up the DEF and exported
+    /// nodes. Returns NULL if the scene could not be parsed.
+    /// \param _url The url that was resolved.
+    /// \param url_contents The contents of the url if it was resolved as a
+    /// string.
+    /// \param file_name The local file name of the url otherwise.
+    /// \param is_tmp_file True if file_name is a temporary file.
+    Group *parseScene( const string &_url,
+                       const string &url_contents,
+                       const string &file_name,
+                       bool is_tmp_file );
+
+    /// Print an error that none of the urls could be loaded.
+    void printNoURLLoaded( const vector< string > &urls );
+
+    /// True while the scene is fetched in a separate thread.
+    bool load_pending;
   };
 }
 
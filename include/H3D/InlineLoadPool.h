@@ -0,0 +1,161 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file InlineLoadPool.h
+/// \brief Header file for InlineLoadPool, threads fetching the scenes of
+/// Inline nodes loading in a separate thread.
+///
+//
+//////////////////////////////////////////////////////////////////////////////
+#ifndef __INLINELOADPOOL_H__
+#define __INLINELOADPOOL_H__
+
+#include <H3D/H3DApi.h>
+#include <H3D/Scene.h>
+#include <H3DUtil/Threads.h>
+
+namespace H3D {
+
+  class Inline;
+
+  /// \class InlineLoadPool
+  /// \brief Threads that fetch the scenes of Inline nodes with loadInThread
+  /// "SEPARATE".
+  ///
+  /// The threads resolve the urls of the Inline nodes, which includes
+  /// downloading them if they are not local files. The scene is then
+  /// parsed and added to the Inline node in the main thread through
+  /// Scene::addCallback, between two frames, since creating and
+  /// initializing nodes can only be done in the main thread.
+  ///
+  /// At most GlobalSettings::maxInlineLoadThreads scenes are fetched at
+  /// the same time. Queued requests are loaded in priority order, lowest
+  /// value first. Inline nodes set the priority to their distance from the
+  /// viewer each time they are traversed while waiting for their scene, so
+  /// Inline nodes close to the viewer are loaded first. Requests for Inline
+  /// nodes that have not been traversed are loaded last.
+  class H3DAPI_API InlineLoadPool {
+  public:
+    /// The priority of requests for Inline nodes that have not been
+    /// traversed.
+    static const H3DFloat default_priority;
+
+    /// Request the scene of inline_node to be fetched from the first
+    /// of the urls that can be resolved. Any previous request of the node
+    /// is cancelled. Inline::loadedInThread() is called in the main thread
+    /// when done. Must be called in the main thread.
+    static void load( Inline *inline_node, const vector< string > &urls,
+                      H3DFloat priority = default_priority );
+
+    /// Cancel the request of inline_node. Inline::loadedInThread() will not
+    /// be called for it. If its urls are being resolved the result is
+    /// discarded when done.
+    static void cancel( Inline *inline_node );
+
+    /// Set the priority of the request of inline_node. Requests with lower
+    /// values are loaded first.
+    static void setPriority( Inline *inline_node, H3DFloat priority );
+
+    /// Stop the threads and wait for them to finish. Urls being resolved
+    /// are resolved first and queued requests are not loaded. Called at
+    /// exit.
+    static void stopThreads();
+
+  protected:
+    /// The state of a Job.
+    typedef enum {
+      /// Waiting for a thread.
+      QUEUED,
+      /// The urls are being resolved.
+      LOADING,
+      /// Resolved and waiting to be handed over.
+      LOADED
+    } JobState;
+
+    /// A request for the scene of an Inline node.
+    struct Job {
+      Job() : inline_node( NULL ), priority( default_priority ),
+              state( QUEUED ), cancelled( false ), is_tmp_file( false ) {}
+
+      /// The node the request is for. Only used in the main thread.
+      Inline *inline_node;
+      vector< string > urls;
+      /// The url base of inline_node, for resolving the urls without it.
+      string url_base;
+      H3DFloat priority;
+      JobState state;
+      /// True if the request has been cancelled while loading or loaded.
+      bool cancelled;
+
+      /// The url that was resolved, empty if none of them could be.
+      string url_used;
+      /// The contents of url_used if it could be resolved as a string.
+      string url_contents;
+      /// The local file name of url_used if it could not be resolved as a
+      /// string.
+      string file_name;
+      /// True if file_name is a temporary file.
+      bool is_tmp_file;
+    };
+
+    /// Start threads until there are as many as the maximum number of
+    /// concurrent loads.
+    static void startThreads();
+
+    /// Cancel all requests of inline_node. Queued requests are removed,
+    /// others are marked as cancelled. Must be called with lock locked.
+    static void cancelJobs( Inline *inline_node );
+
+    /// The function run by the pool threads.
+    static void *loadThreadFunc( void *data );
+
+    /// Resolve the urls of a job. Called in a pool thread.
+    static void resolveURLs( Job *job );
+
+    /// Scene callback handing over the result of a loaded job.
+    static Scene::CallbackCode loadedCB( void *data );
+
+    /// Lock for all members.
+    static H3DUtil::ConditionLock lock;
+
+    /// All jobs that have not been handed over.
+    static vector< Job * > jobs;
+
+    /// The number of jobs in the LOADING state.
+    static unsigned int nr_loading;
+
+    /// The maximum number of jobs in the LOADING state.
+    static unsigned int max_loading;
+
+    /// The pool threads.
+    static vector< H3DUtil::SimpleThread * > threads;
+
+    /// The number of pool threads that have not finished.
+    static unsigned int nr_running;
+
+    /// True when the threads are to finish.
+    static bool stopping;
+  };
+}
+
+#endif
@@ -297,6 +297,8 @@ namespace H3D {
                                           unsigned int &nr_elements,
                                           unsigned int len, 
                                           int id = 0 ) {
+      this->upToDate();
+
       unsigned int sz = sizeof( value_type );
       nr_elements = (unsigned int) this->value.size();
       if( len < sz * nr_elements ) {
@@ -306,8 +308,6 @@ namespace H3D {
       value_type *data_ptr = 
         static_cast< value_type * >( data );
 
-      this->upToDate();
-
       for( unsigned int i = 0; i < nr_elements; ++i ) {
         data_ptr[i] = value[i];
       }
@@ -424,7 +424,11 @@ namespace H3D {
     inline virtual void setValueFromString( const string &s ) {
       std::vector< Type > v;
       X3D::X3DStringToVector< std::vector< Type > >( s, v ); 
-      setValue( v );
+      // the values are parsed straight into the field instead of being
+      // copied, so large arrays are only in memory once.
+      this->checkAccessTypeSet( 0 );
+      this->value.swap( v );
+      setValue( this->value );
     }
 
     /// Add a new element to an MField from a string value.
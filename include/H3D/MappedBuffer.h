@@ -0,0 +1,101 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file MappedBuffer.h
+/// \brief Header file for MappedBuffer, a read-only memory mapping of a
+/// file.
+///
+//
+//////////////////////////////////////////////////////////////////////////////
+#ifndef __MAPPEDBUFFER_H__
+#define __MAPPEDBUFFER_H__
+
+#include <H3D/H3DApi.h>
+#include <H3DUtil/RefCountedClass.h>
+#include <H3DUtil/AutoRef.h>
+
+namespace H3D {
+
+  /// \class MappedBuffer
+  /// \brief A read-only memory mapping of a whole file.
+  ///
+  /// Used to read the values of MF fields that reference an external
+  /// binary buffer instead of listing the values as text, see
+  /// X3D::X3DStringToVector. Pages of the file are only read when they
+  /// are accessed and are shared with all other mappings of the same
+  /// file, also in other processes, through the file cache of the
+  /// operating system.
+  ///
+  /// A file is mapped once per getBuffer() call, unless sharing has been
+  /// started with beginSharing() in the calling thread. X3DSAX2Handlers
+  /// shares the mappings while it parses, so all fields of one loaded
+  /// file that read the same buffer file use one mapping.
+  class H3DAPI_API MappedBuffer : public RefCountedClass {
+  public:
+    /// Get a mapping of the file with the given name. If sharing is
+    /// active in the calling thread and the file has been mapped since
+    /// beginSharing() the same mapping is returned. Returns NULL if the
+    /// file could not be mapped.
+    static AutoRef< MappedBuffer > getBuffer( const string &filename );
+
+    /// Get a mapping of the file a url resolves to through
+    /// ResourceResolver. Relative urls are resolved against the current
+    /// base URL. Returns NULL if the url could not be resolved or mapped.
+    static AutoRef< MappedBuffer > getBufferFromURL( const string &url );
+
+    /// Destructor. Unmaps the file.
+    virtual ~MappedBuffer();
+
+    /// Returns a pointer to the start of the file.
+    inline const unsigned char *getData() { return data; }
+
+    /// Returns the size of the file in bytes.
+    inline size_t getSize() { return size; }
+
+    /// Returns the name of the file.
+    inline const string &getFileName() { return filename; }
+
+    /// Start sharing mappings in the calling thread. Until the matching
+    /// endSharing() all getBuffer() calls for the same file in the thread
+    /// return the same mapping. Calls can be nested, the mappings are
+    /// kept until the outermost endSharing().
+    static void beginSharing();
+
+    /// Stop the sharing started by the last beginSharing() call in the
+    /// calling thread.
+    static void endSharing();
+
+  protected:
+    /// Constructor. Use getBuffer() to create instances.
+    MappedBuffer( const string &_filename );
+
+    /// Map the file. Returns false if it failed.
+    bool mapFile();
+
+    string filename;
+    const unsigned char *data;
+    size_t size;
+  };
+}
+
+#endif
@@ -0,0 +1,127 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file MappedImage.h
+/// \brief Header file for MappedImage, an image whose pixel data is
+/// mapped directly from a file.
+///
+//
+//////////////////////////////////////////////////////////////////////////////
+#ifndef __MAPPEDIMAGE_H__
+#define __MAPPEDIMAGE_H__
+
+#include <H3D/H3DApi.h>
+#include <H3DUtil/Image.h>
+
+namespace H3D {
+
+  /// \class MappedImage
+  /// \brief An Image whose pixel data points directly into a memory
+  /// mapping of the file it was loaded from.
+  ///
+  /// Used by image loaders for uncompressed file formats so that the
+  /// data of large volumes is not copied into memory. Pages of the file
+  /// are only read when they are accessed, and unmodified pages are
+  /// shared with all other mappings of the same file through the file
+  /// cache of the operating system. The mapping is copy-on-write, so
+  /// writing to the data changes only the pages of this image and never
+  /// the file.
+  class H3DAPI_API MappedImage : public Image {
+  public:
+    /// Map the pixel data of an image that starts offset bytes into the
+    /// file with the given name. Returns NULL if the file could not be
+    /// mapped or is too small to hold the image.
+    static MappedImage *mapFile( const string &filename,
+                                 size_t offset,
+                                 unsigned int width,
+                                 unsigned int height,
+                                 unsigned int depth,
+                                 unsigned int bits_per_pixel,
+                                 Image::PixelType pixel_type,
+                                 Image::PixelComponentType component_type,
+                                 const Vec3f &pixel_size = Vec3f( 0, 0, 0 ) );
+
+    /// Destructor. Unmaps the file.
+    virtual ~MappedImage();
+
+    /// Returns the width of the image in pixels.
+    virtual unsigned int width() { return image_width; }
+
+    /// Returns the height of the image in pixels.
+    virtual unsigned int height() { return image_height; }
+
+    /// Returns the depth of the image in pixels.
+    virtual unsigned int depth() { return image_depth; }
+
+    /// Returns the number of bits used for each pixel in the image.
+    virtual unsigned int bitsPerPixel() { return bits_per_pixel; }
+
+    /// Returns the size of a pixel in metres.
+    virtual Vec3f pixelSize() { return pixel_size; }
+
+    /// Returns the pixel type of the image.
+    virtual Image::PixelType pixelType() { return pixel_type; }
+
+    /// Returns the pixel component type of the image.
+    virtual Image::PixelComponentType pixelComponentType() {
+      return pixel_component_type;
+    }
+
+    /// Returns a pointer to the pixel data in the mapping.
+    virtual void *getImageData() { return data; }
+
+    /// Returns the size of the pixel data in bytes.
+    size_t dataSize();
+
+  protected:
+    /// Constructor. Use mapFile() to create instances.
+    MappedImage( unsigned int width,
+                 unsigned int height,
+                 unsigned int depth,
+                 unsigned int bits_per_pixel,
+                 Image::PixelType pixel_type,
+                 Image::PixelComponentType component_type,
+                 const Vec3f &pixel_size );
+
+    unsigned int image_width;
+    unsigned int image_height;
+    unsigned int image_depth;
+    unsigned int bits_per_pixel;
+    Vec3f pixel_size;
+    Image::PixelType pixel_type;
+    Image::PixelComponentType pixel_component_type;
+
+    /// The start of the mapping. The mapping starts at an offset in the
+    /// file that is a multiple of the allocation granularity, which
+    /// may be before the pixel data.
+    void *mapping;
+
+    /// The size of the mapping in bytes.
+    size_t mapping_size;
+
+    /// The start of the pixel data in the mapping.
+    void *data;
+  };
+}
+
+#endif
@@ -344,6 +344,10 @@ namespace H3D {
     
     /// return a pointer to the field specified by name within this instance 
     virtual Field *getField( const string &_name ) const;
+
+    /// return a pointer to the field with the given field name id within
+    /// this instance. The id is given by H3DNodeDatabase::getFieldId().
+    virtual Field *getField( unsigned int field_id ) const;
     
     /// Add a callback function to be run on destruction of node.
     /// Returns 0 on success.
@@ -53,7 +53,9 @@ namespace H3D {
     }
 
     /// Load the image using the NrrdImage library. A new NrrdImageImage
-    /// is returned. NULL if not successfully loaded.
+    /// is returned. NULL if not successfully loaded. The data of files
+    /// with raw encoding in the byte order of this machine is mapped into
+    /// memory instead and a MappedImage is returned.
     virtual Image *loadImage( const string &url );
     
     /// Returns true if the node supports the filetype of the file
@@ -671,6 +671,7 @@ namespace H3D {
     unsigned int current_nr_lightsources;
 
     /// Returns a unique name to use in this shader for a field of a light node.
+    /// The name is given by the index of the light in current_light_nodes.
     string uniqueLightFieldName( const string &field_name,
                                  X3DLightNode *light);
 
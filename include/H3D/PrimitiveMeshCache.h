@@ -0,0 +1,215 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file PrimitiveMeshCache.h
+/// \brief Header file for PrimitiveMeshCache, a cache of tessellated meshes
+/// shared between parametric geometry nodes.
+///
+//
+//////////////////////////////////////////////////////////////////////////////
+#ifndef __PRIMITIVEMESHCACHE_H__
+#define __PRIMITIVEMESHCACHE_H__
+
+#include <H3D/H3DApi.h>
+#include <H3D/X3DTypes.h>
+#include <H3DUtil/Threads.h>
+#include <HAPI/CollisionObjects.h>
+#include <GL/glew.h>
+#include <map>
+
+namespace H3D {
+
+  class X3DGeometryNode;
+
+  /// \class PrimitiveMeshCache
+  /// \brief Process wide cache of the tessellated meshes used by parametric
+  /// geometry nodes such as Sphere, Cylinder, Cone, Capsule, Box and Disk2D.
+  ///
+  /// A mesh is identified by the primitive type and the parameters that
+  /// affect the tessellation, e.g. radius and height for a Cylinder. All
+  /// nodes with the same parameters share one copy of the vertex data, one
+  /// pair of vertex buffer objects and one triangle list used for building
+  /// bound trees. Memory use and build time therefore scale with the number
+  /// of distinct shapes instead of the number of nodes.
+  ///
+  /// Meshes are reference counted. A node gets a mesh with getMesh() and
+  /// must give it back with releaseMesh() when it no longer uses it.
+  class H3DAPI_API PrimitiveMeshCache {
+  public:
+
+    /// The key used to identify a mesh in the cache.
+    struct H3DAPI_API Key {
+      Key() {}
+      Key( const string &_type, const vector< H3DFloat > &_params ) :
+        type( _type ), params( _params ) {}
+
+      bool operator<( const Key &k ) const {
+        if( type != k.type ) return type < k.type;
+        return params < k.params;
+      }
+
+      /// The name of the primitive type, e.g. "Cylinder".
+      string type;
+      /// The parameters used when tessellating the primitive.
+      vector< H3DFloat > params;
+    };
+
+    /// A contiguous range of triangles in a Mesh, e.g. the side or the
+    /// top cap of a Cylinder.
+    struct Part {
+      Part() : min_index( 0 ), max_index( 0 ),
+               index_offset( 0 ), nr_indices( 0 ) {}
+      /// The smallest vertex index used by the part.
+      GLuint min_index;
+      /// The largest vertex index used by the part.
+      GLuint max_index;
+      /// The offset of the first index of the part in index_data.
+      GLsizei index_offset;
+      /// The number of indices in the part.
+      GLsizei nr_indices;
+    };
+
+    /// A tessellated mesh shared between all nodes using the same Key.
+    /// The vertex data is interleaved with 9 floats per vertex, 3 for
+    /// the position, 3 for the normal and 3 for the texture coordinate.
+    /// All primitives are triangles.
+    class H3DAPI_API Mesh {
+    public:
+      /// The number of floats per vertex in vertex_data.
+      static const unsigned int components_per_vertex = 9;
+
+      /// Constructor.
+      Mesh();
+
+      /// Start a new part of the mesh. All triangles added until the
+      /// next call to beginPart() belong to this part.
+      void beginPart();
+
+      /// Add a vertex to the mesh. Returns the index of the vertex.
+      GLuint addVertex( const Vec3f &vertex,
+                        const Vec3f &normal,
+                        const Vec3f &tex_coord );
+
+      /// Add a triangle to the current part of the mesh.
+      void addTriangle( GLuint a, GLuint b, GLuint c );
+
+      /// Render the parts of the mesh that have their bit set in
+      /// part_mask. If use_vertex_buffer_object is true the data is
+      /// rendered from vertex buffer objects, otherwise from vertex arrays.
+      /// If nr_instances is not 1 the mesh is drawn nr_instances times
+      /// with glDrawElementsInstancedARB. Per instance attributes must
+      /// then be set up by the caller.
+      void render( unsigned int part_mask, bool use_vertex_buffer_object,
+                   GLsizei nr_instances = 1 );
+
+      /// Add the triangles of the parts that have their bit set in
+      /// part_mask to triangles.
+      void getTriangles( unsigned int part_mask,
+                         vector< HAPI::Collision::Triangle > &triangles );
+
+      /// The number of triangles in the parts that have their bit set in
+      /// part_mask.
+      unsigned int nrTriangles( unsigned int part_mask ) const;
+
+      /// Get the number of vertices in the mesh.
+      inline unsigned int nrVertices() const {
+        return (unsigned int)vertex_data.size() / components_per_vertex;
+      }
+
+      /// Interleaved vertex data.
+      vector< GLfloat > vertex_data;
+
+      /// Triangle indices into vertex_data.
+      vector< GLuint > index_data;
+
+      /// The parts of the mesh.
+      vector< Part > parts;
+
+    protected:
+      friend class PrimitiveMeshCache;
+
+      /// Update the max and min index of the last part.
+      void updateLastPart();
+
+      /// The triangles of the mesh. Built the first time they are needed.
+      vector< HAPI::Collision::Triangle > triangles;
+
+      /// The ids of the vertex buffer objects for vertex_data and
+      /// index_data.
+      GLuint vbo_id[2];
+
+      /// True if vbo_id contains valid buffers.
+      bool vbo_initialized;
+
+      /// The number of references to the mesh.
+      int use_count;
+
+      /// The key of the mesh in the cache.
+      Key key;
+    };
+
+    /// Function used to tessellate a primitive into a Mesh.
+    typedef void (*BuildMeshFunc)( const vector< H3DFloat > &params,
+                                   Mesh &mesh );
+
+    /// Get the mesh for the given primitive type and parameters. If no
+    /// such mesh exists in the cache it is created using build_func.
+    /// The returned mesh must be released with releaseMesh().
+    static Mesh *getMesh( const string &type,
+                          const vector< H3DFloat > &params,
+                          BuildMeshFunc build_func );
+
+    /// Release a mesh returned by getMesh(). The mesh is removed from
+    /// the cache when no references to it remain.
+    static void releaseMesh( Mesh *mesh );
+
+    /// The number of distinct meshes currently in the cache.
+    static unsigned int nrMeshes();
+
+    /// Returns true if the given geometry should render cached meshes
+    /// with vertex buffer objects according to the GraphicsOptions in
+    /// use for it.
+    static bool usingVertexBufferObjects( X3DGeometryNode *geometry );
+
+  protected:
+    /// Delete the buffers of meshes that have been removed from the
+    /// cache. Must be called with an OpenGL context active.
+    static void deleteReleasedBuffers();
+
+    typedef std::map< Key, Mesh * > MeshDatabase;
+
+    /// All meshes currently in use.
+    static MeshDatabase mesh_database;
+
+    /// Vertex buffer objects from released meshes waiting to be deleted.
+    /// They can only be deleted when an OpenGL context is active, which
+    /// is not always the case when a mesh is released.
+    static vector< GLuint > released_buffers;
+
+    /// Lock for mesh_database and released_buffers. Meshes can be
+    /// released from the haptics thread when geometries are deleted there.
+    static H3DUtil::MutexLock database_lock;
+  };
+}
+
+#endif
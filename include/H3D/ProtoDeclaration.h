@@ -98,12 +98,14 @@ namespace H3D {
     /// Set the string with the internal scenegraph of the prototype.
     void setProtoBody( const string &_body ) {
       body = _body;
+      clearTemplate();
     }
 
     /// Add one part of proto body that is not the main proto
     /// body(i.e. not the first )
     void addProtoBodyExtra( const string &_body ) {
       body_extra.push_back( _body );
+      clearTemplate();
     }
     
     /// Get the proto body extras.
@@ -150,6 +152,7 @@ namespace H3D {
           // No need to add field declaration. Just indicate that it is no
           // longer defined in external proto.
           field_declaration->external = false;
+          clearTemplate();
           return error_message;
         } else {
           return "\"field\" element with name " + _name
@@ -157,6 +160,7 @@ namespace H3D {
         }
       }
       field_declarations.push_back( FieldDeclaration(_name, type, access_type, value ) );
+      clearTemplate();
       return "";
     }
 
@@ -172,6 +176,11 @@ namespace H3D {
       return NULL;
     }
 
+    /// Get all field declarations of the prototype.
+    const std::list< FieldDeclaration > &getFieldDeclarations() {
+      return field_declarations;
+    }
+
     /// Call this to set the external property for all contained field
     /// declarations. The external property should be set if this proto
     /// was created in an ExternalProto and the property is used to know
@@ -184,8 +193,48 @@ namespace H3D {
     }
     
     /// Create a new X3DPrototypeInstance instance using the ProtoDeclaration.
+    /// The first time the proto body is parsed into a template instance.
+    /// If all nodes in it can be cloned, later instances are clones of the
+    /// template with its IS connections and ROUTEs set up again, otherwise
+    /// the proto body is parsed for each instance.
     X3DPrototypeInstance *newProtoInstance();
   protected:
+    /// An IS connection between a field of the prototype and a field of
+    /// a node in the template.
+    struct ISConnection {
+      string proto_field;
+      Node *node;
+      string node_field;
+    };
+
+    /// A ROUTE between fields of two nodes in the template.
+    struct BodyRoute {
+      Node *from_node;
+      string from_field;
+      Node *to_node;
+      string to_field;
+    };
+
+    /// Set the fields of proto and parse the proto body into it. Returns
+    /// NULL and deletes proto if it fails.
+    PrototypeInstance *parseProtoInstance( PrototypeInstance *proto );
+
+    /// Parse the proto body and keep it as template_instance if it can be
+    /// cloned. Returns NULL if it is kept, otherwise the parsed instance.
+    PrototypeInstance *createTemplate();
+
+    /// Create a new instance by cloning template_instance.
+    X3DPrototypeInstance *cloneTemplate();
+
+    /// Remove the template, e.g. when the declaration has changed.
+    void clearTemplate() {
+      template_instance.reset( NULL );
+      template_connections.clear();
+      template_routes.clear();
+      template_created = false;
+    }
+
+
     string name;
     // The main body string, i.e. the first node in the proto body.
     string body;
@@ -199,6 +248,19 @@ namespace H3D {
     // created.
     X3D::PrototypeVector *existing_protos;
 
+    /// The instance that new instances are cloned from, NULL if the proto
+    /// body can not be cloned.
+    AutoRef< PrototypeInstance > template_instance;
+
+    /// True if createTemplate() has been called.
+    bool template_created;
+
+    /// The IS connections of template_instance.
+    vector< ISConnection > template_connections;
+
+    /// The ROUTEs between the nodes of template_instance.
+    vector< BodyRoute > template_routes;
+
     AutoRef< Node > createProtoInstanceNodeX3D( PrototypeInstance *proto,
                                                 X3D::DEFNodes *dn,
                                                 const string &body_string );
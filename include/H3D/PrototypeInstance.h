@@ -66,8 +66,22 @@ namespace H3D {
     ///
     virtual Node* clone ( bool deepCopy= true, DeepCopyMap *deepCopyMap= NULL );
 
+    /// Set the name of the ProtoDeclaration this is an instance of.
+    void setProtoName( const string &_proto_name ) {
+      proto_name = _proto_name;
+    }
+
+    /// Get the name of the ProtoDeclaration this is an instance of. Empty
+    /// if it was not created by ProtoDeclaration::newProtoInstance().
+    const string &getProtoName() {
+      return proto_name;
+    }
+
     /// The H3DNodeDatabase for this node.
     static H3DNodeDatabase database;
+
+  protected:
+    string proto_name;
   };
 }
 
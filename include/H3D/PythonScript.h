@@ -65,6 +65,12 @@ namespace H3D {
       else
         return lookupField( _name );
     }
+
+    virtual Field * getField( unsigned int field_id ) const {
+      Field *f = H3DScriptNode::getField( field_id );
+      if( f ) return f;
+      return getField( H3DNodeDatabase::getFieldName( field_id ) );
+    }
     
      /// Destructor.
     ~PythonScript();
@@ -81,7 +81,8 @@ namespace H3D {
                     Inst< SFVec3f  > _pixelSize = 0 );
 
     /// Loads the image from the url and returns a PixelImage with the data
-    /// loaded from the file/
+    /// loaded from the file. Uncompressed files are not read but mapped
+    /// into memory and a MappedImage is returned.
     virtual Image *loadImage( const string &url );
 
     /// TODO: Implement 
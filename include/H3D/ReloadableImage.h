@@ -0,0 +1,177 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file ReloadableImage.h
+/// \brief Header file for ReloadableImage, an image whose pixel data can
+/// be released and loaded again when needed.
+///
+//
+//////////////////////////////////////////////////////////////////////////////
+#ifndef __RELOADABLEIMAGE_H__
+#define __RELOADABLEIMAGE_H__
+
+#include <H3D/H3DApi.h>
+#include <H3DUtil/Image.h>
+#include <H3DUtil/AutoRef.h>
+#include <H3DUtil/Threads.h>
+
+namespace H3D {
+
+  /// \class ReloadableImage
+  /// \brief An Image that keeps the dimensions and pixel format of another
+  /// image but can release its pixel data to save memory.
+  ///
+  /// Texture nodes replace their image with a ReloadableImage and release
+  /// the pixel data once it has been installed as a texture, see
+  /// GraphicsOptions::releaseImagesAfterUpload. The first call to
+  /// getImageData() after that loads the data again with the reload
+  /// function, e.g. by reading it back from the texture or decoding the
+  /// url again, and the data is kept from then on.
+  ///
+  /// Data is only released in the main thread. Once getImageData() has
+  /// been called in another thread the data is never released again,
+  /// since the caller may keep using it.
+  ///
+  /// Memory is only saved if the wrapped image is not referenced
+  /// elsewhere. Images loaded by ImageLoadPool are given to all textures
+  /// with the same url, so their data is only freed when all of them
+  /// have released it.
+  class H3DAPI_API ReloadableImage : public Image {
+  public:
+    /// Function returning a new image with the same dimensions and pixel
+    /// format as image, or NULL if it could not be loaded. The data of
+    /// image itself must not be used.
+    typedef Image * (*ReloadFunc)( Image *image, void *data );
+
+    /// Constructor. The image is wrapped and its data kept until
+    /// releaseData() is called. If main_thread_only is true the reload
+    /// function uses OpenGL and can only be called in the main thread.
+    ReloadableImage( Image *image,
+                     ReloadFunc reload_func,
+                     void *reload_data,
+                     bool main_thread_only );
+
+    /// Destructor.
+    virtual ~ReloadableImage();
+
+    /// Returns the width of the image in pixels.
+    virtual unsigned int width() { return image_width; }
+
+    /// Returns the height of the image in pixels.
+    virtual unsigned int height() { return image_height; }
+
+    /// Returns the depth of the image in pixels.
+    virtual unsigned int depth() { return image_depth; }
+
+    /// Returns the number of bits used for each pixel in the image.
+    virtual unsigned int bitsPerPixel() { return bits_per_pixel; }
+
+    /// Returns the size of a pixel in metres.
+    virtual Vec3f pixelSize() { return pixel_size; }
+
+    /// Returns the pixel type of the image.
+    virtual Image::PixelType pixelType() { return pixel_type; }
+
+    /// Returns the pixel component type of the image.
+    virtual Image::PixelComponentType pixelComponentType() {
+      return pixel_component_type;
+    }
+
+    /// Returns the pixel data, loading it first if it has been released.
+    /// Returns NULL if it could not be loaded.
+    virtual void *getImageData();
+
+    /// Release the pixel data. Must be called in the main thread.
+    /// Returns false if the image does not hold any data, the data can
+    /// not be loaded again, keepLoaded() has been called for the image or
+    /// the data has been used in another thread.
+    bool releaseData();
+
+    /// Load the pixel data if it has been released. Returns true if the
+    /// image holds its data afterwards.
+    bool loadData();
+
+    /// Returns true if the image holds its pixel data.
+    bool isLoaded();
+
+    /// Returns true if the reload function uses OpenGL.
+    bool isMainThreadOnly() { return main_thread_only; }
+
+    /// Remove the reload function, e.g. when the node it uses is
+    /// destroyed. Released data can not be loaded after this.
+    void detach();
+
+    /// Returns true if the data of the image can be released by wrapping
+    /// it in a ReloadableImage, i.e. if it is an uncompressed image with
+    /// rows that do not need any padding and not a ReloadableImage or
+    /// MappedImage.
+    static bool canWrap( Image *image );
+
+    /// Load the data of the image if it is a ReloadableImage that has
+    /// released it and never release it again. Should be called in the
+    /// main thread before an image is given to the haptics thread, which
+    /// must not wait for the data to be loaded.
+    static void keepLoaded( Image *image );
+
+    /// Returns the number of bytes of pixel data currently released by
+    /// all ReloadableImage instances.
+    static size_t getReleasedBytes();
+
+  protected:
+    /// Load the data. The lock must be held.
+    bool loadDataLocked();
+
+    /// The size of the pixel data in bytes.
+    size_t dataSize();
+
+    unsigned int image_width;
+    unsigned int image_height;
+    unsigned int image_depth;
+    unsigned int bits_per_pixel;
+    Vec3f pixel_size;
+    Image::PixelType pixel_type;
+    Image::PixelComponentType pixel_component_type;
+
+    /// The image holding the data, NULL if released.
+    AutoRef< Image > data;
+
+    ReloadFunc reload_func;
+    void *reload_data;
+    bool main_thread_only;
+
+    /// If true the data is never released, see keepLoaded().
+    bool keep_loaded;
+
+    /// Lock for data and reload_func, since readers in other threads
+    /// may load the data.
+    H3DUtil::MutexLock lock;
+
+    /// The number of bytes released by all instances.
+    static size_t released_bytes;
+
+    /// Lock for released_bytes.
+    static H3DUtil::MutexLock released_bytes_lock;
+  };
+}
+
+#endif
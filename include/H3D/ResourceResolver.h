@@ -33,6 +33,7 @@
 #include <H3D/H3DApi.h>
 #include <string>
 #include <list>
+#include <vector>
 #include <H3D/URNResolver.h>
 #include <H3DUtil/AutoPtrVector.h>
 #include <memory>
@@ -87,15 +88,12 @@ namespace H3D {
     }
 
     /// Set the current base URL. The base URL will be used as the base
-    /// when the url to resolve is a relative url.
-    static void setBaseURL( const string &base ) {
-      baseURL = base;
-    }
+    /// when the url to resolve is a relative url. Each thread has its own
+    /// base URL so that urls can be resolved in several threads at once.
+    static void setBaseURL( const string &base );
 
-    /// Get the current base URL,
-    static const string & getBaseURL() {
-      return baseURL;
-    }
+    /// Get the current base URL of the calling thread.
+    static const string & getBaseURL();
 
     /// Returns a local filename that contains the resource specified
     /// by urn. The boolean pointed to by the is_tmp_file argument 
@@ -123,6 +121,11 @@ namespace H3D {
       return resolveURLAs(urn,NULL,false,true);
     }
 
+    /// Returns the name of the local file specified by urn, or an empty
+    /// string if it is not a local file. No resource resolvers are used,
+    /// so the file can be read directly, e.g. memory mapped.
+    static string resolveURLAsLocalFile( const string &urn );
+
     /// Returns a new unique filename that can be used to create a temporary
     /// file. The filename should be released as soon as it is not needed
     /// any more with the releaseTmpFileName function. 
@@ -133,7 +136,31 @@ namespace H3D {
     /// getTmpFileName function. 
     static bool releaseTmpFileName( const string &file );
 
+    /// Start recording the names of the local files that urls are resolved
+    /// to by the calling thread. Recordings can be nested, a resolved file
+    /// is added to all recordings that are active in the thread.
+    static void beginDependencyRecording();
+
+    /// Stop the recording started last by the calling thread and add the
+    /// names of the files recorded to files. Returns false if any url was
+    /// resolved by a ResourceResolver during the recording, e.g. from a
+    /// zip file or the web, i.e. if the files found are not all the
+    /// resources used.
+    static bool endDependencyRecording( vector< string > &files );
+
+    /// Add a file to the recordings that are active in the calling thread,
+    /// e.g. the dependencies of a file that is not resolved again since
+    /// it has been cached.
+    static void addDependency( const string &file );
+
   protected:
+    /// Add a resolved url to the active recordings of the calling thread.
+    /// \param file The local file name, or the empty string if the url was
+    /// not resolved to a local file.
+    /// \param local True if the url was resolved without any
+    /// ResourceResolver.
+    static void recordDependency( const string &file, bool local );
+
     
     /// Returns a string containing the contents of the url resource
     ///
@@ -167,6 +194,7 @@ namespace H3D {
       return resolvers;
     }
     
+    /// The base URL of the main thread.
     static string baseURL;
     static TmpFileNameList tmp_files;
   };
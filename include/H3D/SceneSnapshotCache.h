@@ -0,0 +1,107 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file SceneSnapshotCache.h
+/// \brief Header file for SceneSnapshotCache, storing parsed scene files
+/// in the binary encoding to avoid parsing them again.
+///
+//
+//////////////////////////////////////////////////////////////////////////////
+#ifndef __SCENESNAPSHOTCACHE_H__
+#define __SCENESNAPSHOTCACHE_H__
+
+#include <H3D/H3DApi.h>
+#include <H3D/Node.h>
+#include <H3D/DEFNodes.h>
+#include <H3D/PrototypeVector.h>
+#include <H3DUtil/AutoRef.h>
+
+#include <vector>
+
+namespace H3D {
+
+  /// \class SceneSnapshotCache
+  /// \brief A cache of the node graphs created from scene files, stored on
+  /// disk in the binary encoding of X3DBinary.h.
+  ///
+  /// When enabled by setting a cache directory, X3D::createX3DFromURL
+  /// stores a snapshot of the nodes, DEF names, ROUTEs and PROTO
+  /// declarations created from a local file. The next time the same file
+  /// is loaded the nodes are created from the snapshot instead, without
+  /// parsing XML or VRML.
+  ///
+  /// A snapshot contains the content hash of the file and of every other
+  /// local file resolved while parsing it, e.g. EXTERNPROTO files, see
+  /// ResourceResolver::beginDependencyRecording. It is only used if none
+  /// of them have changed. Files resolved by a ResourceResolver, e.g. from
+  /// zip files or the web, and files with IMPORT or EXPORT statements are
+  /// not stored. Neither are scenes with script nodes, since the scripts
+  /// run when the scene is created and would change it a second time, or
+  /// scenes with ROUTEs the binary encoding cannot store. The scenes of
+  /// Inline nodes are loaded when the Inline is used and are stored as
+  /// snapshots of their own.
+  class H3DAPI_API SceneSnapshotCache {
+  public:
+    /// Set the directory to store snapshots in. The directory must exist.
+    /// An empty string disables the cache, which is the default.
+    static void setCacheDirectory( const string &dir );
+
+    /// Get the directory snapshots are stored in, an empty string if the
+    /// cache is disabled.
+    static const string &getCacheDirectory() {
+      return cache_directory;
+    }
+
+    /// Create the nodes from the snapshot of a file if there is one and
+    /// none of the files it depends on have changed. The files are added
+    /// to the active dependency recordings of ResourceResolver.
+    /// \param file The local file the snapshot was made from.
+    /// \param node Set to the node created.
+    /// \param dn A DEFNodes structure to store the DEF nodes in.
+    /// \param prototypes A vector to add the PROTO declarations to.
+    /// \return True if the nodes were created from a snapshot.
+    static bool loadSnapshot( const string &file,
+                              AutoRef< Node > &node,
+                              X3D::DEFNodes *dn = NULL,
+                              X3D::PrototypeVector *prototypes = NULL );
+
+    /// Store a snapshot of the nodes created from a file.
+    /// \param file The local file the nodes were created from.
+    /// \param node The node to store.
+    /// \param prototypes The PROTO declarations created from the file.
+    /// \param dependencies The local files resolved when parsing the file.
+    static void saveSnapshot( const string &file,
+                              Node *node,
+                              X3D::PrototypeVector *prototypes,
+                              const std::vector< string > &dependencies );
+
+  protected:
+    /// The name of the file the snapshot of the given file is stored in.
+    static string getSnapshotFileName( const string &file );
+
+    /// The directory snapshots are stored in.
+    static string cache_directory;
+  };
+}
+
+#endif
@@ -84,15 +84,98 @@ namespace H3D {
     bool H3DAPI_API setCGUniformVariableValue( CGprogram program_handle,
                                                Field *field );
 #endif
+    class UniformBlockBuffer;
+
     // struct contains the uniform value changed tag and GLSL uniform location
     struct UniformInfo 
     {
       Field* field;   // associated field for the uniform
       // uniform field location in shader program, need update after re-link
       GLint location; 
+      // the uniform buffer the value is packed into, NULL if the value
+      // is set with glUniform
+      UniformBlockBuffer *block;
     };
+
+    /// A uniform buffer object holding the values of the members of a
+    /// uniform block in a GLSL program. Field values are written to a
+    /// copy in CPU memory and the buffer is updated in one call when it
+    /// is rendered. The layout of the block is queried from the program
+    /// so any layout qualifier can be used.
+    class H3DAPI_API UniformBlockBuffer {
+    public:
+      /// Constructor. Creates a buffer for the uniform block with the
+      /// given index in the program and assigns it the given binding
+      /// point.
+      UniformBlockBuffer( GLhandleARB program_handle,
+                          GLuint block_index,
+                          GLuint _binding );
+
+      /// Destructor.
+      ~UniformBlockBuffer();
+
+      /// Returns true if the block has a member with the given name.
+      /// The names of array members are given without "[0]".
+      inline bool hasMember( const string &name ) {
+        return members.find( name ) != members.end();
+      }
+
+      /// Write the value of a field to the member with the same name.
+      /// Returns false if the member does not exist or its type does
+      /// not match the field type.
+      bool setValue( const string &name, Field *field );
+
+      /// Bind the buffer to its binding point, updating its content if
+      /// any value has changed.
+      void render();
+
+    protected:
+      /// The layout of a block member.
+      struct Member {
+        GLint offset;
+        GLenum type;
+        GLint array_size;
+        GLint array_stride;
+        GLint matrix_stride;
+        GLint row_major;
+      };
+
+      /// The members of the block by name.
+      std::map< string, Member > members;
+
+      /// The content of the buffer.
+      vector< unsigned char > data;
+
+      /// The OpenGL buffer object.
+      GLuint buffer_id;
+
+      /// The binding point of the block.
+      GLuint binding;
+
+      /// True if data has changed since it was last sent to the buffer.
+      bool dirty;
+    };
+
+    /// Returns the location of the uniform variable with the given name
+    /// in a GLSL program. Locations are cached per program until
+    /// clearUniformCache() is called for it.
+    GLint H3DAPI_API getUniformLocation( GLhandleARB program_handle,
+                                         const string &name );
+
+    /// Remove the cached uniform locations and values of a GLSL program.
+    /// Must be called when the program is linked again or deleted.
+    void H3DAPI_API clearUniformCache( GLhandleARB program_handle );
+
+    /// Mark the cached values of all uniforms as unknown, so that the next
+    /// call to setGLSLUniformVariableValue() for each uniform sends its
+    /// value. Must be called when uniforms may have been set without
+    /// setGLSLUniformVariableValue(), e.g. by calling a display list.
+    void H3DAPI_API invalidateUniformValues();
+
     /// Set the value of a uniform variable in the given GLSL shader.
     /// The name of the uniform variable is the same as the name of the field. 
+    /// The value is only sent to OpenGL if it differs from the value last
+    /// set for the uniform in the program.
     ///
     /// \param force If true, then the uniform value is always set even if the field
     ///              value has not changed.
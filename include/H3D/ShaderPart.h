@@ -91,6 +91,9 @@ namespace H3D {
                 Inst< SFString       > _type          = 0,
                 Inst< SFShaderString > _shader_string = 0,
                 Inst< SFBool         > _forceReload   = 0);
+
+    /// Destructor.
+    virtual ~ShaderPart();
     
     /// Compile the shader using the shader_string field as text input.
     /// Returns a handle to the compiled shader or 0 if compiling 
@@ -103,6 +106,35 @@ namespace H3D {
       return shader_handle;
     }
 
+    /// If share is true, the compiled shader object is shared with all
+    /// other ShaderPart nodes that share their shader objects and have
+    /// the same type and shader source, so the source is only compiled
+    /// once. Used by H3DGeneratedShaderNode, where many nodes often
+    /// generate the same source.
+    inline void setShareCompiledShader( bool share ) {
+      share_compiled_shader = share;
+    }
+
+    /// Returns true if the shader is being compiled asynchronously and
+    /// the result is not available yet. When the compilation has finished
+    /// the result is checked, so the handle of the shader is 0 after this
+    /// function has returned false if compiling failed.
+    virtual bool isCompilePending();
+
+    /// Returns the time in seconds it took to compile the shader last
+    /// time it was compiled. 0 if a compiled shader of another node was
+    /// used. For asynchronous compilation it is the time until the
+    /// finished compilation was detected.
+    inline H3DTime getCompileTime() {
+      return compile_time;
+    }
+
+    /// Returns true if shaders should be compiled and linked
+    /// asynchronously, i.e. if GraphicsOptions::asyncShaderCompilation
+    /// is true and GL_ARB_parallel_shader_compile or
+    /// GL_KHR_parallel_shader_compile is supported.
+    static bool asyncCompilation();
+
     /// Returns true if the shader part is compiled and up to date. False
     /// if compilation is required.
     virtual bool isCompiled ();
@@ -152,6 +184,43 @@ namespace H3D {
     GLhandleARB shader_handle;
     GLhandleARB compileShaderPart();
 
+    /// Check the result of compiling shader_handle and print the shader
+    /// log if needed. Returns shader_handle, which is 0 if compiling failed.
+    GLhandleARB finishCompile();
+
+    /// Release shader_handle, deleting the shader object unless it is
+    /// still used by other ShaderPart nodes.
+    void releaseShaderHandle();
+
+    /// A compiled shader object shared between ShaderPart nodes.
+    struct SharedShader {
+      SharedShader() : handle( 0 ), nr_users( 0 ) {}
+      GLhandleARB handle;
+      unsigned int nr_users;
+    };
+
+    /// The shared compiled shader objects, by shader type and source.
+    static map< string, SharedShader > shared_shaders;
+
+    /// True if the compiled shader object can be shared.
+    bool share_compiled_shader;
+
+    /// The shader sources that are being compiled asynchronously by a
+    /// node that shares its compiled shader, by shader type and source.
+    static map< string, ShaderPart * > compiling_shaders;
+
+    /// The key in shared_shaders of shader_handle, "" if not shared.
+    string shared_shader_key;
+
+    /// True if the result of compiling has not been checked yet.
+    bool compile_pending;
+
+    /// The time the last compilation was started.
+    TimeStamp compile_start;
+
+    /// The time it took to compile the shader.
+    H3DTime compile_time;
+
     /// Given the URL of a shader source, return the source code, or "" on failure
     std::string shaderStringFromURL ( const std::string& shader_url );
 
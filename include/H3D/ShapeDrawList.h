@@ -0,0 +1,163 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file ShapeDrawList.h
+/// \brief Header file for ShapeDrawList, a list of shapes sorted by render
+/// state before rendering.
+///
+//
+//////////////////////////////////////////////////////////////////////////////
+#ifndef __SHAPEDRAWLIST_H__
+#define __SHAPEDRAWLIST_H__
+
+#include <H3D/H3DApi.h>
+#include <H3D/X3DTypes.h>
+#include <GL/glew.h>
+
+namespace H3D {
+
+  class X3DShapeNode;
+  class X3DAppearanceNode;
+
+  /// \class ShapeDrawList
+  /// \brief A list of shapes that are rendered sorted by render state
+  /// instead of in scene graph order.
+  ///
+  /// Used by X3DGroupingNode when GraphicsOptions::sortShapes is true.
+  /// Opaque shapes are sorted by a 64 bit state key built from the
+  /// shader, texture, material and appearance in use, so that shapes
+  /// sharing state are rendered after each other. Consecutive shapes
+  /// with the same appearance node only set up the appearance once.
+  /// Transparent shapes are rendered after the opaque ones, sorted back
+  /// to front.
+  ///
+  /// The class also keeps statistics of the number of appearance and
+  /// state changes made when rendering shapes in the current and last
+  /// frame. Shapes rendered from cached display lists are not counted.
+  class H3DAPI_API ShapeDrawList {
+  public:
+    /// Number of state changes made when rendering shapes.
+    struct H3DAPI_API Statistics {
+      Statistics() { reset(); }
+
+      /// Set all counters to 0.
+      void reset() {
+        nr_shapes = 0;
+        nr_appearance_changes = 0;
+        nr_shader_changes = 0;
+        nr_texture_changes = 0;
+        nr_material_changes = 0;
+      }
+
+      /// The number of shapes rendered.
+      unsigned int nr_shapes;
+      /// The number of times an appearance was set up.
+      unsigned int nr_appearance_changes;
+      /// The number of appearance set ups that changed shader.
+      unsigned int nr_shader_changes;
+      /// The number of appearance set ups that changed texture.
+      unsigned int nr_texture_changes;
+      /// The number of appearance set ups that changed material.
+      unsigned int nr_material_changes;
+    };
+
+    /// Remove all shapes from the list.
+    void clear();
+
+    /// Add a shape to the list. If matrix is not NULL it is the
+    /// transformation of the shape relative to the current model view
+    /// matrix when render() is called.
+    void add( X3DShapeNode *shape, const Matrix4f *matrix = NULL );
+
+    /// Returns true if no shapes are in the list.
+    inline bool empty() {
+      return opaque.empty() && transparent.empty();
+    }
+
+    /// Sort the shapes and render them. Must be called with the same
+    /// model view matrix as the shapes were added for, since it is used
+    /// to sort transparent shapes back to front.
+    void render();
+
+    /// Get the state key for an appearance. The highest 16 bits identify
+    /// the shader, followed by the texture, the material and the
+    /// appearance itself. Different appearances can get the same key so
+    /// the key is only to be used for sorting.
+    static GLuint64 getStateKey( X3DAppearanceNode *a );
+
+    /// Count the state changes when setting up the given appearance,
+    /// compared to the appearance set up in the previous call. Called by
+    /// X3DShapeNode::preRenderAppearance().
+    static void countAppearanceChange( X3DAppearanceNode *a );
+
+    /// Start a new frame. The statistics of the current frame are moved
+    /// to last_frame and current_frame is reset.
+    static void beginFrame();
+
+    /// Statistics for the frame being rendered.
+    static Statistics current_frame;
+
+    /// Statistics for the last complete frame.
+    static Statistics last_frame;
+
+  protected:
+    /// A shape in the list.
+    struct Entry {
+      /// The shape to render.
+      X3DShapeNode *shape;
+      /// True if matrix should be multiplied with the model view matrix
+      /// when rendering the shape.
+      bool has_matrix;
+      /// The transformation of the shape in column major order.
+      GLfloat matrix[16];
+      /// The state key of the appearance of the shape.
+      GLuint64 key;
+      /// The depth of the shape in eye coordinates, used for sorting
+      /// transparent shapes.
+      H3DFloat depth;
+    };
+
+    /// Sort order for opaque shapes, by state key, appearance and
+    /// geometry.
+    static bool stateLess( const Entry &a, const Entry &b );
+
+    /// Sort order for transparent shapes, from back to front.
+    static bool depthLess( const Entry &a, const Entry &b );
+
+    /// Render the entries in order, setting up the appearance only when
+    /// it changes between entries.
+    void renderEntries( vector< Entry > &entries );
+
+    /// The opaque shapes.
+    vector< Entry > opaque;
+
+    /// The transparent shapes.
+    vector< Entry > transparent;
+
+    /// The state key of the appearance last counted by
+    /// countAppearanceChange().
+    static GLuint64 last_state_key;
+  };
+}
+
+#endif
@@ -31,6 +31,7 @@
 
 #include <H3D/X3DGeometryNode.h>
 #include <H3D/SFFloat.h>
+#include <H3D/PrimitiveMeshCache.h>
 
 namespace H3D {
 
@@ -84,6 +85,9 @@ namespace H3D {
             Inst< SFFloat>  _radius   = 0,
             Inst< SFBool >  _solid    = 0 );
 
+    /// Destructor.
+    ~Sphere();
+
     /// The number of triangles renderered in this geometry.
     virtual int nrTriangles() {
       return 2500;//50 * 25 * 2;
@@ -96,6 +100,14 @@ namespace H3D {
     /// Renders the Sphere with OpenGL.
     virtual void render();
 
+    /// Get the triangles of the Sphere from the shared unit sphere mesh.
+    virtual bool getTriangles( vector< HAPI::Collision::Triangle > &triangles );
+
+    /// Render instances of the Sphere. Since the radius cannot be
+    /// applied as a scaling before the instance matrix a mesh with the
+    /// radius of this Sphere is used.
+    virtual bool renderInstanced( GLsizei nr_instances );
+
     /// Traverse the scenegraph. Adds a HapticSphere if haptics is enabled.
     virtual void traverseSG( TraverseInfo &ti );
 
@@ -152,19 +164,22 @@ namespace H3D {
     static H3DNodeDatabase database;
 
   protected:
-    // Internal variable used to store id for Sphere vbo.
-    // glDeleteBuffersARB is never called for the allocated buffer. The reason
-    // for this is that it is impossible to know when the OpenGL context is
-    // destroyed and glDeleteBuffersARB should be called before that occurrs.
-    // It is therefore assumed that the memory is cleaned up when the OpenGL
-    // context is removed.
-    static GLuint vbo_id[2];
-    // Internal variable used to indicate if vbo_id contains valid ids.
-    // Can not use -1 because vbo_id is an GLuint.
-    static bool vbo_initialized;
-
-    static vector< GLfloat > sphere_data;
-    static vector< GLuint > sphere_index_data;
+    /// Get the unit sphere mesh shared by all Sphere nodes. The radius
+    /// is applied as a scaling when rendering.
+    PrimitiveMeshCache::Mesh *getMesh();
+
+    /// Get the mesh used by renderInstanced(), which has the radius of
+    /// this Sphere applied to the vertices.
+    PrimitiveMeshCache::Mesh *getInstancedMesh();
+
+    // The mesh currently used by this node.
+    PrimitiveMeshCache::Mesh *mesh;
+
+    // The mesh used by renderInstanced(), NULL until first used.
+    PrimitiveMeshCache::Mesh *instanced_mesh;
+
+    // The radius instanced_mesh was built with.
+    H3DFloat instanced_mesh_radius;
   };
 }
 
@@ -0,0 +1,127 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file TextureMemoryManager.h
+/// \brief Header file for TextureMemoryManager, keeping the graphics card
+/// memory used by textures within a budget.
+///
+//
+//////////////////////////////////////////////////////////////////////////////
+#ifndef __TEXTUREMEMORYMANAGER_H__
+#define __TEXTUREMEMORYMANAGER_H__
+
+#include <H3D/H3DApi.h>
+#include <H3DUtil/Image.h>
+
+#include <map>
+
+namespace H3D {
+
+  class H3DSingleTextureNode;
+
+  /// \class TextureMemoryManager
+  /// \brief Keeps track of the size and last use of every installed
+  /// texture and removes the least recently used textures from the
+  /// graphics card when they use more memory than
+  /// GraphicsOptions::textureMemoryBudget.
+  ///
+  /// The textures of X3DTexture2DNode and X3DTexture3DNode nodes are
+  /// tracked, since they can be installed again from their image. A
+  /// texture is used in a frame if it is traversed or rendered in it.
+  /// Textures used in the current frame are never removed. A removed
+  /// texture is installed again the next time it is rendered.
+  class H3DAPI_API TextureMemoryManager {
+  public:
+    /// The current texture memory usage and the number of textures
+    /// removed and installed again.
+    struct H3DAPI_API Statistics {
+      Statistics() : nr_textures( 0 ), nr_bytes( 0 ) { reset(); }
+
+      /// Set the per frame counters to 0.
+      void reset() {
+        nr_evicted = 0;
+        nr_reinstalled = 0;
+      }
+
+      /// The number of installed textures.
+      unsigned int nr_textures;
+      /// The estimated number of bytes used by installed textures.
+      size_t nr_bytes;
+      /// The number of textures removed in the frame.
+      unsigned int nr_evicted;
+      /// The number of removed textures installed again in the frame.
+      unsigned int nr_reinstalled;
+    };
+
+    /// Called when a texture has been installed with the estimated size
+    /// of it in bytes.
+    static void textureInstalled( H3DSingleTextureNode *texture,
+                                  size_t nr_bytes );
+
+    /// Called when the texture of a node has been removed, or the node is
+    /// destroyed.
+    static void textureRemoved( H3DSingleTextureNode *texture );
+
+    /// Called when a texture is used in the current frame.
+    static void textureUsed( H3DSingleTextureNode *texture );
+
+    /// Remove least recently used textures until the installed textures
+    /// are within GraphicsOptions::textureMemoryBudget. Called by
+    /// H3DWindowNode at the start of rendering.
+    static void evictTextures();
+
+    /// Start a new frame.
+    static void beginFrame();
+
+    /// The estimated number of bytes used by a texture of the image.
+    static size_t estimateByteSize( Image *image, bool mipmaps );
+
+    /// Statistics for the frame being rendered.
+    static Statistics current_frame;
+
+    /// Statistics for the last complete frame.
+    static Statistics last_frame;
+
+  protected:
+    /// Information about a texture.
+    struct TextureInfo {
+      TextureInfo() : nr_bytes( 0 ), last_used_frame( 0 ), evicted( false ) {}
+
+      /// The estimated size, 0 if not installed.
+      size_t nr_bytes;
+      /// The last frame the texture was used in.
+      unsigned int last_used_frame;
+      /// True if the texture was removed by evictTextures() and has not
+      /// been installed since.
+      bool evicted;
+    };
+
+    /// Information about all textures that have been installed.
+    static std::map< H3DSingleTextureNode *, TextureInfo > textures;
+
+    /// The current frame number.
+    static unsigned int frame;
+  };
+}
+
+#endif
@@ -213,7 +213,8 @@ namespace H3D {
                        Inst< SFString > _textureCompareMode = 0,
                        Inst< SFFloat  > _textureCompareFailValue = 0,
                        Inst< SFString > _textureType        = 0,
-                       Inst< SFString > _textureFormat      = 0 );
+                       Inst< SFString > _textureFormat      = 0,
+                       Inst< SFString > _releaseImage       = 0 );
 
     /// Returns the default xml containerField attribute value.
     /// For this node it is "textureProperties".
@@ -459,6 +460,24 @@ namespace H3D {
     /// \dotfile TextureProperties_textureFormat.dot
     auto_ptr< SFString > textureFormat;
 
+    /// The releaseImage field specifies if the pixel data of the image of
+    /// the texture is released once it has been installed as a texture,
+    /// see GraphicsOptions::releaseImagesAfterUpload.
+    /// 
+    /// <table>
+    /// <tr><td>"DEFAULT"</td><td>Use the releaseImagesAfterUpload field of
+    /// GraphicsOptions.</td></tr>
+    /// <tr><td>"RELEASE"</td><td>Release the pixel data.</td></tr>
+    /// <tr><td>"KEEP"</td><td>Keep the pixel data.</td></tr>
+    /// </table>
+    ///
+    /// <b>Access type:</b> inputOutput \n
+    /// <b>Valid values:</b> "DEFAULT", "RELEASE", "KEEP" \n
+    /// <b>Default value:</b> "DEFAULT" \n
+    ///
+    /// \dotfile TextureProperties_releaseImage.dot
+    auto_ptr< SFString > releaseImage;
+
     /// Function that returns true if internal_format input is set.
     virtual bool glInternalFormat( Image *image, GLint &internal_format );
 
@@ -0,0 +1,173 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file TextureUploadManager.h
+/// \brief Header file for TextureUploadManager, uploading texture images
+/// in slices over several frames.
+///
+//
+//////////////////////////////////////////////////////////////////////////////
+#ifndef __TEXTUREUPLOADMANAGER_H__
+#define __TEXTUREUPLOADMANAGER_H__
+
+#include <H3D/H3DApi.h>
+#include <H3D/X3DTypes.h>
+#include <H3DUtil/Image.h>
+#include <H3DUtil/AutoRef.h>
+#include <GL/glew.h>
+
+#include <list>
+
+namespace H3D {
+
+  /// \class TextureUploadManager
+  /// \brief Uploads texture images in slices of rows so that a large image
+  /// does not stall the frame it becomes available in.
+  ///
+  /// If GraphicsOptions::asyncTextureUpload is true, X3DTexture2DNode
+  /// allocates the texture and queues the image here instead of uploading
+  /// it directly. The queued images are uploaded at the start of each
+  /// window render until GraphicsOptions::textureUploadBudget bytes or
+  /// GraphicsOptions::textureUploadTimeBudget seconds have been used
+  /// in the frame. The rows are staged in a pixel buffer object if
+  /// GL_ARB_pixel_buffer_object is supported, so the transfer to the
+  /// graphics card does not block. A texture is not used until all of
+  /// it has been uploaded.
+  ///
+  /// Also scales images and generates mipmaps on the graphics card
+  /// instead of with gluScaleImage and gluBuild2DMipmaps when the
+  /// needed extensions are supported.
+  class H3DAPI_API TextureUploadManager {
+  public:
+    /// The amount of texture data uploaded.
+    struct H3DAPI_API Statistics {
+      Statistics() { reset(); }
+
+      /// Set all counters to 0.
+      void reset() {
+        nr_bytes = 0;
+        nr_slices = 0;
+        nr_completed = 0;
+        nr_pending = 0;
+      }
+
+      /// The number of bytes uploaded in slices.
+      unsigned int nr_bytes;
+      /// The number of slices uploaded.
+      unsigned int nr_slices;
+      /// The number of images that were completed.
+      unsigned int nr_completed;
+      /// The number of images left to upload at the end of the frame.
+      unsigned int nr_pending;
+    };
+
+    /// Returns true if images should be uploaded in slices, i.e. if
+    /// GraphicsOptions::asyncTextureUpload is true.
+    static bool asyncUploads();
+
+    /// Returns true if the given image can be uploaded in slices to
+    /// the given texture target.
+    static bool canUpload( Image *image, GLenum target,
+                           bool generate_mipmaps );
+
+    /// Allocate mipmap level 0 of the texture bound to the target and
+    /// queue the image to be uploaded to it. The pixel transfer scale and
+    /// bias are used when uploading if transfer is true. The texture must
+    /// not be used until isPending() returns false.
+    static void upload( GLenum target, Image *image,
+                        GLint internal_format, GLenum format, GLenum type,
+                        bool generate_mipmaps, bool transfer,
+                        const Vec4f &transfer_scale,
+                        const Vec4f &transfer_bias );
+
+    /// Returns true if the image of texture_id has not been uploaded
+    /// completely yet.
+    static bool isPending( GLuint texture_id );
+
+    /// Remove the queued upload to texture_id, if any. Must be called
+    /// before the texture is deleted.
+    static void cancel( GLuint texture_id );
+
+    /// Upload slices of the queued images until the budget of the frame
+    /// has been used. Called by H3DWindowNode at the start of rendering.
+    static void processUploads();
+
+    /// Start a new frame. The budget is reset and the statistics of the
+    /// current frame are moved to last_frame.
+    static void beginFrame();
+
+    /// Install the image in the texture bound to the target, scaled to
+    /// new_width x new_height on the graphics card. Returns false if
+    /// scaling on the graphics card is not supported for the image, in
+    /// which case nothing is done.
+    static bool scaleImage2D( GLenum target, Image *image,
+                              GLint internal_format, GLenum format,
+                              GLenum type,
+                              unsigned int new_width,
+                              unsigned int new_height );
+
+    /// Generate mipmaps for the texture bound to the target from its
+    /// level 0 on the graphics card. Returns false if not supported.
+    static bool generateMipmaps( GLenum target );
+
+    /// Statistics for the frame being rendered.
+    static Statistics current_frame;
+
+    /// Statistics for the last complete frame.
+    static Statistics last_frame;
+
+  protected:
+    /// An image being uploaded.
+    struct Upload {
+      GLuint texture_id;
+      GLenum target;
+      AutoRef< Image > image;
+      GLenum format;
+      GLenum type;
+      bool generate_mipmaps;
+      bool transfer;
+      Vec4f transfer_scale;
+      Vec4f transfer_bias;
+      /// The next row to upload.
+      unsigned int row;
+    };
+
+    /// Upload rows of upload, at most max_bytes bytes but at least one
+    /// row. Returns the number of bytes uploaded.
+    static unsigned int uploadSlice( Upload *upload, unsigned int max_bytes );
+
+    /// The queued uploads in the order they were queued.
+    static std::list< Upload * > uploads;
+
+    /// The pixel buffer object used for staging, 0 if not created.
+    static GLuint pbo;
+
+    /// The number of bytes uploaded in the current frame.
+    static unsigned int frame_bytes;
+
+    /// The time spent uploading in the current frame.
+    static H3DTime frame_time;
+  };
+}
+
+#endif
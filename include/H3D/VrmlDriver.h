@@ -110,7 +110,9 @@ public:
   // VRML specific functions:
 
   Group *getRoot() { return root.get(); }
-  void setFieldValue( const char *);
+  /// Set the field at the top of the field_stack in the node at the top
+  /// of the node_stack from the text of a field value.
+  void setFieldValue( const string &value );
   void setNodeStatement( int );
   string getLocationString();
   string getOldLocationString();
@@ -0,0 +1,147 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file X3DBinary.h
+/// \brief This file contains functions for writing H3D nodes in a compact
+/// binary encoding and creating H3D nodes from it.
+///
+/// The encoding starts with the 4 bytes "H3DB" followed by a version number.
+/// After that come a table with all node type, field and DEF names used,
+/// the PROTO declarations, the scene graph as nested node records and last
+/// the ROUTEs between the nodes. Nodes that are used more than once are
+/// written once and then referred to by index. All numbers are little
+/// endian.
+///
+/// Fields with float, double and int32 based MF types (e.g. MFVec3f,
+/// MFInt32, MFColor) are stored as raw arrays that are copied directly
+/// into the field when read. Float arrays can be quantized to 16 bits per
+/// component and arrays can be compressed with zlib. All other fields are
+/// stored as strings in the X3D field encoding.
+///
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef __X3DBINARY_H__
+#define __X3DBINARY_H__
+
+#include <iostream>
+#include <H3D/H3DApi.h>
+#include <H3D/Group.h>
+#include <H3D/DEFNodes.h>
+#include <H3DUtil/AutoRef.h>
+#include <H3D/PrototypeVector.h>
+
+namespace H3D {
+  namespace X3D {
+
+    /// Exception thrown when the binary data is not valid.
+    H3D_VALUE_EXCEPTION( string, X3DBinaryParseError );
+
+    /// Returns true if the string starts with the binary encoding header.
+    H3DAPI_API bool isX3DBinary( const string &str );
+
+    /// Returns true if the stream starts with the binary encoding header.
+    /// The characters of the header are consumed.
+    H3DAPI_API bool isX3DBinary( istream &is );
+
+    /// Create H3D nodes given binary encoded data as an istream.
+    /// \param in The input stream to read the data from.
+    /// \param dn A DEFNodes structure to store the DEF nodes found
+    /// in the stream.
+    /// \param exported_nodes Not used, the binary encoding does not store
+    /// EXPORT statements.
+    /// \param prototypes A vector to add the PROTO declarations found in
+    /// the stream to.
+    /// \return A Group containing the nodes created.
+    H3DAPI_API Group* createX3DBinaryFromStream(
+           istream &in,
+           DEFNodes *dn = NULL,
+           DEFNodes *exported_nodes = NULL,
+           PrototypeVector *prototypes = NULL );
+
+    /// Create H3D nodes given binary encoded data as a string.
+    /// \param str The string to read the data from.
+    /// \param dn A DEFNodes structure to store the DEF nodes found
+    /// in the string.
+    /// \param exported_nodes Not used, the binary encoding does not store
+    /// EXPORT statements.
+    /// \param prototypes A vector to add the PROTO declarations found in
+    /// the string to.
+    /// \return A Group containing the nodes created.
+    H3DAPI_API Group* createX3DBinaryFromString(
+           const string &str,
+           DEFNodes *dn = NULL,
+           DEFNodes *exported_nodes = NULL,
+           PrototypeVector *prototypes = NULL );
+
+    /// Create a H3D Node given binary encoded data as an istream.
+    /// \param in The input stream to read the data from.
+    /// \param dn A DEFNodes structure to store the DEF nodes found
+    /// in the stream.
+    /// \param exported_nodes Not used, the binary encoding does not store
+    /// EXPORT statements.
+    /// \param prototypes A vector to add the PROTO declarations found in
+    /// the stream to.
+    /// \return The created Node.
+    H3DAPI_API AutoRef<Node> createX3DBinaryNodeFromStream(
+           istream &in,
+           DEFNodes *dn = NULL,
+           DEFNodes *exported_nodes = NULL,
+           PrototypeVector *prototypes = NULL );
+
+    /// Create a H3D Node given binary encoded data as a string.
+    /// \param str The string to read the data from.
+    /// \param dn A DEFNodes structure to store the DEF nodes found
+    /// in the string.
+    /// \param exported_nodes Not used, the binary encoding does not store
+    /// EXPORT statements.
+    /// \param prototypes A vector to add the PROTO declarations found in
+    /// the string to.
+    /// \return The created Node.
+    H3DAPI_API AutoRef<Node> createX3DBinaryNodeFromString(
+           const string &str,
+           DEFNodes *dn = NULL,
+           DEFNodes *exported_nodes = NULL,
+           PrototypeVector *prototypes = NULL );
+
+    /// Write the node and the nodes below it in the binary encoding to
+    /// the given ostream.
+    /// \param os The stream to write to. Should be opened in binary mode.
+    /// \param node The node to write.
+    /// \param prototypes The PROTO declarations that were used when
+    /// creating the node. Instances of them are written as instances. If
+    /// NULL, or for instances of other prototypes, the nodes the
+    /// instances are made of are written instead.
+    /// \param compress If true, arrays are compressed with zlib. Ignored
+    /// if H3D API is compiled without zlib.
+    /// \param quantize If true, float arrays are stored with 16 bits per
+    /// component.
+    H3DAPI_API void writeNodeAsX3DBinary( ostream& os,
+                                          Node *node,
+                                          PrototypeVector *prototypes = NULL,
+                                          bool compress = false,
+                                          bool quantize = false );
+  }
+};
+
+#endif
@@ -916,6 +916,53 @@ namespace H3D {
       }
     }
 
+    /// Template specializations for vectors of numeric values, e.g. the
+    /// values of MFFloat, MFInt32 and MFVec3f fields. They give the same
+    /// result as the generic version, but parse the numbers with a faster
+    /// parser that rounds floating point values correctly, reserve the
+    /// vector before parsing and skip long runs of whitespace with SIMD
+    /// instructions when available.
+    ///
+    /// Instead of listing the values the string can reference values in
+    /// an external binary file as "buffer( url, offset, count, type )",
+    /// e.g. point="buffer( mesh.bin, 0, 30000, float )" for an MFVec3f.
+    /// offset is the byte offset of the first value in the file, count is
+    /// the number of values and type is the type of the components in the
+    /// file, one of "float", "double", "int32", "uint32", "int16",
+    /// "uint16", "int8" and "uint8". type can be left out if it is the same
+    /// as the component type of the field. The numbers are little endian.
+    /// The url is resolved with ResourceResolver and the file is read
+    /// through a MappedBuffer, which is shared by all values read while
+    /// X3DSAX2Handlers parses a file.
+    /// \param x3d_string The string to convert.
+    /// \param values The return vector.
+    /// \throws Convert::X3DFieldConversionError
+    ///
+    template<> H3DAPI_API void X3DStringToVector< vector< float > >(
+                           const string &x3d_string, vector< float > &values );
+    template<> H3DAPI_API void X3DStringToVector< vector< double > >(
+                           const string &x3d_string, vector< double > &values );
+    template<> H3DAPI_API void X3DStringToVector< vector< int > >(
+                           const string &x3d_string, vector< int > &values );
+    template<> H3DAPI_API void X3DStringToVector< vector< Vec2f > >(
+                           const string &x3d_string, vector< Vec2f > &values );
+    template<> H3DAPI_API void X3DStringToVector< vector< Vec3f > >(
+                           const string &x3d_string, vector< Vec3f > &values );
+    template<> H3DAPI_API void X3DStringToVector< vector< Vec4f > >(
+                           const string &x3d_string, vector< Vec4f > &values );
+    template<> H3DAPI_API void X3DStringToVector< vector< Vec2d > >(
+                           const string &x3d_string, vector< Vec2d > &values );
+    template<> H3DAPI_API void X3DStringToVector< vector< Vec3d > >(
+                           const string &x3d_string, vector< Vec3d > &values );
+    template<> H3DAPI_API void X3DStringToVector< vector< Vec4d > >(
+                           const string &x3d_string, vector< Vec4d > &values );
+    template<> H3DAPI_API void X3DStringToVector< vector< RGB > >(
+                           const string &x3d_string, vector< RGB > &values );
+    template<> H3DAPI_API void X3DStringToVector< vector< RGBA > >(
+                           const string &x3d_string, vector< RGBA > &values );
+    template<> H3DAPI_API void X3DStringToVector< vector< Rotation > >(
+                        const string &x3d_string, vector< Rotation > &values );
+
     /// Convert a string to a PixelImage according to the X3D/XML
     /// field encoding for SFImage.
     /// \param x3d_string The string to convert.
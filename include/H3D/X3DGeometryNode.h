@@ -157,6 +157,30 @@ namespace H3D {
     /// geometry. 
     virtual H3DShadowObjectNode *getShadowObject();
 
+    /// Get the triangles of the geometry in local coordinates without
+    /// rendering it. Used by SFBoundTree to avoid collecting the
+    /// primitives through the OpenGL feedback buffer. Geometries that
+    /// have their triangles available on the CPU, e.g. the ones using
+    /// PrimitiveMeshCache, should override this function.
+    /// \param triangles The triangles of the geometry are added to this
+    /// vector.
+    /// \returns true if the triangles were added, false if the geometry
+    /// must be rendered in order to get them.
+    virtual bool getTriangles( vector< HAPI::Collision::Triangle > &triangles ) {
+      return false;
+    }
+
+    /// Render nr_instances instances of the geometry with a single
+    /// instanced draw call. The per instance vertex attributes, e.g.
+    /// the instance matrices used by X3DShapeNode::renderInstances(),
+    /// must be set up by the caller. Face culling is not set up by this
+    /// function.
+    /// \returns true if the instances were rendered, false if the
+    /// geometry does not support instanced rendering.
+    virtual bool renderInstanced( GLsizei nr_instances ) {
+      return false;
+    }
+
     /// This function should be used by the render() function to disable
     /// or enable face culling. DO NOT USE glEnable/glDisable to do
     /// this, since it will cause problems with OpenHaptics.
@@ -36,6 +36,7 @@
 #include <H3D/X3DPointingDeviceSensorNode.h>
 #include <H3D/ClipPlane.h>
 #include <H3D/Profiling.h>
+#include <H3D/ShapeDrawList.h>
 
 namespace H3D {
   class H3DRenderStateObject;
@@ -261,6 +262,46 @@ namespace H3D {
 
       /// A vector of only ClipPlane children of this X3DGroupingNode.
       vector< ClipPlane * > clip_planes;
+
+      /// Children of the group that only differ in their transformation
+      /// and are rendered as instances of one shape.
+      struct InstanceBatch {
+        /// The X3DShapeNode rendered. All children in the batch have a
+        /// shape with the same geometry and appearance as this one.
+        AutoRef< Node > shape;
+
+        /// The transformation matrices of the instances with 16 floats
+        /// per instance in column major order.
+        vector< GLfloat > matrices;
+      };
+
+      /// Returns the shape of the child if it is a Shape, or a Transform
+      /// or MatrixTransform with only a Shape as child and no state of its
+      /// own. matrix is then set to the matrix of the transform, or NULL
+      /// for a Shape. Such children can be rendered by instancing or in
+      /// another order than scene graph order. Returns NULL for all other
+      /// children.
+      X3DShapeNode *getSimpleShape( Node *child, const Matrix4f *&matrix );
+
+      /// Find the children that can be rendered as instances of the same
+      /// shape and put them in instance_batches, and check if children
+      /// should be sorted by render state. Controlled by the useInstancing
+      /// and sortShapes fields of GraphicsOptions.
+      void updateRenderBatches( TraverseInfo &ti );
+
+      /// The instance batches found in the last call to traverseSG.
+      vector< InstanceBatch > instance_batches;
+
+      /// instanced_children[i] is true if the i:th child is rendered as
+      /// part of an InstanceBatch instead of by itself.
+      vector< bool > instanced_children;
+
+      /// True if simple shapes among the children are rendered sorted by
+      /// render state. Set in traverseSG.
+      bool sort_shapes;
+
+      /// The list used to render children sorted by render state.
+      ShapeDrawList shape_draw_list;
   };
 }
 
@@ -92,6 +92,17 @@ namespace H3D {
       prototyped_node_extras.push_back( n );
     }
 
+    /// Add the node set with setPrototypedNode() and the nodes added with
+    /// addPrototypedNodeExtra() to nodes. Unlike getPrototypedNode() an
+    /// X3DPrototypeInstance set as prototyped node is not looked into.
+    void getPrototypedNodes( vector< Node * > &nodes ) {
+      if( prototyped_node.get() ) nodes.push_back( prototyped_node.get() );
+      for( unsigned int i = 0; i < prototyped_node_extras.size(); ++i ) {
+        if( prototyped_node_extras[i] )
+          nodes.push_back( prototyped_node_extras[i] );
+      }
+    }
+
     /// Returns the default xml containerField attribute value.
     virtual string defaultXMLContainerField() {
       if( prototyped_node.get() )
@@ -31,12 +31,14 @@
 
 #include <stack>
 #include <list>
+#include <map>
 #include <H3D/Field.h>
 #include <H3D/Node.h>
 #include <H3D/DEFNodes.h>
 #include <H3D/ProtoDeclaration.h>
 #include <H3D/X3D.h>
 #include <H3D/H3DScriptNode.h>
+#include <H3D/MappedBuffer.h>
 
 #include <H3DUtil/Exception.h>
 #include <H3DUtil/AutoRef.h>
@@ -110,10 +112,14 @@ namespace H3D {
         if( !_proto_declarations ) {
           proto_declarations = new PrototypeVector;
         }
+        // all fields that reference the same buffer file while parsing
+        // use one mapping of it.
+        MappedBuffer::beginSharing();
       };
 
       /// Destructor.
       ~X3DSAX2Handlers() {
+        MappedBuffer::endSharing();
         if( delete_DEF_map ) 
           delete DEF_map;
         if( delete_exported_map )
@@ -126,6 +132,22 @@ namespace H3D {
       void setDocumentLocator( const Locator *const _locator ) {
         locator = (Locator *)_locator;
       }
+
+      /// If true, attribute values of MF fields that are at least
+      /// lazy_field_value_min_size characters long are not converted
+      /// when parsed but the first time the field value is used, see
+      /// ParsableField::setValueFromStringOnUse(). Values of nodes that
+      /// are never used, e.g. inactive Switch choices and LOD levels, are
+      /// then never converted. Conversion errors are printed as warnings
+      /// when the value is used instead of stopping the parsing.
+      /// References to external buffers, "buffer( url, ... )", are always
+      /// converted when parsed since the url is relative to the file.
+      /// Default is false.
+      static bool lazy_field_values;
+
+      /// The minimum length of attribute values to convert on use when
+      /// lazy_field_values is true. Default is 256.
+      static unsigned int lazy_field_value_min_size;
       
       /// Get the node that has been generated by the last parsing. Only
       /// valid after a successful call to the parse() function of a
@@ -352,6 +374,10 @@ namespace H3D {
       /// is included. Only valid during event callbacks.
       string getLocationString();
 
+      /// Returns the H3DNodeDatabase field id of the field with the given
+      /// attribute name. The ids are cached in field_ids.
+      unsigned int getFieldId( const string &name );
+
       /// A stack of NodeElements. Used during parsing to keep track
       /// of the created Nodes.
       typedef std::stack< NodeElement > NodeElementStack;
@@ -443,6 +469,11 @@ namespace H3D {
       /// in the characters function when inside_cdata is true.
       /// Reset in endCDATA fucntion.
       string cdata;
+
+      /// Map from attribute name to the field id given by
+      /// H3DNodeDatabase::getFieldId(). Documents use the same attribute
+      /// names many times so the ids are only looked up once.
+      std::map< string, unsigned int > field_ids;
     };
 
     H3DAPI_API SAX2XMLReader* getNewXMLParser();
@@ -185,6 +185,32 @@ namespace H3D {
     /// Render the shape using OpenGL.
     virtual void render();
 
+    /// Render the shape once for each of the given transformation
+    /// matrices with the appearance set up only once. The matrices are
+    /// stored with 16 floats per instance in column major order and are
+    /// relative to the current model view matrix. If the geometry
+    /// supports instanced rendering and the active shader program has a
+    /// mat4 attribute named "instanceMatrix" all instances are drawn with
+    /// one draw call. The shader is then responsible for applying the
+    /// instance matrix to the vertices. Otherwise the geometry is
+    /// rendered once for each matrix.
+    virtual void renderInstances( const vector< GLfloat > &matrices );
+
+    /// Set up the OpenGL state for the appearance and the renderMode of
+    /// the active GlobalSettings. Together with renderGeometry() and
+    /// postRenderAppearance() this does the same as render(), but allows
+    /// several shapes with the same appearance to be rendered with the
+    /// appearance only set up once, see ShapeDrawList.
+    void preRenderAppearance();
+
+    /// Render the geometry with the current geometry_render_mode. Must
+    /// be called between preRenderAppearance() and postRenderAppearance()
+    /// of a shape with the same appearance.
+    void renderGeometry();
+
+    /// Restore the OpenGL state changed by preRenderAppearance().
+    void postRenderAppearance();
+
     /// Traverse the scenegraph. Calls traverseSG on appeance and geometry.
     virtual void traverseSG( TraverseInfo &ti );
 
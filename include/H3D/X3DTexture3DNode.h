@@ -33,6 +33,7 @@
 #include <H3D/H3DImageObject.h>
 #include <H3D/TextureProperties.h>
 #include <H3D/DependentNodeFields.h>
+#include <H3D/GLStateTracker.h>
 
 namespace H3D {
   /// \ingroup AbstractNodes
@@ -82,13 +83,17 @@ namespace H3D {
     
     /// Destructor.
     ~X3DTexture3DNode() {
-      if( texture_id ) glDeleteTextures( 1, &texture_id );
+      if( texture_id ) GLStateTracker::deleteTextures( 1, &texture_id );
     }
 
     /// Performs the OpenGL rendering required to install the image
     /// as a texture.
     virtual void render();
 
+    /// Remove the texture from the graphics card. It is installed again
+    /// from the image the next time the node is rendered.
+    virtual bool evictTexture();
+
     /// Render all OpenGL texture properties.
     virtual void renderTextureProperties();
 
@@ -201,6 +206,22 @@ namespace H3D {
     ///
     virtual std::pair<H3DInt32,H3DInt32> getDefaultSaveDimensions ();
 
+    /// Replace the image with a ReloadableImage and release its pixel
+    /// data if that is enabled, see TextureProperties::releaseImage.
+    /// Called once each time the texture has been installed. The texture
+    /// must be bound.
+    void releaseImageData();
+
+    /// Returns a new ReloadableImage wrapping the image that can load its
+    /// data again after it has been released, or NULL if the data can
+    /// not be released. By default the data is read back from the
+    /// installed texture if it holds all of it.
+    virtual ReloadableImage *newReloadableImage( Image *_image );
+
+    /// ReloadableImage::ReloadFunc reading the image back from the
+    /// texture of the X3DTexture3DNode given as data.
+    static Image *readTextureImage( Image *_image, void *data );
+
     /// Field to indicate image changed
     auto_ptr< Field > imageUpdated;
 
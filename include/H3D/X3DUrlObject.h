@@ -113,6 +113,25 @@ namespace H3D {
     /// Get the content of the URL as a string
     string resolveURLAsString( const string &url );
 
+    /// Get the url as a local file that can be read directly. Returns
+    /// an empty string if the url does not refer to a local file.
+    string resolveURLAsLocalFile( const string &url );
+
+    /// Resolve a url with relative urls resolved from url_base, as
+    /// resolveURLAsString() if return_contents is true and otherwise as
+    /// resolveURLAsFile(). Inline prefixes are not supported. Does not use
+    /// an X3DUrlObject, so it can be used in another thread while the
+    /// node the url and url_base come from is destroyed.
+    static string resolveURLFromBase( const string &url_base,
+                                      const string &url,
+                                      bool return_contents,
+                                      bool *is_tmp_file = NULL );
+
+    /// As resolveURLAsLocalFile() with relative urls resolved from
+    /// url_base. Inline prefixes are not supported.
+    static string resolveURLAsLocalFileFromBase( const string &url_base,
+                                                 const string &url );
+
     /// Remove a tmpfile with the given name.
     /// Returns true on success, or false if no such file exists
     /// or the removal failed.
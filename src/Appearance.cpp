@@ -41,6 +41,7 @@
 #include <H3D/NavigationInfo.h>
 #include <H3DUtil/Console.h>
 #include <H3D/GraphicsHardwareInfo.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -254,7 +255,7 @@ void Appearance::preRender() {
   if ( m ) m->preRender();
   else {
     if( X3DShapeNode::disable_lighting_if_no_app ) {
-      glDisable( GL_LIGHTING );
+      GLStateTracker::disable( GL_LIGHTING );
     }
   }
   
@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/Arc2D.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -79,7 +80,7 @@ void Arc2D::DisplayList::callList( bool build_list ) {
   Arc2D *arc = 
    static_cast< Arc2D * >( owner );
 
-  glPushAttrib( GL_CURRENT_BIT );
+  GLStateTracker::pushAttrib( GL_CURRENT_BIT );
 
   float v[4];
   glGetMaterialfv( GL_FRONT, GL_EMISSION, v );
@@ -87,14 +88,14 @@ void Arc2D::DisplayList::callList( bool build_list ) {
 
   X3DGeometryNode::DisplayList::callList( build_list );
 
-  glPopAttrib();
+  GLStateTracker::popAttrib();
 }
 
 void Arc2D::render() {
   // Save the old state of GL_LIGHTING 
   GLboolean lighting_enabled;
   glGetBooleanv( GL_LIGHTING, &lighting_enabled );
-  glDisable( GL_LIGHTING );
+  GLStateTracker::disable( GL_LIGHTING );
 
   H3DFloat start_angle = startAngle->getValue();
   H3DFloat end_angle = endAngle->getValue();
@@ -132,7 +133,7 @@ void Arc2D::render() {
 
   // reenable lighting if it was enabled before
   if( lighting_enabled )
-    glEnable( GL_LIGHTING );
+    GLStateTracker::enable( GL_LIGHTING );
 }
 
 
@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/Background.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -114,11 +115,11 @@ Background::Background( Inst< SFSetBind > _set_bind,
 void Background::render() {
   if( render_enabled ) {
     X3DBackgroundNode::render();
-    glPushAttrib( GL_ALL_ATTRIB_BITS );
+    GLStateTracker::pushAttrib( GL_ALL_ATTRIB_BITS );
     H3DFloat s = (H3DFloat)0.05;
     glCullFace( GL_BACK );
-    glEnable( GL_CULL_FACE );
-    glDisable( GL_LIGHTING );
+    GLStateTracker::enable( GL_CULL_FACE );
+    GLStateTracker::disable( GL_LIGHTING );
 
     Matrix4d pm = projectionMatrix->getValue();
     H3DDouble projection_matrix[16] = { pm[0][0], pm[1][0], pm[2][0], pm[3][0],
@@ -142,7 +143,7 @@ void Background::render() {
     glMultMatrixf( mv );
     glColor4f( 1, 1, 1, 1 );
     if( frontUrl->size() > 0 ) {
-      glPushAttrib( frontTexture->getAffectedGLAttribs() );
+      GLStateTracker::pushAttrib( frontTexture->getAffectedGLAttribs() );
       frontTexture->preRender();
       frontTexture->displayList->callList();
       glBegin( GL_QUADS );
@@ -157,11 +158,11 @@ void Background::render() {
       glVertex3f( s, -s, -s );      
       glEnd();
       frontTexture->postRender();
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
   
     if( backUrl->size() > 0 ) {
-      glPushAttrib( backTexture->getAffectedGLAttribs() );
+      GLStateTracker::pushAttrib( backTexture->getAffectedGLAttribs() );
       backTexture->preRender();
       backTexture->displayList->callList();
       glBegin( GL_QUADS );
@@ -176,11 +177,11 @@ void Background::render() {
       glVertex3f( s, s, s );
       glEnd();
       backTexture->postRender();
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
 
     if( leftUrl->size() > 0 ) {
-      glPushAttrib( leftTexture->getAffectedGLAttribs() );
+      GLStateTracker::pushAttrib( leftTexture->getAffectedGLAttribs() );
       leftTexture->preRender();
       leftTexture->displayList->callList();
       glBegin( GL_QUADS );
@@ -195,11 +196,11 @@ void Background::render() {
       glVertex3f( -s, s, -s );
       glEnd();
       leftTexture->postRender();
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
 
     if( rightUrl->size() > 0 ) {
-      glPushAttrib( rightTexture->getAffectedGLAttribs() );
+      GLStateTracker::pushAttrib( rightTexture->getAffectedGLAttribs() );
       rightTexture->preRender();
       rightTexture->displayList->callList();
       glBegin( GL_QUADS );
@@ -214,11 +215,11 @@ void Background::render() {
       glVertex3f( s, s, s );
       glEnd();
       rightTexture->postRender();
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
 
     if( topUrl->size() > 0 ) {
-      glPushAttrib( topTexture->getAffectedGLAttribs() );
+      GLStateTracker::pushAttrib( topTexture->getAffectedGLAttribs() );
       topTexture->preRender();
       topTexture->displayList->callList();
       glBegin( GL_QUADS );
@@ -233,11 +234,11 @@ void Background::render() {
       glVertex3f( s, s, s );
       glEnd();
       topTexture->postRender();
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
 
     if( bottomUrl->size() > 0 ) {
-      glPushAttrib( bottomTexture->getAffectedGLAttribs() );
+      GLStateTracker::pushAttrib( bottomTexture->getAffectedGLAttribs() );
       bottomTexture->preRender();
       bottomTexture->displayList->callList();
       glBegin( GL_QUADS );
@@ -252,7 +253,7 @@ void Background::render() {
       glVertex3f( -s, -s, s );
       glEnd();
       bottomTexture->postRender();
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
 
 
@@ -260,7 +261,7 @@ void Background::render() {
     glPopMatrix(); 
     glMatrixMode( GL_PROJECTION );
     glPopMatrix();
-    glPopAttrib();
+    GLStateTracker::popAttrib();
   }
 }
 
@@ -27,6 +27,7 @@
 //
 //////////////////////////////////////////////////////////////////////////////
 #include <H3D/Bound.h>
+#include <H3D/GLStateTracker.h>
 
 #ifdef MACOSX
 #include <OpenGL/gl.h>
@@ -42,7 +43,7 @@ void BoxBound::render() {
   Vec3f min = c - half_size;
   Vec3f max = c + half_size;
 
-  glDisable( GL_LIGHTING );
+  GLStateTracker::disable( GL_LIGHTING );
   glColor3f( 0, 0, 1 );
 
   glBegin( GL_LINE_STRIP );
@@ -71,7 +72,7 @@ void BoxBound::render() {
   glVertex3f( max.x, max.y, max.z );
   glVertex3f( max.x, max.y, min.z );
   glEnd();
-  glEnable( GL_LIGHTING );
+  GLStateTracker::enable( GL_LIGHTING );
 }
 
 bool BoxBound::movingSphereIntersect( const Vec3f &from,
@@ -41,6 +41,61 @@ H3DNodeDatabase Box::database( "Box",
 namespace BoxInternals {
   FIELDDB_ELEMENT( Box, size, INPUT_OUTPUT );
   FIELDDB_ELEMENT( Box, solid, INPUT_OUTPUT );
+
+  // The normal of each face of the box.
+  const H3DFloat face_normals[6][3] = {
+    { 0, 0, 1 }, { 0, 0, -1 }, { 0, 1, 0 },
+    { 0, -1, 0 }, { 1, 0, 0 }, { -1, 0, 0 } };
+
+  // The corners of each face of the box, given as the sign of the
+  // x, y and z coordinate, followed by the texture coordinate.
+  const H3DFloat face_vertices[6][4][5] = {
+    // +z
+    { {  1,  1,  1, 1, 1 }, { -1,  1,  1, 0, 1 },
+      { -1, -1,  1, 0, 0 }, {  1, -1,  1, 1, 0 } },
+    // -z
+    { {  1, -1, -1, 0, 0 }, { -1, -1, -1, 1, 0 },
+      { -1,  1, -1, 1, 1 }, {  1,  1, -1, 0, 1 } },
+    // +y
+    { {  1,  1,  1, 1, 0 }, {  1,  1, -1, 1, 1 },
+      { -1,  1, -1, 0, 1 }, { -1,  1,  1, 0, 0 } },
+    // -y
+    { { -1, -1,  1, 0, 1 }, { -1, -1, -1, 0, 0 },
+      {  1, -1, -1, 1, 0 }, {  1, -1,  1, 1, 1 } },
+    // +x
+    { {  1,  1,  1, 0, 1 }, {  1, -1,  1, 0, 0 },
+      {  1, -1, -1, 1, 0 }, {  1,  1, -1, 1, 1 } },
+    // -x
+    { { -1,  1, -1, 0, 1 }, { -1, -1, -1, 0, 0 },
+      { -1, -1,  1, 1, 0 }, { -1,  1,  1, 1, 1 } } };
+
+  // Build the mesh for a box. params contains the size of the box.
+  void buildMesh( const vector< H3DFloat > &params,
+                  PrimitiveMeshCache::Mesh &mesh ) {
+    H3DFloat x = params[0] / 2;
+    H3DFloat y = params[1] / 2;
+    H3DFloat z = params[2] / 2;
+
+    mesh.vertex_data.reserve(
+      24 * PrimitiveMeshCache::Mesh::components_per_vertex );
+    mesh.index_data.reserve( 36 );
+    mesh.beginPart();
+    for( unsigned int f = 0; f < 6; ++f ) {
+      Vec3f normal( face_normals[f][0], face_normals[f][1],
+                    face_normals[f][2] );
+      GLuint v = 0;
+      for( unsigned int c = 0; c < 4; ++c ) {
+        const H3DFloat *corner = face_vertices[f][c];
+        GLuint index =
+          mesh.addVertex( Vec3f( corner[0] * x, corner[1] * y, corner[2] * z ),
+                          normal,
+                          Vec3f( corner[3], corner[4], 0 ) );
+        if( c == 0 ) v = index;
+      }
+      mesh.addTriangle( v, v + 1, v + 2 );
+      mesh.addTriangle( v, v + 2, v + 3 );
+    }
+  }
 }
 
 
@@ -51,7 +106,9 @@ Box::Box(
          Inst< SFBool  >  _solid ) :
   X3DGeometryNode( _metadata, _bound ),
   size    ( _size     ),
-  solid   ( _solid    ) {
+  solid   ( _solid    ),
+  meshFieldsUpToDate( new Field ),
+  mesh( NULL ) {
 
   type_name = "Box";
   database.initFields( this );
@@ -64,87 +121,45 @@ Box::Box(
   size->route( displayList );
   solid->route( displayList );
 
+  meshFieldsUpToDate->setName( "meshFieldsUpToDate" );
+  size->route( meshFieldsUpToDate );
+}
+
+Box::~Box() {
+  PrimitiveMeshCache::releaseMesh( mesh );
+  mesh = NULL;
+}
+
+PrimitiveMeshCache::Mesh *Box::getMesh() {
+  if( !mesh || !meshFieldsUpToDate->isUpToDate() ) {
+    meshFieldsUpToDate->upToDate();
+    const Vec3f &s = size->getValue();
+    vector< H3DFloat > params( 3 );
+    params[0] = s.x;
+    params[1] = s.y;
+    params[2] = s.z;
+    PrimitiveMeshCache::Mesh *new_mesh =
+      PrimitiveMeshCache::getMesh( "Box", params, &BoxInternals::buildMesh );
+    PrimitiveMeshCache::releaseMesh( mesh );
+    mesh = new_mesh;
+  }
+  return mesh;
 }
 
 void Box::render() {
-  H3DFloat x = size->getValue().x / 2;
-  H3DFloat y = size->getValue().y / 2;
-  H3DFloat z = size->getValue().z / 2;
-  
-  glBegin( GL_QUADS );
-  
-  // +z
-  glNormal3f  ( 0, 0, 1 );
-
-  renderTexCoordForActiveTexture( Vec3f( 1, 1, 0 ) );
-  glVertex3f  ( x, y, z );
-  renderTexCoordForActiveTexture( Vec3f( 0, 1, 0 ) );
-  glVertex3f  ( -x, y, z );
-  renderTexCoordForActiveTexture( Vec3f( 0, 0, 0 ) );
-  glVertex3f  ( -x, -y, z );
-  renderTexCoordForActiveTexture( Vec3f( 1, 0, 0 ) );
-  glVertex3f  ( x, -y, z );
-  
-  // -z
-  glNormal3f  ( 0, 0, -1 );
-  renderTexCoordForActiveTexture( Vec3f( 0, 0, 0 ) );
-  glVertex3f  ( x, -y, -z );
-  renderTexCoordForActiveTexture( Vec3f( 1, 0, 0 ) );
-  glVertex3f  ( -x, -y, -z );
-  renderTexCoordForActiveTexture( Vec3f( 1, 1, 0 ) );
-  glVertex3f  ( -x, y, -z );
-  renderTexCoordForActiveTexture( Vec3f( 0, 1, 0 ) );
-  glVertex3f  ( x, y, -z );
-
-  // +y
-  glNormal3f  ( 0, 1, 0 );
-
-  renderTexCoordForActiveTexture( Vec3f( 1, 0, 0 ) );
-  glVertex3f  ( x, y, z );
-  renderTexCoordForActiveTexture( Vec3f( 1, 1, 0 ) );
-  glVertex3f  ( x, y, -z );
-  renderTexCoordForActiveTexture( Vec3f( 0, 1, 0 ) );
-  glVertex3f  ( -x, y, -z );
-  renderTexCoordForActiveTexture( Vec3f( 0, 0, 0 ) );
-  glVertex3f  ( -x, y, z );
-
-  // -y
-  glNormal3f  ( 0, -1, 0 );
-
-  renderTexCoordForActiveTexture( Vec3f( 0, 1, 0 ) );
-  glVertex3f  ( -x, -y, z );
-  renderTexCoordForActiveTexture( Vec3f( 0, 0, 0 ) );
-  glVertex3f  ( -x, -y, -z );
-  renderTexCoordForActiveTexture( Vec3f( 1, 0, 0 ) );
-  glVertex3f  ( x, -y, -z );
-  renderTexCoordForActiveTexture( Vec3f( 1, 1, 0 ) );
-  glVertex3f  ( x, -y, z );
-  
-  // +x
-  glNormal3f  ( 1, 0, 0 );
-
-  renderTexCoordForActiveTexture( Vec3f( 0, 1, 0 ) );
-  glVertex3f  ( x, y, z );
-  renderTexCoordForActiveTexture( Vec3f( 0, 0, 0 ) );
-  glVertex3f  ( x, -y, z );
-  renderTexCoordForActiveTexture( Vec3f( 1, 0, 0 ) );
-  glVertex3f  ( x, -y, -z );
-  renderTexCoordForActiveTexture( Vec3f( 1, 1, 0 ) );
-  glVertex3f  ( x, y, -z );
-  
-  // -x
-  glNormal3f  ( -1, 0, 0 );
-
-  renderTexCoordForActiveTexture( Vec3f( 0, 1, 0 ) );
-  glVertex3f  ( -x, y, -z );
-  renderTexCoordForActiveTexture( Vec3f( 0, 0, 0 ) );
-  glVertex3f  ( -x, -y, -z );
-  renderTexCoordForActiveTexture( Vec3f( 1, 0, 0 ) );
-  glVertex3f  ( -x, -y, z );
-  renderTexCoordForActiveTexture( Vec3f( 1, 1, 0 ) );
-  glVertex3f  ( -x, y, z );
-
-  glEnd();
+  getMesh()->render( 1, PrimitiveMeshCache::usingVertexBufferObjects( this ) );
+}
+
+bool Box::renderInstanced( GLsizei nr_instances ) {
+  getMesh()->render( 1,
+                     PrimitiveMeshCache::usingVertexBufferObjects( this ),
+                     nr_instances );
+  return true;
+}
+
+bool Box::getTriangles( vector< HAPI::Collision::Triangle > &triangles ) {
+  getMesh()->getTriangles( 1, triangles );
+  return true;
 }
 
 void Box::traverseSG( TraverseInfo &ti ) {
@@ -0,0 +1,563 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file BrickedVolumeTexture.cpp
+/// \brief CPP file for BrickedVolumeTexture.
+///
+//
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <H3D/BrickedVolumeTexture.h>
+#include <H3D/TextureProperties.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <cmath>
+
+using namespace H3D;
+
+// Add this node to the H3DNodeDatabase system.
+H3DNodeDatabase BrickedVolumeTexture::database( 
+                                       "BrickedVolumeTexture", 
+                                       &(newInstance<BrickedVolumeTexture>), 
+                                       typeid( BrickedVolumeTexture ),
+                                       &X3DTexture3DNode::database );
+
+namespace BrickedVolumeTextureInternals {
+  FIELDDB_ELEMENT( BrickedVolumeTexture, texture, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( BrickedVolumeTexture, brickSize, INITIALIZE_ONLY );
+  FIELDDB_ELEMENT( BrickedVolumeTexture, cacheMemory, INITIALIZE_ONLY );
+  FIELDDB_ELEMENT( BrickedVolumeTexture, brickUploadBudget, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( BrickedVolumeTexture, emptyThreshold, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( BrickedVolumeTexture, pageTable, OUTPUT_ONLY );
+  FIELDDB_ELEMENT( BrickedVolumeTexture, brickRange, OUTPUT_ONLY );
+  FIELDDB_ELEMENT( BrickedVolumeTexture, volumeSize, OUTPUT_ONLY );
+  FIELDDB_ELEMENT( BrickedVolumeTexture, brickCount, OUTPUT_ONLY );
+  FIELDDB_ELEMENT( BrickedVolumeTexture, cacheBrickCount, OUTPUT_ONLY );
+
+  typedef std::pair< H3DFloat, unsigned int > BrickDistance;
+
+  // A texture with one texel per brick, sampled with nearest filtering.
+  Pixel3DTexture *newBrickTexture() {
+    Pixel3DTexture *t = new Pixel3DTexture;
+    TextureProperties *tp = new TextureProperties;
+    tp->minificationFilter->setValue( "NEAREST_PIXEL" );
+    tp->magnificationFilter->setValue( "NEAREST_PIXEL" );
+    tp->boundaryModeS->setValue( "CLAMP_TO_EDGE" );
+    tp->boundaryModeT->setValue( "CLAMP_TO_EDGE" );
+    tp->boundaryModeR->setValue( "CLAMP_TO_EDGE" );
+    tp->textureCompression->setValue( "NONE" );
+    // the data is updated in place.
+    tp->releaseImage->setValue( "KEEP" );
+    t->textureProperties->setValue( tp );
+    t->scaleToPowerOfTwo->setValue( false );
+    return t;
+  }
+
+  // The value of a component normalized as when sampled from a texture.
+  H3DFloat componentValue( const unsigned char *p,
+                           Image::PixelComponentType type,
+                           unsigned int nr_bytes ) {
+    switch( type ) {
+    case Image::UNSIGNED:
+      if( nr_bytes == 1 ) return *p / 255.0f;
+      if( nr_bytes == 2 ) 
+        return *(const unsigned short *)p / 65535.0f;
+      if( nr_bytes == 4 ) 
+        return (H3DFloat)( *(const unsigned int *)p / 4294967295.0 );
+      break;
+    case Image::SIGNED:
+      if( nr_bytes == 1 ) return *(const signed char *)p / 127.0f;
+      if( nr_bytes == 2 ) return *(const short *)p / 32767.0f;
+      if( nr_bytes == 4 ) 
+        return (H3DFloat)( *(const int *)p / 2147483647.0 );
+      break;
+    case Image::RATIONAL:
+      if( nr_bytes == 4 ) return *(const float *)p;
+      if( nr_bytes == 8 ) return (H3DFloat)*(const double *)p;
+      break;
+    }
+    return 0;
+  }
+
+  // The range of the voxel values in data, clamped to [0, 1]. The value
+  // of a voxel is its alpha component if it has one and otherwise its
+  // largest component.
+  void valueRange( const unsigned char *data, size_t nr_voxels,
+                   Image *image, H3DFloat &min_value, H3DFloat &max_value ) {
+    unsigned int nr_components = 1;
+    bool has_alpha = false;
+    switch( image->pixelType() ) {
+    case Image::LUMINANCE_ALPHA: nr_components = 2; has_alpha = true; break;
+    case Image::RGB:
+    case Image::BGR: nr_components = 3; break;
+    case Image::RGBA:
+    case Image::BGRA: nr_components = 4; has_alpha = true; break;
+    default: break;
+    }
+    unsigned int bytes_per_voxel = image->bitsPerPixel() / 8;
+    unsigned int bytes_per_component = bytes_per_voxel / nr_components;
+    Image::PixelComponentType type = image->pixelComponentType();
+
+    min_value = 1;
+    max_value = 0;
+    for( size_t i = 0; i < nr_voxels; ++i ) {
+      const unsigned char *voxel = data + i * bytes_per_voxel;
+      H3DFloat v;
+      if( has_alpha ) {
+        v = componentValue( voxel + ( nr_components - 1 ) * bytes_per_component,
+                            type, bytes_per_component );
+      } else {
+        v = componentValue( voxel, type, bytes_per_component );
+        for( unsigned int c = 1; c < nr_components; ++c ) {
+          v = H3DMax( v, componentValue( voxel + c * bytes_per_component,
+                                         type, bytes_per_component ) );
+        }
+      }
+      v = H3DMin( H3DMax( v, 0.0f ), 1.0f );
+      if( v < min_value ) min_value = v;
+      if( v > max_value ) max_value = v;
+    }
+  }
+}
+
+BrickedVolumeTexture::BrickedVolumeTexture( 
+                           Inst< DisplayList     > _displayList,
+                           Inst< SFNode          > _metadata,
+                           Inst< SFBool          > _repeatS,
+                           Inst< SFBool          > _repeatT,
+                           Inst< SFBool          > _repeatR,
+                           Inst< SFBool          > _scaleToP2,
+                           Inst< SFImage         > _image,
+                           Inst< SFTextureProperties > _textureProperties,
+                           Inst< SFTexture3DNode > _texture,
+                           Inst< SFInt32         > _brickSize,
+                           Inst< SFInt32         > _cacheMemory,
+                           Inst< SFInt32         > _brickUploadBudget,
+                           Inst< SFFloat         > _emptyThreshold,
+                           Inst< SFNode          > _pageTable,
+                           Inst< SFNode          > _brickRange,
+                           Inst< SFVec3f         > _volumeSize,
+                           Inst< SFVec3f         > _brickCount,
+                           Inst< SFVec3f         > _cacheBrickCount ) :
+  X3DTexture3DNode( _displayList, _metadata, _repeatS, _repeatT,
+                    _repeatR, _scaleToP2, _image, _textureProperties ),
+  texture( _texture ),
+  brickSize( _brickSize ),
+  cacheMemory( _cacheMemory ),
+  brickUploadBudget( _brickUploadBudget ),
+  emptyThreshold( _emptyThreshold ),
+  pageTable( _pageTable ),
+  brickRange( _brickRange ),
+  volumeSize( _volumeSize ),
+  brickCount( _brickCount ),
+  cacheBrickCount( _cacheBrickCount ),
+  brick_size( 0 ),
+  stalled( false ),
+  texels_changed( false ),
+  empty_threshold( 0 ) {
+  type_name = "BrickedVolumeTexture";
+  database.initFields( this );
+
+  brickSize->setValue( 32 );
+  cacheMemory->setValue( 256 );
+  brickUploadBudget->setValue( 8 );
+  emptyThreshold->setValue( 0 );
+
+  pageTable->setValue( BrickedVolumeTextureInternals::newBrickTexture(), id );
+  brickRange->setValue( BrickedVolumeTextureInternals::newBrickTexture(), id );
+
+  for( unsigned int i = 0; i < 3; ++i ) {
+    nr_bricks[i] = 0;
+    nr_slots[i] = 0;
+  }
+
+  texture->route( displayList );
+  brickUploadBudget->route( displayList );
+  emptyThreshold->route( displayList );
+}
+
+Vec3f BrickedVolumeTexture::textureSize() {
+  X3DTexture3DNode *volume = texture->getValue();
+  if( volume ) return volume->textureSize();
+  return Vec3f( 0, 0, 0 );
+}
+
+void BrickedVolumeTexture::render() {
+  glGetIntegerv( GL_ACTIVE_TEXTURE_ARB, &texture_unit );
+  texture_target = GL_TEXTURE_3D;
+
+  X3DTexture3DNode *volume = texture->getValue();
+  Image *i = volume ? volume->image->getValue() : NULL;
+  if( i != source_image.get() ) {
+    // a new volume, start over.
+    if( texture_id ) {
+      GLStateTracker::deleteTextures( 1, &texture_id );
+      texture_id = 0;
+    }
+    bricks.clear();
+    source_image.reset( i );
+    if( i ) initBricks( i );
+  }
+  if( bricks.empty() ) return;
+
+  if( !texture_id ) {
+    initCache( i );
+  } else {
+    GLStateTracker::bindTexture( texture_target, texture_id );
+  }
+  updateEmptyBricks();
+
+  // the position of the viewer in the local coordinate system.
+  GLdouble mv[16];
+  glGetDoublev( GL_MODELVIEW_MATRIX, mv );
+  Matrix4d model_view( mv[0], mv[4], mv[8 ], mv[12],
+                       mv[1], mv[5], mv[9 ], mv[13],
+                       mv[2], mv[6], mv[10], mv[14],
+                       mv[3], mv[7], mv[11], mv[15] );
+  Vec3f viewer_pos = (Vec3f)( model_view.inverse() * Vec3d( 0, 0, 0 ) );
+
+  if( streamBricks( i, viewer_pos ) ) {
+    // the bricks to install depend on the viewer position.
+    displayList->breakCache();
+  }
+
+  if( texels_changed ) {
+    Pixel3DTexture *textures[2] = {
+      static_cast< Pixel3DTexture * >( pageTable->getValue() ),
+      static_cast< Pixel3DTexture * >( brickRange->getValue() ) };
+    for( unsigned int t = 0; t < 2; ++t ) {
+      textures[t]->image->beginEditing();
+      textures[t]->image->setEditedArea( 0, 0, 0,
+                                         nr_bricks[0] - 1,
+                                         nr_bricks[1] - 1,
+                                         nr_bricks[2] - 1 );
+      textures[t]->image->endEditing();
+    }
+    texels_changed = false;
+  }
+
+  enableTexturing();
+  renderTextureProperties();
+}
+
+bool BrickedVolumeTexture::initBricks( Image *image ) {
+  if( image->compressionType() != Image::NO_COMPRESSION ||
+      image->bitsPerPixel() % 8 != 0 ) {
+    Console(LogLevel::Error) << "Warning: The image of the texture field "
+                             << "can not be divided into bricks since it is "
+                             << "compressed or has pixels that are not a "
+                             << "whole number of bytes (in " << getName()
+                             << ")." << endl;
+    return false;
+  }
+
+  brick_size = (unsigned int)H3DMax( brickSize->getValue(), 1 );
+  unsigned int dims[3] = { image->width(), image->height(), image->depth() };
+  for( unsigned int i = 0; i < 3; ++i ) {
+    nr_bricks[i] = ( dims[i] + brick_size - 1 ) / brick_size;
+  }
+  size_t nr = (size_t)nr_bricks[0] * nr_bricks[1] * nr_bricks[2];
+  bricks.assign( nr, Brick() );
+  stalled = false;
+  empty_threshold = emptyThreshold->getValue();
+
+  // no bricks are installed and all ranges are unknown.
+  unsigned char *page_data = new unsigned char[ nr * 4 ];
+  memset( page_data, 0, nr * 4 );
+  unsigned char *range_data = new unsigned char[ nr * 2 ];
+  for( size_t i = 0; i < nr; ++i ) {
+    range_data[ i * 2 ] = 0;
+    range_data[ i * 2 + 1 ] = 255;
+  }
+  static_cast< Pixel3DTexture * >( pageTable->getValue() )->image->setValue( 
+    new PixelImage( nr_bricks[0], nr_bricks[1], nr_bricks[2], 32,
+                    Image::RGBA, Image::UNSIGNED, page_data ) );
+  static_cast< Pixel3DTexture * >( brickRange->getValue() )->image->setValue( 
+    new PixelImage( nr_bricks[0], nr_bricks[1], nr_bricks[2], 16,
+                    Image::LUMINANCE_ALPHA, Image::UNSIGNED, range_data ) );
+
+  volumeSize->setValue( Vec3f( (H3DFloat)dims[0], 
+                               (H3DFloat)dims[1],
+                               (H3DFloat)dims[2] ), id );
+  brickCount->setValue( Vec3f( (H3DFloat)nr_bricks[0],
+                               (H3DFloat)nr_bricks[1],
+                               (H3DFloat)nr_bricks[2] ), id );
+  return true;
+}
+
+void BrickedVolumeTexture::initCache( Image *image ) {
+  unsigned int stored_size = brick_size + 2;
+  size_t brick_bytes = 
+    (size_t)stored_size * stored_size * stored_size * 
+    image->bitsPerPixel() / 8;
+  size_t cache_bytes = 
+    (size_t)H3DMax( cacheMemory->getValue(), 1 ) * 1024 * 1024;
+  size_t max_slots = H3DMax( cache_bytes / brick_bytes, (size_t)1 );
+
+  GLint max_texture_size = 0;
+  glGetIntegerv( GL_MAX_3D_TEXTURE_SIZE, &max_texture_size );
+
+  // the slot positions must fit in the page table texels.
+  unsigned int max_per_axis = 
+    H3DMin( (unsigned int)max_texture_size / stored_size, 255u );
+
+  size_t nr = bricks.size();
+  if( nr <= max_slots &&
+      nr_bricks[0] <= max_per_axis &&
+      nr_bricks[1] <= max_per_axis &&
+      nr_bricks[2] <= max_per_axis ) {
+    // all bricks fit, keep the layout of the volume.
+    for( unsigned int i = 0; i < 3; ++i ) nr_slots[i] = nr_bricks[i];
+  } else {
+    // a cube of slots.
+    unsigned int n = (unsigned int)
+      std::floor( std::pow( (double)max_slots, 1.0 / 3.0 ) + 1e-6 );
+    n = H3DMax( H3DMin( n, max_per_axis ), 1u );
+    nr_slots[0] = nr_slots[1] = nr_slots[2] = n;
+  }
+
+  unsigned int nr_free = nr_slots[0] * nr_slots[1] * nr_slots[2];
+  free_slots.clear();
+  for( unsigned int i = nr_free; i > 0; --i ) free_slots.push_back( i - 1 );
+  for( size_t i = 0; i < nr; ++i ) {
+    if( bricks[i].slot >= 0 ) {
+      bricks[i].slot = -1;
+      updateBrickTexels( (unsigned int)i );
+    }
+  }
+  stalled = false;
+
+  glGenTextures( 1, &texture_id );
+  GLStateTracker::bindTexture( texture_target, texture_id );
+  glTexImage3D( texture_target, 0, glInternalFormat( image ),
+                nr_slots[0] * stored_size,
+                nr_slots[1] * stored_size,
+                nr_slots[2] * stored_size,
+                0, glPixelFormat( image ), glPixelComponentType( image ),
+                NULL );
+
+  cacheBrickCount->setValue( Vec3f( (H3DFloat)nr_slots[0],
+                                    (H3DFloat)nr_slots[1],
+                                    (H3DFloat)nr_slots[2] ), id );
+}
+
+bool BrickedVolumeTexture::streamBricks( Image *image,
+                                         const Vec3f &viewer_pos ) {
+  using namespace BrickedVolumeTextureInternals;
+  if( stalled && ( viewer_pos - last_viewer_pos ).lengthSqr() < 1e-12 ) {
+    // nothing can be installed until the viewer moves.
+    return true;
+  }
+  last_viewer_pos = viewer_pos;
+
+  Vec3f size = textureSize();
+  unsigned int dims[3] = { image->width(), image->height(), image->depth() };
+
+  // the distance to the viewer of the bricks to install and of the
+  // installed bricks.
+  vector< BrickDistance > wanted, installed;
+  unsigned int index = 0;
+  for( unsigned int z = 0; z < nr_bricks[2]; ++z ) {
+    for( unsigned int y = 0; y < nr_bricks[1]; ++y ) {
+      for( unsigned int x = 0; x < nr_bricks[0]; ++x, ++index ) {
+        const Brick &b = bricks[index];
+        if( b.slot < 0 && b.empty ) continue;
+        unsigned int pos[3] = { x, y, z };
+        Vec3f center;
+        for( unsigned int i = 0; i < 3; ++i ) {
+          unsigned int first = pos[i] * brick_size;
+          H3DFloat middle = 
+            first + H3DMin( brick_size, dims[i] - first ) / 2.0f;
+          center[i] = ( middle / dims[i] - 0.5f ) * size[i];
+        }
+        BrickDistance d( ( center - viewer_pos ).lengthSqr(), index );
+        if( b.slot >= 0 ) installed.push_back( d );
+        else wanted.push_back( d );
+      }
+    }
+  }
+
+  if( wanted.empty() ) {
+    stalled = false;
+    return false;
+  }
+
+  H3DInt32 budget = brickUploadBudget->getValue();
+  unsigned int nr_to_install = 
+    budget <= 0 ? (unsigned int)wanted.size() :
+    H3DMin( (unsigned int)budget, (unsigned int)wanted.size() );
+  std::partial_sort( wanted.begin(), wanted.begin() + nr_to_install,
+                     wanted.end() );
+  // farthest first.
+  std::sort( installed.begin(), installed.end(),
+             std::greater< BrickDistance >() );
+
+  GLint unpack_alignment;
+  glGetIntegerv( GL_UNPACK_ALIGNMENT, &unpack_alignment );
+  glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+
+  unsigned int nr_read = 0;
+  unsigned int next_evicted = 0;
+  for( ; nr_read < nr_to_install; ++nr_read ) {
+    unsigned int slot;
+    if( !free_slots.empty() ) {
+      slot = free_slots.back();
+      free_slots.pop_back();
+    } else if( next_evicted < installed.size() &&
+               installed[next_evicted].first > wanted[nr_read].first ) {
+      // replace a brick farther away.
+      Brick &evicted = bricks[ installed[next_evicted].second ];
+      slot = evicted.slot;
+      evicted.slot = -1;
+      updateBrickTexels( installed[next_evicted].second );
+      ++next_evicted;
+    } else {
+      // the cache holds the nearest bricks that fit.
+      break;
+    }
+
+    if( !installBrick( image, wanted[nr_read].second, slot ) ) {
+      free_slots.push_back( slot );
+    }
+  }
+
+  glPixelStorei( GL_UNPACK_ALIGNMENT, unpack_alignment );
+
+  stalled = nr_read == 0;
+  return true;
+}
+
+bool BrickedVolumeTexture::installBrick( Image *image, unsigned int index,
+                                         unsigned int slot ) {
+  const unsigned char *source = 
+    static_cast< const unsigned char * >( image->getImageData() );
+  if( !source ) return false;
+
+  unsigned int stored_size = brick_size + 2;
+  unsigned int bytes_per_voxel = image->bitsPerPixel() / 8;
+  int dims[3] = { (int)image->width(), (int)image->height(),
+                  (int)image->depth() };
+  unsigned int pos[3] = { index % nr_bricks[0],
+                          ( index / nr_bricks[0] ) % nr_bricks[1],
+                          index / ( nr_bricks[0] * nr_bricks[1] ) };
+
+  // copy the brick with a border of one voxel, clamped to the volume.
+  size_t nr_voxels = (size_t)stored_size * stored_size * stored_size;
+  vector< unsigned char > data( nr_voxels * bytes_per_voxel );
+  unsigned char *dest = &data[0];
+  for( unsigned int z = 0; z < stored_size; ++z ) {
+    int sz = H3DMin( H3DMax( (int)( pos[2] * brick_size + z ) - 1, 0 ),
+                     dims[2] - 1 );
+    for( unsigned int y = 0; y < stored_size; ++y ) {
+      int sy = H3DMin( H3DMax( (int)( pos[1] * brick_size + y ) - 1, 0 ),
+                       dims[1] - 1 );
+      const unsigned char *row = 
+        source + ( (size_t)sz * dims[1] + sy ) * dims[0] * bytes_per_voxel;
+      for( unsigned int x = 0; x < stored_size; ++x ) {
+        int sx = H3DMin( H3DMax( (int)( pos[0] * brick_size + x ) - 1, 0 ),
+                         dims[0] - 1 );
+        memcpy( dest, row + (size_t)sx * bytes_per_voxel, bytes_per_voxel );
+        dest += bytes_per_voxel;
+      }
+    }
+  }
+
+  Brick &brick = bricks[index];
+  BrickedVolumeTextureInternals::valueRange( &data[0], nr_voxels, image,
+                                             brick.min_value,
+                                             brick.max_value );
+  brick.read = true;
+  brick.empty = brick.max_value <= empty_threshold;
+  if( brick.empty ) {
+    updateBrickTexels( index );
+    return false;
+  }
+
+  glTexSubImage3D( texture_target, 0,
+                   ( slot % nr_slots[0] ) * stored_size,
+                   ( ( slot / nr_slots[0] ) % nr_slots[1] ) * stored_size,
+                   ( slot / ( nr_slots[0] * nr_slots[1] ) ) * stored_size,
+                   stored_size, stored_size, stored_size,
+                   glPixelFormat( image ), glPixelComponentType( image ),
+                   &data[0] );
+  brick.slot = (int)slot;
+  updateBrickTexels( index );
+  return true;
+}
+
+void BrickedVolumeTexture::updateEmptyBricks() {
+  H3DFloat threshold = emptyThreshold->getValue();
+  if( threshold == empty_threshold ) return;
+  empty_threshold = threshold;
+
+  // the ranges of the bricks that have been read are known, so they do
+  // not have to be read again.
+  for( unsigned int i = 0; i < bricks.size(); ++i ) {
+    Brick &brick = bricks[i];
+    if( !brick.read ) continue;
+    bool empty = brick.max_value <= threshold;
+    if( empty == brick.empty ) continue;
+    brick.empty = empty;
+    if( empty && brick.slot >= 0 ) {
+      free_slots.push_back( (unsigned int)brick.slot );
+      brick.slot = -1;
+    }
+    updateBrickTexels( i );
+  }
+  // bricks that were empty may have to be installed.
+  stalled = false;
+}
+
+void BrickedVolumeTexture::updateBrickTexels( unsigned int index ) {
+  const Brick &brick = bricks[index];
+
+  Image *page_image = 
+    static_cast< Pixel3DTexture * >( pageTable->getValue() )->image->getValue();
+  unsigned char *entry = 
+    static_cast< unsigned char * >( page_image->getImageData() ) + 
+    (size_t)index * 4;
+  if( brick.slot >= 0 ) {
+    unsigned int slot = (unsigned int)brick.slot;
+    entry[0] = (unsigned char)( slot % nr_slots[0] );
+    entry[1] = (unsigned char)( ( slot / nr_slots[0] ) % nr_slots[1] );
+    entry[2] = (unsigned char)( slot / ( nr_slots[0] * nr_slots[1] ) );
+    entry[3] = 255;
+  } else {
+    entry[0] = entry[1] = entry[2] = 0;
+    entry[3] = brick.empty ? 128 : 0;
+  }
+
+  Image *range_image = 
+    static_cast< Pixel3DTexture * >( brickRange->getValue() )->image->getValue();
+  unsigned char *range = 
+    static_cast< unsigned char * >( range_image->getImageData() ) + 
+    (size_t)index * 2;
+  // rounded outwards so that the range always holds the values.
+  range[0] = (unsigned char)std::floor( brick.min_value * 255 );
+  range[1] = (unsigned char)std::ceil( brick.max_value * 255 );
+
+  texels_changed = true;
+}
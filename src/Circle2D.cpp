@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/Circle2D.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -68,21 +69,21 @@ void Circle2D::DisplayList::callList( bool build_list ) {
   Circle2D *circle = 
    static_cast< Circle2D * >( owner );
 
-  glPushAttrib( GL_CURRENT_BIT );
+  GLStateTracker::pushAttrib( GL_CURRENT_BIT );
   float v[4];
   glGetMaterialfv( GL_FRONT, GL_EMISSION, v );
   glColor3f( v[0], v[1], v[2] );
 
   X3DGeometryNode::DisplayList::callList( build_list );
 
-  glPopAttrib();
+  GLStateTracker::popAttrib();
 }
 
 void Circle2D::render() {
   // Save the old state of GL_LIGHTING 
   GLboolean lighting_enabled;
   glGetBooleanv( GL_LIGHTING, &lighting_enabled );
-  glDisable( GL_LIGHTING );
+  GLStateTracker::disable( GL_LIGHTING );
 
   H3DFloat theta, angle_increment;
   H3DFloat nr_segments = 40;
@@ -109,6 +110,6 @@ void Circle2D::render() {
 
   // reenable lighting if it was enabled before
   if( lighting_enabled )
-    glEnable( GL_LIGHTING );
+    GLStateTracker::enable( GL_LIGHTING );
 }
 
@@ -30,6 +30,7 @@
 
 #include <H3D/ClipPlane.h>
 #include <H3D/H3DHapticsDevice.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -130,7 +131,7 @@ void ClipPlane::enableGraphicsState() {
     const Vec4d &v = plane->getValue();
     GLdouble e[] = { v.x, v.y, v.z, v.w };
     glClipPlane( GL_CLIP_PLANE0 + plane_index, e );
-    glEnable( GL_CLIP_PLANE0 + plane_index );
+    GLStateTracker::enable( GL_CLIP_PLANE0 + plane_index );
   } 
 };
 
@@ -138,7 +139,7 @@ void ClipPlane::disableGraphicsState() {
   if( enabled->getValue() && 
       clipGraphics->getValue() && 
     plane_index < max_nr_clip_planes ) {
-    glDisable( GL_CLIP_PLANE0 + plane_index );
+    GLStateTracker::disable( GL_CLIP_PLANE0 + plane_index );
     --nr_active_clip_planes;
     plane_index = -1;
   }
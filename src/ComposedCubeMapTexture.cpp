@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/ComposedCubeMapTexture.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -175,7 +176,7 @@ void ComposedCubeMapTexture::render() {
       } 
 
       if( !invalid_dims ) {
-        glBindTexture( GL_TEXTURE_CUBE_MAP_ARB, cube_map_id );
+        GLStateTracker::bindTexture( GL_TEXTURE_CUBE_MAP_ARB, cube_map_id );
         if( textureUpdated->hasCausedEvent( back ) && 
             back_tex->image->getValue() ){
           back_tex->glTexImage( back_tex->image->getValue(), 
@@ -221,7 +222,7 @@ void ComposedCubeMapTexture::render() {
                           GL_LINEAR);
         } 
       } else {
-        glBindTexture( GL_TEXTURE_CUBE_MAP_ARB, 0 );
+        GLStateTracker::bindTexture( GL_TEXTURE_CUBE_MAP_ARB, 0 );
         Console(LogLevel::Warning) << "Warning: Invalid cube map textures in \"" << getName()
                    << "\" node. All images must have the same square dimensions."
                    << endl;
@@ -235,10 +236,10 @@ void ComposedCubeMapTexture::render() {
 }
 
 void ComposedCubeMapTexture::enableTexturing() {
-  glEnable( GL_TEXTURE_CUBE_MAP_ARB );
+  GLStateTracker::enable( GL_TEXTURE_CUBE_MAP_ARB );
 }
 
 void ComposedCubeMapTexture::disableTexturing() {
-  glDisable( GL_TEXTURE_CUBE_MAP_ARB );
+  GLStateTracker::disable( GL_TEXTURE_CUBE_MAP_ARB );
 }
 
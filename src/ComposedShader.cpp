@@ -34,10 +34,14 @@
 #include <H3D/ShaderAtomicCounter.h>
 #include <H3D/GlobalSettings.h>
 #include <H3D/GraphicsHardwareInfo.h>
+#include <H3D/GLStateTracker.h>
 
 #include<fstream>
 #include<sstream>
 #include<algorithm>
+#include<iomanip>
+#include<iterator>
+#include<cstring>
 
 using namespace H3D;
 using namespace std;
@@ -46,6 +50,8 @@ bool ComposedShader::tessellation_support_checked= false;
 
 map<string, GLhandleARB> ComposedShader::phandles_map;
 map<GLhandleARB, int> ComposedShader::phandle_counts;
+map< string, ComposedShader::PendingLink > ComposedShader::pending_links;
+vector< ComposedShader::ProgramBuildTime > ComposedShader::program_build_times;
 
 // Add this node to the H3DNodeDatabase system.
 H3DNodeDatabase ComposedShader::database( 
@@ -63,6 +69,7 @@ namespace ComposedShaderInternals {
   FIELDDB_ELEMENT( ComposedShader, transparencyDetectMode, INPUT_OUTPUT );
   FIELDDB_ELEMENT( ComposedShader, transformFeedbackVaryings, INPUT_OUTPUT );
   FIELDDB_ELEMENT( ComposedShader, printShaderWarnings, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( ComposedShader, packUniformsInBuffers, INPUT_OUTPUT );
 #ifdef EXPORT_SHADER
   FIELDDB_ELEMENT( ComposedShader, saveShadersToUrl, INPUT_OUTPUT );
 #endif
@@ -81,7 +88,8 @@ ComposedShader::ComposedShader( Inst< DisplayList  > _displayList,
                                 Inst< SFInt32      > _geometryVerticesOut,
                                 Inst< SFString     > _transparencyDetectMode,
                                 Inst< MFString     > _transformFeedbackVaryings,
-                                Inst< SFBool       > _printShaderWarnings
+                                Inst< SFBool       > _printShaderWarnings,
+                                Inst< SFBool       > _packUniformsInBuffers
 #ifdef EXPORT_SHADER
                                 ,
                                 Inst< UpdateSaveShadersToUrl > _saveShadersToUrl
@@ -98,10 +106,14 @@ ComposedShader::ComposedShader( Inst< DisplayList  > _displayList,
   transparencyDetectMode( _transparencyDetectMode ),
   transformFeedbackVaryings ( _transformFeedbackVaryings ),
   printShaderWarnings ( _printShaderWarnings ),
+  packUniformsInBuffers ( _packUniformsInBuffers ),
 #ifdef EXPORT_SHADER
   saveShadersToUrl( _saveShadersToUrl ),
 #endif
   program_handle( 0 ),
+  share_relinked_program( false ),
+  link_pending( false ),
+  share_link( true ),
   setupDynamicRoutes( new SetupDynamicRoutes ),
   updateUniforms ( new UpdateUniforms ),
   debug_options_previous( NULL ),
@@ -111,6 +123,7 @@ ComposedShader::ComposedShader( Inst< DisplayList  > _displayList,
 
   suppressUniformWarnings->setValue( false );
   printShaderWarnings->setValue( false );
+  packUniformsInBuffers->setValue( false );
 
   geometryInputType->addValidValue( "POINTS");
   geometryInputType->addValidValue( "LINES");
@@ -149,6 +162,7 @@ ComposedShader::ComposedShader( Inst< DisplayList  > _displayList,
   // need to update uniform values if shader is re-linked
   // displayList->route ( updateUniforms );
   activate->route( updateUniforms, id );
+  packUniformsInBuffers->route( updateUniforms, id );
 }
 
 bool ComposedShader::shader_support_checked = false;
@@ -265,20 +279,20 @@ GLbitfield ComposedShader::getAffectedGLAttribs() {
 
 void ComposedShader::preRender() {
   if( GLEW_ARB_shader_objects ) {
-    glUseProgramObjectARB( program_handle );
+    GLStateTracker::useProgram( program_handle );
     Shaders::preRenderTextures( this );
     //Shaders::preRenderTextures( &shader_textures, &max_texture_in_shader );
     Shaders::preRenderShaderResources( this, program_handle );
     X3DShaderNode::preRender();
   }
 
-  glEnable( GL_BLEND );
+  GLStateTracker::enable( GL_BLEND );
   glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
 void ComposedShader::postRender() {
   if( GLEW_ARB_shader_objects ) {
-    glUseProgramObjectARB( 0 );
+    GLStateTracker::useProgram( 0 );
     Shaders::postRenderTextures( this );
     //Shaders::postRenderTextures(&shader_textures, &max_texture_in_shader);
     X3DShaderNode::postRender();
@@ -340,7 +354,8 @@ void ComposedShader::traverseSG ( TraverseInfo& ti ) {
 
 // The ComposedShader is modified to use 1 instance of different program_handlers
 // that share the same set of shader parts. However, a new program_handle object 
-// will be created when the Shader is re-activated (regardsless)
+// will be created when the Shader is re-activated (regardsless, unless
+// share_relinked_program is true)
 
 
 void ComposedShader::render() {
@@ -353,6 +368,7 @@ void ComposedShader::render() {
     if( isValid->getValue() ) isValid->setValue( false, id );
   } else {
     bool all_parts_valid = true;
+    bool parts_pending = false;
     
     // compile all shader parts
     bool re_link= false;
@@ -360,7 +376,10 @@ void ComposedShader::render() {
          i != parts->end(); ++i ) {
       ShaderPart* s= static_cast< ShaderPart * >(*i);
       re_link|= !s->isCompiled();
-      if( s->compileShader() == 0 ) {
+      s->compileShader();
+      if( s->isCompilePending() ) {
+        parts_pending = true;
+      } else if( s->getShaderHandle() == 0 ) {
         all_parts_valid = false;
       }
     }
@@ -369,81 +388,36 @@ void ComposedShader::render() {
       activate->setValue ( true );
     }
 
+    if( all_parts_valid && parts_pending ) {
+      // the parts are compiled asynchronously, render without the
+      // shader until they are done.
+      GLStateTracker::useProgram( 0 );
+      displayList->breakCache();
+      return;
+    }
+
     if( isValid->getValue() != all_parts_valid )
       isValid->setValue( all_parts_valid, id );
     
     if( all_parts_valid )
     {
-      // if the first time we run the shader and there is some part attached
-      if ( !program_handle && parts->size() ) {
-        std::string key = ComposedShader::genKeyFromShader( this );
-
-        if (phandles_map.find(key) != phandles_map.end()) {
-          // if a handle found, use that!
-          program_handle = phandles_map[key];
-          ++(phandle_counts[program_handle]);
-          //std::cout<< getName() << " use program handle " << program_handle
-          // << std::endl;
-          glUseProgramObjectARB( program_handle );
-        } else {
-          // if not, create one, link to shaderparts
-          GLhandleARB h = createHandle( this );
-          if (h != 0) {
-            // use that handle
-            program_handle = h;
-            glUseProgramObjectARB( h );
-            phandle_counts[h] = 1;
-            phandles_map[key] = h;
-            // register shader objects
-            for ( MFShaderPart::const_iterator i = parts->begin();
-                  i != parts->end(); ++i ) {
-              current_shaders.push_back(
-                static_cast< ShaderPart * >(*i)->getShaderHandle() );
-            }
-          }
-        }
-      }
-
       // if a TRUE event has been sent to the activate field we 
-      // relink the program (without looking up)
-      else if( activateMonitor->hasCausedEvent(activate)&&activate->getValue(id) ) {
-        // deallocate old instance if not used anywhere
-        if (phandle_counts.find(program_handle) != phandle_counts.end()) {
-          --(phandle_counts[program_handle]);
-          if (phandle_counts[program_handle] == 0) {
-            // detach the old shaders from the program
-            for( vector< GLhandleARB >::iterator i = current_shaders.begin();
-              i != current_shaders.end(); ++i ) {
-              glDetachObjectARB( program_handle, *i );
-            }
-            current_shaders.clear();
-            // delete object
-            //std::cout<< this->getName() << " remove phandle "
-            //         << program_handle << std::endl;
-            glDeleteObjectARB( program_handle );
-            phandle_counts.erase( program_handle );
-          }
-        } else {
-          // if not, this is a floating program handle. delete it anyway
-          //std::cout<< this->getName() << " remove phandle " << program_handle
-          //         << std::endl;
-          glDeleteObjectARB( program_handle );
-        }
+      // relink the program
+      if( program_handle && 
+          activateMonitor->hasCausedEvent(activate)&&activate->getValue(id) ) {
+        releaseProgram();
+        share_link = share_relinked_program;
+      } else if( !link_pending ) {
+        share_link = true;
+      }
 
-        // we can't use the old instance (because that forces other
-        // shaders to re-link)
-
-        GLhandleARB h = createHandle(this);
-        if (h != 0) {
-          program_handle = h;
-          glUseProgramObjectARB( h );
-          // register shader objects
-          for ( MFShaderPart::const_iterator i = parts->begin();
-                i != parts->end(); ++i ) {
-            current_shaders.push_back(
-              static_cast< ShaderPart * >(*i)->getShaderHandle() );
-          }
-        }
+      // if the first time we run the shader and there is some part attached
+      if( !program_handle && parts->size() && !setupProgram( share_link ) ) {
+        // the program is linked asynchronously, render without the
+        // shader until it is done.
+        GLStateTracker::useProgram( 0 );
+        displayList->breakCache();
+        return;
       }
     }
 
@@ -460,6 +434,22 @@ void ComposedShader::render() {
 
       updateUniforms->upToDate();
 
+      // if the program is shared with other nodes they may have set
+      // other uniform values since this node was rendered. All values
+      // are checked, but only the ones that differ from the values last
+      // set in the program are sent.
+      map< GLhandleARB, int >::iterator c = phandle_counts.find( program_handle );
+      if( c != phandle_counts.end() && (*c).second > 1 ) {
+        for( UniformFieldMap::iterator i = uniformFields.begin();
+             i != uniformFields.end(); ++i ) {
+          setUniformValue( (*i).first, (*i).second, false );
+        }
+      }
+
+      for( unsigned int i = 0; i < uniform_blocks.size(); ++i ) {
+        uniform_blocks[i]->render();
+      }
+
 //#ifdef HAVE_PROFILER
 //      H3DTimer::stepEnd("updateUniform");
 //#endif
@@ -468,6 +458,260 @@ void ComposedShader::render() {
   activateMonitor->upToDate();
 }
 
+namespace ComposedShaderInternals {
+  // 64 bit FNV-1a hash of a string.
+  GLuint64 hashString( const string &s, GLuint64 hash = 14695981039346656037ULL ) {
+    for( string::const_iterator i = s.begin(); i != s.end(); ++i ) {
+      hash ^= (unsigned char)(*i);
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  // Identifies the format of the files in the program binary cache.
+  const char program_binary_magic[] = "H3DPROG2";
+}
+
+string ComposedShader::getProgramBinaryFile( ComposedShader *shader,
+                                             string &key ) {
+  using namespace ComposedShaderInternals;
+  GraphicsOptions *options = NULL;
+  GlobalSettings *default_settings = GlobalSettings::getActive();
+  if( default_settings ) default_settings->getOptionNode( options );
+  if( !options ) return "";
+  string dir = options->shaderProgramCacheDirectory->getValue();
+  if( dir == "" || !GLEW_ARB_get_program_binary ) return "";
+
+  // a program binary is only valid for the driver that created it.
+  stringstream key_ss;
+  const GLubyte *vendor = glGetString( GL_VENDOR );
+  const GLubyte *renderer = glGetString( GL_RENDERER );
+  const GLubyte *version = glGetString( GL_VERSION );
+  if( vendor ) key_ss << vendor;
+  key_ss << "\n";
+  if( renderer ) key_ss << renderer;
+  key_ss << "\n";
+  if( version ) key_ss << version;
+  key_ss << "\n" << shader->geometryInputType->getValue()
+         << "\n" << shader->geometryOutputType->getValue()
+         << "\n" << shader->geometryVerticesOut->getValue() << "\n";
+  const vector< string > &varyings = shader->transformFeedbackVaryings->getValue();
+  for( unsigned int i = 0; i < varyings.size(); ++i ) {
+    key_ss << varyings[i] << "\n";
+  }
+  for( MFShaderPart::const_iterator i = shader->parts->begin();
+       i != shader->parts->end(); ++i ) {
+    ShaderPart *part = static_cast< ShaderPart * >(*i);
+    const string &source = part->shaderString->getValue();
+    // the length keeps the sources of different parts apart.
+    key_ss << part->type->getValue() << "\n" << source.size() << "\n"
+           << source;
+  }
+  key = key_ss.str();
+  GLuint64 hash = hashString( key );
+
+  stringstream file;
+  char last = dir[ dir.size() - 1 ];
+  file << dir;
+  if( last != '/' && last != '\\' ) file << "/";
+  file << std::hex << std::setw( 16 ) << std::setfill( '0' ) << hash << ".bin";
+  return file.str();
+}
+
+bool ComposedShader::loadProgramBinary( GLhandleARB program, 
+                                        const string &file,
+                                        const string &key ) {
+  using namespace ComposedShaderInternals;
+  ifstream is( file.c_str(), ios::in | ios::binary );
+  if( !is.good() ) return false;
+
+  char magic[ sizeof( program_binary_magic ) ];
+  GLuint key_size = 0;
+  is.read( magic, sizeof( magic ) );
+  is.read( (char *)&key_size, sizeof( key_size ) );
+  if( !is.good() || 
+      memcmp( magic, program_binary_magic, sizeof( magic ) ) != 0 ||
+      key_size != key.size() ) {
+    return false;
+  }
+
+  // the file name is only a hash of the key, so the file can be for
+  // another program with the same hash.
+  vector< char > file_key( key_size );
+  if( key_size > 0 ) is.read( &file_key[0], key_size );
+  if( !is.good() || 
+      ( key_size > 0 && 
+        memcmp( &file_key[0], key.data(), key_size ) != 0 ) ) {
+    return false;
+  }
+
+  GLenum format = 0;
+  is.read( (char *)&format, sizeof( format ) );
+  if( !is.good() ) return false;
+  vector< char > binary( ( std::istreambuf_iterator< char >( is ) ),
+                         std::istreambuf_iterator< char >() );
+  if( binary.empty() ) return false;
+
+  glProgramBinary( program, format, &binary[0], (GLsizei)binary.size() );
+  GLint link_success = GL_FALSE;
+  glGetProgramiv( program, GL_LINK_STATUS, &link_success );
+  // clear any error caused by a rejected binary.
+  while( glGetError() != GL_NO_ERROR );
+  return link_success == GL_TRUE;
+}
+
+void ComposedShader::saveProgramBinary( GLhandleARB program, 
+                                        const string &file,
+                                        const string &key ) {
+  using namespace ComposedShaderInternals;
+  GLint length = 0;
+  glGetProgramiv( program, GL_PROGRAM_BINARY_LENGTH, &length );
+  if( length <= 0 ) return;
+
+  vector< char > binary( length );
+  GLenum format = 0;
+  glGetProgramBinary( program, length, NULL, &format, &binary[0] );
+  if( glGetError() != GL_NO_ERROR ) return;
+
+  ofstream os( file.c_str(), ios::out | ios::binary );
+  if( !os.good() ) {
+    Console(LogLevel::Warning) << "Warning: Could not write shader program "
+                               << "binary to \"" << file << "\"." << endl;
+    return;
+  }
+  GLuint key_size = (GLuint)key.size();
+  os.write( program_binary_magic, sizeof( program_binary_magic ) );
+  os.write( (const char *)&key_size, sizeof( key_size ) );
+  os.write( key.data(), key.size() );
+  os.write( (const char *)&format, sizeof( format ) );
+  os.write( &binary[0], binary.size() );
+}
+
+void ComposedShader::releaseProgram() {
+  // deallocate old instance if not used anywhere
+  if (phandle_counts.find(program_handle) != phandle_counts.end()) {
+    --(phandle_counts[program_handle]);
+    if (phandle_counts[program_handle] == 0) {
+      // detach the old shaders from the program
+      for( vector< GLhandleARB >::iterator i = current_shaders.begin();
+        i != current_shaders.end(); ++i ) {
+        glDetachObjectARB( program_handle, *i );
+      }
+      // delete object
+      //std::cout<< this->getName() << " remove phandle "
+      //         << program_handle << std::endl;
+      Shaders::clearUniformCache( program_handle );
+      glDeleteObjectARB( program_handle );
+      phandle_counts.erase( program_handle );
+      // the program must not be found by key anymore.
+      for( map< string, GLhandleARB >::iterator i = phandles_map.begin();
+           i != phandles_map.end(); ) {
+        if( (*i).second == program_handle ) phandles_map.erase( i++ );
+        else ++i;
+      }
+    }
+  } else {
+    // if not, this is a floating program handle. delete it anyway
+    //std::cout<< this->getName() << " remove phandle " << program_handle
+    //         << std::endl;
+    Shaders::clearUniformCache( program_handle );
+    glDeleteObjectARB( program_handle );
+  }
+  current_shaders.clear();
+  program_handle = 0;
+}
+
+bool ComposedShader::setupProgram( bool share ) {
+  std::string key = ComposedShader::genKeyFromShader( this );
+
+  if( share && phandles_map.find( key ) != phandles_map.end() ) {
+    // if a handle found, use that!
+    program_handle = phandles_map[key];
+    ++(phandle_counts[program_handle]);
+    //std::cout<< getName() << " use program handle " << program_handle
+    // << std::endl;
+    GLStateTracker::useProgram( program_handle );
+    link_pending = false;
+    return true;
+  }
+
+  // programs that are not shared are linked separately for each node.
+  string pending_key = key;
+  if( !share ) {
+    stringstream s;
+    s << key << "@" << this;
+    pending_key = s.str();
+  }
+
+  map< string, PendingLink >::iterator p = pending_links.find( pending_key );
+  if( p == pending_links.end() ) {
+    // if not, create one, link to shaderparts. We can't use the old 
+    // instance (because that forces other shaders to re-link)
+    PendingLink link;
+    link.start_time = TimeStamp();
+    link.program = linkProgram( this, link.binary_file, link.binary_key,
+                                link.loaded_binary );
+    if( link.program && ShaderPart::asyncCompilation() ) {
+      pending_links[ pending_key ] = link;
+      link_pending = true;
+      return false;
+    }
+    p = pending_links.insert( make_pair( pending_key, link ) ).first;
+  } else {
+#ifdef GL_COMPLETION_STATUS_ARB
+    GLint done = GL_TRUE;
+    glGetObjectParameterivARB( (*p).second.program, 
+                               GL_COMPLETION_STATUS_ARB, &done );
+    if( done == GL_FALSE ) {
+      link_pending = true;
+      return false;
+    }
+#endif
+  }
+
+  PendingLink link = (*p).second;
+  pending_links.erase( p );
+  link_pending = false;
+  GLhandleARB h = 0;
+  if( link.program ) {
+    h = checkLinkStatus( this, link.program, link.binary_file,
+                         link.binary_key, link.loaded_binary );
+    addProgramBuildTime( TimeStamp() - link.start_time );
+  }
+
+  if (h != 0) {
+    // use that handle
+    program_handle = h;
+    GLStateTracker::useProgram( h );
+    if( share ) {
+      phandle_counts[h] = 1;
+      phandles_map[key] = h;
+    }
+    // register shader objects
+    for ( MFShaderPart::const_iterator i = parts->begin();
+          i != parts->end(); ++i ) {
+      current_shaders.push_back(
+        static_cast< ShaderPart * >(*i)->getShaderHandle() );
+    }
+  }
+  return true;
+}
+
+void ComposedShader::addProgramBuildTime( H3DTime link_time ) {
+  ProgramBuildTime t;
+  t.name = getName();
+  t.compile_time = 0;
+  t.link_time = link_time;
+  for( MFShaderPart::const_iterator i = parts->begin();
+       i != parts->end(); ++i ) {
+    t.compile_time += static_cast< ShaderPart * >(*i)->getCompileTime();
+  }
+  if( program_build_times.size() >= max_program_build_times ) {
+    program_build_times.erase( program_build_times.begin() );
+  }
+  program_build_times.push_back( t );
+}
+
 // check if any existing program handle using the same set of ShaderParts
 // so that we can reuse the program handle
 // Return the handle if found, zero if not found
@@ -489,9 +733,15 @@ std::string ComposedShader::genKeyFromShader(ComposedShader* shader)
 }
 
 
-// create handle and link to shaderparts. return 0 if failed.
+// create handle and start linking it to shaderparts. return 0 if failed.
 // Preclusion: parts > 0
-GLhandleARB ComposedShader::createHandle(ComposedShader* shader) {
+GLhandleARB ComposedShader::linkProgram( ComposedShader* shader,
+                                         string &binary_file,
+                                         string &binary_key,
+                                         bool &loaded_binary ) {
+  binary_file = "";
+  binary_key = "";
+  loaded_binary = false;
   if ( !shader->parts->size() )
     return 0;
 
@@ -516,8 +766,27 @@ GLhandleARB ComposedShader::createHandle(ComposedShader* shader) {
     glTransformFeedbackVaryings(program_handle, varyings.size(), &varyings[0], GL_INTERLEAVED_ATTRIBS);
   }
 
-  // link shader program
-  glLinkProgramARB( program_handle );
+  // use the linked program from the program binary cache if there is
+  // one, otherwise link the shader program
+  binary_file = getProgramBinaryFile( shader, binary_key );
+  loaded_binary = binary_file != "" && 
+    loadProgramBinary( program_handle, binary_file, binary_key );
+  if( !loaded_binary ) {
+    if( binary_file != "" ) {
+      glProgramParameteri( program_handle, 
+                           GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+    }
+    glLinkProgramARB( program_handle );
+  }
+  return program_handle;
+}
+
+// check the result of linking a program. return 0 if failed.
+GLhandleARB ComposedShader::checkLinkStatus( ComposedShader* shader,
+                                             GLhandleARB program_handle,
+                                             const string &binary_file,
+                                             const string &binary_key,
+                                             bool loaded_binary ) {
   GLint link_success;
   glGetObjectParameterivARB( program_handle, GL_OBJECT_LINK_STATUS_ARB,
                              &link_success );
@@ -544,6 +813,7 @@ GLhandleARB ComposedShader::createHandle(ComposedShader* shader) {
       }
 	  
       if( print_error == 1 ) {
+        Shaders::clearUniformCache( program_handle );
         glDeleteObjectARB( program_handle );
         program_handle = 0;
       }
@@ -551,6 +821,10 @@ GLhandleARB ComposedShader::createHandle(ComposedShader* shader) {
     }
   }
 
+  if( program_handle && !loaded_binary && binary_file != "" ) {
+    saveProgramBinary( program_handle, binary_file, binary_key );
+  }
+
   //std::cout<< const_cast<ComposedShader&>(*shader).getName()
   //  << " created program handle " << program_handle << std::endl;
 
@@ -699,16 +973,19 @@ void ComposedShader::SetupDynamicRoutes::update() {
 
 void ComposedShader::UpdateUniforms::update() {
   ComposedShader* node= static_cast<ComposedShader*>(getOwner());
-  bool update_all= hasCausedEvent ( node->activate );
+  bool update_all= hasCausedEvent ( node->activate ) ||
+    hasCausedEvent( node->packUniformsInBuffers );
   if( update_all ) { // program re-linked, need to update all uniform
+    node->setupUniformBlocks();
     // update the uniform location information in unifromFields
     UniformFieldMap::iterator it;
     for( it = node->uniformFields.begin(); it!= node->uniformFields.end(); ++it  ) {
       const string &_name = it->first;
-      GLint location = glGetUniformLocationARB( node->program_handle,
-        _name.c_str() );
-      it->second.location = location;
-      if( !Shaders::setGLSLUniformVariableValue( node->program_handle, it->second.field, &(it->second), true /* force update */ ) 
+      if( !it->second.block ) {
+        it->second.location = 
+          Shaders::getUniformLocation( node->program_handle, _name );
+      }
+      if( !node->setUniformValue( _name, it->second, true /* force update */ ) 
         && !node->suppressUniformWarnings->getValue() ) {
         Console(LogLevel::Warning) << "Warning: Uniform variable \"" << it->first
           << "\" not defined in shader source or field is of unsupported field type of the ShaderPart nodes "
@@ -725,13 +1002,10 @@ void ComposedShader::UpdateUniforms::update() {
   for( it = node->uniformFields.begin(); it!= node->uniformFields.end(); ++it ) {
     Field* current_field = it->second.field;
     if( hasCausedEvent( current_field ) ) {// current_field update since last time
-      //if( current_field->getTypeName()=="SFUniform" ) {
-      //  // this is a SFUniform value, check if its value actually changed
       current_field->upToDate();
       // within setGLSLUniformVariableValue, check if the updated value
       // is the same as before to decide whether to reload uniform value to GPU
-      if( !Shaders::setGLSLUniformVariableValue( node->program_handle, 
-        it->second.field, &it->second ) &&
+      if( !node->setUniformValue( it->first, it->second, false ) &&
         !node->suppressUniformWarnings->getValue() ) {
           Console(LogLevel::Warning) << "Warning: Uniform variable \"" << it->first
             << "\" not defined in shader source or field is of unsupported field type of the ShaderPart nodes "
@@ -743,6 +1017,48 @@ void ComposedShader::UpdateUniforms::update() {
   EventCollectingField < Field >::update();
 }
 
+void ComposedShader::setupUniformBlocks() {
+  uniform_blocks.clear();
+  for( UniformFieldMap::iterator it = uniformFields.begin();
+       it != uniformFields.end(); ++it ) {
+    it->second.block = NULL;
+  }
+
+  if( !packUniformsInBuffers->getValue() || !program_handle ) return;
+  if( !GLEW_ARB_uniform_buffer_object ) {
+    Console(LogLevel::Warning) << "Warning: packUniformsInBuffers in \""
+      << getName() << "\" requires the OpenGL extension "
+      << "GL_ARB_uniform_buffer_object which is not supported by your "
+      << "graphics card. Uniforms are set one by one." << endl;
+    return;
+  }
+
+  GLint nr_blocks = 0;
+  glGetProgramiv( program_handle, GL_ACTIVE_UNIFORM_BLOCKS, &nr_blocks );
+  for( GLint i = 0; i < nr_blocks; ++i ) {
+    uniform_blocks.push_back( 
+      new Shaders::UniformBlockBuffer( program_handle, i, i ) );
+  }
+
+  for( UniformFieldMap::iterator it = uniformFields.begin();
+       it != uniformFields.end(); ++it ) {
+    for( unsigned int i = 0; i < uniform_blocks.size(); ++i ) {
+      if( uniform_blocks[i]->hasMember( it->first ) ) {
+        it->second.block = uniform_blocks[i];
+        break;
+      }
+    }
+  }
+}
+
+bool ComposedShader::setUniformValue( const string &name,
+                                      Shaders::UniformInfo &ui,
+                                      bool force ) {
+  if( ui.block ) return ui.block->setValue( name, ui.field );
+  return Shaders::setGLSLUniformVariableValue( program_handle, ui.field,
+                                               &ui, force );
+}
+
 #ifdef EXPORT_SHADER
 
 void ComposedShader::UpdateSaveShadersToUrl::onNewValue( const std::string &v ){
@@ -44,6 +44,67 @@ namespace ConeInternals {
   FIELDDB_ELEMENT( Cone, height, INPUT_OUTPUT );
   FIELDDB_ELEMENT( Cone, side, INPUT_OUTPUT );
   FIELDDB_ELEMENT( Cone, solid, INPUT_OUTPUT );
+
+  // The number of faces around the cone.
+  const int nr_faces = 120;
+
+  // Indices of the parts in the cone mesh.
+  enum ConePart {
+    SIDE = 0,
+    BOTTOM = 1
+  };
+
+  // Build the mesh for a cone. params[0] is the bottom radius and
+  // params[1] is the height.
+  void buildMesh( const vector< H3DFloat > &params,
+                  PrimitiveMeshCache::Mesh &mesh ) {
+    const H3DFloat l_radius = params[0];
+    const H3DFloat l_height = params[1];
+    const H3DFloat half_height = l_height / 2;
+
+    mesh.vertex_data.reserve(
+      ( 3 * nr_faces + 2 ) * PrimitiveMeshCache::Mesh::components_per_vertex );
+    mesh.index_data.reserve( ( 2 * nr_faces - 2 ) * 3 );
+
+    // Side. Each column has its own apex vertex in order to get the
+    // normals and texture coordinates right.
+    mesh.beginPart();
+    H3DFloat normal_y = atan( l_radius / l_height );
+    for( int i = 0; i <= nr_faces; ++i ) {
+      H3DFloat ratio = (H3DFloat) i / nr_faces;
+      H3DFloat angle = ratio * (H3DFloat)Constants::pi*2;
+      H3DFloat sina = i == nr_faces ? 0 : H3DSin( angle );
+      H3DFloat cosa = i == nr_faces ? 1 : H3DCos( angle );
+      Vec3f normal( -sina, normal_y, -cosa );
+      GLuint v = mesh.addVertex( Vec3f( 0, half_height, 0 ),
+                                 normal, Vec3f( ratio, 1, 0 ) );
+      mesh.addVertex( Vec3f( -l_radius * sina, -half_height,
+                             -l_radius * cosa ),
+                      normal, Vec3f( ratio, 0, 0 ) );
+      if( i < nr_faces ) {
+        mesh.addTriangle( v, v + 1, v + 3 );
+      }
+    }
+
+    // Bottom.
+    mesh.beginPart();
+    GLuint base_vertex_index = 0;
+    for( int i = 0; i < nr_faces; ++i ) {
+      H3DFloat angle = (H3DFloat)( i * (Constants::pi*2) / nr_faces );
+      H3DFloat sina = H3DSin( angle );
+      H3DFloat cosa = H3DCos( angle );
+      GLuint v =
+        mesh.addVertex( Vec3f( -l_radius * sina, -half_height,
+                               -l_radius * cosa ),
+                        Vec3f( 0, -1, 0 ),
+                        Vec3f( 0.5f - 0.5f * sina, 0.5f + 0.5f * cosa, 0 ) );
+      if( i == 0 ) {
+        base_vertex_index = v;
+      } else if( i > 1 ) {
+        mesh.addTriangle( base_vertex_index, v, v - 1 );
+      }
+    }
+  }
 }
 
 Cone::Cone( 
@@ -59,7 +120,9 @@ Cone::Cone(
   bottomRadius( _bottomRadius ),
   height      ( _height       ),
   side        ( _side         ),
-  solid       ( _solid        ) {
+  solid       ( _solid        ),
+  meshFieldsUpToDate( new Field ),
+  mesh( NULL ) {
 
 
   type_name = "Cone";
@@ -79,50 +142,57 @@ Cone::Cone(
   height->route( displayList );
   side->route( displayList );
   solid->route( displayList );
+
+  meshFieldsUpToDate->setName( "meshFieldsUpToDate" );
+  bottomRadius->route( meshFieldsUpToDate );
+  height->route( meshFieldsUpToDate );
+}
+
+Cone::~Cone() {
+  PrimitiveMeshCache::releaseMesh( mesh );
+  mesh = NULL;
+}
+
+PrimitiveMeshCache::Mesh *Cone::getMesh() {
+  if( !mesh || !meshFieldsUpToDate->isUpToDate() ) {
+    meshFieldsUpToDate->upToDate();
+    vector< H3DFloat > params( 2 );
+    params[0] = bottomRadius->getValue();
+    params[1] = height->getValue();
+    PrimitiveMeshCache::Mesh *new_mesh =
+      PrimitiveMeshCache::getMesh( "Cone", params,
+                                   &ConeInternals::buildMesh );
+    PrimitiveMeshCache::releaseMesh( mesh );
+    mesh = new_mesh;
+  }
+  return mesh;
+}
+
+unsigned int Cone::getPartMask() {
+  unsigned int part_mask = 0;
+  if( side->getValue() ) part_mask |= 1 << ConeInternals::SIDE;
+  if( bottom->getValue() ) part_mask |= 1 << ConeInternals::BOTTOM;
+  return part_mask;
 }
 
 
 void Cone::render() {
   X3DGeometryNode::render();     
-  
-  const H3DFloat l_radius = bottomRadius->getValue();
-  const H3DFloat l_height = height->getValue();
-  int nr_faces = 120;
-  
-  // render side
-  if ( side->getValue() ) {
-    glBegin( GL_QUAD_STRIP );
-    for( int i=0; i<=nr_faces; ++i ) {
-      H3DFloat ratio = (H3DFloat) i / nr_faces;
-      H3DFloat angle =  ratio * (H3DFloat)Constants::pi*2;
-      
-      H3DFloat sina = sin( angle );
-      H3DFloat cosa = cos( angle );
-      
-      glNormal3f( -sina, atan( l_radius / l_height ) , -cosa );
-      renderTexCoordForActiveTexture( Vec3f( ratio, 1, 0 ) );
-      glVertex3f( 0, l_height / 2, 0 );
-      renderTexCoordForActiveTexture( Vec3f( ratio, 0, 0 ) );
-      glVertex3f( -l_radius * sina, -l_height / 2, -l_radius * cosa );
-    }
-    glEnd();
-  }
-  
-  // render bottom
-  if ( bottom->getValue() ) {
-    glBegin( GL_POLYGON );
-    glNormal3f( 0, -1, 0 );
-    for( int i = nr_faces; i >= 0; --i ) {
-      float angle = (float)( i * (Constants::pi*2) / (float) nr_faces);
-      float sina = sin( angle );
-      float cosa = cos( angle );
-      renderTexCoordForActiveTexture( Vec3f( 0.5f - 0.5f * sina, 0.5f + 0.5f * cosa, 0 ) );
-      glVertex3f( -l_radius * sina, -l_height / 2, -l_radius * cosa );
-    }
-    glEnd();
-  }
+  getMesh()->render( getPartMask(),
+                     PrimitiveMeshCache::usingVertexBufferObjects( this ) );
 }
 
+bool Cone::renderInstanced( GLsizei nr_instances ) {
+  getMesh()->render( getPartMask(),
+                     PrimitiveMeshCache::usingVertexBufferObjects( this ),
+                     nr_instances );
+  return true;
+}
+
+bool Cone::getTriangles( vector< HAPI::Collision::Triangle > &triangles ) {
+  getMesh()->getTriangles( getPartMask(), triangles );
+  return true;
+}
 
 void Cone::traverseSG( TraverseInfo &ti ) {
   X3DGeometryNode::traverseSG( ti );
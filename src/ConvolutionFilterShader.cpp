@@ -16,6 +16,7 @@
 #include <H3D/ConvolutionFilterShader.h>
 #include <H3D/GeneratedTexture.h>
 #include <H3D/RenderTargetTexture.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -122,12 +123,12 @@ void ConvolutionFilterShader::traverseSG( TraverseInfo &ti ) {
     if( gen_tex &&
         gen_tex->textureIdIsInitialized()) {
       GLuint tex_id = gen_tex->getTextureId();
-      glPushAttrib( GL_TEXTURE_BIT );
-      glBindTexture( gen_tex->getTextureTarget(), tex_id );
+      GLStateTracker::pushAttrib( GL_TEXTURE_BIT );
+      GLStateTracker::bindTexture( gen_tex->getTextureTarget(), tex_id );
       GLint h,w;
       glGetTexLevelParameteriv(gen_tex->getTextureTarget(), 0, GL_TEXTURE_WIDTH, &w);
       glGetTexLevelParameteriv(gen_tex->getTextureTarget(), 0, GL_TEXTURE_HEIGHT, &h);
-      glPopAttrib();
+      GLStateTracker::popAttrib();
       if( width->getValue()==-1 ) {
         widthInUse->setValue(w,id);
       }else{
@@ -145,12 +146,12 @@ void ConvolutionFilterShader::traverseSG( TraverseInfo &ti ) {
   }
   if( rtt ) {// if texture is a renderTargetTexture
     GLuint tex_id = rtt->getTextureId();
-    glPushAttrib( GL_TEXTURE_BIT );
-    glBindTexture( rtt->getTextureTarget(), tex_id );
+    GLStateTracker::pushAttrib( GL_TEXTURE_BIT );
+    GLStateTracker::bindTexture( rtt->getTextureTarget(), tex_id );
     GLint h,w;
     glGetTexLevelParameteriv(rtt->getTextureTarget(), 0, GL_TEXTURE_WIDTH, &w);
     glGetTexLevelParameteriv(rtt->getTextureTarget(), 0, GL_TEXTURE_HEIGHT, &h);
-    glPopAttrib();
+    GLStateTracker::popAttrib();
     if( width->getValue()==-1 ) {
       widthInUse->setValue(w,id);
     }else{
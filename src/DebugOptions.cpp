@@ -43,6 +43,7 @@ namespace DebugOptionsInternals {
   FIELDDB_ELEMENT( DebugOptions, drawBoundTree, INPUT_OUTPUT );
   FIELDDB_ELEMENT( DebugOptions, drawHapticTriangles, INPUT_OUTPUT );
   FIELDDB_ELEMENT( DebugOptions, printShaderWarnings, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( DebugOptions, validateGLState, INPUT_OUTPUT );
 }
 
 DebugOptions::DebugOptions( 
@@ -50,12 +51,14 @@ DebugOptions::DebugOptions(
                            Inst< SFBool  > _drawBound,
                            Inst< SFInt32 > _drawBoundTree,
                            Inst< SFBool  > _drawHapticTriangles,
-                           Inst< SFBool  > _printShaderWarnings ) :
+                           Inst< SFBool  > _printShaderWarnings,
+                           Inst< SFBool  > _validateGLState ) :
   H3DOptionNode( _metadata ),
   drawBound( _drawBound ),
   drawBoundTree( _drawBoundTree ),
   drawHapticTriangles( _drawHapticTriangles ),
-  printShaderWarnings( _printShaderWarnings ) {
+  printShaderWarnings( _printShaderWarnings ),
+  validateGLState( _validateGLState ) {
   type_name = "DebugOptions";
 
   database.initFields( this );
@@ -64,11 +67,13 @@ DebugOptions::DebugOptions(
   drawBoundTree->route( updateOption );
   drawHapticTriangles->route( updateOption );
   printShaderWarnings->route( updateOption );
+  validateGLState->route( updateOption );
 
   drawBound->setValue( false );
   drawBoundTree->setValue( -1 );
   drawHapticTriangles->setValue( false );
   printShaderWarnings->setValue( false );
+  validateGLState->setValue( false );
 }
 
 
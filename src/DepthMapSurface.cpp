@@ -77,6 +77,8 @@ DepthMapSurface::DepthMapSurface(
    bool wrap_s = true, wrap_t = true, wrap_r = true;
    if( height_map ) {
      temp_image = height_map->image->getValue();
+     // the haptics thread can not load released image data.
+     ReloadableImage::keepLoaded( temp_image );
      TextureProperties * tex_prop =
        static_cast< TextureProperties * >
        ( height_map->textureProperties->getValue() );
@@ -107,6 +109,7 @@ DepthMapSurface::DepthMapSurface(
  void DepthMapSurface::SetImagePtr::update() {
    Image *image =
      static_cast< X3DTexture2DNode::SFImage * >(routes_in[0])->getValue();
+   ReloadableImage::keepLoaded( image );
    DepthMapSurface *dms = 
      static_cast< DepthMapSurface * >( getOwner() );
    HAPI::DepthMapSurface * _hapi_surface = 
@@ -37,9 +37,21 @@
 #include <dcmtk/dcmdata/dcdatset.h>
 #include <dcmtk/dcmdata/dcdeftag.h>
 #include <dcmtk/ofstd/ofconsol.h>
+#include <dcmtk/dcmimgle/dcmimage.h>
+#include <dcmtk/dcmimgle/dipixel.h>
+
+#include <H3D/ImageLoadPool.h>
+#include <H3DUtil/PixelImage.h>
+#include <H3DUtil/Threads.h>
+
+#include <algorithm>
+#include <limits>
+#include <cstring>
 
 #ifndef WIN32 
 #include <dirent.h>
+#else
+#include <windows.h>
 #endif
 
 using namespace H3D;
@@ -49,10 +61,254 @@ H3DNodeDatabase DicomImageLoader::database( "DicomImageLoader",
                                            &(newInstance<DicomImageLoader>), 
                                            typeid( DicomImageLoader ) );
 
+std::set< DicomImageLoader * > DicomImageLoader::loaders;
+H3DUtil::MutexLock DicomImageLoader::loaders_lock;
+
 namespace DicomImageLoaderInternals {
   FIELDDB_ELEMENT( DicomImageLoader, loadSingleFile, INITIALIZE_ONLY );
+  FIELDDB_ELEMENT( DicomImageLoader, progress, OUTPUT_ONLY );
+
+  // Header information about a slice of a series.
+  struct Slice {
+    string filename;
+    long instance_number;
+    // the position along the slice normal.
+    H3DDouble position;
+  };
+
+  // Orders slices by position, or by instance number if the positions
+  // are not known.
+  struct SliceOrder {
+    SliceOrder( bool _use_position ) : use_position( _use_position ) {}
+    bool operator()( const Slice &a, const Slice &b ) const {
+      if( use_position && a.position != b.position ) {
+        return a.position < b.position;
+      }
+      return a.instance_number < b.instance_number;
+    }
+    bool use_position;
+  };
+
+  // The names of all files in a directory.
+  vector< string > listFiles( const string &dir ) {
+    vector< string > files;
+#ifdef WIN32
+    WIN32_FIND_DATAA find_data;
+    HANDLE find = FindFirstFileA( ( dir + "*" ).c_str(), &find_data );
+    if( find != INVALID_HANDLE_VALUE ) {
+      do {
+        if( !( find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ) ) {
+          files.push_back( dir + find_data.cFileName );
+        }
+      } while( FindNextFileA( find, &find_data ) );
+      FindClose( find );
+    }
+#else
+    DIR *d = opendir( dir.empty() ? "." : dir.c_str() );
+    if( d ) {
+      struct dirent *entry;
+      while( ( entry = readdir( d ) ) ) {
+        string name = entry->d_name;
+        if( name != "." && name != ".." ) files.push_back( dir + name );
+      }
+      closedir( d );
+    }
+#endif
+    return files;
+  }
+
+  // Read the attributes of a DICOM file, without the pixel data.
+  bool readHeader( const string &filename, DcmFileFormat &fileformat ) {
+    // larger elements, such as the pixel data, are not read.
+    return fileformat.loadFile( filename.c_str(), EXS_Unknown,
+                                EGL_noChange, 1024 ).good();
+  }
+
+  // Get a string attribute, "" if not found.
+  string getString( DcmDataset *dataset, const DcmTagKey &tag ) {
+    OFString value;
+    if( dataset->findAndGetOFString( tag, value ).good() ) {
+      return value.c_str();
+    }
+    return "";
+  }
+
+  // Get value nr of a numeric attribute, default_value if not found.
+  H3DDouble getDouble( DcmDataset *dataset, const DcmTagKey &tag,
+                       unsigned long nr, H3DDouble default_value ) {
+    Float64 value;
+    if( dataset->findAndGetFloat64( tag, value, nr ).good() ) return value;
+    return default_value;
+  }
+
+  // Get an integer string attribute, default_value if not found.
+  long getInteger( DcmDataset *dataset, const DcmTagKey &tag,
+                   long default_value ) {
+    Sint32 value;
+    if( dataset->findAndGetSint32( tag, value ).good() ) return value;
+    return default_value;
+  }
+
+  // Get the position of the slice along the slice normal. Returns false
+  // if the slice has no position.
+  bool slicePosition( DcmDataset *dataset, H3DDouble &position ) {
+    Vec3d p, row, column;
+    for( unsigned int i = 0; i < 3; ++i ) {
+      Float64 v;
+      if( dataset->findAndGetFloat64( DCM_ImagePositionPatient, v, i ).bad() ) {
+        return false;
+      }
+      p[i] = v;
+      row[i] = getDouble( dataset, DCM_ImageOrientationPatient, i,
+                          i == 0 ? 1 : 0 );
+      column[i] = getDouble( dataset, DCM_ImageOrientationPatient, i + 3,
+                             i == 1 ? 1 : 0 );
+    }
+    position = p * row.crossProduct( column );
+    return true;
+  }
+
+  // The range of the values of a slice after the modality transform,
+  // given its attributes.
+  void sliceValueRange( DcmDataset *dataset,
+                        H3DDouble &min_value, H3DDouble &max_value ) {
+    Uint16 bits_stored = 16, pixel_representation = 0;
+    dataset->findAndGetUint16( DCM_BitsStored, bits_stored );
+    dataset->findAndGetUint16( DCM_PixelRepresentation,
+                               pixel_representation );
+    if( bits_stored == 0 || bits_stored > 32 ) bits_stored = 16;
+
+    min_value = 0;
+    max_value = pow( 2.0, (H3DDouble)bits_stored ) - 1;
+    if( pixel_representation == 1 ) {
+      min_value = -pow( 2.0, (H3DDouble)( bits_stored - 1 ) );
+      max_value = -min_value - 1;
+    }
+
+    // the modality transform is applied when decoding.
+    H3DDouble slope = getDouble( dataset, DCM_RescaleSlope, 0, 1 );
+    H3DDouble intercept = getDouble( dataset, DCM_RescaleIntercept, 0, 0 );
+    min_value = min_value * slope + intercept;
+    max_value = max_value * slope + intercept;
+    if( min_value > max_value ) std::swap( min_value, max_value );
+  }
+
+  // The representation in which all values in the given range fit.
+  EP_Representation rangeRepresentation( H3DDouble min_value, 
+                                         H3DDouble max_value ) {
+    if( min_value >= 0 ) {
+      if( max_value <= 255 ) return EPR_Uint8;
+      if( max_value <= 65535 ) return EPR_Uint16;
+      return EPR_Uint32;
+    }
+    if( min_value >= -128 && max_value <= 127 ) return EPR_Sint8;
+    if( min_value >= -32768 && max_value <= 32767 ) return EPR_Sint16;
+    return EPR_Sint32;
+  }
+
+  // The size in bytes of a value with the given representation.
+  unsigned int representationSize( EP_Representation representation ) {
+    switch( representation ) {
+    case EPR_Uint8: case EPR_Sint8: return 1;
+    case EPR_Uint16: case EPR_Sint16: return 2;
+    default: return 4;
+    }
+  }
+
+  // Convert values to the type of dest, clamping them to its range.
+  template< class S, class T >
+  void convertValues( const S *source, T *dest, size_t count ) {
+    const H3DDouble min_value = (H3DDouble)std::numeric_limits< T >::min();
+    const H3DDouble max_value = (H3DDouble)std::numeric_limits< T >::max();
+    for( size_t i = 0; i < count; ++i ) {
+      H3DDouble v = (H3DDouble)source[i];
+      dest[i] = (T)( v < min_value ? min_value :
+                     ( v > max_value ? max_value : v ) );
+    }
+  }
+
+  template< class T >
+  void convertPixels( const DiPixel *pixels, T *dest, size_t count ) {
+    const void *data = pixels->getData();
+    switch( pixels->getRepresentation() ) {
+    case EPR_Uint8:
+      convertValues( (const Uint8 *)data, dest, count ); break;
+    case EPR_Sint8:
+      convertValues( (const Sint8 *)data, dest, count ); break;
+    case EPR_Uint16:
+      convertValues( (const Uint16 *)data, dest, count ); break;
+    case EPR_Sint16:
+      convertValues( (const Sint16 *)data, dest, count ); break;
+    case EPR_Uint32:
+      convertValues( (const Uint32 *)data, dest, count ); break;
+    case EPR_Sint32:
+      convertValues( (const Sint32 *)data, dest, count ); break;
+    }
+  }
+
+  // Decode a monochrome slice into dest with the given representation.
+  // Returns false if it could not be decoded or does not match the size
+  // of the series.
+  bool decodeSlice( const string &filename,
+                    unsigned int width, unsigned int height,
+                    EP_Representation representation,
+                    void *dest ) {
+    ::DicomImage image( filename.c_str() );
+    if( image.getStatus() != EIS_Normal ||
+        !image.isMonochrome() ||
+        image.getFrameCount() != 1 ||
+        image.getWidth() != width || image.getHeight() != height ) {
+      return false;
+    }
+
+    const DiPixel *pixels = image.getInterData();
+    size_t count = (size_t)width * height;
+    if( !pixels || pixels->getPlanes() != 1 ||
+        pixels->getCount() < count ) {
+      return false;
+    }
+
+    if( pixels->getRepresentation() == representation ) {
+      memcpy( dest, pixels->getData(),
+              count * representationSize( representation ) );
+      return true;
+    }
+
+    switch( representation ) {
+    case EPR_Uint8: convertPixels( pixels, (Uint8 *)dest, count ); break;
+    case EPR_Sint8: convertPixels( pixels, (Sint8 *)dest, count ); break;
+    case EPR_Uint16: convertPixels( pixels, (Uint16 *)dest, count ); break;
+    case EPR_Sint16: convertPixels( pixels, (Sint16 *)dest, count ); break;
+    case EPR_Uint32: convertPixels( pixels, (Uint32 *)dest, count ); break;
+    case EPR_Sint32: convertPixels( pixels, (Sint32 *)dest, count ); break;
+    }
+    return true;
+  }
 }
 
+struct DicomImageLoader::SeriesLoad {
+  DicomImageLoader *loader;
+  vector< DicomImageLoaderInternals::Slice > slices;
+  unsigned int width;
+  unsigned int height;
+  EP_Representation representation;
+
+  // The 3D image data the slices are decoded into.
+  unsigned char *data;
+  size_t slice_bytes;
+
+  // Lock for the members below.
+  H3DUtil::ConditionLock lock;
+  // The index of the next slice to decode.
+  unsigned int next_slice;
+  // The number of slices decoded.
+  unsigned int nr_decoded;
+  // The number of worker threads that have not finished.
+  unsigned int nr_running;
+  // False if any slice could not be decoded.
+  bool success;
+};
+
 H3DImageLoaderNode::FileReaderRegistration 
 DicomImageLoader::reader_registration(
                             "DicomImageLoader",
@@ -62,12 +318,26 @@ DicomImageLoader::reader_registration(
 
 
 DicomImageLoader::DicomImageLoader():
-  loadSingleFile( new SFBool ) {
+  loadSingleFile( new SFBool ),
+  progress( new SFFloat ),
+  pending_progress( 0 ),
+  progress_pending( false ) {
 
   type_name = "DicomImageLoader";
   database.initFields( this );
   
   loadSingleFile->setValue( false );
+  progress->setValue( 0, id );
+
+  loaders_lock.lock();
+  loaders.insert( this );
+  loaders_lock.unlock();
+}
+
+DicomImageLoader::~DicomImageLoader() {
+  loaders_lock.lock();
+  loaders.erase( this );
+  loaders_lock.unlock();
 }
 
 bool DicomImageLoader::supportsFileType( const string &url ) {
@@ -95,7 +365,190 @@ bool DicomImageLoader::supportsFileType( const string &url ) {
 }
 
 H3D::Image *DicomImageLoader::loadImage( const string &url ) {
+  if( !loadSingleFile->getValue() ) {
+    H3D::Image *image = loadSeries( url );
+    if( image ) return image;
+  }
   return H3DUtil::loadDicomFile( url, loadSingleFile->getValue() );
 }
 
+H3D::Image *DicomImageLoader::loadSeries( const string &url ) {
+  using namespace DicomImageLoaderInternals;
+
+  DcmFileFormat fileformat;
+  if( !readHeader( url, fileformat ) ) return NULL;
+  DcmDataset *dataset = fileformat.getDataset();
+  string series_uid = getString( dataset, DCM_SeriesInstanceUID );
+  Uint16 samples_per_pixel = 1, rows = 0, columns = 0;
+  dataset->findAndGetUint16( DCM_SamplesPerPixel, samples_per_pixel );
+  dataset->findAndGetUint16( DCM_Rows, rows );
+  dataset->findAndGetUint16( DCM_Columns, columns );
+  if( series_uid == "" || samples_per_pixel != 1 || rows == 0 ||
+      columns == 0 || getInteger( dataset, DCM_NumberOfFrames, 1 ) > 1 ) {
+    return NULL;
+  }
+
+  // the size of a voxel in mm.
+  Vec3d spacing( getDouble( dataset, DCM_PixelSpacing, 1, 1 ),
+                 getDouble( dataset, DCM_PixelSpacing, 0, 1 ),
+                 getDouble( dataset, DCM_SliceThickness, 0, 1 ) );
+
+  // find the slices of the series.
+  string::size_type slash = url.find_last_of( "/\\" );
+  string dir = slash == string::npos ? "" : url.substr( 0, slash + 1 );
+  vector< string > files = listFiles( dir );
+
+  vector< Slice > slices;
+  bool use_position = true;
+  H3DDouble min_value = 0, max_value = 0;
+  for( vector< string >::iterator f = files.begin(); f != files.end(); ++f ) {
+    DcmFileFormat slice_format;
+    if( !readHeader( *f, slice_format ) ) continue;
+    DcmDataset *slice_dataset = slice_format.getDataset();
+    Uint16 slice_rows = 0, slice_columns = 0;
+    slice_dataset->findAndGetUint16( DCM_Rows, slice_rows );
+    slice_dataset->findAndGetUint16( DCM_Columns, slice_columns );
+    if( getString( slice_dataset, DCM_SeriesInstanceUID ) != series_uid ||
+        slice_rows != rows || slice_columns != columns ) {
+      continue;
+    }
+
+    Slice slice;
+    slice.filename = *f;
+    slice.instance_number = 
+      getInteger( slice_dataset, DCM_InstanceNumber, 0 );
+    slice.position = 0;
+    if( !slicePosition( slice_dataset, slice.position ) ) {
+      use_position = false;
+    }
+    slices.push_back( slice );
+
+    // slices can have different rescale attributes, so the values of
+    // all of them must fit.
+    H3DDouble slice_min, slice_max;
+    sliceValueRange( slice_dataset, slice_min, slice_max );
+    if( slices.size() == 1 || slice_min < min_value ) min_value = slice_min;
+    if( slices.size() == 1 || slice_max > max_value ) max_value = slice_max;
+  }
+  if( slices.empty() ) return NULL;
+  EP_Representation representation = 
+    rangeRepresentation( min_value, max_value );
+  std::sort( slices.begin(), slices.end(), SliceOrder( use_position ) );
+
+  if( use_position && slices.size() > 1 ) {
+    H3DDouble distance = slices[1].position - slices[0].position;
+    if( distance > 0 ) spacing.z = distance;
+  }
+
+  SeriesLoad load;
+  load.loader = this;
+  load.slices = slices;
+  load.width = columns;
+  load.height = rows;
+  load.representation = representation;
+  load.slice_bytes = 
+    (size_t)columns * rows * representationSize( representation );
+  load.data = new unsigned char[ load.slice_bytes * slices.size() ];
+  load.next_slice = 0;
+  load.nr_decoded = 0;
+  load.success = true;
+
+  setProgress( 0 );
+
+  // the loading thread is one of the workers.
+  unsigned int nr_threads = 
+    H3DMin( ImageLoadPool::getNrThreads(), (unsigned int)slices.size() );
+  load.nr_running = nr_threads;
+  vector< H3DUtil::SimpleThread * > threads;
+  for( unsigned int i = 1; i < nr_threads; ++i ) {
+    H3DUtil::SimpleThread *thread =
+      new H3DUtil::SimpleThread( &decodeSlicesThreadFunc, &load );
+    thread->setThreadName( "DICOM slice decode thread" );
+    threads.push_back( thread );
+  }
+  decodeSlicesThreadFunc( &load );
+
+  load.lock.lock();
+  while( load.nr_running > 0 ) load.lock.wait();
+  load.lock.unlock();
+  // the destructor of SimpleThread cancels and joins the thread. The
+  // workers do not accept cancellation, so this waits until they have
+  // returned and no longer use load.
+  for( unsigned int i = 0; i < threads.size(); ++i ) delete threads[i];
+
+  if( !load.success ) {
+    delete [] load.data;
+    return NULL;
+  }
+
+  bool is_signed = representation == EPR_Sint8 ||
+                   representation == EPR_Sint16 ||
+                   representation == EPR_Sint32;
+  // pixel sizes are in mm in DICOM files.
+  return new H3D::PixelImage( columns, rows, (unsigned int)slices.size(),
+                              representationSize( representation ) * 8,
+                              H3D::Image::LUMINANCE,
+                              is_signed ? H3D::Image::SIGNED :
+                                          H3D::Image::UNSIGNED,
+                              load.data,
+                              false,
+                              (Vec3f)( spacing * 0.001 ) );
+}
+
+void *DicomImageLoader::decodeSlicesThreadFunc( void *data ) {
+  SeriesLoad *load = static_cast< SeriesLoad * >( data );
+  // the thread must not be cancelled while it uses load, see loadSeries.
+  int cancel_state;
+  pthread_setcancelstate( PTHREAD_CANCEL_DISABLE, &cancel_state );
+  load->lock.lock();
+  while( load->success && load->next_slice < load->slices.size() ) {
+    unsigned int index = load->next_slice++;
+    load->lock.unlock();
+
+    bool decoded = 
+      DicomImageLoaderInternals::decodeSlice( 
+        load->slices[index].filename, load->width, load->height,
+        load->representation, load->data + index * load->slice_bytes );
+
+    load->lock.lock();
+    if( !decoded ) {
+      load->success = false;
+    } else {
+      ++load->nr_decoded;
+      load->loader->setProgress( (H3DFloat)load->nr_decoded / 
+                                 load->slices.size() );
+    }
+  }
+  --load->nr_running;
+  load->lock.signal();
+  load->lock.unlock();
+  pthread_setcancelstate( cancel_state, NULL );
+  return NULL;
+}
+
+void DicomImageLoader::setProgress( H3DFloat value ) {
+  loaders_lock.lock();
+  bool add_callback = !progress_pending;
+  pending_progress = value;
+  progress_pending = true;
+  loaders_lock.unlock();
+  // only one callback at a time, it sets the latest value.
+  if( add_callback ) Scene::addCallback( progressCB, this );
+}
+
+Scene::CallbackCode DicomImageLoader::progressCB( void *data ) {
+  DicomImageLoader *loader = static_cast< DicomImageLoader * >( data );
+  loaders_lock.lock();
+  if( loaders.find( loader ) == loaders.end() ) {
+    // the node has been destroyed.
+    loaders_lock.unlock();
+    return Scene::CALLBACK_DONE;
+  }
+  H3DFloat value = loader->pending_progress;
+  loader->progress_pending = false;
+  loaders_lock.unlock();
+  loader->progress->setValue( value, loader->id );
+  return Scene::CALLBACK_DONE;
+}
+
 #endif //HAVE_DCMTK
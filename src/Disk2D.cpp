@@ -42,6 +42,59 @@ namespace Disk2DInternals {
   FIELDDB_ELEMENT( Disk2D, innerRadius, INPUT_OUTPUT );
   FIELDDB_ELEMENT( Disk2D, outerRadius, INPUT_OUTPUT );
   FIELDDB_ELEMENT( Disk2D, solid, INPUT_OUTPUT );
+
+  // The number of segments around the disk.
+  const int nr_segments = 40;
+
+  // Build the mesh for a disk. params[0] is the inner radius and params[1]
+  // is the outer radius.
+  void buildMesh( const vector< H3DFloat > &params,
+                  PrimitiveMeshCache::Mesh &mesh ) {
+    H3DFloat inner_radius = params[0];
+    H3DFloat outer_radius = params[1];
+    H3DFloat angle_increment = (H3DFloat) Constants::pi*2 / nr_segments;
+    H3DFloat tex_scale = 1 / (outer_radius*2);
+    Vec3f normal( 0.f, 0.f, 1.f );
+
+    mesh.beginPart();
+    if( inner_radius == 0 ) {
+      // a filled circle
+      GLuint center = mesh.addVertex( Vec3f( 0, 0, 0 ), normal,
+                                      Vec3f( 0.5f, 0.5f, 0 ) );
+      for( int i = 0; i <= nr_segments; ++i ) {
+        H3DFloat theta = i == nr_segments ? 0 : i * angle_increment;
+        H3DFloat x = outer_radius * H3DCos(theta);
+        H3DFloat y = outer_radius * H3DSin(theta);
+        GLuint v =
+          mesh.addVertex( Vec3f( x, y, 0 ), normal,
+                          Vec3f( x * tex_scale + 0.5f,
+                                 y * tex_scale + 0.5f, 0 ) );
+        if( i > 0 ) mesh.addTriangle( center, v - 1, v );
+      }
+    } else {
+      // a disc with a hole
+      for( int i = 0; i <= nr_segments; ++i ) {
+        H3DFloat theta = i == nr_segments ? 0 : i * angle_increment;
+        H3DFloat cos_t = H3DCos( theta );
+        H3DFloat sin_t = H3DSin( theta );
+        H3DFloat inner_x = inner_radius * cos_t;
+        H3DFloat inner_y = inner_radius * sin_t;
+        H3DFloat outer_x = outer_radius * cos_t;
+        H3DFloat outer_y = outer_radius * sin_t;
+        GLuint v =
+          mesh.addVertex( Vec3f( inner_x, inner_y, 0 ), normal,
+                          Vec3f( inner_x * tex_scale + 0.5f,
+                                 inner_y * tex_scale + 0.5f, 0 ) );
+        mesh.addVertex( Vec3f( outer_x, outer_y, 0 ), normal,
+                        Vec3f( outer_x * tex_scale + 0.5f,
+                               outer_y * tex_scale + 0.5f, 0 ) );
+        if( i < nr_segments ) {
+          mesh.addTriangle( v, v + 1, v + 3 );
+          mesh.addTriangle( v, v + 3, v + 2 );
+        }
+      }
+    }
+  }
 }
 
 
@@ -59,7 +112,9 @@ Disk2D::Disk2D( Inst< SFNode      > _metadata,
                    _force, _contactPoint, _contactNormal ),
   innerRadius( _innerRadius ),
   outerRadius( _outerRadius ),
-  solid( _solid ) {
+  solid( _solid ),
+  meshFieldsUpToDate( new Field ),
+  mesh( NULL ) {
 
   type_name = "Disk2D";
   database.initFields( this );
@@ -73,45 +128,41 @@ Disk2D::Disk2D( Inst< SFNode      > _metadata,
   innerRadius->route( displayList );
   outerRadius->route( displayList );
   solid->route( displayList );
+
+  meshFieldsUpToDate->setName( "meshFieldsUpToDate" );
+  innerRadius->route( meshFieldsUpToDate );
+  outerRadius->route( meshFieldsUpToDate );
+}
+
+Disk2D::~Disk2D() {
+  PrimitiveMeshCache::releaseMesh( mesh );
+  mesh = NULL;
+}
+
+PrimitiveMeshCache::Mesh *Disk2D::getMesh() {
+  if( !mesh || !meshFieldsUpToDate->isUpToDate() ) {
+    meshFieldsUpToDate->upToDate();
+    vector< H3DFloat > params( 2 );
+    params[0] = innerRadius->getValue();
+    params[1] = outerRadius->getValue();
+    PrimitiveMeshCache::Mesh *new_mesh =
+      PrimitiveMeshCache::getMesh( "Disk2D", params,
+                                   &Disk2DInternals::buildMesh );
+    PrimitiveMeshCache::releaseMesh( mesh );
+    mesh = new_mesh;
+  }
+  return mesh;
 }
 
 void Disk2D::render() {
   H3DFloat inner_radius = innerRadius->getValue();
   H3DFloat outer_radius = outerRadius->getValue();
   
-  H3DFloat theta, angle_increment;
-  H3DFloat nr_segments = 40;
-
-  angle_increment = (H3DFloat) Constants::pi*2 / nr_segments;
+  if( outer_radius == inner_radius ) {
+    H3DFloat theta, angle_increment;
+    H3DFloat nr_segments = 40;
+    angle_increment = (H3DFloat) Constants::pi*2 / nr_segments;
 
-  if( inner_radius == 0 ) {
-    // draw a filled circle
-    glBegin( GL_TRIANGLE_FAN );
-    glNormal3f( 0.f, 0.f, 1.f );
-    renderTexCoordForActiveTexture( Vec3f( 0.5f, 0.5f, 0 ) );
-    glVertex2f( 0, 0 );
-    H3DFloat x, y;
-    int i = 0;
-    for ( ; i < nr_segments; ++i ) {
-      theta = i * angle_increment;
-      x = outer_radius * H3DCos(theta);
-      y = outer_radius * H3DSin(theta);
-      renderTexCoordForActiveTexture( Vec3f( x /(outer_radius*2) + 0.5f, 
-                                             y / (outer_radius*2) + 0.5f,
-                                             0 ) );
-      glVertex2f (x, y);
-    }
-    
-    theta = 0;
-    x = outer_radius * H3DCos(theta);
-    y = outer_radius * H3DSin(theta);
-    renderTexCoordForActiveTexture( Vec3f( x /(outer_radius*2) + 0.5f, 
-                                           y / (outer_radius*2) + 0.5f,
-                                           0 ) );
-    glVertex2f (x, y);
-    
-    glEnd ();
-  } else if( outer_radius == inner_radius ) {
     // draw a circle with lines
     H3DFloat x, y;
     glBegin( GL_LINE_STRIP );
@@ -131,52 +182,25 @@ void Disk2D::render() {
     
     glEnd ();
   } else {
-    // draw a disc
-    glBegin( GL_QUAD_STRIP );
-    
-    Vec2f inner_start_point, outer_start_point;
-    glNormal3f( 0.f, 0.f, 1.f );
-    int i = 0;
-    for ( ; i < nr_segments; ++i ) {
-      theta = i * angle_increment;
-      H3DFloat cos_t = H3DCos( theta );
-      H3DFloat sin_t = H3DSin( theta );
-      H3DFloat inner_x = inner_radius * cos_t;
-      H3DFloat inner_y = inner_radius * sin_t;
-      H3DFloat outer_x = outer_radius * cos_t;
-      H3DFloat outer_y = outer_radius * sin_t;
-      if( i == 0 ) {
-        inner_start_point = Vec2f( inner_x, inner_y );
-        outer_start_point = Vec2f( outer_x, outer_y );
-      }
-      
-      renderTexCoordForActiveTexture( Vec3f( inner_x / (outer_radius*2) + 0.5f,
-                                             inner_y / (outer_radius*2) + 0.5f,
-                                             0 ) ) ;
-      glVertex2f (inner_x, inner_y);
-      renderTexCoordForActiveTexture( Vec3f( outer_x / (outer_radius*2) + 0.5f,
-                                             outer_y / (outer_radius*2) + 0.5f,
-                                             0 ) );
-      glVertex2f (outer_x, outer_y);
-    }
-    
-    if( i != 0 ) {
-      renderTexCoordForActiveTexture( 
-                Vec3f( inner_start_point.x / (outer_radius*2) + 0.5f,
-                       inner_start_point.y / (outer_radius*2) + 0.5f,
-                       0 ) );
-      glVertex2f (inner_start_point.x, inner_start_point.y);
-      renderTexCoordForActiveTexture( 
-                Vec3f( outer_start_point.x / (outer_radius*2) + 0.5f,
-                       outer_start_point.y / (outer_radius*2) + 0.5f,
-                       0 ) ) ;
-      glVertex2f (outer_start_point.x, outer_start_point.y);
-    }
-    
-    glEnd ();
+    getMesh()->render( 1,
+                       PrimitiveMeshCache::usingVertexBufferObjects( this ) );
   }
 }
 
+bool Disk2D::getTriangles( vector< HAPI::Collision::Triangle > &triangles ) {
+  if( innerRadius->getValue() == outerRadius->getValue() ) return false;
+  getMesh()->getTriangles( 1, triangles );
+  return true;
+}
+
+bool Disk2D::renderInstanced( GLsizei nr_instances ) {
+  if( innerRadius->getValue() == outerRadius->getValue() ) return false;
+  getMesh()->render( 1,
+                     PrimitiveMeshCache::usingVertexBufferObjects( this ),
+                     nr_instances );
+  return true;
+}
+
 void Disk2D::traverseSG( TraverseInfo &ti ) {
   X3DGeometryNode::traverseSG( ti );
   if( solid->getValue() ) {
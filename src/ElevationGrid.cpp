@@ -34,6 +34,7 @@
 #include <H3D/Normal.h>
 #include <H3D/GlobalSettings.h>
 #include <H3D/GraphicsOptions.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -268,7 +269,7 @@ void ElevationGrid::render() {
 
     // fog coordinates
     if( GLEW_EXT_fog_coord && fog_coord_node ) {
-      glPushAttrib( GL_FOG_BIT );
+      GLStateTracker::pushAttrib( GL_FOG_BIT );
       glFogi(GL_FOG_COORDINATE_SOURCE_EXT, GL_FOG_COORDINATE_EXT);
     }
 
@@ -570,7 +571,7 @@ void ElevationGrid::render() {
     }
 
     if( GLEW_EXT_fog_coord && fog_coord_node ) {
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
 
     if( tex_coord_gen ) {
@@ -669,16 +670,16 @@ void ElevationGrid::startTexGen(
       if( mt ) {
         size_t texture_units = mt->texture->size();
         for( size_t i = 0; i < texture_units; ++i ) {
-          glActiveTexture( GL_TEXTURE0_ARB + (unsigned int) i );
+          GLStateTracker::activeTexture( GL_TEXTURE0_ARB + (unsigned int) i );
           glTexGend( GL_S, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
           glTexGend( GL_T, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
           glTexGend( GL_R, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
           glTexGenfv( GL_S, GL_OBJECT_PLANE, sparams );
           glTexGenfv( GL_T, GL_OBJECT_PLANE, tparams );
           glTexGenfv( GL_R, GL_OBJECT_PLANE, rparams );
-          glEnable( GL_TEXTURE_GEN_S );
-          glEnable( GL_TEXTURE_GEN_T );
-          glEnable( GL_TEXTURE_GEN_R );
+          GLStateTracker::enable( GL_TEXTURE_GEN_S );
+          GLStateTracker::enable( GL_TEXTURE_GEN_T );
+          GLStateTracker::enable( GL_TEXTURE_GEN_R );
         }
       } else {
         glTexGend( GL_S, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
@@ -687,9 +688,9 @@ void ElevationGrid::startTexGen(
         glTexGenfv( GL_S, GL_OBJECT_PLANE, sparams );
         glTexGenfv( GL_T, GL_OBJECT_PLANE, tparams );
         glTexGenfv( GL_R, GL_OBJECT_PLANE, rparams );
-        glEnable( GL_TEXTURE_GEN_S );
-        glEnable( GL_TEXTURE_GEN_T );
-        glEnable( GL_TEXTURE_GEN_R );
+        GLStateTracker::enable( GL_TEXTURE_GEN_S );
+        GLStateTracker::enable( GL_TEXTURE_GEN_T );
+        GLStateTracker::enable( GL_TEXTURE_GEN_R );
       }
     } else {
       stringstream s;
@@ -703,7 +704,7 @@ void ElevationGrid::startTexGen(
     if( mt ) {
       size_t texture_units = mt->texture->size();
       for( size_t i = 0; i < texture_units; ++i ) {
-        glActiveTexture( GL_TEXTURE0_ARB + (unsigned int) i );
+        GLStateTracker::activeTexture( GL_TEXTURE0_ARB + (unsigned int) i );
         tex_coord_gen->startTexGen();
       }
     } else {
@@ -721,21 +722,21 @@ void ElevationGrid::stopTexGen(
     if( mt ) {
       size_t texture_units = mt->texture->size();
       for( size_t i = 0; i < texture_units; ++i ) {
-        glActiveTexture( GL_TEXTURE0_ARB + (unsigned int) i );
-        glDisable( GL_TEXTURE_GEN_S );
-        glDisable( GL_TEXTURE_GEN_T );
-        glDisable( GL_TEXTURE_GEN_R );
+        GLStateTracker::activeTexture( GL_TEXTURE0_ARB + (unsigned int) i );
+        GLStateTracker::disable( GL_TEXTURE_GEN_S );
+        GLStateTracker::disable( GL_TEXTURE_GEN_T );
+        GLStateTracker::disable( GL_TEXTURE_GEN_R );
       }
     } else {
-      glDisable( GL_TEXTURE_GEN_S );
-      glDisable( GL_TEXTURE_GEN_T );
-      glDisable( GL_TEXTURE_GEN_R );
+      GLStateTracker::disable( GL_TEXTURE_GEN_S );
+      GLStateTracker::disable( GL_TEXTURE_GEN_T );
+      GLStateTracker::disable( GL_TEXTURE_GEN_R );
     }
   } else {
     if( mt ) {
       size_t texture_units = mt->texture->size();
       for( size_t i = 0; i < texture_units; ++i ) {
-        glActiveTexture( GL_TEXTURE0_ARB + (unsigned int) i );
+        GLStateTracker::activeTexture( GL_TEXTURE0_ARB + (unsigned int) i );
         tex_coord_gen->stopTexGen();
       }
     } else {
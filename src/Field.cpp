@@ -29,6 +29,7 @@
 #include <H3D/Field.h>
 #include <H3D/Node.h>
 #include <H3D/Scene.h>
+#include <H3D/X3DFieldConversion.h>
 #include <algorithm>
 
 #ifdef DEBUG
@@ -390,3 +391,64 @@ int Field::ownerId() {
   if( owner ) return owner->id;
   else return -1;
 }
+
+ParsableField::~ParsableField() {
+  delete value_string;
+}
+
+void ParsableField::setValueFromStringOnUse( const string &s ) {
+  delete value_string;
+  value_string = NULL;
+  // any pending event is replaced by the new value as if set by
+  // setValueFromString.
+  event.ptr = NULL;
+  value_string = new string( s );
+}
+
+void ParsableField::upToDate() {
+  if( value_string ) {
+    if( event.ptr ) {
+      // a value routed to the field after the string was given.
+      delete value_string;
+      value_string = NULL;
+    } else {
+      convertValueString();
+    }
+  }
+  Field::upToDate();
+}
+
+void ParsableField::startEvent() {
+  delete value_string;
+  value_string = NULL;
+  Field::startEvent();
+}
+
+void ParsableField::convertValueString() {
+  auto_ptr< string > s( value_string );
+  value_string = NULL;
+
+  // the fields routed to have already got an event when the route was
+  // set up and the field is set after initialization of its owner.
+  FieldSet routes;
+  routes.swap( routes_out );
+  bool access_check = access_check_on;
+  access_check_on = false;
+  try {
+    setValueFromString( *s );
+  } catch( const X3D::Convert::X3DFieldConversionError &e ) {
+    Console(LogLevel::Warning) << "Warning: Could not convert value to "
+                               << e.value << " for field \""
+                               << getFullName() << "\"." << endl;
+  } catch( const X3D::Convert::UnimplementedConversionType &e ) {
+    Console(LogLevel::Warning) << "Warning: Conversion for " << e.value
+                               << " not implemented for field \""
+                               << getFullName() << "\"." << endl;
+  } catch( ... ) {
+    routes_out.swap( routes );
+    access_check_on = access_check;
+    throw;
+  }
+  routes_out.swap( routes );
+  access_check_on = access_check;
+}
@@ -30,6 +30,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/FillProperties.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -90,8 +91,8 @@ void FillProperties::render() {
     } else {
       const RGB &c = hatchColor->getValue();
       glColor3f( c.r, c.g, c.b );
-      glDisable( GL_LIGHTING );
-      glEnable (GL_POLYGON_STIPPLE);
+      GLStateTracker::disable( GL_LIGHTING );
+      GLStateTracker::enable (GL_POLYGON_STIPPLE);
 
       if( hatch_style == 1 ) {
         // horizontal, equally spaced lines
@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/Fog.h>
+#include <H3D/GLStateTracker.h>
 #include <GL/glew.h>
 
 using namespace H3D;
@@ -81,6 +82,6 @@ void Fog::renderFog() {
     glFogfv( GL_FOG_COLOR, gl_fog_color );
     glFogf( GL_FOG_START, 0.0f );
     glFogf( GL_FOG_END, scale_local_to_global * visibility_range );
-    glEnable( GL_FOG );
+    GLStateTracker::enable( GL_FOG );
   }
 }
@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/FontStyle.h>
+#include <H3D/GLStateTracker.h>
 #if defined(__APPLE__) && defined(__MACH__)
 #include <AGL/agl.h>
 #endif
@@ -577,8 +578,8 @@ X3DFontStyleNode::Justification FontStyle::getMinorJustification() {
    glScalef( scale_factor, scale_factor, scale_factor );
    
    if( renderType->getValue() == "TEXTURE" ) {
-     glEnable( GL_TEXTURE_2D);
-     glEnable( GL_ALPHA_TEST );
+     GLStateTracker::enable( GL_TEXTURE_2D);
+     GLStateTracker::enable( GL_ALPHA_TEST );
      glAlphaFunc (GL_GREATER, 0);
    }
    
@@ -599,8 +600,8 @@ X3DFontStyleNode::Justification FontStyle::getMinorJustification() {
 #endif
 
    if( renderType->getValue() == "TEXTURE" ) {
-     glDisable( GL_ALPHA_TEST );
-     glDisable( GL_TEXTURE_2D);
+     GLStateTracker::disable( GL_ALPHA_TEST );
+     GLStateTracker::disable( GL_TEXTURE_2D);
    }
    glPopMatrix();
  }
@@ -614,8 +615,8 @@ void FontStyle::renderChar( unsigned char c ) {
   glScalef( scale_factor, scale_factor, scale_factor );
   
   if( renderType->getValue() == "TEXTURE" ) {
-    glEnable( GL_TEXTURE_2D);
-    glEnable( GL_ALPHA_TEST );
+    GLStateTracker::enable( GL_TEXTURE_2D);
+    GLStateTracker::enable( GL_ALPHA_TEST );
     glAlphaFunc (GL_GREATER, 0);
   }
   
@@ -643,8 +644,8 @@ void FontStyle::renderChar( unsigned char c ) {
 #endif
   
   if( renderType->getValue() == "TEXTURE" ) {
-    glDisable( GL_ALPHA_TEST );
-    glDisable( GL_TEXTURE_2D);
+    GLStateTracker::disable( GL_ALPHA_TEST );
+    GLStateTracker::disable( GL_TEXTURE_2D);
   }
   glMatrixMode(GL_MODELVIEW);
   glPopMatrix();
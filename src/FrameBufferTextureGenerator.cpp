@@ -40,6 +40,7 @@
 #include <H3D/X3DShaderNode.h>
 #include <H3D/GraphicsHardwareInfo.h>
 #include <H3D/X3DProgrammableShaderObject.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -559,13 +560,13 @@ void FrameBufferTextureGenerator::render()     {
   if (have_local_vp) {
     // when there is local viewpoint, push GL_POLYGON_BIT to make use cull face mode will not be 
     // affect by main scene rendering when mirroring is specified
-    glPushAttrib(GL_TEXTURE_BIT | GL_COLOR_BUFFER_BIT | GL_VIEWPORT_BIT | GL_SCISSOR_BIT | GL_POLYGON_BIT);
+    GLStateTracker::pushAttrib(GL_TEXTURE_BIT | GL_COLOR_BUFFER_BIT | GL_VIEWPORT_BIT | GL_SCISSOR_BIT | GL_POLYGON_BIT);
     // ignore mirroring in fbtg node
     glFrontFace(GL_CCW);
   } else {
     // when there is no local viewpoint, the global one will be used, so need to keep the face mode specified
     // in main scene, otherwise the mirroring effect will only flip the object, its cull face won't be flipped
-    glPushAttrib(GL_TEXTURE_BIT | GL_COLOR_BUFFER_BIT | GL_VIEWPORT_BIT | GL_SCISSOR_BIT);
+    GLStateTracker::pushAttrib(GL_TEXTURE_BIT | GL_COLOR_BUFFER_BIT | GL_VIEWPORT_BIT | GL_SCISSOR_BIT);
   }
 
   /// Make sure all textures and buffers are initialized.
@@ -648,7 +649,7 @@ void FrameBufferTextureGenerator::render()     {
       if( useScissor->getValue() ) {
         setupScissor(true, viewports_size, desired_fbo_width, desired_fbo_heigth );
       }else{
-        glDisable(GL_SCISSOR_TEST);
+        GLStateTracker::disable(GL_SCISSOR_TEST);
       }
       
     }else{
@@ -684,7 +685,7 @@ void FrameBufferTextureGenerator::render()     {
   // Don't do anything if buffer resize had an error.
   if( !last_resize_success ) {
     glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, previous_fbo_id);
-    glPopAttrib();
+    GLStateTracker::popAttrib();
     return;
   }
 
@@ -908,7 +909,7 @@ void FrameBufferTextureGenerator::render()     {
       glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT );
       if( !checkFBOCompleteness() ) {
         glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, previous_fbo_id);
-        glPopAttrib();        
+        GLStateTracker::popAttrib();        
         return;
       }
       X3DGroupingNode::render();
@@ -934,7 +935,7 @@ void FrameBufferTextureGenerator::render()     {
         } 
         if( !checkFBOCompleteness() ) {
           glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, previous_fbo_id);
-          glPopAttrib();        
+          GLStateTracker::popAttrib();        
           return;
         }
         // render child
@@ -971,7 +972,7 @@ void FrameBufferTextureGenerator::render()     {
   glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, previous_fbo_id);
 
   // reset previous state.
-  glPopAttrib();
+  GLStateTracker::popAttrib();
 };
 
 void FrameBufferTextureGenerator::initializeFBO() {
@@ -1410,7 +1411,7 @@ void FrameBufferTextureGenerator::preProcessFBO(int x, int y,int w, int h, int d
               color_ids[i] = external_FBO_color_id;
               colorTextures->setValue(i, external_FBO_color_tex, id);
               //glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, target_fbo );
-              glBindTextureEXT(texture_type,external_FBO_color_id);
+              GLStateTracker::bindTexture(texture_type,external_FBO_color_id);
               switch (texture_type)
               {
               case GL_TEXTURE_2D :
@@ -1610,7 +1611,7 @@ bool FrameBufferTextureGenerator::resizeBuffers( H3DInt32 _width, H3DInt32 _heig
   if( generateDepthTexture->getValue()  ) {
     if( texture_type != GL_TEXTURE_3D ) {
       // do not support 3D depth texture
-      glBindTexture( texture_type, depth_id );
+      GLStateTracker::bindTexture( texture_type, depth_id );
 
       if (texture_type!= GL_TEXTURE_2D_MULTISAMPLE&&texture_type!=GL_TEXTURE_2D_MULTISAMPLE_ARRAY){
         // filter needs to be something else than GL_MIPMAP_LINEAR that is default
@@ -1710,7 +1711,7 @@ bool FrameBufferTextureGenerator::resizeBuffers( H3DInt32 _width, H3DInt32 _heig
 
   // set up color buffers
   for( size_t i = 0; i < color_texture_types.size(); ++i ) {
-    glBindTexture( texture_type, color_ids[i] );
+    GLStateTracker::bindTexture( texture_type, color_ids[i] );
     if (texture_type!=GL_TEXTURE_2D_MULTISAMPLE&&texture_type!=GL_TEXTURE_2D_MULTISAMPLE_ARRAY){
       // filter needs to be something else than GL_MIPMAP_LINEAR that is default
       // since that is not supported by FBO.
@@ -1946,24 +1947,24 @@ void FrameBufferTextureGenerator::clearBuffers(GLenum src, int x, int y,
   int _width, int _height, GLbitfield mask){
     // clear buffer defined by mask of the area defined by x, y, width, height
     //glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, src);
-    glPushAttrib( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT | GL_SCISSOR_BIT );
+    GLStateTracker::pushAttrib( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT | GL_SCISSOR_BIT );
     glScissor( x, y, _width, _height );
-    glEnable( GL_SCISSOR_TEST );
+    GLStateTracker::enable( GL_SCISSOR_TEST );
     glClear( mask );
-    glDisable( GL_SCISSOR_TEST );
-    glPopAttrib();
+    GLStateTracker::disable( GL_SCISSOR_TEST );
+    GLStateTracker::popAttrib();
 }
 
 void FrameBufferTextureGenerator::clearColorBuffer( GLenum src, int x, int y, 
   int _width, int _height, GLfloat* value, GLint index ){
     // clear index th attached color buffer
     //glBindFramebufferEXT( GL_FRAMEBUFFER_EXT, src );
-    glPushAttrib( GL_COLOR_BUFFER_BIT | GL_SCISSOR_BIT );
+    GLStateTracker::pushAttrib( GL_COLOR_BUFFER_BIT | GL_SCISSOR_BIT );
     glScissor( x, y, _width, _height );
-    glEnable( GL_SCISSOR_TEST );
+    GLStateTracker::enable( GL_SCISSOR_TEST );
     glClearBufferfv( GL_COLOR, index, value );
-    glDisable( GL_SCISSOR_TEST );
-    glPopAttrib();
+    GLStateTracker::disable( GL_SCISSOR_TEST );
+    GLStateTracker::popAttrib();
 }
 
 
@@ -2048,8 +2049,8 @@ void FrameBufferTextureGenerator::blitColorBuffer(GLenum src, GLenum dst,
 void FrameBufferTextureGenerator::blitFBOBuffers(GLenum src, GLenum dst, 
   int srcX, int srcY, int w, int h){
     if( useScissor->getValue() ) {
-      glPushAttrib(GL_SCISSOR_BIT);
-      glDisable(GL_SCISSOR_TEST);
+      GLStateTracker::pushAttrib(GL_SCISSOR_BIT);
+      GLStateTracker::disable(GL_SCISSOR_TEST);
     }
     if( support_dsa ) {
 #ifdef GL_ARB_direct_state_access
@@ -2121,7 +2122,7 @@ void FrameBufferTextureGenerator::blitFBOBuffers(GLenum src, GLenum dst,
 #endif
     }
     if( useScissor->getValue() ) {
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
 }
 
@@ -2135,7 +2136,7 @@ void FrameBufferTextureGenerator::setupScissor( bool needSinglePassStereo,
   float* viewports_size, int desired_fbo_width, int desired_fbo_height ){
 #ifdef GL_ARB_viewport_array
   if( needSinglePassStereo ) {
-    glEnable(GL_SCISSOR_TEST);
+    GLStateTracker::enable(GL_SCISSOR_TEST);
     
     GLint scissorBox_size[12];
     int box_x  = scissorBoxX->getValue();
@@ -2168,7 +2169,7 @@ void FrameBufferTextureGenerator::setupScissor( bool needSinglePassStereo,
     glScissorArrayv( 0, 3, scissorBox_size );
   }else{
 #endif
-    glEnable(GL_SCISSOR_TEST);
+    GLStateTracker::enable(GL_SCISSOR_TEST);
     int box_x  = scissorBoxX->getValue();
     int box_y = scissorBoxY->getValue();
     int box_w = scissorBoxWidth->getValue();
@@ -30,6 +30,7 @@
 
 #include <H3D/FullscreenRectangle.h>
 #include <H3D/GlobalSettings.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -117,7 +118,7 @@ void FullscreenRectangle::render() {
   // post processing effects and if wireframe mode is used we do not want the default behavior
   // being to render it in wireframe as nothing at all will be shown then. Hence we force it 
   // filled.
-  glPushAttrib( GL_POLYGON_MODE );
+  GLStateTracker::pushAttrib( GL_POLYGON_MODE );
   glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
 
   GLdouble mvmatrix[16], projmatrix[16];
@@ -260,7 +261,7 @@ void FullscreenRectangle::render() {
   // restore previous front face.
   glFrontFace( front_face );
 
-  glPopAttrib();
+  GLStateTracker::popAttrib();
 }
 
 void FullscreenRectangle::fillVec3ToArray( const Vec3d V, vector<float>& array ){
@@ -0,0 +1,331 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file GLStateTracker.cpp
+/// \brief CPP file for GLStateTracker.
+///
+//
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <H3D/GLStateTracker.h>
+#include <H3D/GraphicsOptions.h>
+#include <H3D/DebugOptions.h>
+#include <H3D/GlobalSettings.h>
+
+using namespace H3D;
+
+GLStateTracker::Statistics GLStateTracker::current_frame;
+GLStateTracker::Statistics GLStateTracker::last_frame;
+GLStateTracker::State GLStateTracker::state;
+GLhandleARB GLStateTracker::program = 0;
+bool GLStateTracker::program_known = false;
+vector< GLbitfield > GLStateTracker::attrib_masks;
+vector< GLStateTracker::State > GLStateTracker::attrib_states;
+int GLStateTracker::display_list_depth = 0;
+bool GLStateTracker::filter_redundant = false;
+bool GLStateTracker::validate = false;
+
+namespace GLStateTrackerInternals {
+  // The tracked capabilities and the attribute group, besides
+  // GL_ENABLE_BIT, that saves each of them.
+  const GLenum capabilities[] = {
+    GL_LIGHTING,
+    GL_COLOR_MATERIAL,
+    GL_BLEND,
+    GL_ALPHA_TEST,
+    GL_DEPTH_TEST,
+    GL_CULL_FACE,
+    GL_POLYGON_STIPPLE,
+    GL_POLYGON_OFFSET_FILL,
+    GL_LINE_STIPPLE,
+    GL_LINE_SMOOTH,
+    GL_NORMALIZE,
+    GL_FOG,
+    GL_SCISSOR_TEST,
+    GL_STENCIL_TEST };
+
+  const GLbitfield capability_attrib_bits[] = {
+    GL_LIGHTING_BIT,
+    GL_LIGHTING_BIT,
+    GL_COLOR_BUFFER_BIT,
+    GL_COLOR_BUFFER_BIT,
+    GL_DEPTH_BUFFER_BIT,
+    GL_POLYGON_BIT,
+    GL_POLYGON_BIT,
+    GL_POLYGON_BIT,
+    GL_LINE_BIT,
+    GL_LINE_BIT,
+    GL_TRANSFORM_BIT,
+    GL_FOG_BIT,
+    GL_SCISSOR_BIT,
+    GL_STENCIL_BUFFER_BIT };
+
+  // The tracked texture targets and the query for their binding.
+  const GLenum texture_targets[] = {
+    GL_TEXTURE_1D,
+    GL_TEXTURE_2D,
+    GL_TEXTURE_3D,
+    GL_TEXTURE_CUBE_MAP_ARB,
+    GL_TEXTURE_RECTANGLE_ARB,
+    GL_TEXTURE_2D_ARRAY_EXT };
+
+  const GLenum texture_binding_queries[] = {
+    GL_TEXTURE_BINDING_1D,
+    GL_TEXTURE_BINDING_2D,
+    GL_TEXTURE_BINDING_3D,
+    GL_TEXTURE_BINDING_CUBE_MAP_ARB,
+    GL_TEXTURE_BINDING_RECTANGLE_ARB,
+    GL_TEXTURE_BINDING_2D_ARRAY_EXT };
+}
+
+void GLStateTracker::enable( GLenum cap ) {
+  setCapability( cap, true );
+}
+
+void GLStateTracker::disable( GLenum cap ) {
+  setCapability( cap, false );
+}
+
+void GLStateTracker::setCapability( GLenum cap, bool enabled ) {
+  int i = capabilityIndex( cap );
+  if( i >= 0 && filtering() && state.enabled[i] == (GLint)enabled ) {
+    GLint real_value = state.enabled[i];
+    if( validate ) real_value = glIsEnabled( cap ) ? 1 : 0;
+    if( real_value == state.enabled[i] ) {
+      ++current_frame.nr_skipped;
+      return;
+    }
+    reportMismatch( "capability", state.enabled[i], real_value );
+  }
+
+  ++current_frame.nr_issued;
+  if( enabled ) glEnable( cap );
+  else glDisable( cap );
+  if( i >= 0 ) state.enabled[i] = enabled ? 1 : 0;
+}
+
+void GLStateTracker::pushAttrib( GLbitfield mask ) {
+  ++current_frame.nr_issued;
+  glPushAttrib( mask );
+  attrib_masks.push_back( mask );
+  attrib_states.push_back( state );
+}
+
+void GLStateTracker::popAttrib() {
+  using namespace GLStateTrackerInternals;
+  ++current_frame.nr_issued;
+  glPopAttrib();
+
+  if( attrib_masks.empty() ) {
+    // glPushAttrib was called without the tracker so we do not know
+    // what was restored.
+    invalidate();
+    return;
+  }
+
+  GLbitfield mask = attrib_masks.back();
+  const State &saved = attrib_states.back();
+  for( unsigned int i = 0; i < nr_capabilities; ++i ) {
+    if( mask & ( GL_ENABLE_BIT | capability_attrib_bits[i] ) ) {
+      state.enabled[i] = saved.enabled[i];
+    }
+  }
+  if( mask & GL_TEXTURE_BIT ) {
+    state.active_texture = saved.active_texture;
+    for( unsigned int i = 0; i < max_texture_units; ++i ) {
+      for( unsigned int t = 0; t < nr_texture_targets; ++t ) {
+        state.texture_binding[i][t] = saved.texture_binding[i][t];
+      }
+    }
+  }
+  attrib_masks.pop_back();
+  attrib_states.pop_back();
+}
+
+void GLStateTracker::activeTexture( GLenum texture ) {
+  GLint unit = (GLint)texture - GL_TEXTURE0_ARB;
+  if( unit < 0 || unit >= (GLint)max_texture_units ) unit = -1;
+  if( unit >= 0 && filtering() && state.active_texture == unit ) {
+    GLint real_value = unit;
+    if( validate ) {
+      glGetIntegerv( GL_ACTIVE_TEXTURE_ARB, &real_value );
+      real_value -= GL_TEXTURE0_ARB;
+    }
+    if( real_value == unit ) {
+      ++current_frame.nr_skipped;
+      return;
+    }
+    reportMismatch( "active texture unit", unit, real_value );
+  }
+
+  ++current_frame.nr_issued;
+  glActiveTextureARB( texture );
+  state.active_texture = unit;
+}
+
+void GLStateTracker::bindTexture( GLenum target, GLuint texture ) {
+  using namespace GLStateTrackerInternals;
+  int t = textureTargetIndex( target );
+  GLint unit = state.active_texture;
+  if( t >= 0 && unit >= 0 && filtering() &&
+      state.texture_binding[unit][t] == (GLint)texture ) {
+    GLint real_value = texture;
+    if( validate ) glGetIntegerv( texture_binding_queries[t], &real_value );
+    if( real_value == (GLint)texture ) {
+      ++current_frame.nr_skipped;
+      return;
+    }
+    reportMismatch( "texture binding", (GLint)texture, real_value );
+  }
+
+  ++current_frame.nr_issued;
+  glBindTexture( target, texture );
+  if( t >= 0 && unit >= 0 ) state.texture_binding[unit][t] = texture;
+}
+
+void GLStateTracker::useProgram( GLhandleARB program_handle ) {
+  if( program_known && filtering() && program == program_handle ) {
+    GLhandleARB real_value = program_handle;
+    if( validate ) real_value = glGetHandleARB( GL_PROGRAM_OBJECT_ARB );
+    if( real_value == program_handle ) {
+      ++current_frame.nr_skipped;
+      return;
+    }
+    reportMismatch( "shader program", program_handle, real_value );
+  }
+
+  ++current_frame.nr_issued;
+  glUseProgramObjectARB( program_handle );
+  program = program_handle;
+  program_known = true;
+}
+
+void GLStateTracker::deleteTextures( GLsizei n, const GLuint *textures ) {
+  glDeleteTextures( n, textures );
+  // deleted textures that are bound are replaced by texture 0.
+  for( GLsizei i = 0; i < n; ++i ) {
+    if( textures[i] == 0 ) continue;
+    for( unsigned int u = 0; u < max_texture_units; ++u ) {
+      for( unsigned int t = 0; t < nr_texture_targets; ++t ) {
+        if( state.texture_binding[u][t] == (GLint)textures[i] ) {
+          state.texture_binding[u][t] = 0;
+        }
+      }
+    }
+    for( unsigned int j = 0; j < attrib_states.size(); ++j ) {
+      State &saved = attrib_states[j];
+      for( unsigned int u = 0; u < max_texture_units; ++u ) {
+        for( unsigned int t = 0; t < nr_texture_targets; ++t ) {
+          if( saved.texture_binding[u][t] == (GLint)textures[i] ) {
+            saved.texture_binding[u][t] = -1;
+          }
+        }
+      }
+    }
+  }
+}
+
+void GLStateTracker::invalidate() {
+  for( unsigned int i = 0; i < nr_capabilities; ++i ) {
+    state.enabled[i] = -1;
+  }
+  state.active_texture = -1;
+  for( unsigned int i = 0; i < max_texture_units; ++i ) {
+    for( unsigned int t = 0; t < nr_texture_targets; ++t ) {
+      state.texture_binding[i][t] = -1;
+    }
+  }
+  program_known = false;
+}
+
+void GLStateTracker::beginRender() {
+  GraphicsOptions *graphics_options = NULL;
+  DebugOptions *debug_options = NULL;
+  GlobalSettings *default_settings = GlobalSettings::getActive();
+  if( default_settings ) {
+    default_settings->getOptionNode( graphics_options );
+    default_settings->getOptionNode( debug_options );
+  }
+
+  filter_redundant = graphics_options &&
+    graphics_options->filterRedundantStateChanges->getValue();
+  validate = debug_options && debug_options->validateGLState->getValue();
+
+  attrib_masks.clear();
+  attrib_states.clear();
+  display_list_depth = 0;
+  invalidate();
+}
+
+void GLStateTracker::beginDisplayList() {
+  ++display_list_depth;
+}
+
+void GLStateTracker::endDisplayList() {
+  if( display_list_depth > 0 ) --display_list_depth;
+}
+
+void GLStateTracker::beginFrame() {
+  last_frame = current_frame;
+  current_frame.reset();
+}
+
+void GLStateTracker::reportMismatch( const char *state_name,
+                                     GLint shadow_value,
+                                     GLint real_value ) {
+  ++current_frame.nr_validation_errors;
+  Console(LogLevel::Warning) << "Warning: GLStateTracker shadow state of "
+                             << state_name << " is " << shadow_value
+                             << " but OpenGL has " << real_value
+                             << ". Something has changed the OpenGL state "
+                             << "without using GLStateTracker." << endl;
+}
+
+void GLStateTracker::reportMismatch( const char *state_name,
+                                     GLhandleARB shadow_value,
+                                     GLhandleARB real_value ) {
+  ++current_frame.nr_validation_errors;
+  Console(LogLevel::Warning) << "Warning: GLStateTracker shadow state of "
+                             << state_name << " is "
+                             << (H3DPtrUint)shadow_value
+                             << " but OpenGL has " << (H3DPtrUint)real_value
+                             << ". Something has changed the OpenGL state "
+                             << "without using GLStateTracker." << endl;
+}
+
+int GLStateTracker::capabilityIndex( GLenum cap ) {
+  using namespace GLStateTrackerInternals;
+  for( unsigned int i = 0; i < nr_capabilities; ++i ) {
+    if( capabilities[i] == cap ) return i;
+  }
+  return -1;
+}
+
+int GLStateTracker::textureTargetIndex( GLenum target ) {
+  using namespace GLStateTrackerInternals;
+  for( unsigned int i = 0; i < nr_texture_targets; ++i ) {
+    if( texture_targets[i] == target ) return i;
+  }
+  return -1;
+}
@@ -32,6 +32,7 @@
 #include <H3D/X3DBackgroundNode.h>
 #include <H3D/DeviceInfo.h>
 #include <H3D/X3DShapeNode.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -88,7 +89,7 @@ void GeneratedCubeMapTexture::initializeTextures() {
     glGenTextures( 1, &cube_map_id );
   }
   
-  glBindTexture( GL_TEXTURE_CUBE_MAP_ARB, cube_map_id );
+  GLStateTracker::bindTexture( GL_TEXTURE_CUBE_MAP_ARB, cube_map_id );
 
 
   if( GLEW_EXT_framebuffer_object ) {
@@ -160,11 +161,11 @@ void GeneratedCubeMapTexture::render() {
 }
 
 void GeneratedCubeMapTexture::enableTexturing() {
-  glEnable( GL_TEXTURE_CUBE_MAP_ARB );
+  GLStateTracker::enable( GL_TEXTURE_CUBE_MAP_ARB );
 }
 
 void GeneratedCubeMapTexture::disableTexturing() {
-  glDisable( GL_TEXTURE_CUBE_MAP_ARB );
+  GLStateTracker::disable( GL_TEXTURE_CUBE_MAP_ARB );
 }
 
 void GeneratedCubeMapTexture::traverseSG( TraverseInfo &ti ) {
@@ -180,7 +181,7 @@ void GeneratedCubeMapTexture::updateCubeMapTextures( X3DChildNode *n,
 
   generating_textures = true;
   displayList->touch();
-  glBindTexture( GL_TEXTURE_CUBE_MAP_ARB, cube_map_id );
+  GLStateTracker::bindTexture( GL_TEXTURE_CUBE_MAP_ARB, cube_map_id );
 
   if( GLEW_EXT_framebuffer_object ) {
     glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, fbo_id);
@@ -283,7 +284,7 @@ void GeneratedCubeMapTexture::updateCubeMap( GLuint texture_target,
              c_up.x, c_up.y, c_up.z );
 
   // Rotate the headlight in the direction of the viewpoint.
-  glPushAttrib( GL_LIGHTING_BIT );
+  GLStateTracker::pushAttrib( GL_LIGHTING_BIT );
   Vec3f dir( 0, 0, -1 );
   dir = vp_rot * (vp_orientation * dir );
   dir = -dir;
@@ -331,7 +332,7 @@ void GeneratedCubeMapTexture::updateCubeMap( GLuint texture_target,
     else n->render();
   }
 
-  glPopAttrib();
+  GLStateTracker::popAttrib();
 
 
 
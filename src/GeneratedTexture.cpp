@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/GeneratedTexture.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -58,7 +59,7 @@ GeneratedTexture::GeneratedTexture(
 void GeneratedTexture::render() {
   glGetIntegerv( GL_ACTIVE_TEXTURE_ARB, &texture_unit );
   ensureInitialized();
-  glBindTexture(  texture_target, texture_id );
+  GLStateTracker::bindTexture(  texture_target, texture_id );
   renderTextureProperties();
   if (this->texture_target!=GL_TEXTURE_2D_MULTISAMPLE){
     // GL_TEXTURE_2D_MULTISAMPLE do not need to be enabled
@@ -101,7 +102,7 @@ bool GeneratedTexture::ensureInitialized( GLenum tex_target ) {
 }
 
 void GeneratedTexture::reinitialize () {
-  glDeleteTextures ( 1, &texture_id );
+  GLStateTracker::deleteTextures ( 1, &texture_id );
   texture_id_initialized= false;
   ensureInitialized ( texture_target );
 }
@@ -110,12 +111,12 @@ std::pair<H3DInt32,H3DInt32> H3D::GeneratedTexture::getDefaultSaveDimensions()
 {
   if( textureIdIsInitialized() ) {
     GLuint tex_id = getTextureId();
-    glPushAttrib( GL_TEXTURE_BIT );
-    glBindTexture(getTextureTarget(), tex_id);
+    GLStateTracker::pushAttrib( GL_TEXTURE_BIT );
+    GLStateTracker::bindTexture(getTextureTarget(), tex_id);
     GLint h, w;
     glGetTexLevelParameteriv( getTextureTarget(), 0, GL_TEXTURE_WIDTH, &w );
     glGetTexLevelParameteriv( getTextureTarget(), 0, GL_TEXTURE_HEIGHT, &h);
-    glPopAttrib();
+    GLStateTracker::popAttrib();
     return std::pair<H3DInt32,H3DInt32> ( w, h );
   }else {
     return X3DTextureNode::getDefaultSaveDimensions();
@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/GeneratedTexture3D.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -60,7 +61,7 @@ void GeneratedTexture3D::render() {
   glGetIntegerv( GL_ACTIVE_TEXTURE_ARB, &texture_unit );
 
   ensureInitialized();
-  glBindTexture(  texture_target, texture_id );
+  GLStateTracker::bindTexture(  texture_target, texture_id );
   if( texture_target!=GL_TEXTURE_2D_MULTISAMPLE_ARRAY ) {
     // can not specify texture property for 2d multiple array texture
     // and enableTexturing is not needed also as it will not be rendered directly
@@ -82,7 +83,7 @@ bool GeneratedTexture3D::ensureInitialized( GLenum tex_target ) {
 }
 
 void GeneratedTexture3D::reinitialize () {
-  glDeleteTextures ( 1, &texture_id );
+  GLStateTracker::deleteTextures ( 1, &texture_id );
   texture_id_initialized= false;
   ensureInitialized ( texture_target );
 }
@@ -47,6 +47,8 @@ namespace GlobalSettingsInternals {
   FIELDDB_ELEMENT( GlobalSettings, loadTexturesInThread, INPUT_OUTPUT );
   FIELDDB_ELEMENT( GlobalSettings, renderMode, INPUT_OUTPUT );
   FIELDDB_ELEMENT( GlobalSettings, multiThreadedPython, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( GlobalSettings, loadInlinesInThread, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( GlobalSettings, maxInlineLoadThreads, INPUT_OUTPUT );
 }
 
 
@@ -59,7 +61,9 @@ GlobalSettings::GlobalSettings(
                        Inst< SFBool       > _x3dROUTESendsEvent,
                        Inst< SFBool       > _loadTexturesInThread,
                        Inst< SFString     > _renderMode,
-                       Inst< SFBool       > _multiThreadedPython ):
+                       Inst< SFBool       > _multiThreadedPython,
+                       Inst< SFBool       > _loadInlinesInThread,
+                       Inst< SFInt32      > _maxInlineLoadThreads ):
   X3DBindableNode( "GlobalSettings", _set_bind, _metadata, 
                    _bindTime, _isBound ),
   options        ( _options ),
@@ -67,6 +71,8 @@ GlobalSettings::GlobalSettings(
   loadTexturesInThread( _loadTexturesInThread ),
   renderMode( _renderMode ),
   multiThreadedPython ( _multiThreadedPython ),
+  loadInlinesInThread( _loadInlinesInThread ),
+  maxInlineLoadThreads( _maxInlineLoadThreads ),
   updateOptions( new UpdateOptions ){
 
   type_name = "GlobalSettings";
@@ -83,6 +89,8 @@ GlobalSettings::GlobalSettings(
   renderMode->setValue( "DEFAULT" );
  
   multiThreadedPython->setValue ( false );
+  loadInlinesInThread->setValue( false );
+  maxInlineLoadThreads->setValue( 4 );
   updateOptions->setName( "UpdateOptions" );
   updateOptions->setOwner( this );
   options->route( updateOptions );
@@ -56,6 +56,17 @@ namespace GraphicsOptionsInternals {
   FIELDDB_ELEMENT( GraphicsOptions, shareTextures, INPUT_OUTPUT );
   FIELDDB_ELEMENT( GraphicsOptions, maxTextureDimension, INPUT_OUTPUT );
   FIELDDB_ELEMENT( GraphicsOptions, textureCompression, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( GraphicsOptions, useInstancing, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( GraphicsOptions, instancingThreshold, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( GraphicsOptions, sortShapes, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( GraphicsOptions, filterRedundantStateChanges, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( GraphicsOptions, shaderProgramCacheDirectory, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( GraphicsOptions, asyncShaderCompilation, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( GraphicsOptions, asyncTextureUpload, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( GraphicsOptions, textureUploadBudget, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( GraphicsOptions, textureUploadTimeBudget, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( GraphicsOptions, textureMemoryBudget, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( GraphicsOptions, releaseImagesAfterUpload, INPUT_OUTPUT );
 }
 
 GraphicsOptions::GraphicsOptions( 
@@ -74,7 +85,18 @@ GraphicsOptions::GraphicsOptions(
                                  Inst< SFTime > _bindlessTexturesUnusedTime,
                                  Inst< SFBool > _shareTextures,
                                  Inst< SFInt32 > _maxTextureDimension,
-                                 Inst< SFString > _textureCompression ) :
+                                 Inst< SFString > _textureCompression,
+                                 Inst< SFBool > _useInstancing,
+                                 Inst< SFInt32 > _instancingThreshold,
+                                 Inst< SFBool > _sortShapes,
+                                 Inst< SFBool > _filterRedundantStateChanges,
+                                 Inst< SFString > _shaderProgramCacheDirectory,
+                                 Inst< SFBool > _asyncShaderCompilation,
+                                 Inst< SFBool > _asyncTextureUpload,
+                                 Inst< SFInt32 > _textureUploadBudget,
+                                 Inst< SFTime > _textureUploadTimeBudget,
+                                 Inst< SFInt32 > _textureMemoryBudget,
+                                 Inst< SFBool > _releaseImagesAfterUpload ) :
   H3DOptionNode( _metadata ),
   useCaching( _useCaching ),
   cachingDelay( _cachingDelay ),
@@ -90,7 +112,18 @@ GraphicsOptions::GraphicsOptions(
   bindlessTexturesUnusedTime ( _bindlessTexturesUnusedTime ),
   shareTextures ( _shareTextures ),
   maxTextureDimension ( _maxTextureDimension ),
-  textureCompression ( _textureCompression ) {
+  textureCompression ( _textureCompression ),
+  useInstancing ( _useInstancing ),
+  instancingThreshold ( _instancingThreshold ),
+  sortShapes ( _sortShapes ),
+  filterRedundantStateChanges ( _filterRedundantStateChanges ),
+  shaderProgramCacheDirectory ( _shaderProgramCacheDirectory ),
+  asyncShaderCompilation ( _asyncShaderCompilation ),
+  asyncTextureUpload ( _asyncTextureUpload ),
+  textureUploadBudget ( _textureUploadBudget ),
+  textureUploadTimeBudget ( _textureUploadTimeBudget ),
+  textureMemoryBudget ( _textureMemoryBudget ),
+  releaseImagesAfterUpload ( _releaseImagesAfterUpload ) {
   
   type_name = "GraphicsOptions";
   database.initFields( this );
@@ -135,6 +168,18 @@ GraphicsOptions::GraphicsOptions(
   textureCompression->addValidValue( "BC7" );
   textureCompression->setValue( "DEFAULT" );
 
+  useInstancing->setValue( false );
+  instancingThreshold->setValue( 8 );
+  sortShapes->setValue( false );
+  filterRedundantStateChanges->setValue( false );
+  shaderProgramCacheDirectory->setValue( "" );
+  asyncShaderCompilation->setValue( false );
+  asyncTextureUpload->setValue( false );
+  textureUploadBudget->setValue( 4194304 );
+  textureUploadTimeBudget->setValue( H3DTime( 0.002 ) );
+  textureMemoryBudget->setValue( 0 );
+  releaseImagesAfterUpload->setValue( false );
+
   if( !Scene::scenes.empty() ) {
     defaultShadowCaster->setValue( (*Scene::scenes.begin())->getDefaultShadowCaster() );
   }
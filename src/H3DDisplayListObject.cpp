@@ -36,6 +36,8 @@
 #include <H3D/X3DGeometryNode.h>
 #include <H3D/MatrixTransform.h>
 #include <H3D/H3DWindowNode.h>
+#include <H3D/GLStateTracker.h>
+#include <H3D/ShaderFunctions.h>
 
 using namespace H3D;
 
@@ -96,8 +98,10 @@ bool H3DDisplayListObject::DisplayList::tryBuildDisplayList( bool cache_broken )
                    << "\" when rendering " << getFullName() << endl;
         return false;
       }
+      GLStateTracker::beginDisplayList();
       owner->render();
       glEndList();
+      GLStateTracker::endDisplayList();
       err = glGetError();
       if( err != GL_NO_ERROR ) {
         Console(LogLevel::Error) << "OpenGL error in glEndList() Error: \"" << gluErrorString( err ) 
@@ -176,6 +180,9 @@ void H3DDisplayListObject::DisplayList::callList( bool build_list ) {
   
   if ( using_caching && haveValidDisplayList() ) {
     glCallList( display_list );
+    // the display list may have changed any state.
+    GLStateTracker::invalidate();
+    Shaders::invalidateUniformValues();
     err = glGetError();
     if( err != GL_NO_ERROR ) {
       Console(LogLevel::Error) << "OpenGL error in glCallList() Error: \"" << gluErrorString( err ) 
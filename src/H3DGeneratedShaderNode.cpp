@@ -45,6 +45,8 @@ namespace H3DGeneratedShaderNodeInternals {
   FIELDDB_ELEMENT( H3DGeneratedShaderNode, fragmentShaderString, INPUT_OUTPUT );
 }
 
+map< H3DGeneratedShaderNode *, string > *H3DGeneratedShaderNode::build_shader_ids = NULL;
+
 H3DGeneratedShaderNode::H3DGeneratedShaderNode( 
                               Inst< DisplayList  > _displayList,
                               Inst< SFNode       > _metadata,
@@ -79,11 +81,17 @@ H3DGeneratedShaderNode::H3DGeneratedShaderNode(
   suppressUniformWarnings->setValue( true );
   language->setValue( "GLSL" );
 
+  // nodes generating the same source share compiled shader objects and
+  // hence also the linked program.
+  share_relinked_program = true;
+
   ShaderPart *vertex_shader = new ShaderPart;
   vertex_shader->type->setValue( "VERTEX" );
+  vertex_shader->setShareCompiledShader( true );
 
   ShaderPart *fragment_shader = new ShaderPart;
   fragment_shader->type->setValue( "FRAGMENT" );
+  fragment_shader->setShareCompiledShader( true );
 
   parts->push_back( vertex_shader );
   parts->push_back( fragment_shader );
@@ -97,6 +105,19 @@ H3DGeneratedShaderNode::H3DGeneratedShaderNode(
 
 
 string H3DGeneratedShaderNode::uniqueShaderName( const string &base_name ) {
+  if( build_shader_ids ) {
+    // while building a shader the nodes are numbered in the order they
+    // are used, so nodes with the same configuration generate the same
+    // source.
+    map< H3DGeneratedShaderNode *, string >::iterator i = 
+      build_shader_ids->find( this );
+    if( i == build_shader_ids->end() ) {
+      stringstream id_s;
+      id_s << "_" << build_shader_ids->size();
+      i = build_shader_ids->insert( make_pair( this, id_s.str() ) ).first;
+    }
+    return base_name + (*i).second;
+  }
   return base_name + shader_id;
 }
 
@@ -123,6 +144,13 @@ string H3DGeneratedShaderNode::getVertexShaderString(){
 
 void H3DGeneratedShaderNode::buildShader() {
 
+  // names are made unique by the order of the nodes in this shader
+  // instead of by their address, see uniqueShaderName.
+  map< H3DGeneratedShaderNode *, string > shader_ids;
+  map< H3DGeneratedShaderNode *, string > *previous_shader_ids = 
+    build_shader_ids;
+  build_shader_ids = &shader_ids;
+
   // clear the uniform field map
 
   uniformFields.clear();
@@ -196,6 +224,8 @@ void H3DGeneratedShaderNode::buildShader() {
   //  Console(LogLevel::Error) << sf.str() << endl;
   fragmentShaderString->clear( id );
   fragmentShaderString->push_back( string("glsl:") + sf.str(), id );
+
+  build_shader_ids = previous_shader_ids;
   
   // force relink of shader
   activate->setValue( true );
@@ -30,6 +30,7 @@
 
 #include <H3D/H3DNodeDatabase.h>
 #include <H3D/Node.h>
+#include <H3DUtil/Threads.h>
 
 #include <algorithm>
 #include <string> 
@@ -41,10 +42,42 @@ H3DNodeDatabase::database;
 
 bool H3DNodeDatabase::initialized = false;
 
+unsigned int H3DNodeDatabase::fields_generation = 1;
+
+namespace H3DNodeDatabaseInternals {
+  // Field names are interned from the static initialization of the
+  // FieldDBElements, so the tables are created on first use.
+  struct FieldNames {
+    map< string, unsigned int > ids;
+    vector< const string * > names;
+  };
+
+  FieldNames &fieldNames() {
+    static FieldNames field_names;
+    return field_names;
+  }
+
+  // Lock for the field names and the field tables. Field names and
+  // dynamic fields can be added while files are loaded in other threads.
+  MutexLock &fieldsLock() {
+    static MutexLock lock;
+    return lock;
+  }
+
+  // The index of the slot in the field table to start looking for
+  // the field name id in.
+  inline unsigned int fieldTableSlot( unsigned int field_id, 
+                                      size_t table_size ) {
+    return field_id & (unsigned int)( table_size - 1 );
+  }
+}
+
 H3DNodeDatabase::H3DNodeDatabase( const string &_name, 
                                   H3DCreateNodeFunc _createf,
                                   const type_info &_ti,
                                   H3DNodeDatabase *_parent ) :
+field_table_generation( 0 ),
+fields_changed_generation( fields_generation ),
 createf( _createf ),
 ti( _ti ),
 parent( _parent ),
@@ -64,6 +97,8 @@ H3DNodeDatabase::H3DNodeDatabase( const string &_name,
                                   H3DCreateNodeFunc _createf,
                                   const type_info &_ti,
                                   H3DNodeDatabase *_parent ) :
+field_table_generation( 0 ),
+fields_changed_generation( fields_generation ),
 createf( _createf ),
 ti( _ti ),
 parent( _parent ),
@@ -83,6 +118,8 @@ database_allocated_dynamic( false ) {
 
 H3DNodeDatabase::H3DNodeDatabase( const type_info &_ti,
                                   H3DNodeDatabase *_parent ) :
+field_table_generation( 0 ),
+fields_changed_generation( fields_generation ),
 name( "" ),
 createf( NULL ),
 ti( _ti ),
@@ -115,6 +152,9 @@ H3DNodeDatabase::~H3DNodeDatabase(void){
     for( H3DNodeInstanceDatabase::iterator i = node_instance_database.begin();
          i != node_instance_database.end(); ++i ) {
       (*i).second->parent = NULL;
+      // the field table of the instance database refers to the fields
+      // of this database.
+      (*i).second->fieldsChanged();
     }
     node_instance_database.clear();
 
@@ -169,36 +209,117 @@ void H3DNodeDatabase::initFields( Node *n ) const {
 }
 
 
-Field *H3DNodeDatabase::getFieldHelp( const Node *n, const string &_f ) const {
-  std::string f(_f);
-  std::transform(f.begin(), f.end(), f.begin(), ::tolower); 
-  for( FieldDBType::const_iterator i = fields.begin(); i != fields.end(); ++i ) {
-    FieldDBElement *fdb = (*i).second;
-    const string &name = (*i).first;
-    if ( name == f )
-      return fdb->getField( n );
+unsigned int H3DNodeDatabase::getFieldId( const string &_name ) {
+  using namespace H3DNodeDatabaseInternals;
+  std::string name(_name);
+  std::transform(name.begin(), name.end(), name.begin(), ::tolower); 
+  FieldNames &field_names = fieldNames();
+  fieldsLock().lock();
+  map< string, unsigned int >::iterator i = field_names.ids.find( name );
+  if( i == field_names.ids.end() ) {
+    i = field_names.ids.insert( 
+          make_pair( name, (unsigned int)field_names.names.size() ) ).first;
+    field_names.names.push_back( &(*i).first );
   }
-  if ( parent )
-    return parent->getField( n, f );
-  else
-    return NULL;
+  unsigned int id = (*i).second;
+  fieldsLock().unlock();
+  return id;
+}
+
+const string &H3DNodeDatabase::getFieldName( unsigned int field_id ) {
+  using namespace H3DNodeDatabaseInternals;
+  FieldNames &field_names = fieldNames();
+  fieldsLock().lock();
+  const string *name = field_names.names[ field_id ];
+  fieldsLock().unlock();
+  return *name;
+}
+
+void H3DNodeDatabase::fieldsChanged() {
+  using namespace H3DNodeDatabaseInternals;
+  fieldsLock().lock();
+  fields_changed_generation = ++fields_generation;
+  fieldsLock().unlock();
+}
+
+void H3DNodeDatabase::updateFieldTable() const {
+  using namespace H3DNodeDatabaseInternals;
+  // the table is up to date if it was built after the last change to
+  // this database and all databases it inherits from.
+  unsigned int last_change = 0;
+  for( const H3DNodeDatabase *db = this; db; db = db->parent ) {
+    if( db->fields_changed_generation > last_change ) 
+      last_change = db->fields_changed_generation;
+  }
+  if( field_table_generation >= last_change ) return;
+
+  size_t nr_fields = 0;
+  for( const H3DNodeDatabase *db = this; db; db = db->parent ) {
+    nr_fields += db->fields.size();
+  }
+  // keep the table at most half full.
+  size_t table_size = 1;
+  while( table_size < 2 * nr_fields ) table_size *= 2;
+
+  vector< FieldDBElement * > table( table_size, NULL );
+  for( const H3DNodeDatabase *db = this; db; db = db->parent ) {
+    for( FieldDBType::const_iterator i = db->fields.begin(); 
+         i != db->fields.end(); ++i ) {
+      FieldDBElement *fdb = (*i).second;
+      unsigned int slot = fieldTableSlot( fdb->getId(), table_size );
+      while( table[slot] && table[slot]->getId() != fdb->getId() ) {
+        slot = fieldTableSlot( slot + 1, table_size );
+      }
+      // fields in databases closer to this one take precedence.
+      if( !table[slot] ) table[slot] = fdb;
+    }
+  }
+  field_table.swap( table );
+  field_table_generation = fields_generation;
+}
+
+FieldDBElement *H3DNodeDatabase::getFieldHelp( unsigned int field_id ) const {
+  using namespace H3DNodeDatabaseInternals;
+  // the table can be rebuilt by another thread, so it is only used
+  // with the lock held.
+  fieldsLock().lock();
+  updateFieldTable();
+  FieldDBElement *found = NULL;
+  if( !field_table.empty() ) {
+    unsigned int slot = fieldTableSlot( field_id, field_table.size() );
+    while( FieldDBElement *fdb = field_table[slot] ) {
+      if( fdb->getId() == field_id ) {
+        found = fdb;
+        break;
+      }
+      slot = fieldTableSlot( slot + 1, field_table.size() );
+    }
+  }
+  fieldsLock().unlock();
+  return found;
 }
 
 Field *H3DNodeDatabase::getField( const Node *n, const string &_name ) const {
-  std::string name(_name);
-  std::transform(name.begin(), name.end(), name.begin(), ::tolower); 
-  Field *f = getFieldHelp( n, name );
-  if( f ) return f;
+  return getField( n, getFieldId( _name ) );
+}
+
+Field *H3DNodeDatabase::getField( const Node *n, 
+                                  unsigned int field_id ) const {
+  FieldDBElement *fdb = getFieldHelp( field_id );
+  if( fdb ) return fdb->getField( n );
 
   // could not find the field with the given name. If the name starts with
   // "set_" try to remove that prefix.
+  const string &name = getFieldName( field_id );
   if( name.size() > 4 && name.substr( 0, 4 ) == "set_" ) {
-    f = getFieldHelp( n, name.substr( 4, name.size() - 4 ) );
+    fdb = getFieldHelp( getFieldId( name.substr( 4, name.size() - 4 ) ) );
+    Field *f = fdb ? fdb->getField( n ) : NULL;
     if( f && f->getAccessType() == Field::INPUT_OUTPUT ) return f;
   }
 
   if( name.size() > 8 && name.substr( name.size() - 8, 8 ) == "_changed" ) {
-    f = getFieldHelp( n, name.substr( 0, name.size() - 8 ) );
+    fdb = getFieldHelp( getFieldId( name.substr( 0, name.size() - 8 ) ) );
+    Field *f = fdb ? fdb->getField( n ) : NULL;
     if( f && f->getAccessType() == Field::INPUT_OUTPUT ) return f;
   }
 
@@ -211,14 +332,20 @@ void H3DNodeDatabase::addField( FieldDBElement *f ) {
     FieldDBConstIterator i = fieldDBBegin();
     for( ; fieldDBEnd() != i; ++i )
       if( tmp_name == (*i) ) break;
-    if( i == fieldDBEnd() ) fields[tmp_name] = f;
+    if( i == fieldDBEnd() ) {
+      fields[tmp_name] = f;
+      fieldsChanged();
+    }
   } else {
     // In the case of static intialized databases the lower-most node in
     // an inheritance hierarchy decides how a field should look. Therefore we
     // only check its own fields. The other reason is also that
     // fieldDBBegin() can't be used in the static initialization sequence
     // because of how the parent is referenced.
-    if( fields.find( tmp_name ) == fields.end() ) fields[tmp_name] = f;
+    if( fields.find( tmp_name ) == fields.end() ) {
+      fields[tmp_name] = f;
+      fieldsChanged();
+    }
   }
 }
 
@@ -231,6 +358,7 @@ bool H3DNodeDatabase::removeField ( const string& _name, Node* _node ) {
     if( fdb && ( _node == NULL || fdb->getField ( _node ) ) && fdb->getName() == _name ) {
       fields.erase( to_erase );
       delete fdb;
+      fieldsChanged();
       return true;
     }
   }
@@ -274,6 +402,7 @@ container( _container ), access( _access ) {
   std::string __name(_name);
   std::transform(__name.begin(), __name.end(), __name.begin(), ::tolower); 
   name = __name;
+  id = H3DNodeDatabase::getFieldId( name );
 }
 
 bool H3DNodeDatabase::FieldDBConstIterator::operator==( 
@@ -334,6 +463,7 @@ H3DNodeDatabase::FieldDBConstIterator::FieldDBConstIterator(
 
 
 void H3DNodeDatabase::clearDynamicFields() {
+  bool changed = false;
   for( FieldDBType::iterator i = fields.begin(); i != fields.end();  ) {
     DynamicFieldDBElement *fdb = 
       dynamic_cast< DynamicFieldDBElement * >( (*i).second );
@@ -342,11 +472,14 @@ void H3DNodeDatabase::clearDynamicFields() {
     if( fdb ) {
       fields.erase( to_erase );
       delete fdb;
+      changed = true;
     }
   }
+  if( changed ) fieldsChanged();
 }
 
 void H3DNodeDatabase::clearDynamicFields( Node *n ) {
+  bool changed = false;
   for( FieldDBType::iterator i = fields.begin(); i != fields.end();  ) {
     DynamicFieldDBElement *fdb = 
       dynamic_cast< DynamicFieldDBElement * >( (*i).second );
@@ -359,8 +492,10 @@ void H3DNodeDatabase::clearDynamicFields( Node *n ) {
       // Delete the DynamicFieldDBElement. It is not used anymore, and not
       // deleted anywhere else.
       delete fdb;
+      changed = true;
     } 
   }
+  if( changed ) fieldsChanged();
 }
 
 H3DNodeDatabase::FieldDBConstIterator::FieldDBConstIterator( const FieldDBConstIterator &f ):
@@ -387,6 +522,8 @@ H3DNodeDatabase::FieldDBConstIterator & H3DNodeDatabase::FieldDBConstIterator::o
 
 H3DNodeDatabase::H3DNodeDatabase( const Node * n,
                                   H3DNodeDatabase *_parent ) :
+field_table_generation( 0 ),
+fields_changed_generation( fields_generation ),
 name( _parent->name ),
 createf( _parent->createf ),
 ti( _parent->ti ),
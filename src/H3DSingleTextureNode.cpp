@@ -30,6 +30,9 @@
 #include <H3D/X3DShaderNode.h>
 #include <H3D/X3DProgrammableShaderObject.h>
 #include <H3D/Scene.h>
+#include <H3D/TextureMemoryManager.h>
+#include <H3D/GraphicsOptions.h>
+#include <H3D/GlobalSettings.h>
 
 //#define DEBUG_BINDLESS
 
@@ -45,17 +48,88 @@ H3DSingleTextureNode::H3DSingleTextureNode(
   texture_handle ( 0 ),
   last_used ( 0 ),
   is_resident ( false ),
+  release_image_checked ( false ),
   texture_id(0),
   texture_unit(GL_TEXTURE0),
   texture_target(0){
 }
 
 H3DSingleTextureNode::~H3DSingleTextureNode () {
+  TextureMemoryManager::textureRemoved( this );
+  // the image may be used after this node is destroyed.
+  setReloadableImage( NULL );
   if ( X3DProgrammableShaderObject::use_bindless_textures ) {
     makeNonResident ();
   }
 }
 
+bool H3DSingleTextureNode::releaseImageAfterUpload( 
+                                 TextureProperties *texture_properties ) {
+  if( texture_properties ) {
+    const string &release = texture_properties->releaseImage->getValue();
+    if( release == "RELEASE" ) return true;
+    if( release == "KEEP" ) return false;
+  }
+  GraphicsOptions *options = NULL;
+  GlobalSettings *default_settings = GlobalSettings::getActive();
+  if( default_settings ) default_settings->getOptionNode( options );
+  return options && options->releaseImagesAfterUpload->getValue();
+}
+
+bool H3DSingleTextureNode::textureHoldsImage( Image *image,
+                                 TextureProperties *texture_properties ) {
+  if( texture_properties ) {
+    // the pixel transfer and the texture format change the data.
+    if( texture_properties->textureTransferScale->getValue() != 
+        Vec4f( 1, 1, 1, 1 ) ||
+        texture_properties->textureTransferBias->getValue() != 
+        Vec4f( 0, 0, 0, 0 ) ||
+        texture_properties->textureFormat->getValue() != "NORMAL" ) {
+      return false;
+    }
+  }
+
+  GLint compressed = GL_FALSE;
+  glGetTexLevelParameteriv( texture_target, 0, GL_TEXTURE_COMPRESSED_ARB,
+                            &compressed );
+  if( compressed ) return false;
+
+  // the texture must not have been scaled.
+  GLint width = 0, height = 0, depth = 1;
+  glGetTexLevelParameteriv( texture_target, 0, GL_TEXTURE_WIDTH, &width );
+  glGetTexLevelParameteriv( texture_target, 0, GL_TEXTURE_HEIGHT, &height );
+  if( texture_target == GL_TEXTURE_3D ||
+      texture_target == GL_TEXTURE_2D_ARRAY_EXT ) {
+    glGetTexLevelParameteriv( texture_target, 0, GL_TEXTURE_DEPTH, &depth );
+  }
+  if( (unsigned int)width != image->width() ||
+      (unsigned int)height != image->height() ||
+      (unsigned int)depth != image->depth() ) {
+    return false;
+  }
+
+  // the internal format must keep the precision of the image.
+  const GLenum size_params[] = { GL_TEXTURE_RED_SIZE,
+                                 GL_TEXTURE_GREEN_SIZE,
+                                 GL_TEXTURE_BLUE_SIZE,
+                                 GL_TEXTURE_ALPHA_SIZE,
+                                 GL_TEXTURE_LUMINANCE_SIZE,
+                                 GL_TEXTURE_INTENSITY_SIZE,
+                                 GL_TEXTURE_DEPTH_SIZE };
+  GLint bits_per_pixel = 0;
+  for( unsigned int i = 0; i < sizeof( size_params ) / sizeof( GLenum ); ++i ) {
+    GLint bits = 0;
+    glGetTexLevelParameteriv( texture_target, 0, size_params[i], &bits );
+    bits_per_pixel += bits;
+  }
+  return (unsigned int)bits_per_pixel >= image->bitsPerPixel();
+}
+
+void H3DSingleTextureNode::setReloadableImage( ReloadableImage *image ) {
+  if( reloadable_image.get() ) reloadable_image->detach();
+  reloadable_image.reset( image );
+}
+
 bool H3DSingleTextureNode::makeResident () {
 #ifdef GL_ARB_bindless_texture
   if ( !is_resident ) {
@@ -125,6 +199,11 @@ void H3DSingleTextureNode::removeShaderField ( Field& _field ) {
   }
 }
 
+void H3DSingleTextureNode::traverseSG( TraverseInfo &ti ) {
+  X3DTextureNode::traverseSG( ti );
+  TextureMemoryManager::textureUsed( this );
+}
+
 void H3DSingleTextureNode::inUse () {
   last_used= Scene::time->getValue();
 }
@@ -29,6 +29,7 @@
 
 
 #include <H3D/H3DVideoTextureNode.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -66,7 +67,7 @@ void H3DVideoTextureNode::render() {
     X3DTexture2DNode::render();
   } else {
     PixelImage *pi = dynamic_cast< PixelImage * >( image->getValue() );
-    glBindTexture( GL_TEXTURE_2D, texture_id );
+    GLStateTracker::bindTexture( GL_TEXTURE_2D, texture_id );
     enableTexturing();
     if( decoder->haveNewFrame() ) {
       decoder->getNewFrame( (unsigned char *)pi->getImageData() );
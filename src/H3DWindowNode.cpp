@@ -52,6 +52,10 @@
 #include <H3D/X3DPointingDeviceSensorNode.h>
 #include <H3D/GraphicsOptions.h>
 #include <H3D/GraphicsHardwareInfo.h>
+#include <H3D/GLStateTracker.h>
+#include <H3D/TextureUploadManager.h>
+#include <H3D/TextureMemoryManager.h>
+#include <H3D/ShaderFunctions.h>
 
 #include <H3DUtil/TimeStamp.h>
 #include <H3DUtil/Exception.h>
@@ -300,11 +304,11 @@ void H3DWindowNode::initialize() {
   GraphicsHardwareInfo::initializeInfo();
 
   // configure OpenGL context for rendering.
-  glEnable( GL_DEPTH_TEST );
+  GLStateTracker::enable( GL_DEPTH_TEST );
   glGetError(); // Clear error flag caused by bug in glewInit()
   glDepthFunc( GL_LESS );
   glDepthMask( GL_TRUE );
-  glEnable( GL_LIGHTING );
+  GLStateTracker::enable( GL_LIGHTING );
   glLightModeli( GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE );
   glLightModeli( GL_LIGHT_MODEL_LOCAL_VIEWER, GL_TRUE );
   GLfloat no_ambient[] = { 0.0, 0.0, 0.0, 1.0 };
@@ -367,12 +371,12 @@ void renderHapticTriangles() {
         if( render_triangles ) {
           glMatrixMode( GL_MODELVIEW );
           glPushMatrix();
-          glPushAttrib( GL_CURRENT_BIT | GL_ENABLE_BIT | GL_POLYGON_BIT );
-          glDisable( GL_LIGHTING );
+          GLStateTracker::pushAttrib( GL_CURRENT_BIT | GL_ENABLE_BIT | GL_POLYGON_BIT );
+          GLStateTracker::disable( GL_LIGHTING );
           glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
           glColor3f( 1, 1, 1 );
           (*i)->glRender();
-          glPopAttrib();
+          GLStateTracker::popAttrib();
           glPopMatrix();
         }
       }
@@ -834,6 +838,13 @@ void H3DWindowNode::render( X3DChildNode *child_to_render ) {
   
   // make this the active window
   makeWindowActive();
+  // state tracked for another context is not valid for this one.
+  GLStateTracker::beginRender();
+  Shaders::invalidateUniformValues();
+  // continue uploading texture images before anything is rendered.
+  TextureUploadManager::processUploads();
+  // keep the textures within the memory budget.
+  TextureMemoryManager::evictTextures();
   if( check_if_stereo_obtained )
     checkIfStereoObtained();
 
@@ -858,7 +869,7 @@ void H3DWindowNode::render( X3DChildNode *child_to_render ) {
     return;
   }
 
-  glPushAttrib( GL_ENABLE_BIT );
+  GLStateTracker::pushAttrib( GL_ENABLE_BIT );
 
   X3DBackgroundNode *background = X3DBackgroundNode::getActive();
   Fog *fog = Fog::getActive();
@@ -869,8 +880,8 @@ void H3DWindowNode::render( X3DChildNode *child_to_render ) {
 
   glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
   
-  glEnable( GL_DEPTH_TEST ); 
-  glEnable( GL_LIGHTING );
+  GLStateTracker::enable( GL_DEPTH_TEST ); 
+  GLStateTracker::enable( GL_LIGHTING );
   glLightModeli( GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE );
   glLightModeli( GL_LIGHT_MODEL_LOCAL_VIEWER, GL_TRUE );
   GLfloat no_ambient[] = { 0.0, 0.0, 0.0, 1.0 };
@@ -889,10 +900,10 @@ void H3DWindowNode::render( X3DChildNode *child_to_render ) {
   if( !nav_info ) nav_info = NavigationInfo::getActive();
   GLint headlight_index = -1;
   if( !nav_info || nav_info->headlight->getValue() ) {
-    glPushAttrib( GL_LIGHTING_BIT );
+    GLStateTracker::pushAttrib( GL_LIGHTING_BIT );
     headlight_index =
       X3DLightNode::getLightIndex( "Headlight in H3DWindowNode" );
-    glEnable( GL_LIGHT0 + (GLuint)(headlight_index) );
+    GLStateTracker::enable( GL_LIGHT0 + (GLuint)(headlight_index) );
   }
 
   // add headlight shadows if specified in NavigationInfo
@@ -1138,7 +1149,7 @@ void H3DWindowNode::render( X3DChildNode *child_to_render ) {
         glDrawPixels( stencil_mask_width, stencil_mask_height, 
                       GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, stencil_mask );
       // render only every second line
-      glEnable(GL_STENCIL_TEST);
+      GLStateTracker::enable(GL_STENCIL_TEST);
       glStencilFunc(GL_EQUAL,1,1);
       glStencilOp(GL_KEEP,GL_KEEP,GL_KEEP);
       fbo_current_x = 0;
@@ -1246,7 +1257,7 @@ void H3DWindowNode::render( X3DChildNode *child_to_render ) {
                stereo_mode == RenderMode::HORIZONTAL_INTERLACED ||
                stereo_mode == RenderMode::CHECKER_INTERLACED ||
                stereo_mode == RenderMode::VERTICAL_INTERLACED_GREEN_SHIFT ) {
-      glEnable(GL_STENCIL_TEST);
+      GLStateTracker::enable(GL_STENCIL_TEST);
       glStencilFunc(GL_NOTEQUAL,1,1);
       glStencilOp(GL_KEEP,GL_KEEP,GL_KEEP);
     }else{// set viewport for right eye when it is not covering the full window
@@ -1335,27 +1346,27 @@ void H3DWindowNode::render( X3DChildNode *child_to_render ) {
     if( stereo_mode == RenderMode::VERTICAL_INTERLACED ||
              stereo_mode == RenderMode::HORIZONTAL_INTERLACED ||
              stereo_mode == RenderMode::CHECKER_INTERLACED ) 
-      glDisable( GL_STENCIL_TEST );
+      GLStateTracker::disable( GL_STENCIL_TEST );
     else if( stereo_mode == RenderMode::VERTICAL_INTERLACED_GREEN_SHIFT ) {
-      glDisable( GL_STENCIL_TEST );
+      GLStateTracker::disable( GL_STENCIL_TEST );
       // do green shift
-      glPushAttrib(GL_CURRENT_BIT | GL_LINE_BIT | GL_POLYGON_BIT | 
+      GLStateTracker::pushAttrib(GL_CURRENT_BIT | GL_LINE_BIT | GL_POLYGON_BIT | 
                    GL_POLYGON_STIPPLE_BIT | GL_VIEWPORT_BIT | 
                    GL_TRANSFORM_BIT | GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT);
-      glDisable(GL_POLYGON_STIPPLE);
-      glDisable(GL_LINE_STIPPLE);
-      glDisable(GL_DITHER);
-      glDisable(GL_DEPTH_TEST);
-      glDisable(GL_BLEND);
-      glDisable(GL_FOG);
-      glDisable(GL_LIGHTING);
-      glDisable(GL_TEXTURE_2D);
-      glDisable(GL_TEXTURE_1D);
-      glDisable(GL_POLYGON_SMOOTH);
-      glDisable(GL_NORMALIZE);
-      glDisable(GL_STENCIL_TEST);
-      glDisable(GL_SCISSOR_TEST);
-      glDisable(GL_ALPHA_TEST);
+      GLStateTracker::disable(GL_POLYGON_STIPPLE);
+      GLStateTracker::disable(GL_LINE_STIPPLE);
+      GLStateTracker::disable(GL_DITHER);
+      GLStateTracker::disable(GL_DEPTH_TEST);
+      GLStateTracker::disable(GL_BLEND);
+      GLStateTracker::disable(GL_FOG);
+      GLStateTracker::disable(GL_LIGHTING);
+      GLStateTracker::disable(GL_TEXTURE_2D);
+      GLStateTracker::disable(GL_TEXTURE_1D);
+      GLStateTracker::disable(GL_POLYGON_SMOOTH);
+      GLStateTracker::disable(GL_NORMALIZE);
+      GLStateTracker::disable(GL_STENCIL_TEST);
+      GLStateTracker::disable(GL_SCISSOR_TEST);
+      GLStateTracker::disable(GL_ALPHA_TEST);
       glPixelTransferi(GL_MAP_COLOR,0);
       glPixelTransferi(GL_MAP_STENCIL,0);
       glPixelZoom(1.000000,1.000000);
@@ -1376,25 +1387,25 @@ void H3DWindowNode::render( X3DChildNode *child_to_render ) {
       glPopMatrix();
       glMatrixMode(GL_MODELVIEW);
       glPopMatrix();
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     } else if( stereo_mode == RenderMode::HDMI_FRAME_PACKED_720P ) {
       // set 30 lines to black as per hdmi standard 
       glScissor( 0, 719, 1280, 30 );
-      glEnable( GL_SCISSOR_TEST );
-      glPushAttrib( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+      GLStateTracker::enable( GL_SCISSOR_TEST );
+      GLStateTracker::pushAttrib( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
       glClearColor( 0.0, 0.0, 0.0, 1.0 );
       glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
-      glPopAttrib();
-      glDisable( GL_SCISSOR_TEST );
+      GLStateTracker::popAttrib();
+      GLStateTracker::disable( GL_SCISSOR_TEST );
     } else if( stereo_mode == RenderMode::HDMI_FRAME_PACKED_1080P ) {
       // set 45 lines to black as per hdmi standard 
       glScissor( 0, 1079, 1920, 45 );
-      glEnable( GL_SCISSOR_TEST );
-      glPushAttrib( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+      GLStateTracker::enable( GL_SCISSOR_TEST );
+      GLStateTracker::pushAttrib( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
       glClearColor( 0.0, 0.0, 0.0, 1.0 );
       glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
-      glPopAttrib();
-      glDisable( GL_SCISSOR_TEST );
+      GLStateTracker::popAttrib();
+      GLStateTracker::disable( GL_SCISSOR_TEST );
     }
 #ifdef  HAVE_PROFILER
     H3DUtil::H3DTimer::stepBegin("Stereo_swapBuffers");
@@ -1471,7 +1482,7 @@ void H3DWindowNode::render( X3DChildNode *child_to_render ) {
         }
         
         
-        glDisable(GL_SCISSOR_TEST);
+        GLStateTracker::disable(GL_SCISSOR_TEST);
         
       } else {
 #endif
@@ -1510,7 +1521,7 @@ void H3DWindowNode::render( X3DChildNode *child_to_render ) {
 
     GLboolean norm= glIsEnabled( GL_NORMALIZE );
     if ( !norm ) 
-      glEnable( GL_NORMALIZE );
+      GLStateTracker::enable( GL_NORMALIZE );
 
     // add viewmatrix to model view matrix.
     vp->setupViewMatrix( eye_mode );
@@ -1554,7 +1565,7 @@ void H3DWindowNode::render( X3DChildNode *child_to_render ) {
     }
 
     if ( !norm ) 
-      glDisable( GL_NORMALIZE );
+      GLStateTracker::disable( GL_NORMALIZE );
 #ifdef HAVE_PROFILER
     H3DUtil::H3DTimer::stepBegin("mono_swapBuffers");
 #endif
@@ -1563,7 +1574,7 @@ void H3DWindowNode::render( X3DChildNode *child_to_render ) {
     H3DUtil::H3DTimer::stepEnd("mono_swapBuffers");
 #endif
   }
-  glPopAttrib();
+  GLStateTracker::popAttrib();
 
   // if we are using automatic cursor control we now choose cursor 
   // depending on scene state.
@@ -1690,7 +1701,7 @@ void H3DWindowNode::render( X3DChildNode *child_to_render ) {
   previous_mouse_position[1] = mouse_position[1];
 
   if( headlight_index != -1 ) {
-    glPopAttrib();
+    GLStateTracker::popAttrib();
     X3DLightNode::decreaseLightIndex();
   }
 }
@@ -32,6 +32,7 @@
 
 
 #include <H3D/X3D.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -186,8 +187,8 @@ void HAnimJoint::renderSkeleton( RenderType type ) {
 
   // render lines if in skeleton mode
   if( type == HAnimJoint::SKELETON ) {
-    glPushAttrib( GL_LIGHTING_BIT );
-    glDisable( GL_LIGHTING );
+    GLStateTracker::pushAttrib( GL_LIGHTING_BIT );
+    GLStateTracker::disable( GL_LIGHTING );
     glColor3f( 1, 1, 1 );
     
     glBegin( GL_LINES );
@@ -200,7 +201,7 @@ void HAnimJoint::renderSkeleton( RenderType type ) {
       } 
     }    
     glEnd();
-    glPopAttrib();
+    GLStateTracker::popAttrib();
   } 
 }
 
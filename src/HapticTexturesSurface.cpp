@@ -156,21 +156,26 @@ void HapticTexturesSurface::initialize() {
   Image * stiffness_image = 0;
   if( a_map )
     stiffness_image = a_map->image->getValue();
+  // the haptics thread can not load released image data.
+  ReloadableImage::keepLoaded( stiffness_image );
 
   a_map = static_cast< X3DTexture2DNode * >( dampingMap->getValue() );
   Image * damping_image = 0;
   if( a_map )
     damping_image = a_map->image->getValue();
+  ReloadableImage::keepLoaded( damping_image );
 
   a_map = static_cast< X3DTexture2DNode * >( staticFrictionMap->getValue() );
   Image * static_friction_image = 0;
   if( a_map )
     static_friction_image = a_map->image->getValue();
+  ReloadableImage::keepLoaded( static_friction_image );
 
   a_map = static_cast< X3DTexture2DNode * >( dynamicFrictionMap->getValue() );
   Image * dynamic_friction_image = 0;
   if( a_map )
     dynamic_friction_image = a_map->image->getValue();
+  ReloadableImage::keepLoaded( dynamic_friction_image );
 
   H3DFloat max_stiffness = maxStiffness->getValue();
   H3DFloat min_stiffness = minStiffness->getValue();
@@ -231,6 +236,8 @@ void HapticTexturesSurface::initialize() {
 void HapticTexturesSurface::SetImagePtr::update() {
    Image *image =
      static_cast< X3DTexture2DNode::SFImage * >(event.ptr)->getValue();
+   // the haptics thread can not load released image data.
+   ReloadableImage::keepLoaded( image );
    HapticTexturesSurface *hms = 
      static_cast< HapticTexturesSurface * >( getOwner() );
    HAPI::HapticTexturesSurface * _hapi_surface = 
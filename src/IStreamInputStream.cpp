@@ -43,6 +43,7 @@ XMLSize_t X3D::IStreamInputStream::readBytes(
                                           XMLByte* const to_fill,
                                           const XMLSize_t max_to_read ) {
   is.read( (char *) to_fill, max_to_read );
+  total_count += (unsigned int) is.gcount();
   return (unsigned int) is.gcount();
 }
 #else
@@ -54,6 +55,7 @@ unsigned int X3D::IStreamInputStream::readBytes(
                                           XMLByte* const to_fill,
                                           const unsigned int max_to_read ) {
   is.read( (char *) to_fill, max_to_read );
+  total_count += (unsigned int) is.gcount();
   return (unsigned int) is.gcount();
 }
 #endif
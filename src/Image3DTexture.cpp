@@ -31,6 +31,7 @@
 #include <H3D/Image3DTexture.h>
 #include <H3D/ResourceResolver.h>
 #include <H3D/GlobalSettings.h>
+#include <H3D/ImageLoadPool.h>
 #include <H3D/X3DProgrammableShaderObject.h>
 
 using namespace H3D;
@@ -79,37 +80,44 @@ Image3DTexture::Image3DTexture(
   imageLoader->route( image );
 }
 
-Image* Image3DTexture::SFImage::loadImage( Image3DTexture *texture,
-                                           const vector< string > &urls,
-                                           const NodeVector &image_loaders ) {
+Image* Image3DTexture::SFImage::loadImage( const ThreadFuncData &input,
+                                           string &url_used ) {
   // First try the image loader nodes specified
-  if( image_loaders.size() ) { 
-    for( vector<string>::const_iterator i = urls.begin(); 
-         i != urls.end(); ++i ) {
-      for( NodeVector::const_iterator il = image_loaders.begin();
-           il != image_loaders.end();
+  if( input.image_loaders.size() ) { 
+    for( vector<string>::const_iterator i = input.urls.begin(); 
+         i != input.urls.end(); ++i ) {
+      for( NodeVector::const_iterator il = input.image_loaders.begin();
+           il != input.image_loaders.end();
            ++il ) {
-        // First try to resolve the url to file contents and load via string buffer
-        // Otherwise fallback on using temp files
-        string url_contents= ResourceResolver::resolveURLAsString ( *i );
+        // Local files are loaded directly so that loaders can map them.
+        // Otherwise first try to resolve the url to file contents and load
+        // via string buffer and fall back on using temp files.
+        string url_contents;
+        if( X3DUrlObject::resolveURLAsLocalFileFromBase( input.url_base,
+                                                         *i ).empty() ) {
+          url_contents =
+            X3DUrlObject::resolveURLFromBase( input.url_base, *i, true );
+        }
         if ( url_contents != "" ) {
           istringstream tmp_istream( url_contents );
           Image *_image = 
             static_cast< H3DImageLoaderNode * >(*il)->loadImage ( tmp_istream );
           if( _image ) {
-            texture->setURLUsed( *i );
+            url_used = *i;
             return _image;
           }
         }
 
         bool is_tmp_file;
-        string _url = texture->resolveURLAsFile( *i, &is_tmp_file );
+        string _url =
+          X3DUrlObject::resolveURLFromBase( input.url_base, *i, false,
+                                            &is_tmp_file );
         if( !_url.empty() ) {
           Image *_image = 
             static_cast< H3DImageLoaderNode * >(*il)->loadImage( _url );
           if( is_tmp_file ) ResourceResolver::releaseTmpFileName( _url );
           if( _image ) {
-            texture->setURLUsed( *i );
+            url_used = *i;
             return _image;
           }
         }
@@ -118,29 +126,37 @@ Image* Image3DTexture::SFImage::loadImage( Image3DTexture *texture,
   }
 
   // Now try to find any image loader that can handle the format
-  for( vector<string>::const_iterator i = urls.begin(); 
-       i != urls.end(); ++i ) {
-    // First try to resolve the url to file contents and load via string buffer
-    // Otherwise fallback on using temp files
-    string url_contents= ResourceResolver::resolveURLAsString ( *i );
+  for( vector<string>::const_iterator i = input.urls.begin(); 
+       i != input.urls.end(); ++i ) {
+    // Local files are loaded directly so that loaders can map them.
+    // Otherwise first try to resolve the url to file contents and load
+    // via string buffer and fall back on using temp files.
+    string url_contents;
+    if( X3DUrlObject::resolveURLAsLocalFileFromBase( input.url_base,
+                                                     *i ).empty() ) {
+      url_contents =
+        X3DUrlObject::resolveURLFromBase( input.url_base, *i, true );
+    }
     if ( url_contents != "" ) {
       istringstream tmp_istream( url_contents );
       auto_ptr< H3DImageLoaderNode > 
         il( H3DImageLoaderNode::getSupportedFileReader( tmp_istream ) );
       if( il.get() ) {
-        texture->setURLUsed( *i );
+        url_used = *i;
         Image *_image = il->loadImage( tmp_istream );
         return _image;
       }
     }
 
     bool is_tmp_file;
-    string _url = texture->resolveURLAsFile( *i, &is_tmp_file );
+    string _url =
+      X3DUrlObject::resolveURLFromBase( input.url_base, *i, false,
+                                        &is_tmp_file );
     if( !_url.empty() ) {
       auto_ptr< H3DImageLoaderNode > 
         il( H3DImageLoaderNode::getSupportedFileReader( _url ) );
       if( il.get() ) {
-        texture->setURLUsed( *i );
+        url_used = *i;
         Image *_image = il->loadImage( _url );
         if( is_tmp_file ) ResourceResolver::releaseTmpFileName( _url );
         return _image;
@@ -150,39 +166,39 @@ Image* Image3DTexture::SFImage::loadImage( Image3DTexture *texture,
   }
 
   Console(LogLevel::Error) << "Warning: None of the urls in Image3DTexture with url [";
-  for( vector<string>::const_iterator i = urls.begin(); 
-       i != urls.end(); ++i ) {  
+  for( vector<string>::const_iterator i = input.urls.begin(); 
+       i != input.urls.end(); ++i ) {  
     Console(LogLevel::Error) << " \"" << *i << "\"";
   }
   Console(LogLevel::Error) << "] could be loaded. Either they don't exist or the file format "
              << "is not supported by any H3DImageLoaderNode that is available "
-             << "(in " << getOwner()->getName() << ")" << endl;
+             << "(in " << input.texture_name << ")" << endl;
 
-  texture->setURLUsed( "" );
+  url_used = "";
   return( NULL );
 }
 
-Scene::CallbackCode Image3DTexture::SFImage::loadImageCB( void *data ) {
-  CBData *input = static_cast< CBData * >( data );
-  input->texture->image->setValue( input->image );
-  input->texture = NULL;
-  input->image = NULL;
-  return Scene::CALLBACK_DONE;
+Image *Image3DTexture::SFImage::ThreadFuncData::load( string &url_used ) {
+  return loadImage( *this, url_used );
+}
+
+void Image3DTexture::SFImage::loadImageDone( void *data, Image *image,
+                                             const string &url_used ) {
+  SFImage *sfimage = static_cast< SFImage * >( data );
+  sfimage->load_pending = false;
+  sfimage->url_image = image;
+  Image3DTexture *texture = static_cast< Image3DTexture * >( sfimage->getOwner() );
+  texture->setURLUsed( url_used );
+  sfimage->setValue( image );
+}
+
+Image *Image3DTexture::SFImage::reloadImage() {
+  string url_used;
+  return loadImage( thread_data, url_used );
 }
 
-void *Image3DTexture::SFImage::loadImageThreadFunc( void * data ) {
-  ThreadFuncData *input = static_cast< ThreadFuncData * >( data );
-  input->load_thread_mutex.lock();
-  SFImage *sfimage = static_cast< SFImage * >( input->texture->image.get() );
-  Image *image = sfimage->loadImage( input->texture,
-                                     input->urls,
-                                     input->image_loaders );
-                                  
-  sfimage->cb_data.texture = input->texture;
-  sfimage->cb_data.image = image;
-  Scene::addCallback( loadImageCB, &sfimage->cb_data );
-  input->load_thread_mutex.unlock();
-  return NULL;
+void Image3DTexture::SFImage::setLoadPriority( H3DFloat priority ) {
+  if( load_pending ) ImageLoadPool::setPriority( this, priority );
 }
 
 void Image3DTexture::SFImage::update() {
@@ -200,20 +216,41 @@ void Image3DTexture::SFImage::update() {
     load_in_thread= load_in_thread_local == "SEPARATE";
   }
 
+  // the image of an earlier load is no longer wanted.
+  ImageLoadPool::cancel( this );
+  load_pending = false;
+
+  // also used to load the image again by reloadImage().
+  thread_data.url_base = texture->getURLBase();
+  thread_data.texture_name = texture->getName();
+  thread_data.urls = urls->getValue();
+  thread_data.image_loaders = image_loaders->getValue();
+
   if( load_in_thread ) {
     value = NULL;
-    // delete the old thread
-    texture->load_thread.reset( NULL );
-    
-    thread_data.texture = texture;
-    thread_data.urls = urls->getValue();
-    thread_data.image_loaders = image_loaders->getValue();
-
-    texture->load_thread.reset( new H3DUtil::SimpleThread( &loadImageThreadFunc, 
-                                                   (void *)&thread_data ) );
-    texture->load_thread->setThreadName( "ImageTexture3D load thread" );
+    url_image = NULL;
+
+    // textures loading the same urls with the same image loaders share
+    // one load.
+    stringstream key;
+    key << "Image3DTexture\n" << texture->getURLBase();
+    for( vector< string >::const_iterator i = thread_data.urls.begin();
+         i != thread_data.urls.end(); ++i ) {
+      key << "\n" << *i;
+    }
+    for( NodeVector::const_iterator i = thread_data.image_loaders.begin();
+         i != thread_data.image_loaders.end(); ++i ) {
+      key << "\n" << (void *)(*i);
+    }
+
+    load_pending = true;
+    ImageLoadPool::load( key.str(), new ThreadFuncData( thread_data ),
+                         &loadImageDone, this );
   } else {
-    value = loadImage( texture, urls->getValue(), image_loaders->getValue() );
+    string url_used;
+    value = loadImage( thread_data, url_used );
+    texture->setURLUsed( url_used );
+    url_image = value.get();
   }
 
   // reset the editing variables since we are doing a full load of a new
@@ -227,8 +264,31 @@ void Image3DTexture::SFImage::update() {
   }
 }
 
+ReloadableImage *Image3DTexture::newReloadableImage( Image *_image ) {
+  SFImage *sfimage = static_cast< SFImage * >( image.get() );
+  if( sfimage->isLoadedFromURL( _image ) ) {
+    // decoding the url again does not need the texture.
+    return new ReloadableImage( _image, &reloadImage, this, false );
+  }
+  return X3DTexture3DNode::newReloadableImage( _image );
+}
+
+Image *Image3DTexture::reloadImage( Image *_image, void *data ) {
+  Image3DTexture *texture = static_cast< Image3DTexture * >( data );
+  return static_cast< SFImage * >( texture->image.get() )->reloadImage();
+}
+
 void Image3DTexture::render() {
   if( url->size() > 0 ) {
+    SFImage *sfimage = static_cast< SFImage * >( image.get() );
+    if( sfimage->isLoadPending() ) {
+      // rendered textures are loaded before textures that are not, and
+      // closer textures before textures farther away.
+      GLfloat mv[16];
+      glGetFloatv( GL_MODELVIEW_MATRIX, mv );
+      sfimage->setLoadPriority( Vec3f( mv[12], mv[13], mv[14] ).length() );
+    }
+
     try {
       X3DTexture3DNode::render();
     } catch( InvalidTextureDimensions &e ) {
@@ -257,13 +317,5 @@ void Image3DTexture::render() {
 }
 
 Image3DTexture::SFImage::~SFImage() {
-  thread_data.load_thread_mutex.lock();
-  if( cb_data.texture ) {
-    Scene::removeCallback( &cb_data );
-    if( cb_data.image )
-      delete cb_data.image;
-    cb_data.texture = NULL;
-    cb_data.image = NULL;
-  }
-  thread_data.load_thread_mutex.unlock();
+  ImageLoadPool::cancel( this );
 }
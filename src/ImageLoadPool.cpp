@@ -0,0 +1,270 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file ImageLoadPool.cpp
+/// \brief CPP file for ImageLoadPool.
+///
+//
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <H3D/ImageLoadPool.h>
+#include <H3D/DeviceInfo.h>
+
+#include <algorithm>
+
+#ifdef H3D_WINDOWS
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace H3D;
+
+const H3DFloat ImageLoadPool::default_priority = 1e30f;
+H3DUtil::ConditionLock ImageLoadPool::lock;
+vector< ImageLoadPool::Job * > ImageLoadPool::queued;
+map< string, ImageLoadPool::Job * > ImageLoadPool::shared_jobs;
+map< void *, ImageLoadPool::Job * > ImageLoadPool::listener_jobs;
+vector< H3DUtil::SimpleThread * > ImageLoadPool::threads;
+unsigned int ImageLoadPool::nr_running = 0;
+bool ImageLoadPool::stopping = false;
+
+namespace ImageLoadPoolInternals {
+  // Stops the threads before the members of ImageLoadPool, which are
+  // defined above, are destroyed.
+  struct StopThreads {
+    ~StopThreads() {
+      ImageLoadPool::stopThreads();
+    }
+  };
+  StopThreads stop_threads;
+}
+
+ImageLoadPool::Job::~Job() {
+  delete loading_data;
+  for( unsigned int i = 0; i < listeners.size(); ++i ) {
+    delete listeners[i].load_data;
+  }
+}
+
+H3DFloat ImageLoadPool::Job::getPriority() {
+  H3DFloat priority = default_priority;
+  for( unsigned int i = 0; i < listeners.size(); ++i ) {
+    if( listeners[i].priority < priority ) priority = listeners[i].priority;
+  }
+  return priority;
+}
+
+void ImageLoadPool::load( const string &key, LoadData *load_data,
+                          DoneFunc done_func, void *data,
+                          H3DFloat priority ) {
+  startThreads();
+  lock.lock();
+  removeListener( data );
+
+  Listener listener;
+  listener.load_data = load_data;
+  listener.done_func = done_func;
+  listener.data = data;
+  listener.priority = priority;
+
+  Job *job = NULL;
+  if( key != "" ) {
+    map< string, Job * >::iterator i = shared_jobs.find( key );
+    if( i != shared_jobs.end() ) job = (*i).second;
+  }
+
+  if( !job ) {
+    job = new Job;
+    job->key = key;
+    if( key != "" ) shared_jobs[ key ] = job;
+    queued.push_back( job );
+    lock.broadcast();
+  }
+  job->listeners.push_back( listener );
+  listener_jobs[ data ] = job;
+  lock.unlock();
+}
+
+void ImageLoadPool::cancel( void *data ) {
+  lock.lock();
+  removeListener( data );
+  lock.unlock();
+}
+
+void ImageLoadPool::setPriority( void *data, H3DFloat priority ) {
+  lock.lock();
+  map< void *, Job * >::iterator i = listener_jobs.find( data );
+  if( i != listener_jobs.end() ) {
+    vector< Listener > &listeners = (*i).second->listeners;
+    for( unsigned int j = 0; j < listeners.size(); ++j ) {
+      if( listeners[j].data == data ) listeners[j].priority = priority;
+    }
+  }
+  lock.unlock();
+}
+
+unsigned int ImageLoadPool::getNrThreads() {
+  int nr_cores = 1;
+#ifdef H3D_WINDOWS
+  SYSTEM_INFO info;
+  GetSystemInfo( &info );
+  nr_cores = info.dwNumberOfProcessors;
+#else
+  long n = sysconf( _SC_NPROCESSORS_ONLN );
+  if( n > 0 ) nr_cores = n;
+#endif
+
+  // keep one core for the main thread and one for each haptics thread.
+  int nr_reserved = 1;
+  DeviceInfo *di = DeviceInfo::getActive();
+  if( di ) nr_reserved += (int)di->device->size();
+
+  return H3DMax( nr_cores - nr_reserved, 1 );
+}
+
+void ImageLoadPool::startThreads() {
+  lock.lock();
+  if( threads.empty() && !stopping ) {
+    unsigned int nr_threads = getNrThreads();
+    nr_running = nr_threads;
+    for( unsigned int i = 0; i < nr_threads; ++i ) {
+      H3DUtil::SimpleThread *thread =
+        new H3DUtil::SimpleThread( &loadThreadFunc, NULL );
+      thread->setThreadName( "Image load thread" );
+      threads.push_back( thread );
+    }
+  }
+  lock.unlock();
+}
+
+void ImageLoadPool::stopThreads() {
+  lock.lock();
+  stopping = true;
+  lock.broadcast();
+  while( nr_running > 0 ) lock.wait();
+  lock.unlock();
+
+  // the threads have returned from loadThreadFunc, deleting them waits
+  // for them to end.
+  for( unsigned int i = 0; i < threads.size(); ++i ) delete threads[i];
+  threads.clear();
+}
+
+void ImageLoadPool::removeListener( void *data ) {
+  map< void *, Job * >::iterator i = listener_jobs.find( data );
+  if( i == listener_jobs.end() ) return;
+  Job *job = (*i).second;
+  listener_jobs.erase( i );
+
+  for( vector< Listener >::iterator l = job->listeners.begin();
+       l != job->listeners.end(); ++l ) {
+    if( (*l).data == data ) {
+      delete (*l).load_data;
+      job->listeners.erase( l );
+      break;
+    }
+  }
+
+  if( job->listeners.empty() && !job->loading_data && !job->loaded ) {
+    // nobody wants the image anymore and it is not being loaded.
+    vector< Job * >::iterator q = std::find( queued.begin(), queued.end(), job );
+    if( q != queued.end() ) queued.erase( q );
+    if( job->key != "" ) shared_jobs.erase( job->key );
+    delete job;
+  }
+}
+
+void *ImageLoadPool::loadThreadFunc( void *data ) {
+  lock.lock();
+  while( true ) {
+    while( queued.empty() && !stopping ) lock.wait();
+    if( stopping ) break;
+
+    // load the job with the lowest priority value first.
+    vector< Job * >::iterator next = queued.begin();
+    H3DFloat next_priority = (*next)->getPriority();
+    for( vector< Job * >::iterator i = queued.begin() + 1;
+         i != queued.end(); ++i ) {
+      H3DFloat priority = (*i)->getPriority();
+      if( priority < next_priority ) {
+        next = i;
+        next_priority = priority;
+      }
+    }
+    Job *job = *next;
+    queued.erase( next );
+
+    // the job keeps the load data while loading so that the listener
+    // can be removed meanwhile.
+    LoadData *load_data = job->listeners.front().load_data;
+    job->listeners.front().load_data = NULL;
+    job->loading_data = load_data;
+    lock.unlock();
+
+    string url_used;
+    Image *image = load_data->load( url_used );
+
+    lock.lock();
+    job->loaded = true;
+    job->image = image;
+    job->url_used = url_used;
+    if( stopping ) {
+      // the scene may already be destroyed, so the job is left as is.
+      break;
+    }
+    lock.unlock();
+
+    // the callback is added without holding the lock since loadedCB
+    // locks it while the scene callbacks are locked.
+    Scene::addCallback( loadedCB, job );
+    lock.lock();
+  }
+  --nr_running;
+  lock.broadcast();
+  lock.unlock();
+  return NULL;
+}
+
+Scene::CallbackCode ImageLoadPool::loadedCB( void *data ) {
+  Job *job = static_cast< Job * >( data );
+  lock.lock();
+  vector< Listener > listeners = job->listeners;
+  for( unsigned int i = 0; i < listeners.size(); ++i ) {
+    listener_jobs.erase( listeners[i].data );
+  }
+  map< string, Job * >::iterator j = shared_jobs.find( job->key );
+  if( j != shared_jobs.end() && (*j).second == job ) shared_jobs.erase( j );
+  lock.unlock();
+
+  if( listeners.empty() ) {
+    if( job->image ) delete job->image;
+  } else {
+    for( unsigned int i = 0; i < listeners.size(); ++i ) {
+      listeners[i].done_func( listeners[i].data, job->image, job->url_used );
+    }
+  }
+  delete job;
+  return Scene::CALLBACK_DONE;
+}
@@ -32,6 +32,7 @@
 #include <H3D/ResourceResolver.h>
 #include <H3D/DicomImageLoader.h>
 #include <H3D/GlobalSettings.h>
+#include <H3D/ImageLoadPool.h>
 #include <H3D/X3DProgrammableShaderObject.h>
 
 //#define DEBUG_SHARING
@@ -72,7 +73,6 @@ ImageTexture::ImageTexture(
   imageLoader( _imageLoader ),
   loadInThread ( _loadInThread ),
   canShare ( _canShare ),
-  load_thread( NULL ),
   wrapped_image ( NULL ),
   inited_sharing ( false ),
   share_textures ( false ) {
@@ -95,37 +95,44 @@ ImageTexture::~ImageTexture () {
   removeSharedImage ();
 }
 
-Image* ImageTexture::SFImage::loadImage( ImageTexture *texture,
-                                         const vector< string > &urls,
-                                         const NodeVector &image_loaders ) {
+Image* ImageTexture::SFImage::loadImage( const ThreadFuncData &input,
+                                         string &url_used ) {
   // First try the image loader nodes specified
-  if( image_loaders.size() ) { 
-    for( vector<string>::const_iterator i = urls.begin(); 
-         i != urls.end(); ++i ) {
-      for( NodeVector::const_iterator il = image_loaders.begin();
-           il != image_loaders.end();
+  if( input.image_loaders.size() ) { 
+    for( vector<string>::const_iterator i = input.urls.begin(); 
+         i != input.urls.end(); ++i ) {
+      for( NodeVector::const_iterator il = input.image_loaders.begin();
+           il != input.image_loaders.end();
            ++il ) {
-        // First try to resolve the url to file contents and load via string buffer
-        // Otherwise fallback on using temp files
-        string url_contents= texture->resolveURLAsString ( *i );
+        // Local files are loaded directly so that loaders can map them.
+        // Otherwise first try to resolve the url to file contents and load
+        // via string buffer and fall back on using temp files.
+        string url_contents;
+        if( X3DUrlObject::resolveURLAsLocalFileFromBase( input.url_base,
+                                                         *i ).empty() ) {
+          url_contents =
+            X3DUrlObject::resolveURLFromBase( input.url_base, *i, true );
+        }
         if ( url_contents != "" ) {
           istringstream tmp_istream( url_contents );
           Image *_image =
             static_cast< H3DImageLoaderNode * >(*il)->loadImage ( tmp_istream );
           if( _image ) {
-            texture->setURLUsed( *i );
+            url_used = *i;
             return _image;
           }
         }
 
         bool is_tmp_file;
-        string _url = texture->resolveURLAsFile( *i, &is_tmp_file );
+        string _url =
+          X3DUrlObject::resolveURLFromBase( input.url_base, *i, false,
+                                            &is_tmp_file );
         if( !_url.empty() ) {
           Image *_image = 
             static_cast< H3DImageLoaderNode * >(*il)->loadImage( _url );
           if( is_tmp_file ) ResourceResolver::releaseTmpFileName( _url );
           if( _image ) {
-            texture->setURLUsed( *i );
+            url_used = *i;
             return _image;
           }
         }
@@ -134,25 +141,33 @@ Image* ImageTexture::SFImage::loadImage( ImageTexture *texture,
   }
   
   // Now try to find any image loader that can handle the format
-  for( vector<string>::const_iterator i = urls.begin(); 
-       i != urls.end(); ++i ) {
-    // First try to resolve the url to file contents and load via string buffer
-    // Otherwise fallback on using temp files
-    string url_contents= texture->resolveURLAsString ( *i );
+  for( vector<string>::const_iterator i = input.urls.begin(); 
+       i != input.urls.end(); ++i ) {
+    // Local files are loaded directly so that loaders can map them.
+    // Otherwise first try to resolve the url to file contents and load
+    // via string buffer and fall back on using temp files.
+    string url_contents;
+    if( X3DUrlObject::resolveURLAsLocalFileFromBase( input.url_base,
+                                                     *i ).empty() ) {
+      url_contents =
+        X3DUrlObject::resolveURLFromBase( input.url_base, *i, true );
+    }
     if ( url_contents != "" ) {
       istringstream iss ( url_contents );
       auto_ptr< H3DImageLoaderNode > 
         il( H3DImageLoaderNode::getSupportedFileReader( iss ) );
 
       if( il.get() ) {
-        texture->setURLUsed( *i );
+        url_used = *i;
         Image *_image = il->loadImage( iss );
         return _image;
       }
     }
 
     bool is_tmp_file;
-    string _url = texture->resolveURLAsFile( *i, &is_tmp_file );
+    string _url =
+      X3DUrlObject::resolveURLFromBase( input.url_base, *i, false,
+                                        &is_tmp_file );
     if( !_url.empty() ) {
       auto_ptr< H3DImageLoaderNode > 
         il( H3DImageLoaderNode::getSupportedFileReader( _url ) );
@@ -169,7 +184,7 @@ Image* ImageTexture::SFImage::loadImage( ImageTexture *texture,
 #endif
 
       if( il.get() ) {
-        texture->setURLUsed( *i );
+        url_used = *i;
         Image *_image = il->loadImage( _url );
         if( is_tmp_file ) ResourceResolver::releaseTmpFileName( _url );
         return _image;
@@ -179,39 +194,39 @@ Image* ImageTexture::SFImage::loadImage( ImageTexture *texture,
   }
 
   Console(LogLevel::Error) << "Warning: None of the urls in ImageTexture with url [";
-  for( vector<string>::const_iterator i = urls.begin(); 
-       i != urls.end(); ++i ) {  
+  for( vector<string>::const_iterator i = input.urls.begin(); 
+       i != input.urls.end(); ++i ) {  
     Console(LogLevel::Error) << " \"" << *i << "\"";
   }
   Console(LogLevel::Error) << "] could be loaded. Either they don't exist or the file format "
              << "is not supported by any H3DImageLoaderNode that is available "
-             << "(in " << getOwner()->getName() << ")" << endl;
+             << "(in " << input.texture_name << ")" << endl;
 
-  texture->setURLUsed( "" );
+  url_used = "";
   return( NULL );
 }
 
-Scene::CallbackCode ImageTexture::SFImage::loadImageCB( void *data ) {
-  CBData *input = static_cast< CBData * >( data );
-  input->texture->image->setValue( input->image );
-  input->texture = NULL;
-  input->image = NULL;
-  return Scene::CALLBACK_DONE;
+Image *ImageTexture::SFImage::ThreadFuncData::load( string &url_used ) {
+  return loadImage( *this, url_used );
 }
 
-void *ImageTexture::SFImage::loadImageThreadFunc( void * data ) {
-  ThreadFuncData *input = static_cast< ThreadFuncData * >( data );
-  input->load_thread_mutex.lock();
-  SFImage *sfimage = static_cast< SFImage * >( input->texture->image.get() );
-  Image *image = sfimage->loadImage( input->texture,
-                                     input->urls,
-                                     input->image_loaders );
-                                  
-  sfimage->cb_data.texture = input->texture;
-  sfimage->cb_data.image = image;
-  Scene::addCallback( loadImageCB, &sfimage->cb_data );
-  input->load_thread_mutex.unlock();
-  return NULL;
+void ImageTexture::SFImage::loadImageDone( void *data, Image *image,
+                                           const string &url_used ) {
+  SFImage *sfimage = static_cast< SFImage * >( data );
+  sfimage->load_pending = false;
+  sfimage->url_image = image;
+  ImageTexture *texture = static_cast< ImageTexture * >( sfimage->getOwner() );
+  texture->setURLUsed( url_used );
+  sfimage->setValue( image );
+}
+
+Image *ImageTexture::SFImage::reloadImage() {
+  string url_used;
+  return loadImage( thread_data, url_used );
+}
+
+void ImageTexture::SFImage::setLoadPriority( H3DFloat priority ) {
+  if( load_pending ) ImageLoadPool::setPriority( this, priority );
 }
 
 void ImageTexture::SFImage::update() {
@@ -235,20 +250,41 @@ void ImageTexture::SFImage::update() {
     load_in_thread= load_in_thread_local == "SEPARATE";
   }
 
+  // the image of an earlier load is no longer wanted.
+  ImageLoadPool::cancel( this );
+  load_pending = false;
+
+  // also used to load the image again by reloadImage().
+  thread_data.url_base = texture->getURLBase();
+  thread_data.texture_name = texture->getName();
+  thread_data.urls = urls->getValue();
+  thread_data.image_loaders = image_loaders->getValue();
+
   if( load_in_thread ) {
     value = NULL;
-    // delete the old thread
-    texture->load_thread.reset( NULL );
-    
-    thread_data.texture = texture;
-    thread_data.urls = urls->getValue();
-    thread_data.image_loaders = image_loaders->getValue();
-
-    texture->load_thread.reset( new H3DUtil::SimpleThread( &loadImageThreadFunc, 
-                                                   (void *)&thread_data ) );
-    texture->load_thread->setThreadName( "ImageTexture load thread" );
+    url_image = NULL;
+
+    // textures loading the same urls with the same image loaders share
+    // one load.
+    stringstream key;
+    key << "ImageTexture\n" << texture->getURLBase();
+    for( vector< string >::const_iterator i = thread_data.urls.begin();
+         i != thread_data.urls.end(); ++i ) {
+      key << "\n" << *i;
+    }
+    for( NodeVector::const_iterator i = thread_data.image_loaders.begin();
+         i != thread_data.image_loaders.end(); ++i ) {
+      key << "\n" << (void *)(*i);
+    }
+
+    load_pending = true;
+    ImageLoadPool::load( key.str(), new ThreadFuncData( thread_data ),
+                         &loadImageDone, this );
   } else {
-    value = loadImage( texture, urls->getValue(), image_loaders->getValue() );
+    string url_used;
+    value = loadImage( thread_data, url_used );
+    texture->setURLUsed( url_used );
+    url_image = value.get();
   }
 
   // reset the editing variables since we are doing a full load of a new
@@ -262,8 +298,31 @@ void ImageTexture::SFImage::update() {
   }
 }
 
+ReloadableImage *ImageTexture::newReloadableImage( Image *_image ) {
+  SFImage *sfimage = static_cast< SFImage * >( image.get() );
+  if( sfimage->isLoadedFromURL( _image ) ) {
+    // decoding the url again does not need the texture.
+    return new ReloadableImage( _image, &reloadImage, this, false );
+  }
+  return X3DTexture2DNode::newReloadableImage( _image );
+}
+
+Image *ImageTexture::reloadImage( Image *_image, void *data ) {
+  ImageTexture *texture = static_cast< ImageTexture * >( data );
+  return static_cast< SFImage * >( texture->image.get() )->reloadImage();
+}
+
 void ImageTexture::render() {
   if( url->size() > 0 ) {
+    SFImage *sfimage = static_cast< SFImage * >( image.get() );
+    if( sfimage->isLoadPending() ) {
+      // rendered textures are loaded before textures that are not, and
+      // closer textures before textures farther away.
+      GLfloat mv[16];
+      glGetFloatv( GL_MODELVIEW_MATRIX, mv );
+      sfimage->setLoadPriority( Vec3f( mv[12], mv[13], mv[14] ).length() );
+    }
+
     try {
 
       if ( useSharing () ) {
@@ -511,15 +570,7 @@ void ImageTexture::addSharedImage ( std::vector < std::string > _urls ) {
 }
 
 ImageTexture::SFImage::~SFImage() {
-  thread_data.load_thread_mutex.lock();
-  if( cb_data.texture ) {
-    Scene::removeCallback( &cb_data );
-    if( cb_data.image )
-      delete cb_data.image;
-    cb_data.texture = NULL;
-    cb_data.image = NULL;
-  }
-  thread_data.load_thread_mutex.unlock();
+  ImageLoadPool::cancel( this );
 }
 
 Image* ImageTexture::renderToImage( H3DInt32 _width, H3DInt32 _height, bool output_float_texture /* = false */ ){
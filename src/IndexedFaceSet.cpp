@@ -30,6 +30,7 @@
 
 #include <H3D/IndexedFaceSet.h>
 #include <H3D/Normal.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -180,7 +181,7 @@ void IndexedFaceSet::render() {
 
     // set fog to get fog depth from fog coordinates if available
     if( GLEW_EXT_fog_coord && fog_coords ) {
-      glPushAttrib( GL_FOG_BIT );
+      GLStateTracker::pushAttrib( GL_FOG_BIT );
       glFogi(GL_FOG_COORDINATE_SOURCE_EXT, GL_FOG_COORDINATE_EXT);      
     }
 
@@ -389,7 +390,7 @@ void IndexedFaceSet::render() {
 
     // restore previous fog attributes
     if( GLEW_EXT_fog_coord && fog_coords ) {
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }    
 
     // disable texture coordinate generation.
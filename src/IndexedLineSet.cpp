@@ -32,6 +32,7 @@
 #include <H3D/X3DTextureNode.h>
 #include <H3D/GlobalSettings.h>
 #include <H3D/GraphicsOptions.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -111,7 +112,7 @@ void IndexedLineSet::DisplayList::callList( bool build_list ) {
   IndexedLineSet *line_set = 
    static_cast< IndexedLineSet * >( owner );
 
-  glPushAttrib( GL_CURRENT_BIT );
+  GLStateTracker::pushAttrib( GL_CURRENT_BIT );
   // If color field is NULL, we use the emissive Color from the current material
   // as color.
   if( !line_set->color->getValue() ) {
@@ -120,7 +121,7 @@ void IndexedLineSet::DisplayList::callList( bool build_list ) {
     glColor3f( v[0], v[1], v[2] );
   }
   X3DGeometryNode::DisplayList::callList( build_list );
-  glPopAttrib();
+  GLStateTracker::popAttrib();
 }
 
 void IndexedLineSet::render() {
@@ -148,7 +149,7 @@ void IndexedLineSet::render() {
     // Save the old state of GL_LIGHTING 
     GLboolean lighting_enabled;
     glGetBooleanv( GL_LIGHTING, &lighting_enabled );
-    glDisable( GL_LIGHTING );
+    GLStateTracker::disable( GL_LIGHTING );
 
     // disable texturing
     X3DTextureNode *texture = X3DTextureNode::getActiveTexture();
@@ -156,7 +157,7 @@ void IndexedLineSet::render() {
 
     // set fog to get fog depth from fog coordinates if available
     if( GLEW_EXT_fog_coord && fog_coord_node ) {
-      glPushAttrib( GL_FOG_BIT );
+      GLStateTracker::pushAttrib( GL_FOG_BIT );
       glFogi(GL_FOG_COORDINATE_SOURCE_EXT, GL_FOG_COORDINATE_EXT);
     }
 
@@ -360,12 +361,12 @@ void IndexedLineSet::render() {
 
     // restore previous fog attributes
     if( GLEW_EXT_fog_coord && fog_coord_node ) {
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }  
 
     // reenable lighting if it was enabled before
     if( lighting_enabled )
-      glEnable( GL_LIGHTING );
+      GLStateTracker::enable( GL_LIGHTING );
 
     if( texture ) texture->enableTexturing();
   }
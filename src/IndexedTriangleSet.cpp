@@ -36,6 +36,7 @@
 #include <H3D/TextureCoordinate.h>
 #include <H3D/GlobalSettings.h>
 #include <H3D/GraphicsOptions.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -186,7 +187,7 @@ void IndexedTriangleSet::render() {
 
     // set fog to get fog depth from fog coordinates if available
     if( GLEW_EXT_fog_coord && fog_coord_node ) {
-      glPushAttrib( GL_FOG_BIT );
+      GLStateTracker::pushAttrib( GL_FOG_BIT );
       glFogi(GL_FOG_COORDINATE_SOURCE_EXT, GL_FOG_COORDINATE_EXT);  
     }
 
@@ -450,7 +451,7 @@ void IndexedTriangleSet::render() {
 
     // restore previous fog attributes
     if( GLEW_EXT_fog_coord && fog_coord_node ) {
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
 
     // disable texture coordinate generation.
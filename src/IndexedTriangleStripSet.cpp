@@ -32,6 +32,7 @@
 #include <H3D/Normal.h>
 #include <H3D/GlobalSettings.h>
 #include <H3D/GraphicsOptions.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -156,7 +157,7 @@ void IndexedTriangleStripSet::render() {
 
     // set fog to get fog depth from fog coordinates if available
     if( GLEW_EXT_fog_coord && fog_coord_node ) {
-      glPushAttrib( GL_FOG_BIT );
+      GLStateTracker::pushAttrib( GL_FOG_BIT );
       glFogi(GL_FOG_COORDINATE_SOURCE_EXT, GL_FOG_COORDINATE_EXT);
     }
 
@@ -413,7 +414,7 @@ void IndexedTriangleStripSet::render() {
 
     // restore previous fog attributes
     if( GLEW_EXT_fog_coord && fog_coord_node ) {
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }      
 
     // disable texture coordinate generation.
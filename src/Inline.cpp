@@ -32,6 +32,8 @@
 #include <H3D/X3D.h>
 #include <H3D/X3DSAX2Handlers.h>
 #include "H3D/ResourceResolver.h"
+#include <H3D/GlobalSettings.h>
+#include <H3D/X3DViewpointNode.h>
 
 using namespace H3D;
 
@@ -50,6 +52,7 @@ namespace InlineInternals {
   FIELDDB_ELEMENT( Inline, loadedScene, OUTPUT_ONLY );
   FIELDDB_ELEMENT( Inline, importMode, INITIALIZE_ONLY );
   FIELDDB_ELEMENT( Inline, traverseOn, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( Inline, loadInThread, INPUT_OUTPUT );
 }
 
 
@@ -63,7 +66,8 @@ Inline::Inline(
                Inst< SFBool      > _load,
                Inst< LoadedScene > _loadedScene,
                Inst< SFString    > _importMode,
-               Inst< SFBool      > _traverseOn ) :
+               Inst< SFBool      > _traverseOn,
+               Inst< SFString    > _loadInThread ) :
   X3DChildNode( _metadata   ),
   X3DBoundedObject( _bound, _bboxCenter, _bboxSize ),
   X3DUrlObject( _url ),
@@ -72,7 +76,9 @@ Inline::Inline(
   loadedScene ( _loadedScene ),
   importMode( _importMode ),
   traverseOn( _traverseOn ),
-  use_union_bound( false ) {
+  loadInThread( _loadInThread ),
+  use_union_bound( false ),
+  load_pending( false ) {
 
   type_name = "Inline";
   database.initFields( this );
@@ -92,6 +98,11 @@ Inline::Inline(
   importMode->addValidValue( "AUTO_EXPORT" );
   importMode->setValue( "DEFAULT", id );
   traverseOn->setValue( true );
+
+  loadInThread->addValidValue( "DEFAULT" );
+  loadInThread->addValidValue( "MAIN" );
+  loadInThread->addValidValue( "SEPARATE" );
+  loadInThread->setValue( "DEFAULT" );
 }
 
 void Inline::render() {
@@ -109,12 +120,128 @@ void Inline::traverseSG( TraverseInfo &ti ) {
       Group *g = loadedScene->getValueByIndex( i );
       if( g ) g->traverseSG( ti );
     }
+
+    if( load_pending ) {
+      // load the scenes of the Inline nodes closest to the viewer first.
+      X3DViewpointNode *vp = X3DViewpointNode::getActive();
+      if( vp ) {
+        Vec3f vp_pos = vp->accForwardMatrix->getValue() *
+          vp->totalPosition->getValue();
+        Vec3f center = ti.getAccForwardMatrix() * bboxCenter->getValue();
+        InlineLoadPool::setPriority( this, ( vp_pos - center ).length() );
+      }
+    }
+  }
+}
+
+bool Inline::loadInSeparateThread() {
+  const string &load_in_thread = loadInThread->getValue();
+  if( load_in_thread == "DEFAULT" ) {
+    GlobalSettings *gs = GlobalSettings::getActive();
+    return gs && gs->loadInlinesInThread->getValue();
   }
+  return load_in_thread == "SEPARATE";
+}
+
+void Inline::loadedInThread( const string &_url,
+                             const string &url_contents,
+                             const string &file_name,
+                             bool is_tmp_file ) {
+  if( !loadedScene->isUpToDate() ) {
+    // the load or url field has changed since the request. Updating the
+    // field replaces the request so the scene is no longer wanted.
+    if( is_tmp_file ) ResourceResolver::releaseTmpFileName( file_name );
+    loadedScene->upToDate();
+    return;
+  }
+
+  load_pending = false;
+  if( _url == "" ) {
+    printNoURLLoaded( url->getValue() );
+    setURLUsed( "" );
+    return;
+  }
+
+  Group *g = parseScene( _url, url_contents, file_name, is_tmp_file );
+  if( g ) {
+    loadedScene->push_back( g, id );
+    setURLUsed( _url );
+  }
+}
+
+Group *Inline::parseScene( const string &_url,
+                           const string &url_contents,
+                           const string &file_name,
+                           bool is_tmp_file ) {
+  const string &import_mode = importMode->getValue();
+  string old_url_base = ResourceResolver::getBaseURL();
+#ifdef HAVE_XERCES
+  try 
+#endif
+  {
+    if( is_tmp_file && _url.find( "://" ) != string::npos ) {
+      string::size_type pos = _url.find_last_of( "/\\" );
+      if( pos != string::npos )
+        ResourceResolver::setBaseURL( _url.substr( 0, pos + 1 ) );
+    }
+    Group *g;
+    if ( url_contents != "" ) {
+      // Ensure that we set the base URL even when returning file contents
+      string::size_type to = _url.find_last_of( "/\\" );
+      if ( to != string::npos ) {
+        string base = _url.substr ( 0, to+1 );
+        ResourceResolver::setBaseURL( old_url_base + base );
+      }
+      // We have resolved to file contents, load from string buffer
+      g= X3D::createX3DFromString ( url_contents, 
+                                    &DEF_nodes, 
+                                    &exported_nodes, 
+                                    NULL );
+    } else {
+      // We have resolved to local filename, load from file
+      g= X3D::createX3DFromURL( file_name, 
+                                &DEF_nodes, 
+                                &exported_nodes,
+                                NULL, 
+                                !is_tmp_file );
+    }
+
+    // if import mode is a mode where all DEF nodes are to be automatically
+    // exported, add them to the exported_nodes
+    if( import_mode == "AUTO" || import_mode == "AUTO_EXPORT" ) {
+      exported_nodes.merge( &DEF_nodes );
+    }
+
+    if( is_tmp_file ) ResourceResolver::releaseTmpFileName( file_name );
+    ResourceResolver::setBaseURL( old_url_base );
+    return g;
+  } 
+#ifdef HAVE_XERCES
+  catch( const X3D::XMLParseError &e ) {
+    ResourceResolver::setBaseURL( old_url_base );
+    Console(LogLevel::Warning) << "Warning: Error when parsing \"" << _url << "\" in \"" 
+               << getName() << "\" (" << e << ")." << endl;
+  } 
+#endif
+  return NULL;
+}
+
+void Inline::printNoURLLoaded( const vector< string > &urls ) {
+  Console(LogLevel::Error) << "Warning: None of the urls in Inline node with url [";
+  for( vector< string >::const_iterator i = urls.begin(); i != urls.end(); ++i ) {  
+    Console(LogLevel::Error) << " \"" << *i << "\"";
+  }
+  Console(LogLevel::Error) << "] could be loaded. "
+       << "(in " << getName() << ")" << endl;
 }
 
 void Inline::LoadedScene::update() {
   Inline *inline_node = static_cast< Inline * >( getOwner() );
   value.clear();
+
+  // the scene of an earlier load is no longer wanted.
+  InlineLoadPool::cancel( inline_node );
+  inline_node->load_pending = false;
   
   // should be temporary fix, when creating and deleting a Inline node without
   // doing anything with it there is a problem with calling clear() 
@@ -128,7 +255,14 @@ void Inline::LoadedScene::update() {
 
   if( static_cast< SFBool * >( routes_in[0] )->getValue() ) {
     MFString *urls = static_cast< MFString * >( routes_in[1] );
-    const string &import_mode = inline_node->importMode->getValue();
+
+    if( inline_node->loadInSeparateThread() ) {
+      // the scene is added by loadedInThread() when available.
+      inline_node->setURLUsed( "" );
+      inline_node->load_pending = true;
+      InlineLoadPool::load( inline_node, urls->getValue() );
+      return;
+    }
 
     for( MFString::const_iterator i = urls->begin(); i != urls->end(); ++i ) {
 
@@ -141,67 +275,17 @@ void Inline::LoadedScene::update() {
         _url = inline_node->resolveURLAsFile( *i, &is_tmp_file );
       }
       if( _url != "" || url_contents != "" ) {
-        string old_url_base = ResourceResolver::getBaseURL();
-#ifdef HAVE_XERCES
-        try 
-#endif
-        {
-          if( is_tmp_file && (*i).find( "://" ) != string::npos ) {
-            string::size_type pos = (*i).find_last_of( "/\\" );
-            if( pos != string::npos )
-              ResourceResolver::setBaseURL( (*i).substr( 0, pos + 1 ) );
-          }
-          Group *g;
-          if ( url_contents != "" ) {
-            // Ensure that we set the base URL even when returning file contents
-            string::size_type to = (*i).find_last_of( "/\\" );
-            if ( to != string::npos ) {
-              string base = (*i).substr ( 0, to+1 );
-              ResourceResolver::setBaseURL( old_url_base + base );
-            }
-            // We have resolved to file contents, load from string buffer
-            g= X3D::createX3DFromString ( url_contents, 
-                                          &inline_node->DEF_nodes, 
-                                          &inline_node->exported_nodes, 
-                                          NULL );
-          } else {
-            // We have resolved to local filename, load from file
-            g= X3D::createX3DFromURL( _url, 
-                                      &inline_node->DEF_nodes, 
-                                      &inline_node->exported_nodes,
-                                      NULL, 
-                                      !is_tmp_file );
-          }
-
-          // if import mode is a mode where all DEF nodes are to be automatically
-          // exported, add them to the exported_nodes
-          if( import_mode == "AUTO" || import_mode == "AUTO_EXPORT" ) {
-            inline_node->exported_nodes.merge( &inline_node->DEF_nodes );
-          }
-
-          if( is_tmp_file ) ResourceResolver::releaseTmpFileName( _url );
+        Group *g = inline_node->parseScene( *i, url_contents,
+                                            _url, is_tmp_file );
+        if( g ) {
           value.push_back( g );
           inline_node->setURLUsed( *i );
-          ResourceResolver::setBaseURL( old_url_base );
-        } 
-#ifdef HAVE_XERCES
-        catch( const X3D::XMLParseError &e ) {
-          ResourceResolver::setBaseURL( old_url_base );
-          Console(LogLevel::Warning) << "Warning: Error when parsing \"" << *i << "\" in \"" 
-                     << getOwner()->getName() << "\" (" << e << ")." << endl;
-        } 
-#endif
-       
+        }
         return;
       }
     }
 
-    Console(LogLevel::Error) << "Warning: None of the urls in Inline node with url [";
-    for( MFString::const_iterator i = urls->begin(); i != urls->end(); ++i ) {  
-      Console(LogLevel::Error) << " \"" << *i << "\"";
-    }
-    Console(LogLevel::Error) << "] could be loaded. "
-         << "(in " << getOwner()->getName() << ")" << endl;
+    inline_node->printNoURLLoaded( urls->getValue() );
     inline_node->setURLUsed( "" );
   }
 }
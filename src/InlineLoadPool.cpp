@@ -0,0 +1,225 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file InlineLoadPool.cpp
+/// \brief CPP file for InlineLoadPool.
+///
+//
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <H3D/InlineLoadPool.h>
+#include <H3D/Inline.h>
+#include <H3D/GlobalSettings.h>
+#include <H3D/ResourceResolver.h>
+
+#include <algorithm>
+
+using namespace H3D;
+
+const H3DFloat InlineLoadPool::default_priority = 1e30f;
+H3DUtil::ConditionLock InlineLoadPool::lock;
+vector< InlineLoadPool::Job * > InlineLoadPool::jobs;
+unsigned int InlineLoadPool::nr_loading = 0;
+unsigned int InlineLoadPool::max_loading = 4;
+vector< H3DUtil::SimpleThread * > InlineLoadPool::threads;
+unsigned int InlineLoadPool::nr_running = 0;
+bool InlineLoadPool::stopping = false;
+
+namespace InlineLoadPoolInternals {
+  // Stops the threads before the members of InlineLoadPool, which are
+  // defined above, are destroyed.
+  struct StopThreads {
+    ~StopThreads() {
+      InlineLoadPool::stopThreads();
+    }
+  };
+  StopThreads stop_threads;
+}
+
+void InlineLoadPool::load( Inline *inline_node,
+                           const vector< string > &urls,
+                           H3DFloat priority ) {
+  GlobalSettings *gs = GlobalSettings::getActive();
+  H3DInt32 max_threads = gs ? gs->maxInlineLoadThreads->getValue() : 4;
+
+  lock.lock();
+  max_loading = (unsigned int)H3DMax( max_threads, 1 );
+  cancelJobs( inline_node );
+
+  Job *job = new Job;
+  job->inline_node = inline_node;
+  job->urls = urls;
+  job->url_base = inline_node->getURLBase();
+  job->priority = priority;
+  jobs.push_back( job );
+  // a thread may be waiting for max_loading to increase.
+  lock.broadcast();
+  lock.unlock();
+
+  startThreads();
+}
+
+void InlineLoadPool::cancel( Inline *inline_node ) {
+  lock.lock();
+  cancelJobs( inline_node );
+  lock.unlock();
+}
+
+void InlineLoadPool::setPriority( Inline *inline_node, H3DFloat priority ) {
+  lock.lock();
+  for( unsigned int i = 0; i < jobs.size(); ++i ) {
+    if( jobs[i]->inline_node == inline_node && jobs[i]->state == QUEUED ) {
+      jobs[i]->priority = priority;
+    }
+  }
+  lock.unlock();
+}
+
+void InlineLoadPool::startThreads() {
+  lock.lock();
+  while( threads.size() < max_loading && !stopping ) {
+    ++nr_running;
+    H3DUtil::SimpleThread *thread =
+      new H3DUtil::SimpleThread( &loadThreadFunc, NULL );
+    thread->setThreadName( "Inline load thread" );
+    threads.push_back( thread );
+  }
+  lock.unlock();
+}
+
+void InlineLoadPool::stopThreads() {
+  lock.lock();
+  stopping = true;
+  lock.broadcast();
+  while( nr_running > 0 ) lock.wait();
+  lock.unlock();
+
+  // the threads have returned from loadThreadFunc, deleting them waits
+  // for them to end.
+  for( unsigned int i = 0; i < threads.size(); ++i ) delete threads[i];
+  threads.clear();
+}
+
+void InlineLoadPool::cancelJobs( Inline *inline_node ) {
+  vector< Job * >::iterator i = jobs.begin();
+  while( i != jobs.end() ) {
+    Job *job = *i;
+    if( job->inline_node == inline_node && !job->cancelled ) {
+      if( job->state == QUEUED ) {
+        i = jobs.erase( i );
+        delete job;
+        continue;
+      }
+      // loading and loaded jobs are deleted by the pool.
+      job->cancelled = true;
+    }
+    ++i;
+  }
+}
+
+void *InlineLoadPool::loadThreadFunc( void *data ) {
+  lock.lock();
+  while( !stopping ) {
+    // find the queued job with the lowest priority value.
+    Job *job = NULL;
+    if( nr_loading < max_loading ) {
+      for( unsigned int i = 0; i < jobs.size(); ++i ) {
+        if( jobs[i]->state == QUEUED &&
+            ( !job || jobs[i]->priority < job->priority ) ) {
+          job = jobs[i];
+        }
+      }
+    }
+
+    if( !job ) {
+      lock.wait();
+      continue;
+    }
+
+    job->state = LOADING;
+    ++nr_loading;
+    lock.unlock();
+
+    resolveURLs( job );
+
+    lock.lock();
+    job->state = LOADED;
+    --nr_loading;
+    // wake up threads waiting for nr_loading to decrease.
+    lock.broadcast();
+    if( stopping ) {
+      // the scene may already be destroyed, so the job is left as is.
+      break;
+    }
+    lock.unlock();
+
+    // the callback is added without holding the lock since loadedCB
+    // locks it while the scene callbacks are locked.
+    Scene::addCallback( loadedCB, job );
+    lock.lock();
+  }
+  --nr_running;
+  lock.broadcast();
+  lock.unlock();
+  return NULL;
+}
+
+void InlineLoadPool::resolveURLs( Job *job ) {
+  for( vector< string >::const_iterator i = job->urls.begin();
+       i != job->urls.end(); ++i ) {
+    // First try to resolve URL to file contents, if that is not supported
+    // by the resolvers then fallback to resolve as local filename
+    job->url_contents =
+      X3DUrlObject::resolveURLFromBase( job->url_base, *i, true );
+    if( job->url_contents == "" ) {
+      job->file_name =
+        X3DUrlObject::resolveURLFromBase( job->url_base, *i, false,
+                                          &job->is_tmp_file );
+    }
+    if( job->url_contents != "" || job->file_name != "" ) {
+      job->url_used = *i;
+      return;
+    }
+  }
+}
+
+Scene::CallbackCode InlineLoadPool::loadedCB( void *data ) {
+  Job *job = static_cast< Job * >( data );
+  lock.lock();
+  vector< Job * >::iterator i = std::find( jobs.begin(), jobs.end(), job );
+  if( i != jobs.end() ) jobs.erase( i );
+  bool cancelled = job->cancelled;
+  lock.unlock();
+
+  if( cancelled ) {
+    if( job->is_tmp_file ) {
+      ResourceResolver::releaseTmpFileName( job->file_name );
+    }
+  } else {
+    job->inline_node->loadedInThread( job->url_used, job->url_contents,
+                                      job->file_name, job->is_tmp_file );
+  }
+  delete job;
+  return Scene::CALLBACK_DONE;
+}
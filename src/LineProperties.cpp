@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/LineProperties.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -81,7 +82,7 @@ void LineProperties::render() {
    
     if( line_type != 1 ) { 
       // not solid
-      glEnable( GL_LINE_STIPPLE );
+      GLStateTracker::enable( GL_LINE_STIPPLE );
       if( line_type == 2 )
         // dashed
         glLineStipple( (GLint)width, 0x7777 );
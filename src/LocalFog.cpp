@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/LocalFog.h>
+#include <H3D/GLStateTracker.h>
 #include <GL/glew.h>
 
 using namespace H3D;
@@ -62,7 +63,7 @@ LocalFog::LocalFog( Inst< SFNode    > _metadata,
 }
 
 void LocalFog::enableGraphicsState() {
-  glPushAttrib( GL_FOG_BIT );
+  GLStateTracker::pushAttrib( GL_FOG_BIT );
   if( !enabled->getValue() )
     return;
   H3DFloat visibility_range = visibilityRange->getValue();
@@ -88,10 +89,10 @@ void LocalFog::enableGraphicsState() {
     glFogfv( GL_FOG_COLOR, gl_localFog_color );
     glFogf( GL_FOG_START, 0.0f );
     glFogf( GL_FOG_END, visibilityRange->getValue() );
-    glEnable( GL_FOG );
+    GLStateTracker::enable( GL_FOG );
   }
 }
 
 void LocalFog::disableGraphicsState() {
-  glPopAttrib();
+  GLStateTracker::popAttrib();
 }
@@ -0,0 +1,214 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file MappedBuffer.cpp
+/// \brief CPP file for MappedBuffer.
+///
+//
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <H3D/MappedBuffer.h>
+#include <H3D/ResourceResolver.h>
+#include <H3DUtil/Threads.h>
+
+#include <map>
+
+#ifdef H3D_WINDOWS
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace H3D;
+using namespace H3DUtil;
+
+namespace MappedBufferInternals {
+  // The mappings shared in a thread between MappedBuffer::beginSharing()
+  // and MappedBuffer::endSharing().
+  struct SharedBuffers {
+    SharedBuffers() : depth( 0 ) {}
+    unsigned int depth;
+    std::map< string, AutoRef< MappedBuffer > > buffers;
+  };
+
+  typedef std::map< ThreadBase::ThreadId, SharedBuffers > ThreadSharedBuffers;
+  ThreadSharedBuffers &threadSharedBuffers() {
+    static ThreadSharedBuffers shared_buffers;
+    return shared_buffers;
+  }
+
+  MutexLock &threadSharedBuffersLock() {
+    static MutexLock lock;
+    return lock;
+  }
+
+  // Returns the shared mappings of the calling thread, or NULL if it is
+  // not sharing. Only the calling thread uses its element and map elements
+  // are never moved, so it can be used without the lock.
+  SharedBuffers *getSharedBuffers() {
+    SharedBuffers *shared = NULL;
+    threadSharedBuffersLock().lock();
+    ThreadSharedBuffers::iterator i =
+      threadSharedBuffers().find( ThreadBase::getCurrentThreadId() );
+    if( i != threadSharedBuffers().end() ) shared = &(*i).second;
+    threadSharedBuffersLock().unlock();
+    return shared;
+  }
+}
+
+MappedBuffer::MappedBuffer( const string &_filename ) :
+  filename( _filename ),
+  data( NULL ),
+  size( 0 ) {
+}
+
+MappedBuffer::~MappedBuffer() {
+  if( data && size > 0 ) {
+#ifdef H3D_WINDOWS
+    UnmapViewOfFile( data );
+#else
+    munmap( (void *)data, size );
+#endif
+  }
+}
+
+void MappedBuffer::beginSharing() {
+  using namespace MappedBufferInternals;
+  threadSharedBuffersLock().lock();
+  ++threadSharedBuffers()[ ThreadBase::getCurrentThreadId() ].depth;
+  threadSharedBuffersLock().unlock();
+}
+
+void MappedBuffer::endSharing() {
+  using namespace MappedBufferInternals;
+  // the mappings are released after the lock since unmapping can take
+  // time.
+  std::map< string, AutoRef< MappedBuffer > > released;
+  threadSharedBuffersLock().lock();
+  ThreadSharedBuffers::iterator i =
+    threadSharedBuffers().find( ThreadBase::getCurrentThreadId() );
+  if( i != threadSharedBuffers().end() && --(*i).second.depth == 0 ) {
+    released.swap( (*i).second.buffers );
+    threadSharedBuffers().erase( i );
+  }
+  threadSharedBuffersLock().unlock();
+}
+
+AutoRef< MappedBuffer > MappedBuffer::getBuffer( const string &filename ) {
+  using namespace MappedBufferInternals;
+  SharedBuffers *shared = getSharedBuffers();
+  if( shared ) {
+    std::map< string, AutoRef< MappedBuffer > >::iterator i =
+      shared->buffers.find( filename );
+    if( i != shared->buffers.end() ) return (*i).second;
+  }
+
+  AutoRef< MappedBuffer > buffer;
+  MappedBuffer *new_buffer = new MappedBuffer( filename );
+  if( new_buffer->mapFile() ) {
+    buffer.reset( new_buffer );
+    if( shared ) shared->buffers[ filename ] = buffer;
+  } else {
+    delete new_buffer;
+  }
+  return buffer;
+}
+
+AutoRef< MappedBuffer > MappedBuffer::getBufferFromURL( const string &url ) {
+  string filename = ResourceResolver::resolveURLAsLocalFile( url );
+  if( filename != "" ) return getBuffer( filename );
+
+  // urls that are not local files are downloaded first. The downloaded
+  // file is not shared since it is removed after being mapped.
+  AutoRef< MappedBuffer > buffer;
+  bool is_tmp_file = false;
+  filename = ResourceResolver::resolveURLAsFile( url, &is_tmp_file );
+  if( filename == "" ) return buffer;
+  if( !is_tmp_file ) return getBuffer( filename );
+
+  MappedBuffer *new_buffer = new MappedBuffer( filename );
+  if( new_buffer->mapFile() ) {
+    buffer.reset( new_buffer );
+  } else {
+    delete new_buffer;
+  }
+  ResourceResolver::releaseTmpFileName( filename );
+  return buffer;
+}
+
+bool MappedBuffer::mapFile() {
+#ifdef H3D_WINDOWS
+  HANDLE file = CreateFileA( filename.c_str(), GENERIC_READ,
+                             FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, NULL );
+  if( file == INVALID_HANDLE_VALUE ) return false;
+
+  LARGE_INTEGER file_size;
+  if( !GetFileSizeEx( file, &file_size ) ||
+      (unsigned __int64)file_size.QuadPart > (size_t)-1 ) {
+    CloseHandle( file );
+    return false;
+  }
+  size = (size_t)file_size.QuadPart;
+  if( size == 0 ) {
+    CloseHandle( file );
+    return true;
+  }
+
+  HANDLE file_mapping = CreateFileMappingA( file, NULL, PAGE_READONLY,
+                                            0, 0, NULL );
+  if( file_mapping ) {
+    data = (const unsigned char *)
+      MapViewOfFile( file_mapping, FILE_MAP_READ, 0, 0, size );
+    // the view keeps the file open.
+    CloseHandle( file_mapping );
+  }
+  CloseHandle( file );
+#else
+  int fd = open( filename.c_str(), O_RDONLY );
+  if( fd == -1 ) return false;
+
+  struct stat file_info;
+  if( fstat( fd, &file_info ) != 0 ||
+      (unsigned long long)file_info.st_size > (size_t)-1 ) {
+    close( fd );
+    return false;
+  }
+  size = (size_t)file_info.st_size;
+  if( size == 0 ) {
+    close( fd );
+    return true;
+  }
+
+  // a shared read-only mapping uses the pages of the file cache directly.
+  void *mapping = mmap( NULL, size, PROT_READ, MAP_SHARED, fd, 0 );
+  // the mapping keeps the file open.
+  close( fd );
+  if( mapping != MAP_FAILED ) data = (const unsigned char *)mapping;
+#endif
+  return data != NULL;
+}
@@ -0,0 +1,167 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file MappedImage.cpp
+/// \brief CPP file for MappedImage.
+///
+//
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <H3D/MappedImage.h>
+
+#ifdef H3D_WINDOWS
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace H3D;
+
+MappedImage::MappedImage( unsigned int width,
+                          unsigned int height,
+                          unsigned int depth,
+                          unsigned int _bits_per_pixel,
+                          Image::PixelType _pixel_type,
+                          Image::PixelComponentType component_type,
+                          const Vec3f &_pixel_size ) :
+  image_width( width ),
+  image_height( height ),
+  image_depth( depth ),
+  bits_per_pixel( _bits_per_pixel ),
+  pixel_size( _pixel_size ),
+  pixel_type( _pixel_type ),
+  pixel_component_type( component_type ),
+  mapping( NULL ),
+  mapping_size( 0 ),
+  data( NULL ) {
+}
+
+MappedImage::~MappedImage() {
+  if( mapping ) {
+#ifdef H3D_WINDOWS
+    UnmapViewOfFile( mapping );
+#else
+    munmap( mapping, mapping_size );
+#endif
+  }
+}
+
+size_t MappedImage::dataSize() {
+  return (size_t)image_width * image_height * image_depth *
+    bits_per_pixel / 8;
+}
+
+MappedImage *MappedImage::mapFile( const string &filename,
+                                   size_t offset,
+                                   unsigned int width,
+                                   unsigned int height,
+                                   unsigned int depth,
+                                   unsigned int bits_per_pixel,
+                                   Image::PixelType pixel_type,
+                                   Image::PixelComponentType component_type,
+                                   const Vec3f &pixel_size ) {
+  if( width == 0 || height == 0 || depth == 0 || 
+      bits_per_pixel % 8 != 0 ) return NULL;
+
+  MappedImage *image = new MappedImage( width, height, depth,
+                                        bits_per_pixel, pixel_type,
+                                        component_type, pixel_size );
+  size_t data_size = image->dataSize();
+
+#ifdef H3D_WINDOWS
+  HANDLE file = CreateFileA( filename.c_str(), GENERIC_READ, 
+                             FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, NULL );
+  if( file == INVALID_HANDLE_VALUE ) {
+    delete image;
+    return NULL;
+  }
+
+  LARGE_INTEGER file_size;
+  if( !GetFileSizeEx( file, &file_size ) ||
+      (unsigned __int64)file_size.QuadPart < 
+      (unsigned __int64)offset + data_size ) {
+    CloseHandle( file );
+    delete image;
+    return NULL;
+  }
+
+  // the view can only start at a multiple of the allocation granularity.
+  SYSTEM_INFO info;
+  GetSystemInfo( &info );
+  size_t map_offset = offset - offset % info.dwAllocationGranularity;
+  image->mapping_size = offset - map_offset + data_size;
+
+  // a copy-on-write view, the file itself is never changed.
+  HANDLE file_mapping = CreateFileMappingA( file, NULL, PAGE_WRITECOPY,
+                                            0, 0, NULL );
+  if( file_mapping ) {
+    image->mapping = 
+      MapViewOfFile( file_mapping, FILE_MAP_COPY,
+                     (DWORD)( (unsigned __int64)map_offset >> 32 ),
+                     (DWORD)( map_offset & 0xffffffff ),
+                     image->mapping_size );
+    // the view keeps the file open.
+    CloseHandle( file_mapping );
+  }
+  CloseHandle( file );
+#else
+  int fd = open( filename.c_str(), O_RDONLY );
+  if( fd == -1 ) {
+    delete image;
+    return NULL;
+  }
+
+  struct stat file_info;
+  if( fstat( fd, &file_info ) != 0 ||
+      (unsigned long long)file_info.st_size < 
+      (unsigned long long)offset + data_size ) {
+    close( fd );
+    delete image;
+    return NULL;
+  }
+
+  // the mapping can only start at a multiple of the page size.
+  size_t page_size = (size_t)sysconf( _SC_PAGESIZE );
+  size_t map_offset = offset - offset % page_size;
+  image->mapping_size = offset - map_offset + data_size;
+
+  // a private mapping is copy-on-write, the file itself is never changed.
+  void *mapping = mmap( NULL, image->mapping_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE, fd, (off_t)map_offset );
+  // the mapping keeps the file open.
+  close( fd );
+  if( mapping != MAP_FAILED ) image->mapping = mapping;
+#endif
+
+  if( !image->mapping ) {
+    delete image;
+    return NULL;
+  }
+  image->data = (unsigned char *)image->mapping + ( offset - map_offset );
+  return image;
+}
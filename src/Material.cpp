@@ -31,6 +31,7 @@
 #include <H3D/Material.h>
 #include <H3D/X3DTexture2DNode.h>
 #include <H3D/X3DTexture3DNode.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -94,7 +95,7 @@ void Material::render()  {
   H3DFloat t = transparency->getValue();
   material[3] = 1 - t;
   if( t > 0 ) {
-    glEnable( GL_BLEND );
+    GLStateTracker::enable( GL_BLEND );
     glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   }
     
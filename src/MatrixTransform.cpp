@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/MatrixTransform.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -97,7 +98,7 @@ void MatrixTransform::multiplyGLMatrix() {
 void MatrixTransform::render() { 
   GLboolean norm= glIsEnabled( GL_NORMALIZE );
   if ( !norm ) 
-    glEnable( GL_NORMALIZE );
+    GLStateTracker::enable( GL_NORMALIZE );
   
   GLint front_face;
 
@@ -132,7 +133,7 @@ void MatrixTransform::render() {
   if( negative_scaling )
     glFrontFace( front_face );
   if ( !norm ) 
-    glDisable( GL_NORMALIZE );
+    GLStateTracker::disable( GL_NORMALIZE );
 
   glMatrixMode( GL_MODELVIEW );
   glPopMatrix();
@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/MultiTexture.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -106,7 +107,7 @@ void MultiTexture::render() {
                  << nr_textures_supported << " texture units.\n";
       break;
     }
-    glActiveTexture( GL_TEXTURE0_ARB + i );
+    GLStateTracker::activeTexture( GL_TEXTURE0_ARB + i );
     string rgb_blend_mode = "MODULATE";
     string alpha_blend_mode = "MODULATE";
     string arg2 = "";
@@ -322,7 +323,7 @@ void MultiTexture::render() {
   // texture unit in order to perform that function.
   if( function->size() >= texture->size() && texture->size() > 0 ) {
     const string &func = function->getValueByIndex( texture->size() - 1 );
-    glActiveTexture( GL_TEXTURE0_ARB + texture->size() );
+    GLStateTracker::activeTexture( GL_TEXTURE0_ARB + texture->size() );
     glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE_ARB );
     if( func == "COMPLEMENT" ) {
       // render any texture, will not be used but is required.
@@ -349,7 +350,7 @@ void MultiTexture::render() {
     }
   }
 
-  glActiveTexture( saved_texture );
+  GLStateTracker::activeTexture( saved_texture );
   setActiveTexture( this );
 }
 
@@ -363,12 +364,12 @@ void MultiTexture::enableTexturing() {
     if( dynamic_cast< MultiTexture * >( *i ) ){
       //TODO::::
     } else {
-      glActiveTexture( GL_TEXTURE0_ARB + used_texture_units );
+      GLStateTracker::activeTexture( GL_TEXTURE0_ARB + used_texture_units );
       ++used_texture_units;
       static_cast< X3DTextureNode * >(*i)->enableTexturing();
     }
   }
-  glActiveTexture( saved_texture );
+  GLStateTracker::activeTexture( saved_texture );
 }
 
 
@@ -382,10 +383,10 @@ void MultiTexture::disableTexturing() {
     if( dynamic_cast< MultiTexture * >( *i ) ) {
       //TODO:::
     } else {
-      glActiveTexture( GL_TEXTURE0_ARB + used_texture_units );
+      GLStateTracker::activeTexture( GL_TEXTURE0_ARB + used_texture_units );
       ++used_texture_units;
       static_cast< X3DTextureNode * >(*i)->disableTexturing();
     }
   }
-  glActiveTexture( saved_texture );
+  GLStateTracker::activeTexture( saved_texture );
 }
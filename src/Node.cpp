@@ -216,6 +216,14 @@ Field *Node::getField( const string &_name ) const {
     return NULL;  // Should probably throw an error in this case
 }
 
+Field *Node::getField( unsigned int field_id ) const {
+  H3DNodeDatabase *db = H3DNodeDatabase::lookupNodeInstance( this );
+  if ( db )
+    return db->getField( this, field_id );
+  else
+    return NULL;
+}
+
 /// Add a callback function to be run on destruction of node.
 /// Returns 0 on success.
 int Node::addDestructCallback( void (*func)( Node *, void * ), void *args ) {
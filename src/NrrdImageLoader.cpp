@@ -31,8 +31,11 @@
 #include <H3D/NrrdImageLoader.h>
 #include <H3D/OpenEXRImageLoader.h>
 #include <H3D/DDSImageLoader.h>
+#include <H3D/MappedImage.h>
 
 #include <algorithm>
+#include <fstream>
+#include <sstream>
 
 #ifdef HAVE_TEEM
 #include <H3DUtil/PixelImage.h>
@@ -54,6 +57,196 @@ NrrdImageLoader::reader_registration(
                             &NrrdImageLoader::supportsFileType 
                             );
 
+namespace NrrdImageLoaderInternals {
+  // Get the size in bytes and component type of a nrrd type. Returns
+  // false if not supported.
+  bool componentType( const string &type, unsigned int &nr_bytes,
+                      Image::PixelComponentType &component_type ) {
+    component_type = Image::UNSIGNED;
+    if( type == "uchar" || type == "unsigned char" ||
+        type == "uint8" || type == "uint8_t" ) {
+      nr_bytes = 1;
+    } else if( type == "signed char" || type == "int8" ||
+               type == "int8_t" ) {
+      nr_bytes = 1;
+      component_type = Image::SIGNED;
+    } else if( type == "ushort" || type == "unsigned short" ||
+               type == "unsigned short int" || type == "uint16" ||
+               type == "uint16_t" ) {
+      nr_bytes = 2;
+    } else if( type == "short" || type == "short int" ||
+               type == "signed short" || type == "signed short int" ||
+               type == "int16" || type == "int16_t" ) {
+      nr_bytes = 2;
+      component_type = Image::SIGNED;
+    } else if( type == "uint" || type == "unsigned int" ||
+               type == "uint32" || type == "uint32_t" ) {
+      nr_bytes = 4;
+    } else if( type == "int" || type == "signed int" ||
+               type == "int32" || type == "int32_t" ) {
+      nr_bytes = 4;
+      component_type = Image::SIGNED;
+    } else if( type == "float" ) {
+      nr_bytes = 4;
+      component_type = Image::RATIONAL;
+    } else if( type == "double" ) {
+      nr_bytes = 8;
+      component_type = Image::RATIONAL;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  // Map the data of a nrrd file with raw encoding in the byte order of
+  // this machine and a single data file. Returns NULL if the file can not
+  // be mapped, in which case it is loaded with teem instead.
+  Image *mapNrrdFile( const string &url ) {
+    ifstream is( url.c_str(), ios::in | ios::binary );
+    string line;
+    if( !getline( is, line ) || line.compare( 0, 4, "NRRD" ) != 0 ) {
+      return NULL;
+    }
+
+    string type, encoding, endian, data_file;
+    int dimension = 0;
+    vector< unsigned int > sizes;
+    vector< H3DFloat > spacings;
+    long byte_skip = 0;
+    unsigned int line_skip = 0;
+    bool header_done = false;
+    while( getline( is, line ) ) {
+      if( !line.empty() && line[ line.size() - 1 ] == '\r' ) {
+        line.erase( line.size() - 1 );
+      }
+      if( line.empty() ) {
+        header_done = true;
+        break;
+      }
+      if( line[0] == '#' ) continue;
+      // key/value pairs use ":=" and are ignored.
+      string::size_type colon = line.find( ": " );
+      if( colon == string::npos ) continue;
+      string key = line.substr( 0, colon );
+      string value = line.substr( colon + 2 );
+      istringstream values( value );
+      if( key == "type" ) {
+        type = value;
+      } else if( key == "dimension" ) {
+        values >> dimension;
+      } else if( key == "sizes" ) {
+        unsigned int s;
+        while( values >> s ) sizes.push_back( s );
+      } else if( key == "spacings" ) {
+        string s;
+        while( values >> s ) {
+          H3DFloat spacing = (H3DFloat)atof( s.c_str() );
+          spacings.push_back( spacing == spacing ? spacing : 0 );
+        }
+      } else if( key == "encoding" ) {
+        encoding = value;
+      } else if( key == "endian" ) {
+        endian = value;
+      } else if( key == "byte skip" || key == "byteskip" ) {
+        values >> byte_skip;
+      } else if( key == "line skip" || key == "lineskip" ) {
+        values >> line_skip;
+      } else if( key == "data file" || key == "datafile" ) {
+        data_file = value;
+      }
+    }
+
+    unsigned int nr_bytes;
+    Image::PixelComponentType component_type;
+    if( !header_done || encoding != "raw" ||
+        !componentType( type, nr_bytes, component_type ) ||
+        (int)sizes.size() != dimension ) {
+      return NULL;
+    }
+
+    if( nr_bytes > 1 ) {
+      unsigned short test = 1;
+      bool little_endian = *(unsigned char *)&test == 1;
+      if( endian != ( little_endian ? "little" : "big" ) ) return NULL;
+    }
+
+    // the axes that are used, a first axis of up to four values is the
+    // pixel components.
+    Image::PixelType pixel_type = Image::LUMINANCE;
+    unsigned int nr_components = 1;
+    unsigned int first_axis = 0;
+    if( dimension == 4 && sizes[0] <= 4 ) {
+      Image::PixelType types[] = { Image::LUMINANCE, Image::LUMINANCE_ALPHA,
+                                   Image::RGB, Image::RGBA };
+      nr_components = sizes[0];
+      pixel_type = types[ nr_components - 1 ];
+      first_axis = 1;
+    } else if( ( dimension == 2 || dimension == 3 ) && sizes[0] <= 4 ) {
+      // the first axis could also be pixel components, leave it to teem.
+      return NULL;
+    } else if( dimension != 2 && dimension != 3 ) {
+      return NULL;
+    }
+
+    unsigned int dims[3] = { 1, 1, 1 };
+    Vec3f pixel_size( 0, 0, 0 );
+    for( unsigned int i = 0; i + first_axis < sizes.size(); ++i ) {
+      dims[i] = sizes[ i + first_axis ];
+      if( i + first_axis < spacings.size() ) {
+        pixel_size[i] = spacings[ i + first_axis ];
+      }
+    }
+
+    // the data follows the header unless it is in a detached file.
+    string data_url = url;
+    ifstream data_is;
+    istream *data = &is;
+    if( data_file != "" ) {
+      if( data_file.find_first_of( " \t" ) != string::npos ||
+          data_file == "LIST" ) {
+        // several data files.
+        return NULL;
+      }
+      if( data_file[0] != '/' && data_file[0] != '\\' &&
+          ( data_file.size() < 2 || data_file[1] != ':' ) ) {
+        // relative to the header.
+        string::size_type slash = url.find_last_of( "/\\" );
+        if( slash != string::npos ) {
+          data_file = url.substr( 0, slash + 1 ) + data_file;
+        }
+      }
+      data_url = data_file;
+      data_is.open( data_url.c_str(), ios::in | ios::binary );
+      if( !data_is.is_open() ) return NULL;
+      data = &data_is;
+    }
+
+    for( unsigned int i = 0; i < line_skip; ++i ) getline( *data, line );
+    if( !*data ) return NULL;
+    streamoff offset = data->tellg();
+
+    size_t data_size = (size_t)dims[0] * dims[1] * dims[2] *
+                       nr_components * nr_bytes;
+    if( byte_skip == -1 ) {
+      // the data is at the end of the file.
+      data->seekg( 0, ios::end );
+      streamoff file_size = data->tellg();
+      if( file_size < (streamoff)data_size ) return NULL;
+      offset = file_size - (streamoff)data_size;
+    } else if( byte_skip < 0 ) {
+      return NULL;
+    } else {
+      offset += byte_skip;
+    }
+
+    return MappedImage::mapFile( data_url, (size_t)offset,
+                                 dims[0], dims[1], dims[2],
+                                 nr_components * nr_bytes * 8,
+                                 pixel_type, component_type,
+                                 pixel_size );
+  }
+}
+
 bool NrrdImageLoader::supportsFileType( const string &url ) {
   
 #ifdef HAVE_OPENEXR
@@ -100,6 +293,8 @@ bool NrrdImageLoader::supportsFileType( const string &url ) {
 }
 
 Image *NrrdImageLoader::loadImage( const string &url ) {
+  Image *image = NrrdImageLoaderInternals::mapNrrdFile( url );
+  if( image ) return image;
   return H3DUtil::loadNrrdFile( url ); 
 }
 
@@ -31,6 +31,7 @@
 #include <H3D/ParticleSystem.h>
 
 #include <H3D/X3DViewpointNode.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -132,7 +133,7 @@ void ParticleSystem::render() {
   X3DGeometryNode *g = geometry->getValue();
 
   if ( a ) {
-    glPushAttrib( a->getAffectedGLAttribs() );
+    GLStateTracker::pushAttrib( a->getAffectedGLAttribs() );
     a->preRender();
     a->displayList->callList();
   } 
@@ -159,7 +160,7 @@ void ParticleSystem::render() {
           (*p).render( this );
         }
       } else if( geometry_render_mode == TRANSPARENT_FRONT ) {
-        glPushAttrib( GL_POLYGON_BIT );
+        GLStateTracker::pushAttrib( GL_POLYGON_BIT );
         if( geometryType->getValue() == "GEOMETRY" && g ) {
           // we have a geometry so we use the geometry functions for culling
           GLenum previous_cull_face = g->getCullFace();
@@ -177,15 +178,15 @@ void ParticleSystem::render() {
         } else {
           // not geometry so use OpenGL directly to do face culling
           glCullFace( GL_BACK );
-          glEnable( GL_CULL_FACE );
+          GLStateTracker::enable( GL_CULL_FACE );
           for( Particles::iterator p = particles.begin(); 
             p != particles.end(); ++p ) {
               (*p).render( this );
           }
         }
-        glPopAttrib();
+        GLStateTracker::popAttrib();
       } else if( geometry_render_mode == TRANSPARENT_BACK ) {
-        glPushAttrib( GL_POLYGON_BIT );
+        GLStateTracker::pushAttrib( GL_POLYGON_BIT );
         if( geometryType->getValue() == "GEOMETRY" && g ) {
           // we have a geometry so we use the geometry functions for culling
           GLenum previous_cull_face = g->getCullFace();
@@ -203,19 +204,19 @@ void ParticleSystem::render() {
         } else {
           // not geometry so use OpenGL directly to do face culling
           glCullFace( GL_FRONT );
-          glEnable( GL_CULL_FACE );
+          GLStateTracker::enable( GL_CULL_FACE );
           for( Particles::iterator p = particles.begin(); 
             p != particles.end(); ++p ) {
               (*p).render( this );
           }
         }
-        glPopAttrib();
+        GLStateTracker::popAttrib();
       } 
     }
   }
   if( a ) {
     a->postRender();
-    glPopAttrib();
+    GLStateTracker::popAttrib();
   }
 }
 
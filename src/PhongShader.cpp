@@ -1241,8 +1241,17 @@ string PhongShader::getLightContribution( X3DLightNode *light,
 
 string PhongShader::uniqueLightFieldName( const string &field_name,
                                           X3DLightNode *light) {
+  // the index of the light is used instead of its address so that the
+  // same lights give the same shader source in every run, which the
+  // program binary cache depends on. The headlight is not in
+  // current_light_nodes and gets the index after the last light.
+  unsigned int index = 0;
+  while( index < current_light_nodes.size() &&
+         current_light_nodes[index].getLight() != light ) {
+    ++index;
+  }
   stringstream name_ss;
-  name_ss << field_name << (unsigned long)light;
+  name_ss << field_name << "_light" << index << "_";
   return uniqueShaderName( name_ss.str() );
 }
 
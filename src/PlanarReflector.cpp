@@ -34,6 +34,7 @@
 #include <H3D/X3DBackgroundNode.h>
 #include <H3D/ClipPlane.h>
 #include <H3D/X3DShapeNode.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -114,10 +115,10 @@ void PlanarReflector::renderPostViewpoint ( X3DChildNode *n,
   // geometry
   glStencilOp( GL_REPLACE, GL_REPLACE, GL_REPLACE );
   glStencilFunc( GL_ALWAYS, 1, 1 );
-  glEnable( GL_STENCIL_TEST );
+  GLStateTracker::enable( GL_STENCIL_TEST );
   // don't write to frame buffer or depth buffer
   glColorMask( 0, 0, 0, 0 );
-  glDisable( GL_DEPTH_TEST );
+  GLStateTracker::disable( GL_DEPTH_TEST );
   
   // draw mirror geometry
   X3DGeometryNode *g = geometry->getValue();
@@ -125,7 +126,7 @@ void PlanarReflector::renderPostViewpoint ( X3DChildNode *n,
   
   // reset to frite to frame and depth buffer again
   glColorMask( 1, 1, 1, 1 );
-  glEnable( GL_DEPTH_TEST );
+  GLStateTracker::enable( GL_DEPTH_TEST );
 
   glPopMatrix();
 
@@ -206,7 +207,7 @@ void PlanarReflector::renderPostViewpoint ( X3DChildNode *n,
     GLdouble e[] = {  normal.x, normal.y, normal.z, 
                    -normal.x*point.x - normal.y*point.y - normal.z*point.z };
     glClipPlane( GL_CLIP_PLANE0 + plane_index, e );
-    glEnable( GL_CLIP_PLANE0 + plane_index );
+    GLStateTracker::enable( GL_CLIP_PLANE0 + plane_index );
     
     // draw scene
     glLoadMatrixf( rm );
@@ -234,25 +235,25 @@ void PlanarReflector::renderPostViewpoint ( X3DChildNode *n,
       X3DShapeNode::geometry_render_mode = X3DShapeNode::ALL; 
       n->render();
     }
-    glDisable( GL_CLIP_PLANE0 + plane_index );
+    GLStateTracker::disable( GL_CLIP_PLANE0 + plane_index );
     --ClipPlane::nr_active_clip_planes;
   }
   glPopMatrix();
-  glDisable( GL_STENCIL_TEST );
+  GLStateTracker::disable( GL_STENCIL_TEST );
 
   // draw mirror geometry
   glClear( GL_DEPTH_BUFFER_BIT );
   glPushMatrix();
   glMultMatrixf( t );
-  glEnable( GL_BLEND );
-  glDisable( GL_LIGHTING );
+  GLStateTracker::enable( GL_BLEND );
+  GLStateTracker::disable( GL_LIGHTING );
   glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   
   const RGB &c = color->getValue();
 
   glColor4f( c.r, c.g, c.b, 1 - reflectivity->getValue() );
   if( g ) g->render();
-  glEnable( GL_LIGHTING );
+  GLStateTracker::enable( GL_LIGHTING );
   glPopMatrix();
 
   glFrontFace( front_face );
@@ -271,7 +272,7 @@ void PlanarReflector::renderPostViewpoint ( X3DChildNode *n,
   glClear( GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT );
   glStencilOp( GL_REPLACE, GL_REPLACE, GL_REPLACE );
   glStencilFunc( GL_ALWAYS, 1, 1 );
-  glEnable( GL_STENCIL_TEST );
+  GLStateTracker::enable( GL_STENCIL_TEST );
 
   glColorMask( 0, 0, 0, 0 );
   
@@ -290,7 +291,7 @@ void PlanarReflector::renderPostViewpoint ( X3DChildNode *n,
 
     glClear( GL_DEPTH_BUFFER_BIT );
    if( g ) g->displayList->callList();
-  glDisable( GL_STENCIL_TEST );
+  GLStateTracker::disable( GL_STENCIL_TEST );
 //   X3DGeometryNode *g = geometry->getValue();
 
  
@@ -32,6 +32,7 @@
 #include <H3D/X3DTextureNode.h>
 #include <H3D/GlobalSettings.h>
 #include <H3D/GraphicsOptions.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -78,7 +79,7 @@ void PointSet::DisplayList::callList( bool build_list ) {
   PointSet *point_set = 
    static_cast< PointSet * >( owner );
 
-  glPushAttrib( GL_CURRENT_BIT );
+  GLStateTracker::pushAttrib( GL_CURRENT_BIT );
 
   // If color field is NULL, we use the emissive Color from the current material
   // as color.
@@ -90,7 +91,7 @@ void PointSet::DisplayList::callList( bool build_list ) {
 
   X3DGeometryNode::DisplayList::callList( build_list );
 
-  glPopAttrib();
+  GLStateTracker::popAttrib();
 }   
 
 
@@ -104,7 +105,7 @@ void PointSet::render() {
     // Save the old state of GL_LIGHTING 
     GLboolean lighting_enabled;
     glGetBooleanv( GL_LIGHTING, &lighting_enabled );
-    glDisable( GL_LIGHTING );
+    GLStateTracker::disable( GL_LIGHTING );
     
     // disable texturing
     X3DTextureNode *texture = X3DTextureNode::getActiveTexture();
@@ -124,7 +125,7 @@ void PointSet::render() {
     
     // set fog to get fog depth from fog coordinates if available
     if( GLEW_EXT_fog_coord && fog_coord_node ) {
-      glPushAttrib( GL_FOG_BIT );
+      GLStateTracker::pushAttrib( GL_FOG_BIT );
       glFogi(GL_FOG_COORDINATE_SOURCE_EXT, GL_FOG_COORDINATE_EXT);
     }
 
@@ -221,12 +222,12 @@ void PointSet::render() {
 
     // restore previous fog attributes
     if( GLEW_EXT_fog_coord && fog_coord_node ) {
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
 
     // reenable lighting if it was enabled before
     if( lighting_enabled )
-      glEnable( GL_LIGHTING );
+      GLStateTracker::enable( GL_LIGHTING );
     
     if( texture ) texture->enableTexturing();
   }
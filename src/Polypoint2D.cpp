@@ -31,6 +31,7 @@
 #include <H3D/Polypoint2D.h>
 #include <H3D/GlobalSettings.h>
 #include <H3D/GraphicsOptions.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -81,20 +82,20 @@ void Polypoint2D::DisplayList::callList( bool build_list ) {
   Polypoint2D *arc = 
    static_cast< Polypoint2D * >( owner );
 
-  glPushAttrib( GL_CURRENT_BIT );
+  GLStateTracker::pushAttrib( GL_CURRENT_BIT );
   float v[4];
   glGetMaterialfv( GL_FRONT, GL_EMISSION, v );
   glColor3f( v[0], v[1], v[2] );
 
   X3DGeometryNode::DisplayList::callList( build_list );
-  glPopAttrib();
+  GLStateTracker::popAttrib();
 }
 
 void Polypoint2D::render() {
   // Save the old state of GL_LIGHTING 
   GLboolean lighting_enabled;
   glGetBooleanv( GL_LIGHTING, &lighting_enabled );
-  glDisable( GL_LIGHTING );
+  GLStateTracker::disable( GL_LIGHTING );
 
   bool prefer_vertex_buffer_object = false;
   if( GLEW_ARB_vertex_buffer_object ) {
@@ -147,6 +148,6 @@ void Polypoint2D::render() {
   }
   // reenable lighting if it was enabled before
   if( lighting_enabled )
-    glEnable( GL_LIGHTING );
+    GLStateTracker::enable( GL_LIGHTING );
 }
 
@@ -0,0 +1,294 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file PrimitiveMeshCache.cpp
+/// \brief CPP file for PrimitiveMeshCache.
+///
+//
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <H3D/PrimitiveMeshCache.h>
+#include <H3D/X3DGeometryNode.h>
+#include <H3D/X3DTextureCoordinateNode.h>
+#include <H3D/GraphicsOptions.h>
+#include <H3D/GlobalSettings.h>
+
+using namespace H3D;
+
+PrimitiveMeshCache::MeshDatabase PrimitiveMeshCache::mesh_database;
+vector< GLuint > PrimitiveMeshCache::released_buffers;
+H3DUtil::MutexLock PrimitiveMeshCache::database_lock;
+
+PrimitiveMeshCache::Mesh::Mesh() :
+  vbo_initialized( false ),
+  use_count( 0 ) {
+  vbo_id[0] = 0;
+  vbo_id[1] = 0;
+}
+
+void PrimitiveMeshCache::Mesh::beginPart() {
+  if( !parts.empty() ) updateLastPart();
+  Part part;
+  part.index_offset = (GLsizei)index_data.size();
+  part.min_index = nrVertices();
+  part.max_index = part.min_index;
+  parts.push_back( part );
+}
+
+GLuint PrimitiveMeshCache::Mesh::addVertex( const Vec3f &vertex,
+                                            const Vec3f &normal,
+                                            const Vec3f &tex_coord ) {
+  GLuint index = nrVertices();
+  vertex_data.push_back( vertex.x );
+  vertex_data.push_back( vertex.y );
+  vertex_data.push_back( vertex.z );
+  vertex_data.push_back( normal.x );
+  vertex_data.push_back( normal.y );
+  vertex_data.push_back( normal.z );
+  vertex_data.push_back( tex_coord.x );
+  vertex_data.push_back( tex_coord.y );
+  vertex_data.push_back( tex_coord.z );
+  return index;
+}
+
+void PrimitiveMeshCache::Mesh::addTriangle( GLuint a, GLuint b, GLuint c ) {
+  if( parts.empty() ) beginPart();
+  index_data.push_back( a );
+  index_data.push_back( b );
+  index_data.push_back( c );
+}
+
+void PrimitiveMeshCache::Mesh::updateLastPart() {
+  Part &part = parts.back();
+  part.nr_indices = (GLsizei)index_data.size() - part.index_offset;
+  if( part.nr_indices > 0 ) {
+    part.min_index = index_data[ part.index_offset ];
+    part.max_index = part.min_index;
+    for( size_t i = part.index_offset; i < index_data.size(); ++i ) {
+      if( index_data[i] < part.min_index ) part.min_index = index_data[i];
+      if( index_data[i] > part.max_index ) part.max_index = index_data[i];
+    }
+  }
+}
+
+void PrimitiveMeshCache::Mesh::render( unsigned int part_mask,
+                                       bool use_vertex_buffer_object,
+                                       GLsizei nr_instances ) {
+  PrimitiveMeshCache::deleteReleasedBuffers();
+
+  if( vertex_data.empty() || index_data.empty() ) return;
+
+  GLvoid *vertex_pointer = NULL, *normal_pointer = NULL;
+  GLvoid *texture_pointer = NULL;
+  GLuint *index_pointer = NULL;
+  if( use_vertex_buffer_object ) {
+    if( !vbo_initialized ) {
+      vbo_initialized = true;
+      glGenBuffersARB( 2, vbo_id );
+      glBindBufferARB( GL_ARRAY_BUFFER_ARB, vbo_id[0] );
+      glBufferDataARB( GL_ARRAY_BUFFER_ARB,
+                       vertex_data.size() * sizeof(GLfloat),
+                       &(*vertex_data.begin()), GL_STATIC_DRAW_ARB );
+      glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, vbo_id[1] );
+      glBufferDataARB( GL_ELEMENT_ARRAY_BUFFER_ARB,
+                       index_data.size() * sizeof(GLuint),
+                       &(*index_data.begin()), GL_STATIC_DRAW_ARB );
+    } else {
+      glBindBufferARB( GL_ARRAY_BUFFER_ARB, vbo_id[0] );
+      glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, vbo_id[1] );
+    }
+    normal_pointer = (GLvoid*)(3*sizeof(GLfloat));
+    texture_pointer = (GLvoid*)(6*sizeof(GLfloat));
+  } else {
+    vertex_pointer = &vertex_data[0];
+    normal_pointer = &vertex_data[3];
+    texture_pointer = &vertex_data[6];
+    index_pointer = &index_data[0];
+  }
+
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glVertexPointer( 3, GL_FLOAT, components_per_vertex * sizeof(GLfloat),
+                   vertex_pointer );
+  glEnableClientState(GL_NORMAL_ARRAY);
+  glNormalPointer( GL_FLOAT, components_per_vertex * sizeof(GLfloat),
+                   normal_pointer );
+  X3DTextureCoordinateNode::renderVertexBufferObjectForActiveTexture(
+    3, GL_FLOAT, components_per_vertex * sizeof(GLfloat), texture_pointer );
+
+  // Draw the selected parts. Parts that follow each other in index_data
+  // are drawn with one call.
+  unsigned int i = 0;
+  while( i < parts.size() ) {
+    if( !( part_mask & ( 1 << i ) ) ) {
+      ++i;
+      continue;
+    }
+    GLuint min_index = parts[i].min_index;
+    GLuint max_index = parts[i].max_index;
+    GLsizei index_offset = parts[i].index_offset;
+    GLsizei nr_indices = parts[i].nr_indices;
+    for( ++i; i < parts.size() && ( part_mask & ( 1 << i ) ); ++i ) {
+      if( parts[i].min_index < min_index ) min_index = parts[i].min_index;
+      if( parts[i].max_index > max_index ) max_index = parts[i].max_index;
+      nr_indices += parts[i].nr_indices;
+    }
+    if( nr_indices > 0 ) {
+      if( nr_instances == 1 ) {
+        glDrawRangeElements( GL_TRIANGLES,
+                             min_index,
+                             max_index,
+                             nr_indices,
+                             GL_UNSIGNED_INT,
+                             index_pointer + index_offset );
+      } else {
+        glDrawElementsInstancedARB( GL_TRIANGLES,
+                                    nr_indices,
+                                    GL_UNSIGNED_INT,
+                                    index_pointer + index_offset,
+                                    nr_instances );
+      }
+    }
+  }
+
+  X3DTextureCoordinateNode::disableVBOForActiveTexture();
+  glDisableClientState(GL_NORMAL_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+  if( use_vertex_buffer_object ) {
+    glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
+    glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 );
+  }
+}
+
+void PrimitiveMeshCache::Mesh::getTriangles(
+  unsigned int part_mask,
+  vector< HAPI::Collision::Triangle > &_triangles ) {
+  database_lock.lock();
+  if( triangles.empty() ) {
+    triangles.reserve( index_data.size() / 3 );
+    for( size_t i = 0; i + 2 < index_data.size(); i += 3 ) {
+      const GLfloat *a = &vertex_data[ index_data[i] * components_per_vertex ];
+      const GLfloat *b =
+        &vertex_data[ index_data[i+1] * components_per_vertex ];
+      const GLfloat *c =
+        &vertex_data[ index_data[i+2] * components_per_vertex ];
+      triangles.push_back(
+        HAPI::Collision::Triangle( Vec3d( a[0], a[1], a[2] ),
+                                   Vec3d( b[0], b[1], b[2] ),
+                                   Vec3d( c[0], c[1], c[2] ),
+                                   Vec3d( a[6], a[7], a[8] ),
+                                   Vec3d( b[6], b[7], b[8] ),
+                                   Vec3d( c[6], c[7], c[8] ) ) );
+    }
+  }
+  database_lock.unlock();
+
+  for( unsigned int i = 0; i < parts.size(); ++i ) {
+    if( part_mask & ( 1 << i ) ) {
+      vector< HAPI::Collision::Triangle >::const_iterator start =
+        triangles.begin() + parts[i].index_offset / 3;
+      _triangles.insert( _triangles.end(),
+                         start, start + parts[i].nr_indices / 3 );
+    }
+  }
+}
+
+unsigned int PrimitiveMeshCache::Mesh::nrTriangles(
+  unsigned int part_mask ) const {
+  unsigned int nr_triangles = 0;
+  for( unsigned int i = 0; i < parts.size(); ++i ) {
+    if( part_mask & ( 1 << i ) ) nr_triangles += parts[i].nr_indices / 3;
+  }
+  return nr_triangles;
+}
+
+PrimitiveMeshCache::Mesh *PrimitiveMeshCache::getMesh(
+  const string &type,
+  const vector< H3DFloat > &params,
+  BuildMeshFunc build_func ) {
+  Key key( type, params );
+  database_lock.lock();
+  MeshDatabase::iterator i = mesh_database.find( key );
+  Mesh *mesh = NULL;
+  if( i != mesh_database.end() ) {
+    mesh = (*i).second;
+  } else {
+    mesh = new Mesh;
+    mesh->key = key;
+    build_func( params, *mesh );
+    if( !mesh->parts.empty() ) mesh->updateLastPart();
+    mesh_database[ key ] = mesh;
+  }
+  ++mesh->use_count;
+  database_lock.unlock();
+  return mesh;
+}
+
+void PrimitiveMeshCache::releaseMesh( Mesh *mesh ) {
+  if( !mesh ) return;
+  database_lock.lock();
+  --mesh->use_count;
+  if( mesh->use_count <= 0 ) {
+    mesh_database.erase( mesh->key );
+    if( mesh->vbo_initialized ) {
+      released_buffers.push_back( mesh->vbo_id[0] );
+      released_buffers.push_back( mesh->vbo_id[1] );
+    }
+    delete mesh;
+  }
+  database_lock.unlock();
+}
+
+unsigned int PrimitiveMeshCache::nrMeshes() {
+  database_lock.lock();
+  unsigned int nr_meshes = (unsigned int)mesh_database.size();
+  database_lock.unlock();
+  return nr_meshes;
+}
+
+bool PrimitiveMeshCache::usingVertexBufferObjects(
+  X3DGeometryNode *geometry ) {
+  if( !GLEW_ARB_vertex_buffer_object ) return false;
+  GraphicsOptions * go = NULL;
+  geometry->getOptionNode( go );
+  if( !go ) {
+    GlobalSettings * gs = GlobalSettings::getActive();
+    if( gs ) {
+      gs->getOptionNode( go );
+    }
+  }
+  if( go ) {
+    return go->preferVertexBufferObject->getValue();
+  }
+  return false;
+}
+
+void PrimitiveMeshCache::deleteReleasedBuffers() {
+  database_lock.lock();
+  if( !released_buffers.empty() ) {
+    glDeleteBuffersARB( (GLsizei)released_buffers.size(),
+                        &released_buffers[0] );
+    released_buffers.clear();
+  }
+  database_lock.unlock();
+}
@@ -39,10 +39,56 @@
 #include <H3D/IStreamInputSource.h>
 #include <H3D/VrmlDriver.h>
 #include <H3D/VrmlParser.h>
+#include <H3D/X3DBindableNode.h>
+#include <H3D/X3DTimeDependentNode.h>
+#include <H3D/X3DSensorNode.h>
+#include <H3D/X3DScriptNode.h>
+#include <H3D/H3DScriptNode.h>
+
+#include <set>
+#include <algorithm>
 
 
 using namespace H3D;
 
+namespace ProtoDeclarationInternals {
+  /// Get the fields in the database and the dynamic fields of a node.
+  void getNodeFields( Node *n, vector< Field * > &fields ) {
+    H3DNodeDatabase *db = H3DNodeDatabase::lookupNodeInstance( n );
+    if( db ) {
+      for( H3DNodeDatabase::FieldDBConstIterator i = db->fieldDBBegin();
+           i != db->fieldDBEnd(); ++i ) {
+        Field *f = n->getField( *i );
+        if( f ) fields.push_back( f );
+      }
+    }
+    if( H3DDynamicFieldsObject *dfo =
+        dynamic_cast< H3DDynamicFieldsObject * >( n ) ) {
+      for( H3DDynamicFieldsObject::field_iterator i = dfo->firstField();
+           i != dfo->endField(); ++i ) {
+        if( std::find( fields.begin(), fields.end(), *i ) == fields.end() )
+          fields.push_back( *i );
+      }
+    }
+  }
+
+  /// Returns true if a clone of the node behaves as the node would if
+  /// created by parsing. Nested prototype instances need their own IS
+  /// connections, bindable nodes would put the template on the bindable
+  /// stack and scripts would run in the template. Time dependent nodes
+  /// and sensors generate events by themselves, e.g. a looping
+  /// TimeSensor, so they would keep the template running.
+  bool isClonable( Node *n ) {
+    return !dynamic_cast< X3DPrototypeInstance * >( n ) &&
+           !dynamic_cast< X3DBindableNode * >( n ) &&
+           !dynamic_cast< X3DTimeDependentNode * >( n ) &&
+           !dynamic_cast< X3DSensorNode * >( n ) &&
+           !dynamic_cast< X3DScriptNode * >( n ) &&
+           !dynamic_cast< H3DScriptNode * >( n ) &&
+           H3DNodeDatabase::lookupTypeId( typeid( *n ) );
+  }
+}
+
 ProtoDeclaration::ProtoDeclaration( const string &_name,
                                     const string &_body,
                                     const vector<string > &_body_extra,
@@ -50,7 +96,8 @@ ProtoDeclaration::ProtoDeclaration( const string &_name,
       name( _name ),
       existing_protos( NULL ),
       body( _body ),
-      body_extra( _body_extra ) {
+      body_extra( _body_extra ),
+      template_created( false ) {
   if( _existing_protos ) {
     existing_protos = new PrototypeVector;
     for( PrototypeVector::const_iterator i = _existing_protos->begin();
@@ -73,7 +120,170 @@ ProtoDeclaration::~ProtoDeclaration() {
 }
 
 X3DPrototypeInstance *ProtoDeclaration::newProtoInstance() { 
+  if( !template_created ) {
+    // the first instance is parsed and kept as template if it can be
+    // cloned, otherwise it is used as it is.
+    PrototypeInstance *proto = createTemplate();
+    if( !template_instance.get() ) return proto;
+  }
+  if( template_instance.get() ) return cloneTemplate();
+
   PrototypeInstance *proto = new PrototypeInstance( NULL );
+  proto->setProtoName( name );
+  return parseProtoInstance( proto );
+}
+
+PrototypeInstance *ProtoDeclaration::createTemplate() {
+  using namespace ProtoDeclarationInternals;
+  template_created = true;
+
+  PrototypeInstance *proto = new PrototypeInstance( NULL );
+  proto->setProtoName( name );
+  proto = parseProtoInstance( proto );
+  if( !proto ) return NULL;
+
+  // find all nodes of the proto body.
+  vector< Node * > to_visit;
+  proto->getPrototypedNodes( to_visit );
+  std::set< Node * > nodes;
+  while( !to_visit.empty() ) {
+    Node *n = to_visit.back();
+    to_visit.pop_back();
+    if( !nodes.insert( n ).second ) continue;
+    if( !isClonable( n ) ) return proto;
+
+    vector< Field * > fields;
+    getNodeFields( n, fields );
+    for( unsigned int i = 0; i < fields.size(); ++i ) {
+      if( SFNode *sfnode = dynamic_cast< SFNode * >( fields[i] ) ) {
+        if( sfnode->getValue() ) to_visit.push_back( sfnode->getValue() );
+      } else if( MFNode *mfnode = dynamic_cast< MFNode * >( fields[i] ) ) {
+        for( unsigned int j = 0; j < mfnode->size(); ++j ) {
+          Node *child = mfnode->getValueByIndex( j );
+          if( child ) to_visit.push_back( child );
+        }
+      }
+    }
+  }
+
+  // the default values of the prototype fields are cloned too.
+  for( H3DDynamicFieldsObject::field_iterator i = proto->firstField();
+       i != proto->endField(); ++i ) {
+    vector< Node * > values;
+    if( SFNode *sfnode = dynamic_cast< SFNode * >( *i ) ) {
+      if( sfnode->getValue() ) values.push_back( sfnode->getValue() );
+    } else if( MFNode *mfnode = dynamic_cast< MFNode * >( *i ) ) {
+      for( unsigned int j = 0; j < mfnode->size(); ++j ) {
+        if( mfnode->getValueByIndex( j ) )
+          values.push_back( mfnode->getValueByIndex( j ) );
+      }
+    }
+    for( unsigned int j = 0; j < values.size(); ++j ) {
+      if( !isClonable( values[j] ) ) return proto;
+    }
+  }
+
+  // the IS connections are the routes between the prototype fields and
+  // the fields of the nodes, in either direction.
+  for( H3DDynamicFieldsObject::field_iterator i = proto->firstField();
+       i != proto->endField(); ++i ) {
+    vector< Field * > connected( (*i)->getRoutesOut().begin(),
+                                 (*i)->getRoutesOut().end() );
+    connected.insert( connected.end(),
+                      (*i)->getRoutesIn().begin(),
+                      (*i)->getRoutesIn().end() );
+    for( unsigned int j = 0; j < connected.size(); ++j ) {
+      Field *f = connected[j];
+      if( nodes.find( f->getOwner() ) == nodes.end() ) continue;
+      bool exists = false;
+      for( unsigned int k = 0; k < template_connections.size(); ++k ) {
+        const ISConnection &c = template_connections[k];
+        if( c.proto_field == (*i)->getName() && c.node == f->getOwner() &&
+            c.node_field == f->getName() ) {
+          exists = true;
+          break;
+        }
+      }
+      if( exists ) continue;
+      ISConnection c;
+      c.proto_field = (*i)->getName();
+      c.node = f->getOwner();
+      c.node_field = f->getName();
+      template_connections.push_back( c );
+    }
+  }
+
+  // only routes that can be created with a ROUTE statement are set up
+  // again, i.e. between fields of different nodes. The other routes are
+  // set up by the nodes themselves.
+  for( std::set< Node * >::iterator n = nodes.begin(); n != nodes.end(); ++n ) {
+    vector< Field * > fields;
+    getNodeFields( *n, fields );
+    for( unsigned int i = 0; i < fields.size(); ++i ) {
+      Field *from = fields[i];
+      Field::AccessType access_type = from->getAccessType();
+      if( access_type != Field::OUTPUT_ONLY &&
+          access_type != Field::INPUT_OUTPUT ) continue;
+      const Field::FieldSet &routes_out = from->getRoutesOut();
+      for( Field::FieldSet::const_iterator r = routes_out.begin();
+           r != routes_out.end(); ++r ) {
+        Field *to = *r;
+        Node *to_node = to->getOwner();
+        if( !to_node || to_node == *n ||
+            nodes.find( to_node ) == nodes.end() ) continue;
+        if( to_node->getField( to->getName() ) != to ) continue;
+        access_type = to->getAccessType();
+        if( access_type != Field::INPUT_ONLY &&
+            access_type != Field::INPUT_OUTPUT ) continue;
+        BodyRoute route;
+        route.from_node = *n;
+        route.from_field = from->getName();
+        route.to_node = to_node;
+        route.to_field = to->getName();
+        template_routes.push_back( route );
+      }
+    }
+  }
+
+  template_instance.reset( proto );
+  return NULL;
+}
+
+X3DPrototypeInstance *ProtoDeclaration::cloneTemplate() {
+  Node::DeepCopyMap copy_map;
+  PrototypeInstance *proto = static_cast< PrototypeInstance * >
+    ( template_instance->clone( true, &copy_map ) );
+
+  for( Node::DeepCopyMap::iterator i = copy_map.begin();
+       i != copy_map.end(); ++i ) {
+    if( (*i).first->hasName() ) (*i).second->setName( (*i).first->getName() );
+  }
+
+  for( unsigned int i = 0; i < template_connections.size(); ++i ) {
+    const ISConnection &c = template_connections[i];
+    Node::DeepCopyMap::iterator n = copy_map.find( c.node );
+    if( n == copy_map.end() ) continue;
+    Field *f = (*n).second->getField( c.node_field );
+    if( f ) proto->connectField( c.proto_field, f );
+  }
+
+  for( unsigned int i = 0; i < template_routes.size(); ++i ) {
+    const BodyRoute &r = template_routes[i];
+    Node::DeepCopyMap::iterator from = copy_map.find( r.from_node );
+    Node::DeepCopyMap::iterator to = copy_map.find( r.to_node );
+    if( from == copy_map.end() || to == copy_map.end() ) continue;
+    Field *from_field = (*from).second->getField( r.from_field );
+    Field *to_field = (*to).second->getField( r.to_field );
+    // as for a ROUTE statement the destination gets the value of the
+    // source, also for inputOnly fields whose values are not cloned.
+    if( from_field && to_field ) from_field->route( to_field );
+  }
+
+  return proto;
+}
+
+PrototypeInstance *ProtoDeclaration::parseProtoInstance(
+                                            PrototypeInstance *proto ) {
   try {
 
     for( list< FieldDeclaration >::iterator i = field_declarations.begin();
@@ -136,7 +346,10 @@ X3DPrototypeInstance *ProtoDeclaration::newProtoInstance() {
       }
     }
 
-    if( body == "" ) return NULL;
+    if( body == "" ) {
+      delete proto;
+      return NULL;
+    }
     X3D::DEFNodes dn;
 
     if ( X3D::isVRML( body ) ) {
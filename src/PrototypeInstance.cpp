@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/PrototypeInstance.h>
+#include <H3D/X3DTypeFunctions.h>
 
 using namespace H3D;
 
@@ -48,6 +49,21 @@ Node* PrototypeInstance::clone ( bool deepCopy, DeepCopyMap* deepCopyMap ) {
   // Basic clone
   PrototypeInstance* n= new PrototypeInstance ( getClonedInstance ( prototyped_node.get(), deepCopy, *deepCopyMap ) );
   n->metadata->setValue ( getClonedInstance ( metadata->getValue (), deepCopy, *deepCopyMap ) );
+  n->setProtoName ( proto_name );
+
+  // Clone the fields of the prototype
+  for ( field_iterator i= firstField(); i != endField(); ++i ) {
+    Field* f_from= *i;
+    Field* f_to= X3DTypes::newFieldInstance ( f_from->getX3DType() );
+    if ( f_to ) {
+      f_to->setOwner ( n );
+      f_to->setName ( f_from->getName() );
+      cloneFieldValue ( *f_from, *f_to, deepCopy, *deepCopyMap );
+      n->addField ( f_from->getName(), f_from->getAccessType(), f_to );
+    } else {
+      Console(LogLevel::Error) << "Warning: Failed to clone prototype field " << f_from->getFullName() << "!" << endl;
+    }
+  }
 
   // Clone prototyped_node_extras
   n->prototyped_node_extras.reserve ( prototyped_node_extras.size() );
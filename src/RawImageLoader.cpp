@@ -29,8 +29,11 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/RawImageLoader.h>
+#include <H3D/MappedImage.h>
 #include <H3DUtil/LoadImageFunctions.h>
 
+#include <fstream>
+
 using namespace H3D;
 
 H3DNodeDatabase RawImageLoader::database( 
@@ -48,6 +51,14 @@ namespace RawImageLoaderInternals {
   FIELDDB_ELEMENT( RawImageLoader, pixelComponentType, INPUT_OUTPUT );
   FIELDDB_ELEMENT( RawImageLoader, bitsPerPixel, INPUT_OUTPUT );
   FIELDDB_ELEMENT( RawImageLoader, pixelSize, INPUT_OUTPUT );
+
+  // Returns true if the file starts with the gzip magic number.
+  bool isGzipFile( const string &url ) {
+    ifstream is( url.c_str(), ios::in | ios::binary );
+    unsigned char magic[2] = { 0, 0 };
+    is.read( (char *)magic, 2 );
+    return is.gcount() == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+  }
 }
 
 RawImageLoader::RawImageLoader( Inst< SFInt32  > _width,
@@ -88,6 +99,32 @@ RawImageLoader::RawImageLoader( Inst< SFInt32  > _width,
 }
 
 Image *RawImageLoader::loadImage( const string &url ) {
+  // uncompressed data is used directly from the file.
+  if( !RawImageLoaderInternals::isGzipFile( url ) ) {
+    Image::PixelType pixel_type = Image::RGB;
+    const string &type = pixelType->getValue();
+    if( type == "LUMINANCE" ) pixel_type = Image::LUMINANCE;
+    else if( type == "LUMINANCE_ALPHA" ) pixel_type = Image::LUMINANCE_ALPHA;
+    else if( type == "RGBA" ) pixel_type = Image::RGBA;
+    else if( type == "BGR" ) pixel_type = Image::BGR;
+    else if( type == "BGRA" ) pixel_type = Image::BGRA;
+    else if( type == "VEC3" ) pixel_type = Image::VEC3;
+
+    Image::PixelComponentType component_type = Image::UNSIGNED;
+    const string &component = pixelComponentType->getValue();
+    if( component == "SIGNED" ) component_type = Image::SIGNED;
+    else if( component == "RATIONAL" ) component_type = Image::RATIONAL;
+
+    Image *image = MappedImage::mapFile( url, 0,
+                                         width->getValue(),
+                                         height->getValue(),
+                                         depth->getValue(),
+                                         bitsPerPixel->getValue(),
+                                         pixel_type, component_type,
+                                         pixelSize->getValue() );
+    if( image ) return image;
+  }
+
   RawImageInfo raw_image_info( width->getValue(),
                                height->getValue(),
                                depth->getValue(),
@@ -0,0 +1,187 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file ReloadableImage.cpp
+/// \brief CPP file for ReloadableImage.
+///
+//
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <H3D/ReloadableImage.h>
+#include <H3D/MappedImage.h>
+#include <H3DUtil/Console.h>
+
+using namespace H3D;
+
+size_t ReloadableImage::released_bytes = 0;
+H3DUtil::MutexLock ReloadableImage::released_bytes_lock;
+
+ReloadableImage::ReloadableImage( Image *image,
+                                  ReloadFunc _reload_func,
+                                  void *_reload_data,
+                                  bool _main_thread_only ) :
+  image_width( image->width() ),
+  image_height( image->height() ),
+  image_depth( image->depth() ),
+  bits_per_pixel( image->bitsPerPixel() ),
+  pixel_size( image->pixelSize() ),
+  pixel_type( image->pixelType() ),
+  pixel_component_type( image->pixelComponentType() ),
+  data( image ),
+  reload_func( _reload_func ),
+  reload_data( _reload_data ),
+  main_thread_only( _main_thread_only ),
+  keep_loaded( false ) {
+}
+
+ReloadableImage::~ReloadableImage() {
+  if( !data.get() ) {
+    released_bytes_lock.lock();
+    released_bytes -= dataSize();
+    released_bytes_lock.unlock();
+  }
+}
+
+void *ReloadableImage::getImageData() {
+  lock.lock();
+  void *image_data = NULL;
+  if( loadDataLocked() ) {
+    image_data = data->getImageData();
+    // releaseData() is only called in the main thread, so data used in
+    // the main thread is not released while it is used. There is no
+    // way to know when another thread is done with the data, so it is
+    // kept from then on.
+    if( !H3DUtil::ThreadBase::inMainThread() ) keep_loaded = true;
+  }
+  lock.unlock();
+  return image_data;
+}
+
+bool ReloadableImage::releaseData() {
+  lock.lock();
+  bool released = false;
+  if( data.get() && reload_func && !keep_loaded ) {
+    data.reset( NULL );
+    released_bytes_lock.lock();
+    released_bytes += dataSize();
+    released_bytes_lock.unlock();
+    released = true;
+  }
+  lock.unlock();
+  return released;
+}
+
+bool ReloadableImage::loadData() {
+  lock.lock();
+  bool loaded = loadDataLocked();
+  lock.unlock();
+  return loaded;
+}
+
+bool ReloadableImage::isLoaded() {
+  lock.lock();
+  bool loaded = data.get() != NULL;
+  lock.unlock();
+  return loaded;
+}
+
+void ReloadableImage::detach() {
+  lock.lock();
+  reload_func = NULL;
+  reload_data = NULL;
+  lock.unlock();
+}
+
+bool ReloadableImage::loadDataLocked() {
+  if( data.get() ) return true;
+  if( !reload_func ) return false;
+
+  if( main_thread_only && !H3DUtil::ThreadBase::inMainThread() ) {
+    Console(LogLevel::Error) << "Warning: The released data of an image "
+                             << "can only be loaded again in the main thread. "
+                             << "Call ReloadableImage::keepLoaded() in "
+                             << "the main thread before using the image."
+                             << endl;
+    return false;
+  }
+
+  Image *image = reload_func( this, reload_data );
+  if( !image ) return false;
+  if( image->width() != image_width ||
+      image->height() != image_height ||
+      image->depth() != image_depth ||
+      image->bitsPerPixel() != bits_per_pixel ||
+      image->pixelType() != pixel_type ||
+      image->pixelComponentType() != pixel_component_type ) {
+    // e.g. the file has changed since the image was first loaded.
+    Console(LogLevel::Error) << "Warning: The released data of an image "
+                             << "could not be loaded again since the "
+                             << "reloaded image has a different size or "
+                             << "format." << endl;
+    delete image;
+    return false;
+  }
+
+  data.reset( image );
+  released_bytes_lock.lock();
+  released_bytes -= dataSize();
+  released_bytes_lock.unlock();
+  return true;
+}
+
+size_t ReloadableImage::dataSize() {
+  return (size_t)image_width * image_height * image_depth *
+    bits_per_pixel / 8;
+}
+
+bool ReloadableImage::canWrap( Image *image ) {
+  if( !image || image->compressionType() != Image::NO_COMPRESSION ||
+      dynamic_cast< ReloadableImage * >( image ) ||
+      dynamic_cast< MappedImage * >( image ) ) {
+    // the data of a MappedImage is only paged in from its file.
+    return false;
+  }
+  if( image->bitsPerPixel() % 8 != 0 ) return false;
+  // the data is loaded again without any row padding.
+  unsigned int row_bytes = image->width() * image->bitsPerPixel() / 8;
+  return image->byteAlignment() <= 1 ||
+    row_bytes % image->byteAlignment() == 0;
+}
+
+void ReloadableImage::keepLoaded( Image *image ) {
+  ReloadableImage *reloadable = dynamic_cast< ReloadableImage * >( image );
+  if( reloadable ) {
+    reloadable->lock.lock();
+    reloadable->keep_loaded = true;
+    reloadable->loadDataLocked();
+    reloadable->lock.unlock();
+  }
+}
+
+size_t ReloadableImage::getReleasedBytes() {
+  released_bytes_lock.lock();
+  size_t nr_bytes = released_bytes;
+  released_bytes_lock.unlock();
+  return nr_bytes;
+}
@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/RenderProperties.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -373,9 +374,9 @@ int RenderProperties::getBlendEquation( const string &equation_string, GLenum &e
 void RenderProperties::render() {
 
   if( depthTestEnabled->getValue() ) {
-    glEnable( GL_DEPTH_TEST );
+    GLStateTracker::enable( GL_DEPTH_TEST );
   } else {
-    glDisable( GL_DEPTH_TEST );
+    GLStateTracker::disable( GL_DEPTH_TEST );
   }
 
   // depth test func
@@ -412,9 +413,9 @@ void RenderProperties::render() {
   //  const string &alpha_test = alpha_test->getValue();
   //  if( alphaTest
   if( blendEnabled->getValue() ) {
-    glEnable( GL_BLEND );
+    GLStateTracker::enable( GL_BLEND );
   } else {
-    glDisable( GL_BLEND );
+    GLStateTracker::disable( GL_BLEND );
   }
 
 
@@ -487,7 +488,7 @@ void RenderProperties::render() {
   }
 
   if( gl_alpha_func != GL_ALWAYS ) {
-    glEnable( GL_ALPHA_TEST );
+    GLStateTracker::enable( GL_ALPHA_TEST );
     glAlphaFunc( gl_alpha_func, alphaFuncValue->getValue() );
   }
 
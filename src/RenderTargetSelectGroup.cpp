@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/RenderTargetSelectGroup.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -86,7 +87,7 @@ void RenderTargetSelectGroup::render() {
     return;
   }
 
-  glPushAttrib( GL_COLOR_BUFFER_BIT);
+  GLStateTracker::pushAttrib( GL_COLOR_BUFFER_BIT);
  
   const vector< H3DInt32 > &render_targets = renderTargets->getValue();
 
@@ -131,5 +132,5 @@ void RenderTargetSelectGroup::render() {
 
   X3DGroupingNode::render();
 
-  glPopAttrib();
+  GLStateTracker::popAttrib();
 }
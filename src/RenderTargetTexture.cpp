@@ -14,6 +14,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/RenderTargetTexture.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -200,12 +201,12 @@ std::pair<H3DInt32,H3DInt32> H3D::RenderTargetTexture::getDefaultSaveDimensions(
       gen->colorTextures->getValueByIndex( target_index ) );
     if( t->textureIdIsInitialized() ) {
       GLuint tex_id = t->getTextureId();
-      glPushAttrib( GL_TEXTURE_BIT );
-      glBindTexture( getTextureTarget(), tex_id );
+      GLStateTracker::pushAttrib( GL_TEXTURE_BIT );
+      GLStateTracker::bindTexture( getTextureTarget(), tex_id );
       GLint h, w;
       glGetTexLevelParameteriv( getTextureTarget(), 0, GL_TEXTURE_WIDTH, &w );
       glGetTexLevelParameteriv( getTextureTarget(), 0, GL_TEXTURE_HEIGHT, &h);
-      glPopAttrib();
+      GLStateTracker::popAttrib();
       return std::pair<H3DInt32,H3DInt32> ( w, h );
     }
   }
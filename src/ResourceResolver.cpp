@@ -28,6 +28,9 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/ResourceResolver.h>
+#include <H3DUtil/Threads.h>
+
+#include <map>
 
 #include <sys/stat.h>
 
@@ -45,6 +48,124 @@ using namespace H3DUtil;
 string ResourceResolver::baseURL( "" );
 ResourceResolver::TmpFileNameList ResourceResolver::tmp_files;
 
+namespace ResourceResolverInternals {
+  // The base URLs of threads other than the main thread.
+  typedef std::map< ThreadBase::ThreadId, string > ThreadBaseURLs;
+  ThreadBaseURLs &threadBaseURLs() {
+    static ThreadBaseURLs base_urls;
+    return base_urls;
+  }
+
+  MutexLock &threadBaseURLsLock() {
+    static MutexLock lock;
+    return lock;
+  }
+
+  // A recording started by ResourceResolver::beginDependencyRecording.
+  struct DependencyRecording {
+    DependencyRecording() : local_only( true ) {}
+    vector< string > files;
+    bool local_only;
+  };
+
+  // The active recordings of each thread, the last one started last.
+  typedef std::map< ThreadBase::ThreadId,
+                    std::list< DependencyRecording > > ThreadRecordings;
+  ThreadRecordings &threadRecordings() {
+    static ThreadRecordings recordings;
+    return recordings;
+  }
+
+  MutexLock &threadRecordingsLock() {
+    static MutexLock lock;
+    return lock;
+  }
+
+  // Lock for ResourceResolver::tmp_files, since urls are resolved in
+  // other threads as well, e.g. by InlineLoadPool.
+  MutexLock &tmpFilesLock() {
+    static MutexLock lock;
+    return lock;
+  }
+}
+
+void ResourceResolver::setBaseURL( const string &base ) {
+  if( ThreadBase::inMainThread() ) {
+    baseURL = base;
+  } else {
+    using namespace ResourceResolverInternals;
+    threadBaseURLsLock().lock();
+    if( base == "" ) {
+      threadBaseURLs().erase( ThreadBase::getCurrentThreadId() );
+    } else {
+      threadBaseURLs()[ ThreadBase::getCurrentThreadId() ] = base;
+    }
+    threadBaseURLsLock().unlock();
+  }
+}
+
+const string &ResourceResolver::getBaseURL() {
+  if( ThreadBase::inMainThread() ) return baseURL;
+
+  using namespace ResourceResolverInternals;
+  static const string empty_url( "" );
+  threadBaseURLsLock().lock();
+  ThreadBaseURLs::iterator i =
+    threadBaseURLs().find( ThreadBase::getCurrentThreadId() );
+  // map elements are never moved so the reference stays valid until the
+  // same thread changes its base URL.
+  const string &base = i == threadBaseURLs().end() ? empty_url : (*i).second;
+  threadBaseURLsLock().unlock();
+  return base;
+}
+
+void ResourceResolver::beginDependencyRecording() {
+  using namespace ResourceResolverInternals;
+  threadRecordingsLock().lock();
+  threadRecordings()[ ThreadBase::getCurrentThreadId() ].push_back(
+    DependencyRecording() );
+  threadRecordingsLock().unlock();
+}
+
+bool ResourceResolver::endDependencyRecording( vector< string > &files ) {
+  using namespace ResourceResolverInternals;
+  bool local_only = true;
+  threadRecordingsLock().lock();
+  ThreadRecordings::iterator i =
+    threadRecordings().find( ThreadBase::getCurrentThreadId() );
+  if( i != threadRecordings().end() ) {
+    DependencyRecording &recording = (*i).second.back();
+    files.insert( files.end(),
+                  recording.files.begin(), recording.files.end() );
+    local_only = recording.local_only;
+    (*i).second.pop_back();
+    if( (*i).second.empty() ) threadRecordings().erase( i );
+  }
+  threadRecordingsLock().unlock();
+  return local_only;
+}
+
+void ResourceResolver::addDependency( const string &file ) {
+  recordDependency( file, true );
+}
+
+void ResourceResolver::recordDependency( const string &file, bool local ) {
+  using namespace ResourceResolverInternals;
+  threadRecordingsLock().lock();
+  if( !threadRecordings().empty() ) {
+    ThreadRecordings::iterator i =
+      threadRecordings().find( ThreadBase::getCurrentThreadId() );
+    if( i != threadRecordings().end() ) {
+      for( std::list< DependencyRecording >::iterator r = (*i).second.begin();
+           r != (*i).second.end(); ++r ) {
+        if( !local ) (*r).local_only = false;
+        else if( file != "" ) (*r).files.push_back( file );
+      }
+    }
+  }
+  threadRecordingsLock().unlock();
+}
+
 string ResourceResolver::resolveURLAs( const string &urn,
                                        bool *is_tmp_file,
                                        bool folder,
@@ -56,8 +177,9 @@ string ResourceResolver::resolveURLAs( const string &urn,
   }
   
   // first try as relative path
-  if( baseURL != "" ) {
-    string full_url = baseURL + filename;
+  const string &base_url = getBaseURL();
+  if( base_url != "" ) {
+    string full_url = base_url + filename;
     
     // Only return file contents if a resolver explicitly supports it
     // i.e. if it implements resolveURLAsStringInternal()
@@ -69,6 +191,7 @@ string ResourceResolver::resolveURLAs( const string &urn,
                                 S_ISDIR(file_info.st_mode) :
                                 S_ISREG(file_info.st_mode) ) != 0 ) {
         if( is_tmp_file ) *is_tmp_file = false;
+        if( !folder ) recordDependency( full_url, true );
         return full_url;
       }
     }
@@ -80,12 +203,14 @@ string ResourceResolver::resolveURLAs( const string &urn,
         string resolved_name = (*i)->resolveURLAsTmpFile( full_url );
         if( resolved_name != "" ) {
           if( is_tmp_file ) *is_tmp_file = true;
+          recordDependency( "", false );
           return resolved_name;
         }
       } else {
         string contents = (*i)->resolveURLAsStringInternal( full_url );
         if( contents != "" ) {
           if( is_tmp_file ) *is_tmp_file = false;
+          recordDependency( "", false );
           return contents;
         }
       }
@@ -102,6 +227,7 @@ string ResourceResolver::resolveURLAs( const string &urn,
                               S_ISDIR(file_info.st_mode) :
                               S_ISREG(file_info.st_mode) ) != 0 ) {
       if( is_tmp_file ) *is_tmp_file = false;
+      if( !folder ) recordDependency( filename, true );
       return filename;
     }
   }
@@ -113,12 +239,14 @@ string ResourceResolver::resolveURLAs( const string &urn,
       string resolved_name = (*i)->resolveURLAsTmpFile( filename );
       if( resolved_name != "" ) {
         if( is_tmp_file ) *is_tmp_file = true;
+        recordDependency( "", false );
         return resolved_name;
       }
     } else {
       string contents = (*i)->resolveURLAsStringInternal( filename );
       if( contents != "" ) {
         if( is_tmp_file ) *is_tmp_file = false;
+        recordDependency( "", false );
         return contents;
       }
     }
@@ -127,6 +255,32 @@ string ResourceResolver::resolveURLAs( const string &urn,
   return "";
 }
 
+string ResourceResolver::resolveURLAsLocalFile( const string &urn ) {
+  if( urn == "" ) return "";
+  string filename = urn;
+  if( urn_resolver().get() ) {
+    filename = urn_resolver()->resolveURN( urn );
+  }
+
+  struct stat file_info;
+  const string &base_url = getBaseURL();
+  if( base_url != "" ) {
+    string full_url = base_url + filename;
+    if( ::stat( full_url.c_str(), &file_info ) == 0 &&
+        S_ISREG( file_info.st_mode ) ) {
+      recordDependency( full_url, true );
+      return full_url;
+    }
+  }
+
+  if( ::stat( filename.c_str(), &file_info ) == 0 &&
+      S_ISREG( file_info.st_mode ) ) {
+    recordDependency( filename, true );
+    return filename;
+  }
+  return "";
+}
+
 string ResourceResolver::getTmpFileName() {
 #ifdef H3D_WINDOWS
   // special version on Windows that supports Windows Vista.
@@ -136,7 +290,9 @@ string ResourceResolver::getTmpFileName() {
   string tmp_file( tmp_file_ptr );
   delete tmp_file_ptr;
   if( tmp_file.length() > 0 ) {
+      ResourceResolverInternals::tmpFilesLock().lock();
       tmp_files.push_back( tmp_file );
+      ResourceResolverInternals::tmpFilesLock().unlock();
       return tmp_file;
   } else {
       return "";
@@ -144,7 +300,9 @@ string ResourceResolver::getTmpFileName() {
 #else
   char tmp_file[ L_tmpnam ];
   if( tmpnam( tmp_file ) ) {
+    ResourceResolverInternals::tmpFilesLock().lock();
     tmp_files.push_back( tmp_file );
+    ResourceResolverInternals::tmpFilesLock().unlock();
     return tmp_file;
   } else {
     return "";
@@ -153,14 +311,18 @@ string ResourceResolver::getTmpFileName() {
 }
 
 bool ResourceResolver::releaseTmpFileName( const string &file ) {
+  using namespace ResourceResolverInternals;
+  tmpFilesLock().lock();
   for( list< string >::iterator i = tmp_files.begin();
        i != tmp_files.end(); ++i ) {
     if( file == (*i) ) {
       remove( (*i).c_str() );
       tmp_files.erase( i );
+      tmpFilesLock().unlock();
       return true;
     }
   }
+  tmpFilesLock().unlock();
   return false;
 }
 
@@ -50,6 +50,12 @@
 #include <H3D/X3DShapeNode.h>
 
 #include <H3D/X3DGroupingNode.h>
+#include <H3D/ShapeDrawList.h>
+#include <H3D/GLStateTracker.h>
+#include <H3D/ComposedShader.h>
+#include <H3D/TextureUploadManager.h>
+#include <H3D/TextureMemoryManager.h>
+#include <H3D/ReloadableImage.h>
 #include <H3D/ProfilesAndComponents.h>
 #include <H3D/H3DNavigation.h>
 #include <H3D/NavigationInfo.h>
@@ -228,6 +234,45 @@ std::string Scene::generateProfileResult()
   result << "====================================Node Times===================================" << std::endl;
   result << exclusive_times_string;
   result << "=======================================END=======================================" << std::endl;
+
+  const ShapeDrawList::Statistics &stats = ShapeDrawList::last_frame;
+  result << "===============================Render State Changes==============================" << std::endl;
+  result << "Shapes: " << stats.nr_shapes << std::endl;
+  result << "Appearance changes: " << stats.nr_appearance_changes << std::endl;
+  result << "Shader changes: " << stats.nr_shader_changes << std::endl;
+  result << "Texture changes: " << stats.nr_texture_changes << std::endl;
+  result << "Material changes: " << stats.nr_material_changes << std::endl;
+  const GLStateTracker::Statistics &gl_stats = GLStateTracker::last_frame;
+  result << "OpenGL state calls issued: " << gl_stats.nr_issued << std::endl;
+  result << "OpenGL state calls skipped: " << gl_stats.nr_skipped << std::endl;
+  result << "OpenGL state validation errors: " << gl_stats.nr_validation_errors << std::endl;
+  result << "=======================================END=======================================" << std::endl;
+
+  const TextureUploadManager::Statistics &upload_stats = TextureUploadManager::last_frame;
+  result << "=================================Texture Uploads=================================" << std::endl;
+  result << "Bytes uploaded: " << upload_stats.nr_bytes << std::endl;
+  result << "Slices uploaded: " << upload_stats.nr_slices << std::endl;
+  result << "Images completed: " << upload_stats.nr_completed << std::endl;
+  result << "Images pending: " << upload_stats.nr_pending << std::endl;
+  result << "=======================================END=======================================" << std::endl;
+
+  const TextureMemoryManager::Statistics &memory_stats = TextureMemoryManager::last_frame;
+  result << "=================================Texture Memory==================================" << std::endl;
+  result << "Textures installed: " << memory_stats.nr_textures << std::endl;
+  result << "Estimated size: " << memory_stats.nr_bytes / ( 1024 * 1024 ) << " MB" << std::endl;
+  result << "Textures evicted: " << memory_stats.nr_evicted << std::endl;
+  result << "Textures reinstalled: " << memory_stats.nr_reinstalled << std::endl;
+  result << "Released image data: " << ReloadableImage::getReleasedBytes() / ( 1024 * 1024 ) << " MB" << std::endl;
+  result << "=======================================END=======================================" << std::endl;
+
+  result << "=================================Shader Programs=================================" << std::endl;
+  result << "Compile time, link time and node of the latest built programs:" << std::endl;
+  for( unsigned int i = 0; i < ComposedShader::program_build_times.size(); ++i ) {
+    const ComposedShader::ProgramBuildTime &t = ComposedShader::program_build_times[i];
+    result << std::setprecision( 2 ) << t.compile_time*1000.0 << " ms " 
+           << t.link_time*1000.0 << " ms " << t.name << std::endl;
+  }
+  result << "=======================================END=======================================" << std::endl;
   
   if(!H3D_scene_result.isEmpty())
   {
@@ -597,6 +642,11 @@ void Scene::idle() {
 #ifdef HAVE_PROFILER
   H3DUtil::H3DTimer::stepBegin("Graphic_rendering");
 #endif
+  ShapeDrawList::beginFrame();
+  GLStateTracker::beginFrame();
+  TextureUploadManager::beginFrame();
+  TextureMemoryManager::beginFrame();
+
   // call window's render function
   for( MFWindow::const_iterator w = window->begin(); 
        w != window->end(); ++w ) {
@@ -0,0 +1,285 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file SceneSnapshotCache.cpp
+/// \brief CPP file for SceneSnapshotCache.
+///
+//
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <H3D/SceneSnapshotCache.h>
+#include <H3D/X3DBinary.h>
+#include <H3D/ResourceResolver.h>
+#include <H3D/H3DScriptNode.h>
+#include <H3D/X3DScriptNode.h>
+#include <H3D/PrototypeInstance.h>
+#include <H3D/H3DDynamicFieldsObject.h>
+#include <H3D/MFNode.h>
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <string.h>
+#include <algorithm>
+#include <set>
+
+using namespace H3D;
+
+string SceneSnapshotCache::cache_directory( "" );
+
+namespace SceneSnapshotCacheInternals {
+  const char snapshot_magic[] = "H3DS";
+  const H3DUInt32 snapshot_version = 1;
+
+  typedef unsigned long long Hash;
+
+  // 64 bit FNV-1a hash of a string of bytes.
+  Hash hashBytes( const char *data, size_t size,
+                  Hash hash = 14695981039346656037ULL ) {
+    for( size_t i = 0; i < size; ++i ) {
+      hash ^= (unsigned char)data[i];
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  // Hash the contents of a file. Returns false if it could not be read.
+  bool hashFile( const string &file, Hash &hash ) {
+    ifstream is( file.c_str(), ios::binary );
+    if( !is.good() ) return false;
+    hash = hashBytes( NULL, 0 );
+    char buffer[ 65536 ];
+    while( is.good() ) {
+      is.read( buffer, sizeof( buffer ) );
+      hash = hashBytes( buffer, (size_t)is.gcount(), hash );
+    }
+    return !is.bad();
+  }
+
+  // Returns true if the file might contain IMPORT or EXPORT statements,
+  // which the binary encoding does not store. Compressed files are not
+  // searched.
+  bool mayContainImportOrExport( const string &file ) {
+    ifstream is( file.c_str(), ios::binary );
+    stringstream s;
+    s << is.rdbuf();
+    const string &contents = s.str();
+    if( contents.size() >= 2 &&
+        (unsigned char)contents[0] == 0x1F &&
+        (unsigned char)contents[1] == 0x8B ) return true;
+    return contents.find( "IMPORT" ) != string::npos ||
+           contents.find( "EXPORT" ) != string::npos;
+  }
+
+  // Returns true if the nodes below node can be stored in a snapshot and
+  // be created from it with the same state and ROUTEs as when parsed.
+  bool canStore( Node *node, X3D::PrototypeVector *prototypes,
+                 set< Node * > &visited ) {
+    if( !node || !visited.insert( node ).second ) return true;
+
+    // scripts are run when initialized, so anything they change when 
+    // parsing would be applied twice when created from the snapshot.
+    if( dynamic_cast< H3DScriptNode * >( node ) ||
+        dynamic_cast< X3DScriptNode * >( node ) ) return false;
+
+    if( PrototypeInstance *pi = dynamic_cast< PrototypeInstance * >( node ) ) {
+      // the body of an instance is created from its declaration, but
+      // instances of PROTOs not in the vector are written as the nodes
+      // they are made of and would lose their interface.
+      return prototypes && pi->getProtoName() != "" &&
+        prototypes->getProtoDeclaration( pi->getProtoName() );
+    }
+
+    // ROUTEs are stored by field name, so a routed dynamic field must be
+    // found by its name.
+    if( H3DDynamicFieldsObject *dyn_f_obj =
+        dynamic_cast< H3DDynamicFieldsObject * >( node ) ) {
+      for( H3DDynamicFieldsObject::field_iterator i = dyn_f_obj->firstField();
+           i != dyn_f_obj->endField(); ++i ) {
+        Field *f = *i;
+        if( ( !f->getRoutesOut().empty() || !f->getRoutesIn().empty() ) &&
+            node->getField( f->getName() ) != f ) return false;
+      }
+    }
+
+    H3DNodeDatabase *db = H3DNodeDatabase::lookupNodeInstance( node );
+    for( H3DNodeDatabase::FieldDBConstIterator i = db->fieldDBBegin();
+         i != db->fieldDBEnd(); ++i ) {
+      Field *f = node->getField( *i );
+      if( SFNode *sf = dynamic_cast< SFNode * >( f ) ) {
+        if( !canStore( sf->getValue(), prototypes, visited ) ) return false;
+      } else if( MFNode *mf = dynamic_cast< MFNode * >( f ) ) {
+        const NodeVector &nodes = mf->getValue();
+        for( unsigned int j = 0; j < nodes.size(); ++j ) {
+          if( !canStore( nodes[j], prototypes, visited ) ) return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  void writeUInt32( ostream &os, H3DUInt32 v ) {
+    unsigned char b[4] = { (unsigned char)v, (unsigned char)( v >> 8 ),
+                           (unsigned char)( v >> 16 ),
+                           (unsigned char)( v >> 24 ) };
+    os.write( (const char *)b, 4 );
+  }
+
+  bool readUInt32( istream &is, H3DUInt32 &v ) {
+    unsigned char b[4];
+    if( !is.read( (char *)b, 4 ) ) return false;
+    v = b[0] | ( b[1] << 8 ) | ( b[2] << 16 ) | ( (H3DUInt32)b[3] << 24 );
+    return true;
+  }
+
+  void writeHash( ostream &os, Hash h ) {
+    writeUInt32( os, (H3DUInt32)h );
+    writeUInt32( os, (H3DUInt32)( h >> 32 ) );
+  }
+
+  bool readHash( istream &is, Hash &h ) {
+    H3DUInt32 low, high;
+    if( !readUInt32( is, low ) || !readUInt32( is, high ) ) return false;
+    h = ( (Hash)high << 32 ) | low;
+    return true;
+  }
+}
+
+void SceneSnapshotCache::setCacheDirectory( const string &dir ) {
+  cache_directory = dir;
+  if( cache_directory != "" &&
+      cache_directory[ cache_directory.size() - 1 ] != '/' &&
+      cache_directory[ cache_directory.size() - 1 ] != '\\' ) {
+    cache_directory += "/";
+  }
+}
+
+string SceneSnapshotCache::getSnapshotFileName( const string &file ) {
+  using namespace SceneSnapshotCacheInternals;
+  Hash h = hashBytes( file.c_str(), file.size() );
+  char name[ 17 ];
+  sprintf( name, "%08x%08x", (H3DUInt32)( h >> 32 ), (H3DUInt32)h );
+  return cache_directory + name + ".h3ds";
+}
+
+bool SceneSnapshotCache::loadSnapshot( const string &file,
+                                       AutoRef< Node > &node,
+                                       X3D::DEFNodes *dn,
+                                       X3D::PrototypeVector *prototypes ) {
+  using namespace SceneSnapshotCacheInternals;
+  if( cache_directory == "" ) return false;
+  ifstream is( getSnapshotFileName( file ).c_str(), ios::binary );
+  if( !is.good() ) return false;
+
+  char magic[4];
+  H3DUInt32 version, nr_files;
+  if( !is.read( magic, 4 ) || memcmp( magic, snapshot_magic, 4 ) != 0 ||
+      !readUInt32( is, version ) || version != snapshot_version ||
+      !readUInt32( is, nr_files ) ) return false;
+
+  // the first file is the file the snapshot was made from. Since file
+  // names are hashed to get the snapshot name it is checked as well.
+  vector< string > files;
+  for( H3DUInt32 i = 0; i < nr_files; ++i ) {
+    H3DUInt32 length;
+    Hash stored_hash, current_hash;
+    if( !readUInt32( is, length ) || length > 65536 ) return false;
+    string name( length, '\0' );
+    if( length > 0 && !is.read( &name[0], length ) ) return false;
+    if( !readHash( is, stored_hash ) ) return false;
+    if( ( i == 0 && name != file ) ||
+        !hashFile( name, current_hash ) ||
+        current_hash != stored_hash ) return false;
+    files.push_back( name );
+  }
+
+  try {
+    node = X3D::createX3DBinaryNodeFromStream( is, dn, NULL, prototypes );
+  } catch( const X3D::X3DBinaryParseError &e ) {
+    Console(LogLevel::Warning) << "Warning: Invalid scene snapshot for \""
+                               << file << "\" (" << e << ")" << endl;
+    return false;
+  }
+
+  for( unsigned int i = 0; i < files.size(); ++i ) {
+    ResourceResolver::addDependency( files[i] );
+  }
+  return true;
+}
+
+void SceneSnapshotCache::saveSnapshot( const string &file,
+                                       Node *node,
+                                       X3D::PrototypeVector *prototypes,
+                                       const vector< string > &dependencies ) {
+  using namespace SceneSnapshotCacheInternals;
+  if( cache_directory == "" || !node ) return;
+  if( mayContainImportOrExport( file ) ) return;
+  set< Node * > visited;
+  if( !canStore( node, prototypes, visited ) ) return;
+
+  // the file itself first, then every other file once.
+  vector< string > files( 1, file );
+  for( unsigned int i = 0; i < dependencies.size(); ++i ) {
+    if( find( files.begin(), files.end(), dependencies[i] ) == files.end() )
+      files.push_back( dependencies[i] );
+  }
+
+  stringstream s( ios::out | ios::binary );
+  s.write( snapshot_magic, 4 );
+  writeUInt32( s, snapshot_version );
+  writeUInt32( s, (H3DUInt32)files.size() );
+  for( unsigned int i = 0; i < files.size(); ++i ) {
+    Hash h;
+    if( !hashFile( files[i], h ) ) return;
+    writeUInt32( s, (H3DUInt32)files[i].size() );
+    s.write( files[i].c_str(), files[i].size() );
+    writeHash( s, h );
+  }
+
+  try {
+    X3D::writeNodeAsX3DBinary( s, node, prototypes );
+  } catch( const Exception::H3DException &e ) {
+    Console(LogLevel::Warning) << "Warning: Could not create scene snapshot "
+                               << "for \"" << file << "\" (" << e << ")"
+                               << endl;
+    return;
+  }
+
+  // write to a temporary file first so that an incomplete snapshot is
+  // never read.
+  string snapshot_file = getSnapshotFileName( file );
+  string tmp_file = snapshot_file + ".tmp";
+  ofstream os( tmp_file.c_str(), ios::binary );
+  if( !os.good() ) {
+    Console(LogLevel::Warning) << "Warning: Could not write scene snapshot \""
+                               << snapshot_file << "\"" << endl;
+    return;
+  }
+  const string &data = s.str();
+  os.write( data.data(), data.size() );
+  os.close();
+  remove( snapshot_file.c_str() );
+  if( !os.good() || rename( tmp_file.c_str(), snapshot_file.c_str() ) != 0 )
+    remove( tmp_file.c_str() );
+}
@@ -80,32 +80,42 @@
 #include <H3D/X3DShaderNode.h>
 #include <H3D/X3DProgrammableShaderObject.h>
 #include <H3D/GraphicsHardwareInfo.h>
+#include <H3D/GLStateTracker.h>
+
+#include <algorithm>
+#include <cstring>
 
 using namespace H3D;
 
 namespace H3D {
   namespace Shaders {
     template< class Type >
-    GLint *toIntArray( const vector< Type > &values ) {
+    GLint *toIntArray( const vector< Type > &values,
+                       vector< GLint > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      GLint *v = new GLint[ size ];
+      buffer.resize( size );
+      GLint *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) 
         v[i] = (GLint) values[i];
       return v;
     }
 
     template< class Type >
-    float *toFloatArray( const vector< Type > &values ) {
+    float *toFloatArray( const vector< Type > &values,
+                         vector< float > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      float *v = new float[ size ];
+      buffer.resize( size );
+      float *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) 
         v[i] = (float) values[i];
       return v;
     }
 
-    float *toFloatArray( const vector< Vec2f > &values ) {
+    float *toFloatArray( const vector< Vec2f > &values,
+                         vector< float > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      float *v = new float[ size * 2 ];
+      buffer.resize( size * 2 );
+      float *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Vec2f &a = values[i];
         v[i*2] = a.x;
@@ -115,9 +125,11 @@ namespace H3D {
     }
 
     
-    float *toFloatArray( const vector< Vec3f > &values ) {
+    float *toFloatArray( const vector< Vec3f > &values,
+                         vector< float > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      float *v = new float[ size * 3 ];
+      buffer.resize( size * 3 );
+      float *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Vec3f &a = values[i];
         v[i*3] = a.x;
@@ -128,9 +140,11 @@ namespace H3D {
     }
 
     
-    float *toFloatArray( const vector< Vec4f > &values ) {
+    float *toFloatArray( const vector< Vec4f > &values,
+                         vector< float > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      float *v = new float[ size * 4 ];
+      buffer.resize( size * 4 );
+      float *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Vec4f &a = values[i];
         v[i*4] = a.x;
@@ -142,9 +156,11 @@ namespace H3D {
     }
 
     
-    float *toFloatArray( const vector< Vec2d > &values ) {
+    float *toFloatArray( const vector< Vec2d > &values,
+                         vector< float > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      float *v = new float[ size * 2 ];
+      buffer.resize( size * 2 );
+      float *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Vec2d &a = values[i];
         v[i*2]   = (H3DFloat) a.x;
@@ -154,9 +170,11 @@ namespace H3D {
     }
 
     
-    float *toFloatArray( const vector< Vec3d > &values ) {
+    float *toFloatArray( const vector< Vec3d > &values,
+                         vector< float > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      float *v = new float[ size * 3 ];
+      buffer.resize( size * 3 );
+      float *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Vec3d &a = values[i];
         v[i*3] =   (H3DFloat)a.x;
@@ -167,9 +185,11 @@ namespace H3D {
     }
 
     
-    float *toFloatArray( const vector< Vec4d > &values ) {
+    float *toFloatArray( const vector< Vec4d > &values,
+                         vector< float > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      float *v = new float[ size * 4 ];
+      buffer.resize( size * 4 );
+      float *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Vec4d &a = values[i];
         v[i*4]   = (H3DFloat) a.x;
@@ -181,9 +201,11 @@ namespace H3D {
     }
 
     
-    float *toFloatArray( const vector< Rotation > &values ) {
+    float *toFloatArray( const vector< Rotation > &values,
+                         vector< float > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      float *v = new float[ size * 4 ];
+      buffer.resize( size * 4 );
+      float *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Rotation &r = values[i];
         v[i*4]   = (H3DFloat) r.axis.x;
@@ -195,9 +217,11 @@ namespace H3D {
     }
 
     
-    float *toFloatArray( const vector< RGB > &values ) {
+    float *toFloatArray( const vector< RGB > &values,
+                         vector< float > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      float *v = new float[ size * 3 ];
+      buffer.resize( size * 3 );
+      float *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const RGB &r = values[i];
         v[i*3]   = (H3DFloat) r.r;
@@ -208,9 +232,11 @@ namespace H3D {
     }
 
     
-    float *toFloatArray( const vector< RGBA > &values ) {
+    float *toFloatArray( const vector< RGBA > &values,
+                         vector< float > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      float *v = new float[ size * 4 ];
+      buffer.resize( size * 4 );
+      float *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const RGBA &r = values[i];
         v[i*4]   = (H3DFloat) r.r;
@@ -222,9 +248,11 @@ namespace H3D {
     }
 
     
-    float *toFloatArray( const vector< Matrix3f > &values ) {
+    float *toFloatArray( const vector< Matrix3f > &values,
+                         vector< float > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      float *v = new float[ size * 9 ];
+      buffer.resize( size * 9 );
+      float *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Matrix3f &m = values[i];
         v[i*9]   = (H3DFloat) m[0][0];
@@ -241,9 +269,11 @@ namespace H3D {
     }
 
     
-    float *toFloatArray( const vector< Matrix4f > &values ) {
+    float *toFloatArray( const vector< Matrix4f > &values,
+                         vector< float > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      float *v = new float[ size * 16 ];
+      buffer.resize( size * 16 );
+      float *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Matrix4f &m = values[i];
         v[i*16]   = (H3DFloat) m[0][0];
@@ -268,18 +298,50 @@ namespace H3D {
 
 
 
+    float *toFloatArray( const vector< Matrix3d > &values,
+                         vector< float > &buffer ) {
+      unsigned int size = (unsigned int) values.size();
+      buffer.resize( size * 9 );
+      float *v = buffer.empty() ? NULL : &buffer[0];
+      for( unsigned int i = 0; i < size; ++i ) {
+        const Matrix3d &m = values[i];
+        for( unsigned int c = 0; c < 3; ++c ) 
+          for( unsigned int r = 0; r < 3; ++r ) 
+            v[i*9+c*3+r] = (H3DFloat) m[r][c];
+      }
+      return v;
+    }
+
+    float *toFloatArray( const vector< Matrix4d > &values,
+                         vector< float > &buffer ) {
+      unsigned int size = (unsigned int) values.size();
+      buffer.resize( size * 16 );
+      float *v = buffer.empty() ? NULL : &buffer[0];
+      for( unsigned int i = 0; i < size; ++i ) {
+        const Matrix4d &m = values[i];
+        for( unsigned int c = 0; c < 4; ++c ) 
+          for( unsigned int r = 0; r < 4; ++r ) 
+            v[i*16+c*4+r] = (H3DFloat) m[r][c];
+      }
+      return v;
+    }
+
     template< class Type >
-    double *toDoubleArray( const vector< Type > &values ) {
+    double *toDoubleArray( const vector< Type > &values,
+                           vector< double > &buffer ) {
       unsigned int size = (unsigned int)values.size();
-      double *v = new double[ size ];
+      buffer.resize( size );
+      double *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) 
         v[i] = (double) values[i];
       return v;
     }
 
-    double *toDoubleArray( const vector< Vec2f > &values ) {
+    double *toDoubleArray( const vector< Vec2f > &values,
+                           vector< double > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      double *v = new double[ size * 2 ];
+      buffer.resize( size * 2 );
+      double *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Vec2f &a = values[i];
         v[i*2] = a.x;
@@ -289,9 +351,11 @@ namespace H3D {
     }
 
     
-    double *toDoubleArray( const vector< Vec3f > &values ) {
+    double *toDoubleArray( const vector< Vec3f > &values,
+                           vector< double > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      double *v = new double[ size * 3 ];
+      buffer.resize( size * 3 );
+      double *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Vec3f &a = values[i];
         v[i*3] = a.x;
@@ -302,9 +366,11 @@ namespace H3D {
     }
 
     
-    double *toDoubleArray( const vector< Vec4f > &values ) {
+    double *toDoubleArray( const vector< Vec4f > &values,
+                           vector< double > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      double *v = new double[ size * 4 ];
+      buffer.resize( size * 4 );
+      double *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Vec4f &a = values[i];
         v[i*4] = a.x;
@@ -316,9 +382,11 @@ namespace H3D {
     }
 
     
-    double *toDoubleArray( const vector< Vec2d > &values ) {
+    double *toDoubleArray( const vector< Vec2d > &values,
+                           vector< double > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      double *v = new double[ size * 2 ];
+      buffer.resize( size * 2 );
+      double *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Vec2d &a = values[i];
         v[i*2]   = (H3DDouble) a.x;
@@ -328,9 +396,11 @@ namespace H3D {
     }
 
     
-    double *toDoubleArray( const vector< Vec3d > &values ) {
+    double *toDoubleArray( const vector< Vec3d > &values,
+                           vector< double > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      double *v = new double[ size * 3 ];
+      buffer.resize( size * 3 );
+      double *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Vec3d &a = values[i];
         v[i*3] =   (H3DDouble)a.x;
@@ -341,9 +411,11 @@ namespace H3D {
     }
 
     
-    double *toDoubleArray( const vector< Vec4d > &values ) {
+    double *toDoubleArray( const vector< Vec4d > &values,
+                           vector< double > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      double *v = new double[ size * 4 ];
+      buffer.resize( size * 4 );
+      double *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Vec4d &a = values[i];
         v[i*4]   = (H3DDouble) a.x;
@@ -355,9 +427,11 @@ namespace H3D {
     }
 
     
-    double *toDoubleArray( const vector< Rotation > &values ) {
+    double *toDoubleArray( const vector< Rotation > &values,
+                           vector< double > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      double *v = new double[ size * 4 ];
+      buffer.resize( size * 4 );
+      double *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Rotation &r = values[i];
         v[i*4]   = (H3DDouble) r.axis.x;
@@ -369,9 +443,11 @@ namespace H3D {
     }
 
     
-    double *toDoubleArray( const vector< RGB > &values ) {
+    double *toDoubleArray( const vector< RGB > &values,
+                           vector< double > &buffer ) {
       unsigned int size =(unsigned int)  values.size();
-      double *v = new double[ size * 3 ];
+      buffer.resize( size * 3 );
+      double *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const RGB &r = values[i];
         v[i*3]   = (H3DDouble) r.r;
@@ -382,9 +458,11 @@ namespace H3D {
     }
 
     
-    double *toDoubleArray( const vector< RGBA > &values ) {
+    double *toDoubleArray( const vector< RGBA > &values,
+                           vector< double > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      double *v = new double[ size * 4 ];
+      buffer.resize( size * 4 );
+      double *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const RGBA &r = values[i];
         v[i*4]   = (H3DDouble) r.r;
@@ -396,9 +474,11 @@ namespace H3D {
     }
 
     
-    double *toDoubleArray( const vector< Matrix3f > &values ) {
+    double *toDoubleArray( const vector< Matrix3f > &values,
+                           vector< double > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      double *v = new double[ size * 9 ];
+      buffer.resize( size * 9 );
+      double *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Matrix3f &m = values[i];
         v[i*9]   = (H3DDouble) m[0][0];
@@ -415,34 +495,38 @@ namespace H3D {
     }
 
     
-    double *toDoubleArray( const vector< Matrix4f > &values ) {
+    double *toDoubleArray( const vector< Matrix4f > &values,
+                           vector< double > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      double *v = new double[ size * 16 ];
+      buffer.resize( size * 16 );
+      double *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Matrix4f &m = values[i];
-        v[i*9]   = (H3DDouble) m[0][0];
-        v[i*9+1] = (H3DDouble) m[1][0];
-        v[i*9+2] = (H3DDouble) m[2][0];
-        v[i*9+3] = (H3DDouble) m[3][0];
-        v[i*9+4] = (H3DDouble) m[0][1];
-        v[i*9+5] = (H3DDouble) m[1][1];
-        v[i*9+6] = (H3DDouble) m[2][1];
-        v[i*9+7] = (H3DDouble) m[3][1];
-        v[i*9+8] = (H3DDouble) m[0][2];
-        v[i*9+9] = (H3DDouble) m[1][2];
-        v[i*9+10] = (H3DDouble) m[2][2];
-        v[i*9+11] = (H3DDouble) m[3][2];
-        v[i*9+12] = (H3DDouble) m[0][3];        
-        v[i*9+13] = (H3DDouble) m[1][3];
-        v[i*9+14] = (H3DDouble) m[2][3];
-        v[i*9+15] = (H3DDouble) m[3][3];
+        v[i*16]   = (H3DDouble) m[0][0];
+        v[i*16+1] = (H3DDouble) m[1][0];
+        v[i*16+2] = (H3DDouble) m[2][0];
+        v[i*16+3] = (H3DDouble) m[3][0];
+        v[i*16+4] = (H3DDouble) m[0][1];
+        v[i*16+5] = (H3DDouble) m[1][1];
+        v[i*16+6] = (H3DDouble) m[2][1];
+        v[i*16+7] = (H3DDouble) m[3][1];
+        v[i*16+8] = (H3DDouble) m[0][2];
+        v[i*16+9] = (H3DDouble) m[1][2];
+        v[i*16+10] = (H3DDouble) m[2][2];
+        v[i*16+11] = (H3DDouble) m[3][2];
+        v[i*16+12] = (H3DDouble) m[0][3];
+        v[i*16+13] = (H3DDouble) m[1][3];
+        v[i*16+14] = (H3DDouble) m[2][3];
+        v[i*16+15] = (H3DDouble) m[3][3];
       }
       return v;
     }
 
-    double *toDoubleArray( const vector< Matrix3d > &values ){
+    double *toDoubleArray( const vector< Matrix3d > &values,
+                           vector< double > &buffer ) {
       unsigned int size = ( unsigned int ) values.size();
-      double *v = new double[ size * 9 ];
+      buffer.resize( size * 9 );
+      double *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Matrix3d &m = values[i];
         v[i*9]   = m[0][0];
@@ -458,43 +542,108 @@ namespace H3D {
       return v;
     }
 
-    double *toDoubleArray( const vector< Matrix4d > &values ){
+    double *toDoubleArray( const vector< Matrix4d > &values,
+                           vector< double > &buffer ) {
       unsigned int size = (unsigned int) values.size();
-      double *v = new double[ size * 16 ];
+      buffer.resize( size * 16 );
+      double *v = buffer.empty() ? NULL : &buffer[0];
       for( unsigned int i = 0; i < size; ++i ) {
         const Matrix4d &m = values[i];
-        v[i*9]   = m[0][0];
-        v[i*9+1] = m[1][0];
-        v[i*9+2] = m[2][0];
-        v[i*9+3] = m[3][0];
-        v[i*9+4] = m[0][1];
-        v[i*9+5] = m[1][1];
-        v[i*9+6] = m[2][1];
-        v[i*9+7] = m[3][1];
-        v[i*9+8] = m[0][2];
-        v[i*9+9] = m[1][2];
-        v[i*9+10] = m[2][2];
-        v[i*9+11] = m[3][2];
-        v[i*9+12] = m[0][3];        
-        v[i*9+13] = m[1][3];
-        v[i*9+14] = m[2][3];
-        v[i*9+15] = m[3][3];
+        v[i*16]   = m[0][0];
+        v[i*16+1] = m[1][0];
+        v[i*16+2] = m[2][0];
+        v[i*16+3] = m[3][0];
+        v[i*16+4] = m[0][1];
+        v[i*16+5] = m[1][1];
+        v[i*16+6] = m[2][1];
+        v[i*16+7] = m[3][1];
+        v[i*16+8] = m[0][2];
+        v[i*16+9] = m[1][2];
+        v[i*16+10] = m[2][2];
+        v[i*16+11] = m[3][2];
+        v[i*16+12] = m[0][3];        
+        v[i*16+13] = m[1][3];
+        v[i*16+14] = m[2][3];
+        v[i*16+15] = m[3][3];
       }
       return v;
     }
+
+    // Buffers reused when converting field values to arrays, so that no
+    // memory is allocated each time a uniform is set.
+    vector< float > float_buffer;
+    vector< GLint > int_buffer;
+    vector< double > double_buffer;
+    vector< GLuint64 > handle_buffer;
+
+    // The cached uniform locations of a GLSL program and the values last
+    // set for them.
+    struct ProgramUniforms {
+      struct Value {
+        Value() : generation( 0 ) {}
+        // The value of uniform_generation when the value was set.
+        unsigned int generation;
+        vector< unsigned char > data;
+      };
+
+      std::map< string, GLint > locations;
+      std::map< GLint, Value > values;
+    };
+
+    std::map< GLhandleARB, ProgramUniforms > program_uniforms;
+
+    // Incremented by invalidateUniformValues() to make all values in
+    // program_uniforms out of date.
+    unsigned int uniform_generation = 1;
+
+    // Returns true if the value has to be sent to the uniform location,
+    // i.e. if it is not the value last set for it or force is true. The
+    // value is remembered as the last value set. Values are always sent
+    // while building display lists since the list must contain them.
+    bool needsUpload( GLhandleARB program_handle, GLint location,
+                      const void *data, size_t size, bool force ) {
+      ProgramUniforms::Value &last = 
+        program_uniforms[ program_handle ].values[ location ];
+      const unsigned char *d = static_cast< const unsigned char * >( data );
+      if( !force && !GLStateTracker::isBuildingDisplayList() &&
+          last.generation == uniform_generation &&
+          last.data.size() == size &&
+          std::equal( d, d + size, last.data.begin() ) ) {
+        return false;
+      }
+      last.generation = uniform_generation;
+      last.data.assign( d, d + size );
+      return true;
+    }
   }
 }
 
 
+GLint H3D::Shaders::getUniformLocation( GLhandleARB program_handle,
+                                        const string &name ) {
+  ProgramUniforms &p = program_uniforms[ program_handle ];
+  std::map< string, GLint >::iterator i = p.locations.find( name );
+  if( i != p.locations.end() ) return i->second;
+  GLint location = glGetUniformLocationARB( program_handle, name.c_str() );
+  p.locations[ name ] = location;
+  return location;
+}
+
+void H3D::Shaders::clearUniformCache( GLhandleARB program_handle ) {
+  program_uniforms.erase( program_handle );
+}
+
+void H3D::Shaders::invalidateUniformValues() {
+  ++uniform_generation;
+}
+
 /// Set the value of a uniform variable in the current GLSL shader.
 /// The name of the uniform variable is the same as the name of the field. 
 bool H3D::Shaders::setGLSLUniformVariableValue( GLhandleARB program_handle,
                                                 Field *field, UniformInfo* ui, bool force ) {
   GLint location = -1;
   if( !ui ) {// no extra uniform info was set, need to extract location based on name
-    const string &name = field->getName();
-    location = glGetUniformLocationARB( program_handle,
-      name.c_str() );
+    location = getUniformLocation( program_handle, field->getName() );
   } else
   {
     location = ui->location;
@@ -514,286 +663,194 @@ bool H3D::Shaders::setGLSLUniformVariableValue( GLhandleARB program_handle,
     }
     return false;
   }
+
+  // Each value is only sent if it differs from the value last set for the
+  // location in this program. This replaces the SFUniform::actualChanged
+  // check, which only worked for SFUniform fields.
   X3DTypes::X3DType x3d_type = field->getX3DType();
   switch(x3d_type)
   {
   case X3DTypes::SFFLOAT:
     {
-      // implicit SFUniform field, check actualChanged
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFFloat > * f = static_cast< SFUniform< SFFloat >* >( field );
-        if( f->actualChanged ) {
-          glUniform1fARB( location, f->getValue() );
-        }
-        break;
-      }
-      // normal X3D field, always set uniform value
-      SFFloat* f = static_cast<SFFloat*>(field);
-      glUniform1fARB( location, f->getValue() );
+      GLfloat v = static_cast< SFFloat * >( field )->getValue();
+      if( needsUpload( program_handle, location, &v, sizeof( v ), force ) )
+        glUniform1fARB( location, v );
       break;
     }
   case X3DTypes::MFFLOAT:
     {
       MFFloat *f = static_cast< MFFloat * >( field );
-      GLfloat *v = toFloatArray( f->getValue() );
-      glUniform1fvARB( location, f->size(), v );
-      delete[] v;
+      GLfloat *v = toFloatArray( f->getValue(), float_buffer );
+      if( needsUpload( program_handle, location, v,
+                       float_buffer.size() * sizeof( GLfloat ), force ) )
+        glUniform1fvARB( location, f->size(), v );
       break;
     }
   case X3DTypes::SFDOUBLE:
     {
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFDouble > * f = static_cast< SFUniform< SFDouble >* >( field );
-        if( f->actualChanged ) {
-          glUniform1fARB( location, (GLfloat)f->getValue() );
-        }
-        break;
-      }
-      SFDouble* f = static_cast<SFDouble*>(field);
-      glUniform1fARB( location, (GLfloat)f->getValue() );
+      GLfloat v = (GLfloat)static_cast< SFDouble * >( field )->getValue();
+      if( needsUpload( program_handle, location, &v, sizeof( v ), force ) )
+        glUniform1fARB( location, v );
       break;
     }
   case X3DTypes::MFDOUBLE:
     {
       MFDouble *f = static_cast< MFDouble * >( field );
-      GLfloat *v = toFloatArray( f->getValue() );
-      glUniform1fvARB( location, f->size(), v );
-      delete[] v;
+      GLfloat *v = toFloatArray( f->getValue(), float_buffer );
+      if( needsUpload( program_handle, location, v,
+                       float_buffer.size() * sizeof( GLfloat ), force ) )
+        glUniform1fvARB( location, f->size(), v );
       break;
     }
   case X3DTypes::SFTIME:
     { 
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFTime > * f = static_cast< SFUniform< SFTime >* >( field );
-        if( f->actualChanged ) {
-          glUniform1fARB( location, (GLfloat)f->getValue() );
-        }
-        break;
-      }
-      glUniform1fARB( location, (GLfloat)static_cast<SFTime*>(field)->getValue() );
+      GLfloat v = (GLfloat)static_cast< SFTime * >( field )->getValue();
+      if( needsUpload( program_handle, location, &v, sizeof( v ), force ) )
+        glUniform1fARB( location, v );
       break;
     }
   case X3DTypes::MFTIME:
     {
       MFTime *f = static_cast< MFTime * >( field );
-      GLfloat *v = toFloatArray( f->getValue() );
-      glUniform1fvARB( location, f->size(), v );
-      delete[] v;
+      GLfloat *v = toFloatArray( f->getValue(), float_buffer );
+      if( needsUpload( program_handle, location, v,
+                       float_buffer.size() * sizeof( GLfloat ), force ) )
+        glUniform1fvARB( location, f->size(), v );
       break;
     }
   case X3DTypes::SFINT32:
     {
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFInt32 > * f = static_cast< SFUniform< SFInt32 >* >( field );
-        if( f->actualChanged ) {
-          glUniform1iARB( location, f->getValue() );
-        }
-        break;
-      }
-      glUniform1iARB( location, static_cast<SFInt32*>(field)->getValue() );
+      GLint v = static_cast< SFInt32 * >( field )->getValue();
+      if( needsUpload( program_handle, location, &v, sizeof( v ), force ) )
+        glUniform1iARB( location, v );
       break;
     }
   case X3DTypes::MFINT32:
     {
       MFInt32 *f = static_cast< MFInt32 * >( field );
-      GLint *v = toIntArray( f->getValue() );
-      glUniform1ivARB( location, f->size(), v );
-      delete[] v;
+      GLint *v = toIntArray( f->getValue(), int_buffer );
+      if( needsUpload( program_handle, location, v,
+                       int_buffer.size() * sizeof( GLint ), force ) )
+        glUniform1ivARB( location, f->size(), v );
       break;
     }
   case X3DTypes::SFVEC2F:
     {
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFVec2f > * f = static_cast< SFUniform< SFVec2f >* >( field );
-        if( f->actualChanged ) {
-          const Vec2f &v = f->getValue(); 
-          glUniform2fARB( location, 
-            (GLfloat)v.x,
-            (GLfloat)v.y );
-        }
-        break;
-      }
-      SFVec2f *f = static_cast< SFVec2f * >( field );
-      const Vec2f &v = f->getValue(); 
-      glUniform2fARB( location, 
-                    (GLfloat)v.x,
-                    (GLfloat)v.y );
+      const Vec2f &a = static_cast< SFVec2f * >( field )->getValue();
+      GLfloat v[] = { (GLfloat)a.x, (GLfloat)a.y };
+      if( needsUpload( program_handle, location, v, sizeof( v ), force ) )
+        glUniform2fvARB( location, 1, v );
       break;
     }
   case X3DTypes::MFVEC2F:
     {
       MFVec2f *f = static_cast< MFVec2f * >( field );
-      GLfloat *v = toFloatArray( f->getValue() );
-      glUniform2fvARB( location, f->size(), v );
-      delete[] v;
+      GLfloat *v = toFloatArray( f->getValue(), float_buffer );
+      if( needsUpload( program_handle, location, v,
+                       float_buffer.size() * sizeof( GLfloat ), force ) )
+        glUniform2fvARB( location, f->size(), v );
       break;
     }
   case X3DTypes::SFVEC2D:
     {
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFVec2d > * f = static_cast< SFUniform< SFVec2d >* >( field );
-        if( f->actualChanged ) {
-          const Vec2d &v = f->getValue(); 
-          glUniform2fARB( location, 
-            (GLfloat)v.x,
-            (GLfloat)v.y );
-        }
-        break;
-      }
-      SFVec2d *f = static_cast< SFVec2d * >( field );
-      const Vec2d &v = f->getValue(); 
-      glUniform2fARB( location, 
-                    (GLfloat)v.x,
-                    (GLfloat)v.y );
+      const Vec2d &a = static_cast< SFVec2d * >( field )->getValue();
+      GLfloat v[] = { (GLfloat)a.x, (GLfloat)a.y };
+      if( needsUpload( program_handle, location, v, sizeof( v ), force ) )
+        glUniform2fvARB( location, 1, v );
       break;
     }
   case X3DTypes::MFVEC2D:
     {
       MFVec2d *f = static_cast< MFVec2d * >( field );
-      GLfloat *v = toFloatArray( f->getValue() );
-      glUniform2fvARB( location, f->size(), v );
-      delete[] v;
+      GLfloat *v = toFloatArray( f->getValue(), float_buffer );
+      if( needsUpload( program_handle, location, v,
+                       float_buffer.size() * sizeof( GLfloat ), force ) )
+        glUniform2fvARB( location, f->size(), v );
       break;
     }
   case X3DTypes::SFVEC3F:
     {
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFVec3f > * f = static_cast< SFUniform< SFVec3f >* >( field );
-        if( f->actualChanged ) {
-          const Vec3f &v = f->getValue(); 
-          glUniform3fARB( location, 
-            (GLfloat)v.x,
-            (GLfloat)v.y,
-            (GLfloat)v.z );
-        }
-        break;
-      }
-      SFVec3f *f = static_cast< SFVec3f * >( field );
-      const Vec3f &v = f->getValue(); 
-      glUniform3fARB( location, 
-                    (GLfloat)v.x,
-                    (GLfloat)v.y,
-                    (GLfloat)v.z );
+      const Vec3f &a = static_cast< SFVec3f * >( field )->getValue();
+      GLfloat v[] = { (GLfloat)a.x, (GLfloat)a.y, (GLfloat)a.z };
+      if( needsUpload( program_handle, location, v, sizeof( v ), force ) )
+        glUniform3fvARB( location, 1, v );
       break;
     }
   case X3DTypes::MFVEC3F:
     {
       MFVec3f *f = static_cast< MFVec3f * >( field );
-      GLfloat *v = toFloatArray( f->getValue() );
-      glUniform3fvARB( location, f->size(), v );
-      delete[] v;
+      GLfloat *v = toFloatArray( f->getValue(), float_buffer );
+      if( needsUpload( program_handle, location, v,
+                       float_buffer.size() * sizeof( GLfloat ), force ) )
+        glUniform3fvARB( location, f->size(), v );
       break;
     }
   case X3DTypes::SFVEC3D:
     {
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFVec3d > * f = static_cast< SFUniform< SFVec3d >* >( field );
-        if( f->actualChanged ) {
-          const Vec3d &v = f->getValue(); 
-          glUniform3fARB( location, 
-            (GLfloat)v.x,
-            (GLfloat)v.y,
-            (GLfloat)v.z );
-        }
-        break;
-      }
-      SFVec3d *f = static_cast< SFVec3d * >( field );
-      const Vec3d &v = f->getValue(); 
-      glUniform3fARB( location, 
-                    (GLfloat)v.x,
-                    (GLfloat)v.y,
-                    (GLfloat)v.z );
+      const Vec3d &a = static_cast< SFVec3d * >( field )->getValue();
+      GLfloat v[] = { (GLfloat)a.x, (GLfloat)a.y, (GLfloat)a.z };
+      if( needsUpload( program_handle, location, v, sizeof( v ), force ) )
+        glUniform3fvARB( location, 1, v );
       break;
     }
   case X3DTypes::MFVEC3D:
     {
       MFVec3d *f = static_cast< MFVec3d * >( field );
-      GLfloat *v = toFloatArray( f->getValue() );
-      glUniform3fvARB( location, f->size(), v );
-      delete[] v;
+      GLfloat *v = toFloatArray( f->getValue(), float_buffer );
+      if( needsUpload( program_handle, location, v,
+                       float_buffer.size() * sizeof( GLfloat ), force ) )
+        glUniform3fvARB( location, f->size(), v );
       break;
     }
   case X3DTypes::SFVEC4F:
     {
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFVec4f > * f = static_cast< SFUniform< SFVec4f >* >( field );
-        if( f->actualChanged ) {
-          const Vec4f &v = f->getValue(); 
-          glUniform4fARB( location, 
-            (GLfloat)v.x,
-            (GLfloat)v.y,
-            (GLfloat)v.z,
-            (GLfloat)v.w  );
-        }
-        break;
-      }
-      SFVec4f *f = static_cast< SFVec4f * >( field );
-      const Vec4f &v = f->getValue(); 
-      glUniform4fARB( location, 
-                    (GLfloat)v.x,
-                    (GLfloat)v.y,
-                    (GLfloat)v.z,
-                    (GLfloat)v.w  );
+      const Vec4f &a = static_cast< SFVec4f * >( field )->getValue();
+      GLfloat v[] = { (GLfloat)a.x, (GLfloat)a.y, (GLfloat)a.z, (GLfloat)a.w };
+      if( needsUpload( program_handle, location, v, sizeof( v ), force ) )
+        glUniform4fvARB( location, 1, v );
       break;
     }
   case X3DTypes::MFVEC4F:
     {
       MFVec4f *f = static_cast< MFVec4f * >( field );
-      GLfloat *v = toFloatArray( f->getValue() );
-      glUniform4fvARB( location, f->size(), v );
-      delete[] v;
+      GLfloat *v = toFloatArray( f->getValue(), float_buffer );
+      if( needsUpload( program_handle, location, v,
+                       float_buffer.size() * sizeof( GLfloat ), force ) )
+        glUniform4fvARB( location, f->size(), v );
       break;
     }
   case X3DTypes::SFVEC4D:
     {
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFVec4d > * f = static_cast< SFUniform< SFVec4d >* >( field );
-        if( f->actualChanged ) {
-          const Vec4d &v = f->getValue(); 
-          glUniform4fARB( location, 
-            (GLfloat)v.x,
-            (GLfloat)v.y,
-            (GLfloat)v.z,
-            (GLfloat)v.w  );
-        }
-        break;
-      }
-      SFVec4d *f = static_cast< SFVec4d * >( field );
-      const Vec4d &v = f->getValue(); 
-      glUniform4fARB( location, 
-                    (GLfloat)v.x,
-                    (GLfloat)v.y,
-                    (GLfloat)v.z,
-                    (GLfloat)v.w  );
+      const Vec4d &a = static_cast< SFVec4d * >( field )->getValue();
+      GLfloat v[] = { (GLfloat)a.x, (GLfloat)a.y, (GLfloat)a.z, (GLfloat)a.w };
+      if( needsUpload( program_handle, location, v, sizeof( v ), force ) )
+        glUniform4fvARB( location, 1, v );
       break;
     }
   case X3DTypes::MFVEC4D:
     {
       MFVec4d *f = static_cast< MFVec4d * >( field );
-      GLfloat *v = toFloatArray( f->getValue() );
-      glUniform4fvARB( location, f->size(), v );
-      delete[] v;
+      GLfloat *v = toFloatArray( f->getValue(), float_buffer );
+      if( needsUpload( program_handle, location, v,
+                       float_buffer.size() * sizeof( GLfloat ), force ) )
+        glUniform4fvARB( location, f->size(), v );
       break;
     }
   case X3DTypes::SFBOOL:
     {
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFBool > * f = static_cast< SFUniform< SFBool >* >( field );
-        if( f->actualChanged ) {
-          glUniform1iARB( location, f->getValue() );
-        }
-        break;
-      }
-      glUniform1iARB( location, static_cast<SFBool*>(field)->getValue() );
+      GLint v = static_cast< SFBool * >( field )->getValue();
+      if( needsUpload( program_handle, location, &v, sizeof( v ), force ) )
+        glUniform1iARB( location, v );
       break;
     }
 
   case X3DTypes::MFBOOL:
     {
       MFBool *f = static_cast<MFBool*>(field);
-      GLint *v = toIntArray( f->getValue() );
-      glUniform1ivARB( location, f->size(), v );
-      delete[] v;
+      GLint *v = toIntArray( f->getValue(), int_buffer );
+      if( needsUpload( program_handle, location, v,
+                       int_buffer.size() * sizeof( GLint ), force ) )
+        glUniform1ivARB( location, f->size(), v );
       break;
     }
   case X3DTypes::SFSTRING: return false;
@@ -805,19 +862,24 @@ bool H3D::Shaders::setGLSLUniformVariableValue( GLhandleARB program_handle,
       if( n == NULL ) return true;
       if (ShaderImageNode* si = dynamic_cast<ShaderImageNode*>(n))
       {
-        glUniform1iARB(location, si->getImageUnit());
+        GLint v = si->getImageUnit();
+        if( needsUpload( program_handle, location, &v, sizeof( v ), force ) )
+          glUniform1iARB( location, v );
         break;
       } else if( H3DSingleTextureNode *t = dynamic_cast< H3DSingleTextureNode *>( n ) ) 
       {
 #ifdef GL_ARB_bindless_texture
         if ( X3DProgrammableShaderObject::use_bindless_textures ) {
           GLuint64 h= t->getTextureHandle();
-          if ( h != 0 ) {
+          if ( h != 0 &&
+               needsUpload( program_handle, location, &h, sizeof( h ), force ) ) {
             glUniformHandleui64ARB ( location, h );
           }
         } else {
 #endif
-          glUniform1iARB( location, t->getTextureUnit() - GL_TEXTURE0_ARB );
+          GLint v = t->getTextureUnit() - GL_TEXTURE0_ARB;
+          if( needsUpload( program_handle, location, &v, sizeof( v ), force ) )
+            glUniform1iARB( location, v );
 #ifdef GL_ARB_bindless_texture
         }
 #endif
@@ -831,8 +893,11 @@ bool H3D::Shaders::setGLSLUniformVariableValue( GLhandleARB program_handle,
     {
       MFNode *f = static_cast< MFNode * >( field );
       unsigned int size = f->size();
-      GLint *v = NULL;
-      GLuint64 *b = NULL;
+      if( size == 0 ) break;
+      bool have_units = false;
+      bool have_handles = false;
+      int_buffer.assign( size, 0 );
+      handle_buffer.assign( size, 0 );
       for( unsigned int i = 0; i < size; ++i ) 
       {
         Node *n = f->getValueByIndex( i ); 
@@ -841,257 +906,171 @@ bool H3D::Shaders::setGLSLUniformVariableValue( GLhandleARB program_handle,
         {
           if ( X3DProgrammableShaderObject::use_bindless_textures ) {
             GLuint64 h= t->getTextureHandle();
-            if ( h != 0 ) {
-              if ( !b ) b= new GLuint64 [ size ];
-              b[i] = h;
-            } else {
-              delete[] b;
-              b= NULL;
-              break; // come back when you have a handle
+            if ( h == 0 ) {
+              return true; // come back when you have a handle
             }
+            handle_buffer[i] = h;
+            have_handles = true;
           } else {
-            if ( !v ) v= new GLint [ size ];
-            v[i] = t->getTextureUnit() - GL_TEXTURE0_ARB;
+            int_buffer[i] = t->getTextureUnit() - GL_TEXTURE0_ARB;
+            have_units = true;
           }
-
-          
         } 
         else if ( ShaderImageNode* si = dynamic_cast< ShaderImageNode* >( n ) )
         {
-          if ( !v ) v= new GLint [ size ];
-          v[i] = si->getImageUnit ( );
+          int_buffer[i] = si->getImageUnit ( );
+          have_units = true;
         }
         else 
         {
-          delete [] v;
-          delete [] b;
           return false;
         }
       }
 
-      if ( v && b ) {
+      if ( have_units && have_handles ) {
         Console(LogLevel::Error) << "ERROR: You cannot mix H3DSingleTextureNode and ShaderImageNode in the "
           "same MFNode shader field when using bindless textures!" << endl;
         return false;
-      } else if ( v ) {
-        glUniform1ivARB( location, size, v );
-        delete[] v;
-      } else if ( b ) {
+      } else if ( have_units ) {
+        if( needsUpload( program_handle, location, &int_buffer[0],
+                         size * sizeof( GLint ), force ) )
+          glUniform1ivARB( location, size, &int_buffer[0] );
+      } else if ( have_handles ) {
 #ifdef GL_ARB_bindless_texture
-        glUniformHandleui64vARB ( location, size, b );
+        if( needsUpload( program_handle, location, &handle_buffer[0],
+                         size * sizeof( GLuint64 ), force ) )
+          glUniformHandleui64vARB ( location, size, &handle_buffer[0] );
 #endif
-        delete[] b;
       }
       
       break;
     }
   case X3DTypes::SFCOLOR:
     {
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFColor > * f = static_cast< SFUniform< SFColor >* >( field );
-        if( f->actualChanged ) {
-          const RGB &r = f->getValue(); 
-          glUniform3fARB( location, 
-            (GLfloat)r.r,
-            (GLfloat)r.g,
-            (GLfloat)r.b );
-        }
-        break;
-      }
-      SFColor *f = static_cast< SFColor * >( field );
-      const RGB &r = f->getValue(); 
-      glUniform3fARB( location, 
-                    (GLfloat)r.r,
-                    (GLfloat)r.g,
-                    (GLfloat)r.b );
+      const RGB &r = static_cast< SFColor * >( field )->getValue();
+      GLfloat v[] = { (GLfloat)r.r, (GLfloat)r.g, (GLfloat)r.b };
+      if( needsUpload( program_handle, location, v, sizeof( v ), force ) )
+        glUniform3fvARB( location, 1, v );
       break;
     }
   case X3DTypes::MFCOLOR:
     {
       MFColor *f = static_cast< MFColor * >( field );
-      GLfloat *v = toFloatArray( f->getValue() );
-      glUniform4fvARB( location, f->size(), v );
-      delete[] v;
+      GLfloat *v = toFloatArray( f->getValue(), float_buffer );
+      if( needsUpload( program_handle, location, v,
+                       float_buffer.size() * sizeof( GLfloat ), force ) )
+        glUniform3fvARB( location, f->size(), v );
       break;
     }
   case X3DTypes::SFCOLORRGBA:
     {
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFColorRGBA > * f = static_cast< SFUniform< SFColorRGBA >* >( field );
-        if( f->actualChanged ) {
-          const RGBA &r = f->getValue(); 
-          glUniform4fARB( location, 
-            (GLfloat)r.r,
-            (GLfloat)r.g,
-            (GLfloat)r.b,
-            (GLfloat)r.a );
-        }
-        break;
-      }
-      SFColorRGBA *f = static_cast< SFColorRGBA * >( field );
-      const RGBA &r = f->getValue(); 
-      glUniform4fARB( location, 
-                    (GLfloat)r.r,
-                    (GLfloat)r.g,
-                    (GLfloat)r.b,
-                    (GLfloat)r.a );
+      const RGBA &r = static_cast< SFColorRGBA * >( field )->getValue();
+      GLfloat v[] = { (GLfloat)r.r, (GLfloat)r.g, (GLfloat)r.b, (GLfloat)r.a };
+      if( needsUpload( program_handle, location, v, sizeof( v ), force ) )
+        glUniform4fvARB( location, 1, v );
       break;
     }
   case X3DTypes::MFCOLORRGBA:
     {
       MFColorRGBA *f = static_cast< MFColorRGBA * >( field );
-      GLfloat *v = toFloatArray( f->getValue() );
-      glUniform4fvARB( location, f->size(), v );
-      delete[] v;
+      GLfloat *v = toFloatArray( f->getValue(), float_buffer );
+      if( needsUpload( program_handle, location, v,
+                       float_buffer.size() * sizeof( GLfloat ), force ) )
+        glUniform4fvARB( location, f->size(), v );
       break;
     }
   case X3DTypes::SFROTATION:
     {
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFRotation > * f = static_cast< SFUniform< SFRotation >* >( field );
-        if( f->actualChanged ) {
-          const Rotation &r = f->getValue(); 
-          glUniform4fARB( location, 
-            (GLfloat)r.axis.x,
-            (GLfloat)r.axis.y,
-            (GLfloat)r.axis.z,
-            (GLfloat)r.angle  );
-        }
-        break;
-      }
-      SFRotation *f = static_cast< SFRotation * >( field );
-      const Rotation &r = f->getValue(); 
-      glUniform4fARB( location, 
-                    (GLfloat)r.axis.x,
-                    (GLfloat)r.axis.y,
-                    (GLfloat)r.axis.z,
-                    (GLfloat)r.angle  );
+      const Rotation &r = static_cast< SFRotation * >( field )->getValue();
+      GLfloat v[] = { (GLfloat)r.axis.x, (GLfloat)r.axis.y,
+                      (GLfloat)r.axis.z, (GLfloat)r.angle };
+      if( needsUpload( program_handle, location, v, sizeof( v ), force ) )
+        glUniform4fvARB( location, 1, v );
       break;
     }
   case X3DTypes::MFROTATION:
     {
       MFRotation *f = static_cast< MFRotation * >( field );
-      GLfloat *v = toFloatArray( f->getValue() );
-      glUniform4fvARB( location, f->size(), v );
-      delete[] v;
+      GLfloat *v = toFloatArray( f->getValue(), float_buffer );
+      if( needsUpload( program_handle, location, v,
+                       float_buffer.size() * sizeof( GLfloat ), force ) )
+        glUniform4fvARB( location, f->size(), v );
       break;
     }
   case X3DTypes::SFQUATERNION: return false;
   case X3DTypes::MFQUATERNION: return false;
   case X3DTypes::SFMATRIX3F:
     {
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFMatrix3f > * f = static_cast< SFUniform< SFMatrix3f >* >( field );
-        if( f->actualChanged ) {
-          const Matrix3f &m = f->getValue(); 
-          glUniformMatrix3fvARB( location, 
-            1,
-            true,
-            m[0] );
-        }
-        break;
-      }
-      SFMatrix3f *f = static_cast< SFMatrix3f * >( field );
-      const Matrix3f &m = f->getValue(); 
-      glUniformMatrix3fvARB( location, 
-                           1,
-                           true,
-                           m[0] );
+      const Matrix3f &m = static_cast< SFMatrix3f * >( field )->getValue();
+      if( needsUpload( program_handle, location, m[0],
+                       9 * sizeof( GLfloat ), force ) )
+        glUniformMatrix3fvARB( location, 1, true, m[0] );
       break;
     }
   case X3DTypes::MFMATRIX3F:
     {
       MFMatrix3f *f = static_cast< MFMatrix3f * >( field );
-      GLfloat *v = toFloatArray( f->getValue() );
-      glUniformMatrix3fvARB( location, f->size(), false, v );
-      delete[] v;
+      GLfloat *v = toFloatArray( f->getValue(), float_buffer );
+      if( needsUpload( program_handle, location, v,
+                       float_buffer.size() * sizeof( GLfloat ), force ) )
+        glUniformMatrix3fvARB( location, f->size(), false, v );
       break;
     }
   case X3DTypes::SFMATRIX3D:
     {
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFMatrix3d > * f = static_cast< SFUniform< SFMatrix3d >* >( field );
-        if( f->actualChanged ) {
-          const Matrix3d &m = f->getValue(); 
-          glUniformMatrix3fvARB( location, 
-            1,
-            true,
-            (GLfloat*)m[0] );
-        }
-        break;
-      }
-      SFMatrix3d *f = static_cast< SFMatrix3d* >( field );
-      const Matrix3d &m = f->getValue();
-      glUniformMatrix3fvARB( location, 
-                            1,
-                            true,
-                            (GLfloat*)m[0]);
+      const Matrix3d &m = static_cast< SFMatrix3d * >( field )->getValue();
+      GLfloat v[9];
+      for( unsigned int r = 0; r < 3; ++r ) 
+        for( unsigned int c = 0; c < 3; ++c ) 
+          v[r*3+c] = (GLfloat) m[r][c];
+      if( needsUpload( program_handle, location, v, sizeof( v ), force ) )
+        glUniformMatrix3fvARB( location, 1, true, v );
       break;
     }
   case X3DTypes::MFMATRIX3D:
     {
       MFMatrix3d *f = static_cast< MFMatrix3d* >( field );
-      GLdouble* v = toDoubleArray( f->getValue() );
-      glUniformMatrix3fvARB( location, f->size(), false, (GLfloat*)v );
-      delete[] v;
+      GLfloat *v = toFloatArray( f->getValue(), float_buffer );
+      if( needsUpload( program_handle, location, v,
+                       float_buffer.size() * sizeof( GLfloat ), force ) )
+        glUniformMatrix3fvARB( location, f->size(), false, v );
       break;
     }
   case X3DTypes::SFMATRIX4F:
     {
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFMatrix4f > * f = static_cast< SFUniform< SFMatrix4f >* >( field );
-        if( f->actualChanged ) {
-          const Matrix4f &m = f->getValue(); 
-          glUniformMatrix4fvARB( location, 
-            1,
-            true,
-            m[0] );
-        }
-        break;
-      }
-      SFMatrix4f *f = static_cast< SFMatrix4f * >( field );
-      const Matrix4f &m = f->getValue(); 
-      glUniformMatrix4fvARB( location, 
-                           1,
-                           true,
-                           m[0] );
+      const Matrix4f &m = static_cast< SFMatrix4f * >( field )->getValue();
+      if( needsUpload( program_handle, location, m[0],
+                       16 * sizeof( GLfloat ), force ) )
+        glUniformMatrix4fvARB( location, 1, true, m[0] );
       break;
     }
   case X3DTypes::MFMATRIX4F:
     {
       MFMatrix4f *f = static_cast< MFMatrix4f * >( field );
-      GLfloat *v = toFloatArray( f->getValue() );
-      glUniformMatrix4fvARB( location, f->size(), false, v );
-      delete[] v;
+      GLfloat *v = toFloatArray( f->getValue(), float_buffer );
+      if( needsUpload( program_handle, location, v,
+                       float_buffer.size() * sizeof( GLfloat ), force ) )
+        glUniformMatrix4fvARB( location, f->size(), false, v );
       break;
     }
   case  X3DTypes::SFMATRIX4D:
     {
-      if( !force && field->getTypeName()=="SFUniform" ) {
-        SFUniform< SFMatrix4d > * f = static_cast< SFUniform< SFMatrix4d >* >( field );
-        if( f->actualChanged ) {
-          const Matrix4d &m = f->getValue(); 
-          glUniformMatrix4fvARB( location, 
-            1,
-            true,
-            (GLfloat*)m[0] );
-        }
-        break;
-      }
-      SFMatrix4d * f = static_cast< SFMatrix4d* >( field );
-      const Matrix4d &m = f->getValue();
-      glUniformMatrix4fvARB( location,
-                            1,
-                            true,
-                            (GLfloat*)m[0]);
+      const Matrix4d &m = static_cast< SFMatrix4d * >( field )->getValue();
+      GLfloat v[16];
+      for( unsigned int r = 0; r < 4; ++r ) 
+        for( unsigned int c = 0; c < 4; ++c ) 
+          v[r*4+c] = (GLfloat) m[r][c];
+      if( needsUpload( program_handle, location, v, sizeof( v ), force ) )
+        glUniformMatrix4fvARB( location, 1, true, v );
       break;
     }
   case X3DTypes::MFMATRIX4D:
     {
       MFMatrix4d *f = static_cast< MFMatrix4d* >( field );
-      GLdouble *v = toDoubleArray( f->getValue() );
-      glUniformMatrix4fvARB( location, f->size(), false, (GLfloat*)v );
-      delete[] v;
+      GLfloat *v = toFloatArray( f->getValue(), float_buffer );
+      if( needsUpload( program_handle, location, v,
+                       float_buffer.size() * sizeof( GLfloat ), force ) )
+        glUniformMatrix4fvARB( location, f->size(), false, v );
       break;
     }
   default:
@@ -1103,6 +1082,271 @@ bool H3D::Shaders::setGLSLUniformVariableValue( GLhandleARB program_handle,
   return glerr == GL_NO_ERROR;
 }
 
+namespace H3D {
+  namespace Shaders {
+    // Get the number of columns and rows of a uniform type and if it is
+    // stored as integers. Returns false if the type is not supported.
+    bool getUniformTypeLayout( GLenum type, unsigned int &columns,
+                               unsigned int &rows, bool &is_int ) {
+      columns = 1;
+      is_int = false;
+      switch( type ) {
+      case GL_FLOAT:             rows = 1; return true;
+      case GL_FLOAT_VEC2:        rows = 2; return true;
+      case GL_FLOAT_VEC3:        rows = 3; return true;
+      case GL_FLOAT_VEC4:        rows = 4; return true;
+      case GL_FLOAT_MAT3:        columns = 3; rows = 3; return true;
+      case GL_FLOAT_MAT4:        columns = 4; rows = 4; return true;
+      case GL_INT:
+      case GL_UNSIGNED_INT:
+      case GL_BOOL:              rows = 1; is_int = true; return true;
+      case GL_INT_VEC2:
+      case GL_BOOL_VEC2:         rows = 2; is_int = true; return true;
+      case GL_INT_VEC3:
+      case GL_BOOL_VEC3:         rows = 3; is_int = true; return true;
+      case GL_INT_VEC4:
+      case GL_BOOL_VEC4:         rows = 4; is_int = true; return true;
+      default: return false;
+      }
+    }
+
+    // Convert the value of a field to floats in float_buffer, in the
+    // same order as the values are given to glUniform. Returns the
+    // number of elements or -1 if the field type is not supported.
+    int toFloatBuffer( Field *field ) {
+      switch( field->getX3DType() ) {
+      case X3DTypes::SFFLOAT:
+        float_buffer.assign( 1, static_cast< SFFloat * >( field )->getValue() );
+        return 1;
+      case X3DTypes::SFDOUBLE:
+        float_buffer.assign( 1, (GLfloat)static_cast< SFDouble * >( field )->getValue() );
+        return 1;
+      case X3DTypes::SFTIME:
+        float_buffer.assign( 1, (GLfloat)static_cast< SFTime * >( field )->getValue() );
+        return 1;
+      case X3DTypes::SFINT32:
+        float_buffer.assign( 1, (GLfloat)static_cast< SFInt32 * >( field )->getValue() );
+        return 1;
+      case X3DTypes::SFBOOL:
+        float_buffer.assign( 1, static_cast< SFBool * >( field )->getValue() ? 1.0f : 0.0f );
+        return 1;
+      case X3DTypes::SFVEC2F: {
+        const Vec2f &v = static_cast< SFVec2f * >( field )->getValue();
+        float_buffer.resize( 2 );
+        float_buffer[0] = v.x; float_buffer[1] = v.y;
+        return 1;
+      }
+      case X3DTypes::SFVEC3F: {
+        const Vec3f &v = static_cast< SFVec3f * >( field )->getValue();
+        float_buffer.resize( 3 );
+        float_buffer[0] = v.x; float_buffer[1] = v.y; float_buffer[2] = v.z;
+        return 1;
+      }
+      case X3DTypes::SFVEC4F: {
+        const Vec4f &v = static_cast< SFVec4f * >( field )->getValue();
+        float_buffer.resize( 4 );
+        float_buffer[0] = v.x; float_buffer[1] = v.y;
+        float_buffer[2] = v.z; float_buffer[3] = v.w;
+        return 1;
+      }
+      case X3DTypes::SFCOLOR: {
+        const RGB &c = static_cast< SFColor * >( field )->getValue();
+        float_buffer.resize( 3 );
+        float_buffer[0] = c.r; float_buffer[1] = c.g; float_buffer[2] = c.b;
+        return 1;
+      }
+      case X3DTypes::SFCOLORRGBA: {
+        const RGBA &c = static_cast< SFColorRGBA * >( field )->getValue();
+        float_buffer.resize( 4 );
+        float_buffer[0] = c.r; float_buffer[1] = c.g;
+        float_buffer[2] = c.b; float_buffer[3] = c.a;
+        return 1;
+      }
+      case X3DTypes::SFROTATION: {
+        const Rotation &r = static_cast< SFRotation * >( field )->getValue();
+        float_buffer.resize( 4 );
+        float_buffer[0] = r.axis.x; float_buffer[1] = r.axis.y;
+        float_buffer[2] = r.axis.z; float_buffer[3] = r.angle;
+        return 1;
+      }
+      case X3DTypes::SFMATRIX3F:
+        toFloatArray( vector< Matrix3f >( 1, static_cast< SFMatrix3f * >( field )->getValue() ), float_buffer );
+        return 1;
+      case X3DTypes::SFMATRIX4F:
+        toFloatArray( vector< Matrix4f >( 1, static_cast< SFMatrix4f * >( field )->getValue() ), float_buffer );
+        return 1;
+      case X3DTypes::MFFLOAT: {
+        MFFloat *f = static_cast< MFFloat * >( field );
+        toFloatArray( f->getValue(), float_buffer );
+        return f->size();
+      }
+      case X3DTypes::MFINT32: {
+        MFInt32 *f = static_cast< MFInt32 * >( field );
+        toFloatArray( f->getValue(), float_buffer );
+        return f->size();
+      }
+      case X3DTypes::MFVEC2F: {
+        MFVec2f *f = static_cast< MFVec2f * >( field );
+        toFloatArray( f->getValue(), float_buffer );
+        return f->size();
+      }
+      case X3DTypes::MFVEC3F: {
+        MFVec3f *f = static_cast< MFVec3f * >( field );
+        toFloatArray( f->getValue(), float_buffer );
+        return f->size();
+      }
+      case X3DTypes::MFVEC4F: {
+        MFVec4f *f = static_cast< MFVec4f * >( field );
+        toFloatArray( f->getValue(), float_buffer );
+        return f->size();
+      }
+      case X3DTypes::MFCOLOR: {
+        MFColor *f = static_cast< MFColor * >( field );
+        toFloatArray( f->getValue(), float_buffer );
+        return f->size();
+      }
+      case X3DTypes::MFCOLORRGBA: {
+        MFColorRGBA *f = static_cast< MFColorRGBA * >( field );
+        toFloatArray( f->getValue(), float_buffer );
+        return f->size();
+      }
+      case X3DTypes::MFMATRIX3F: {
+        MFMatrix3f *f = static_cast< MFMatrix3f * >( field );
+        toFloatArray( f->getValue(), float_buffer );
+        return f->size();
+      }
+      case X3DTypes::MFMATRIX4F: {
+        MFMatrix4f *f = static_cast< MFMatrix4f * >( field );
+        toFloatArray( f->getValue(), float_buffer );
+        return f->size();
+      }
+      default:
+        return -1;
+      }
+    }
+  }
+}
+
+H3D::Shaders::UniformBlockBuffer::UniformBlockBuffer( GLhandleARB program_handle,
+                                                      GLuint block_index,
+                                                      GLuint _binding ) :
+  buffer_id( 0 ),
+  binding( _binding ),
+  dirty( true ) {
+  GLint data_size = 0;
+  glGetActiveUniformBlockiv( program_handle, block_index,
+                             GL_UNIFORM_BLOCK_DATA_SIZE, &data_size );
+  GLint nr_members = 0;
+  glGetActiveUniformBlockiv( program_handle, block_index,
+                             GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &nr_members );
+  data.resize( data_size, 0 );
+
+  if( nr_members > 0 ) {
+    vector< GLint > indices( nr_members );
+    glGetActiveUniformBlockiv( program_handle, block_index,
+                               GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES,
+                               &indices[0] );
+    vector< GLuint > uindices( indices.begin(), indices.end() );
+    vector< GLint > offsets( nr_members ), types( nr_members ),
+      sizes( nr_members ), array_strides( nr_members ),
+      matrix_strides( nr_members ), row_majors( nr_members );
+    glGetActiveUniformsiv( program_handle, nr_members, &uindices[0],
+                           GL_UNIFORM_OFFSET, &offsets[0] );
+    glGetActiveUniformsiv( program_handle, nr_members, &uindices[0],
+                           GL_UNIFORM_TYPE, &types[0] );
+    glGetActiveUniformsiv( program_handle, nr_members, &uindices[0],
+                           GL_UNIFORM_SIZE, &sizes[0] );
+    glGetActiveUniformsiv( program_handle, nr_members, &uindices[0],
+                           GL_UNIFORM_ARRAY_STRIDE, &array_strides[0] );
+    glGetActiveUniformsiv( program_handle, nr_members, &uindices[0],
+                           GL_UNIFORM_MATRIX_STRIDE, &matrix_strides[0] );
+    glGetActiveUniformsiv( program_handle, nr_members, &uindices[0],
+                           GL_UNIFORM_IS_ROW_MAJOR, &row_majors[0] );
+
+    for( GLint i = 0; i < nr_members; ++i ) {
+      GLchar name[256];
+      GLsizei length = 0;
+      glGetActiveUniformName( program_handle, uindices[i], sizeof( name ),
+                              &length, name );
+      string member_name( name, length );
+      // strip the block instance name and the array index.
+      string::size_type dot = member_name.rfind( '.' );
+      if( dot != string::npos ) member_name = member_name.substr( dot + 1 );
+      string::size_type bracket = member_name.find( '[' );
+      if( bracket != string::npos ) member_name = member_name.substr( 0, bracket );
+
+      Member m;
+      m.offset = offsets[i];
+      m.type = types[i];
+      m.array_size = sizes[i];
+      m.array_stride = array_strides[i];
+      m.matrix_stride = matrix_strides[i];
+      m.row_major = row_majors[i];
+      members[ member_name ] = m;
+    }
+  }
+
+  glUniformBlockBinding( program_handle, block_index, binding );
+  glGenBuffers( 1, &buffer_id );
+  glBindBuffer( GL_UNIFORM_BUFFER, buffer_id );
+  glBufferData( GL_UNIFORM_BUFFER, data.size(), NULL, GL_DYNAMIC_DRAW );
+  glBindBuffer( GL_UNIFORM_BUFFER, 0 );
+}
+
+H3D::Shaders::UniformBlockBuffer::~UniformBlockBuffer() {
+  if( buffer_id ) glDeleteBuffers( 1, &buffer_id );
+}
+
+bool H3D::Shaders::UniformBlockBuffer::setValue( const string &name,
+                                                 Field *field ) {
+  std::map< string, Member >::iterator i = members.find( name );
+  if( i == members.end() ) return false;
+  const Member &m = i->second;
+
+  unsigned int columns, rows;
+  bool is_int;
+  if( !getUniformTypeLayout( m.type, columns, rows, is_int ) ) return false;
+
+  int nr_elements = toFloatBuffer( field );
+  if( nr_elements < 0 ||
+      float_buffer.size() != nr_elements * columns * rows ) return false;
+
+  // vectors are written as one column, matrices column by column unless
+  // the block uses row major layout.
+  unsigned int nr_written = H3DMin( nr_elements, m.array_size );
+  GLint column_stride = m.row_major ? 4 : m.matrix_stride;
+  GLint row_stride = m.row_major ? m.matrix_stride : 4;
+  for( unsigned int e = 0; e < nr_written; ++e ) {
+    for( unsigned int c = 0; c < columns; ++c ) {
+      for( unsigned int r = 0; r < rows; ++r ) {
+        size_t offset = m.offset + e * m.array_stride +
+          c * column_stride + r * row_stride;
+        if( offset + 4 > data.size() ) return false;
+        GLfloat v = float_buffer[ ( e * columns + c ) * rows + r ];
+        if( is_int ) {
+          GLint iv = (GLint)v;
+          if( memcmp( &data[offset], &iv, 4 ) != 0 ) {
+            memcpy( &data[offset], &iv, 4 );
+            dirty = true;
+          }
+        } else if( memcmp( &data[offset], &v, 4 ) != 0 ) {
+          memcpy( &data[offset], &v, 4 );
+          dirty = true;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+void H3D::Shaders::UniformBlockBuffer::render() {
+  glBindBufferBase( GL_UNIFORM_BUFFER, binding, buffer_id );
+  if( dirty && !data.empty() ) {
+    glBufferSubData( GL_UNIFORM_BUFFER, 0, data.size(), &data[0] );
+    dirty = false;
+  }
+}
+
 #ifdef HAVE_CG
 CGprofile H3D::Shaders::cgProfileFromString( const string &profile, 
                                              const string &type ) {
@@ -1176,40 +1420,34 @@ bool H3D::Shaders::setCGUniformVariableValue( CGprogram program_handle,
   if( SFBool *f = dynamic_cast< SFBool * >( field ) ) {
     cgGLSetParameter1f( param, f->getValue() );
   } else if( MFBool *f = dynamic_cast< MFBool * >( field ) ) {
-    GLfloat *v = toFloatArray( f->getValue() );
+    GLfloat *v = toFloatArray( f->getValue(), float_buffer );
     cgGLSetParameterArray1f( param, 0, f->size(), v );
-    delete[] v;
   } else if( SFInt32 *f = dynamic_cast< SFInt32 * >( field ) ) {
     cgGLSetParameter1f( param, (GLfloat)f->getValue() );
   } else if( MFInt32 *f = dynamic_cast< MFInt32 * >( field ) ) {
-    GLfloat *v = toFloatArray( f->getValue() );
+    GLfloat *v = toFloatArray( f->getValue(), float_buffer );
     cgGLSetParameterArray1f( param, 0, f->size(), v );
-    delete[] v;
   } else if( SFFloat *f = dynamic_cast< SFFloat * >( field ) ) {
     cgGLSetParameter1f( param, f->getValue() );
   } else if( MFFloat *f = dynamic_cast< MFFloat * >( field ) ) {
-    GLfloat *v = toFloatArray( f->getValue() );
+    GLfloat *v = toFloatArray( f->getValue(), float_buffer );
     cgGLSetParameterArray1f( param, 0, f->size(), v );
-    delete[] v;
   } else if( SFDouble *f = dynamic_cast< SFDouble * >( field ) ) {
     cgGLSetParameter1f( param, (GLfloat)f->getValue() );
   } else if( MFDouble *f = dynamic_cast< MFDouble * >( field ) ) {
-    GLfloat *v = toFloatArray( f->getValue() );
+    GLfloat *v = toFloatArray( f->getValue(), float_buffer );
     cgGLSetParameterArray1f( param, 0, f->size(), v );
-    delete[] v;
   } else if( SFTime *f = dynamic_cast< SFTime * >( field ) ) {
     cgGLSetParameter1d( param, f->getValue() );
   } else if( MFTime *f = dynamic_cast< MFTime * >( field ) ) {
-    GLdouble *v = toDoubleArray( f->getValue() );
+    GLdouble *v = toDoubleArray( f->getValue(), double_buffer );
     cgGLSetParameterArray1d( param, 0, f->size(), v );
-    delete[] v;
   } else if( SFVec2f *f = dynamic_cast< SFVec2f * >( field ) ) {
     const Vec2f &v = f->getValue(); 
     cgGLSetParameter2f( param, (GLfloat)v.x, (GLfloat)v.y );
   } else if( MFVec2f *f = dynamic_cast< MFVec2f * >( field ) ) {
-    GLfloat *v = toFloatArray( f->getValue() );
+    GLfloat *v = toFloatArray( f->getValue(), float_buffer );
     cgGLSetParameterArray2f( param, 0, f->size(), v );
-    delete[] v;
   } else if( SFVec3f *f = dynamic_cast< SFVec3f * >( field ) ) {
     const Vec3f &v = f->getValue(); 
     cgGLSetParameter3f( param, 
@@ -1217,9 +1455,8 @@ bool H3D::Shaders::setCGUniformVariableValue( CGprogram program_handle,
                     (GLfloat)v.y,
                     (GLfloat)v.z );
   } else if( MFVec3f *f = dynamic_cast< MFVec3f * >( field ) ) {
-    GLfloat *v = toFloatArray( f->getValue() );
+    GLfloat *v = toFloatArray( f->getValue(), float_buffer );
     cgGLSetParameterArray3f( param, 0, f->size(), v );
-    delete[] v;
   } else if( SFVec4f *f = dynamic_cast< SFVec4f * >( field ) ) {
     const Vec4f &v = f->getValue(); 
     cgGLSetParameter4f( param, 
@@ -1228,30 +1465,26 @@ bool H3D::Shaders::setCGUniformVariableValue( CGprogram program_handle,
                     (GLfloat)v.z,
                     (GLfloat)v.w  );
   } else if( MFVec4f *f = dynamic_cast< MFVec4f * >( field ) ) {
-    GLfloat *v = toFloatArray( f->getValue() );
+    GLfloat *v = toFloatArray( f->getValue(), float_buffer );
     cgGLSetParameterArray4f( param, 0, f->size(), v );
-    delete[] v;
   } else if( SFVec2d *f = dynamic_cast< SFVec2d * >( field ) ) {
     const Vec2d &v = f->getValue(); 
     cgGLSetParameter2d( param, v.x, v.y );
   } else if( MFVec2d *f = dynamic_cast< MFVec2d * >( field ) ) {
-    GLdouble *v = toDoubleArray( f->getValue() );
+    GLdouble *v = toDoubleArray( f->getValue(), double_buffer );
     cgGLSetParameterArray2d( param, 0, f->size(), v );
-    delete[] v;
   } else if( SFVec3d *f = dynamic_cast< SFVec3d * >( field ) ) {
     const Vec3d &v = f->getValue(); 
     cgGLSetParameter3d( param, v.x, v.y, v.z );
   } else if( MFVec3d *f = dynamic_cast< MFVec3d * >( field ) ) {
-    GLdouble *v = toDoubleArray( f->getValue() );
+    GLdouble *v = toDoubleArray( f->getValue(), double_buffer );
     cgGLSetParameterArray3d( param, 0, f->size(), v );
-    delete[] v;
   } else if( SFVec4d *f = dynamic_cast< SFVec4d * >( field ) ) {
     const Vec4d &v = f->getValue(); 
     cgGLSetParameter4d( param, v.x, v.y, v.z, v.w  );
   } else if( MFVec4d *f = dynamic_cast< MFVec4d * >( field ) ) {
-    GLdouble *v = toDoubleArray( f->getValue() );
+    GLdouble *v = toDoubleArray( f->getValue(), double_buffer );
     cgGLSetParameterArray4d( param, 0, f->size(), v );
-    delete[] v;
   } else if( SFRotation *f = dynamic_cast< SFRotation * >( field ) ) {
     const Rotation &r = f->getValue(); 
     cgGLSetParameter4f( param, 
@@ -1260,9 +1493,8 @@ bool H3D::Shaders::setCGUniformVariableValue( CGprogram program_handle,
                     (GLfloat)r.axis.z,
                     (GLfloat)r.angle  );
   } else if( MFRotation *f = dynamic_cast< MFRotation * >( field ) ) {
-    GLfloat *v = toFloatArray( f->getValue() );
+    GLfloat *v = toFloatArray( f->getValue(), float_buffer );
     cgGLSetParameterArray4f( param, 0, f->size(), v );
-    delete[] v;
   } else if( SFColor *f = dynamic_cast< SFColor * >( field ) ) {
     const RGB &r = f->getValue(); 
     cgGLSetParameter3f( param, 
@@ -1270,9 +1502,8 @@ bool H3D::Shaders::setCGUniformVariableValue( CGprogram program_handle,
                     (GLfloat)r.g,
                     (GLfloat)r.b );
   } else if( MFColor *f = dynamic_cast< MFColor * >( field ) ) {
-    GLfloat *v = toFloatArray( f->getValue() );
+    GLfloat *v = toFloatArray( f->getValue(), float_buffer );
     cgGLSetParameterArray4f( param, 0, f->size(), v );
-    delete[] v;
   } else if( SFColorRGBA *f = dynamic_cast< SFColorRGBA * >( field ) ) {
     const RGBA &r = f->getValue(); 
     cgGLSetParameter4f( param, 
@@ -1281,23 +1512,20 @@ bool H3D::Shaders::setCGUniformVariableValue( CGprogram program_handle,
                     (GLfloat)r.b,
                     (GLfloat)r.a );
   } else if( MFColorRGBA *f = dynamic_cast< MFColorRGBA * >( field ) ) {
-    GLfloat *v = toFloatArray( f->getValue() );
+    GLfloat *v = toFloatArray( f->getValue(), float_buffer );
     cgGLSetParameterArray4f( param, 0, f->size(), v );
-    delete[] v;
   } else if( SFMatrix3f *f = dynamic_cast< SFMatrix3f * >( field ) ) {
     const Matrix3f &m = f->getValue(); 
     cgGLSetMatrixParameterfr( param, m[0] );
   } else if( MFMatrix3f *f = dynamic_cast< MFMatrix3f * >( field ) ) {
-    GLfloat *v = toFloatArray( f->getValue() );
+    GLfloat *v = toFloatArray( f->getValue(), float_buffer );
     cgGLSetMatrixParameterArrayfr( param, 0, f->size(), v );
-    delete[] v;
   } else if( SFMatrix4f *f = dynamic_cast< SFMatrix4f * >( field ) ) {
     const Matrix4f &m = f->getValue(); 
     cgGLSetMatrixParameterfr( param, m[0] );
   } else if( MFMatrix4f *f = dynamic_cast< MFMatrix4f * >( field ) ) {
-    GLfloat *v = toFloatArray( f->getValue() );
+    GLfloat *v = toFloatArray( f->getValue(), float_buffer );
     cgGLSetMatrixParameterArrayfr( param, 0, f->size(), v );
-    delete[] v;
   } else if( SFNode *f = dynamic_cast< SFNode * >( field ) ) {
     Node *n = f->getValue(); 
     if( H3DSingleTextureNode *t = dynamic_cast< H3DSingleTextureNode *>( n ) ) {
@@ -1421,7 +1649,7 @@ void H3D::Shaders::preRenderTextures( H3DDynamicFieldsObject *dfo ) {
         n = static_cast<SFNode*>(*f)->getValue(); 
         if( H3DSingleTextureNode *t = 
           dynamic_cast< H3DSingleTextureNode *>( n ) ) {
-            glActiveTextureARB(GL_TEXTURE0_ARB + nr_textures );
+            GLStateTracker::activeTexture(GL_TEXTURE0_ARB + nr_textures );
             t->preRender();
             ++nr_textures;
         } 
@@ -1433,7 +1661,7 @@ void H3D::Shaders::preRenderTextures( H3DDynamicFieldsObject *dfo ) {
           Node *_n = mfnode->getValueByIndex( i ); 
           if( H3DSingleTextureNode *t = 
             dynamic_cast< H3DSingleTextureNode *>( _n ) ) {
-              glActiveTextureARB(GL_TEXTURE0_ARB + nr_textures );
+              GLStateTracker::activeTexture(GL_TEXTURE0_ARB + nr_textures );
               t->preRender();
               ++nr_textures;
           }
@@ -1445,7 +1673,7 @@ void H3D::Shaders::preRenderTextures( H3DDynamicFieldsObject *dfo ) {
       }
     }
 
-    glActiveTextureARB(GL_TEXTURE0_ARB );
+    GLStateTracker::activeTexture(GL_TEXTURE0_ARB );
     X3DTextureNode::setActiveTexture( active_texture );
   }
 }
@@ -1467,7 +1695,7 @@ void H3D::Shaders::preRenderTextures( list<H3DSingleTextureNode*>* shader_textur
     X3DTextureNode *active_texture = X3DTextureNode::getActiveTexture();
     unsigned int nr_textures = 0; 
     for( list<H3DSingleTextureNode*>::const_iterator it = shader_textures->begin(); it!=shader_textures->end(); ++it ){
-      glActiveTextureARB(GL_TEXTURE0_ARB + nr_textures);
+      GLStateTracker::activeTexture(GL_TEXTURE0_ARB + nr_textures);
       (*it)->setTextureUnit(GL_TEXTURE0_ARB + nr_textures);
       (*it)->preRender();
       ++nr_textures;
@@ -1476,7 +1704,7 @@ void H3D::Shaders::preRenderTextures( list<H3DSingleTextureNode*>* shader_textur
         break;
       }
     }
-    glActiveTextureARB(GL_TEXTURE0_ARB );
+    GLStateTracker::activeTexture(GL_TEXTURE0_ARB );
     X3DTextureNode::setActiveTexture( active_texture );
   }
 }
@@ -1553,7 +1781,7 @@ void H3D::Shaders::postRenderTextures( H3DDynamicFieldsObject *dfo ) {
       n = static_cast<SFNode*>(*f)->getValue();
       if( H3DSingleTextureNode *t = dynamic_cast< H3DSingleTextureNode *>( n ) ) 
       {
-        glActiveTextureARB(GL_TEXTURE0_ARB + nr_textures );
+        GLStateTracker::activeTexture(GL_TEXTURE0_ARB + nr_textures );
         t->postRender();
         ++nr_textures;
       }
@@ -1566,7 +1794,7 @@ void H3D::Shaders::postRenderTextures( H3DDynamicFieldsObject *dfo ) {
 
         if( H3DSingleTextureNode *t = 
           dynamic_cast< H3DSingleTextureNode *>( n ) ) {
-            glActiveTextureARB(GL_TEXTURE0_ARB + nr_textures );
+            GLStateTracker::activeTexture(GL_TEXTURE0_ARB + nr_textures );
             t->postRender();
             ++nr_textures;
         }
@@ -1577,7 +1805,7 @@ void H3D::Shaders::postRenderTextures( H3DDynamicFieldsObject *dfo ) {
       break;
     }
   }
-  glActiveTextureARB(GL_TEXTURE0_ARB );
+  GLStateTracker::activeTexture(GL_TEXTURE0_ARB );
 }
 
 void H3D::Shaders::postRenderTextures( list<H3DSingleTextureNode*>* shader_textures, H3DInt32* nr_textures_supported ){
@@ -1627,7 +1855,7 @@ void H3D::Shaders::renderTextures( H3DDynamicFieldsObject *dfo ) {
     {
       n = static_cast<SFNode*>(*f)->getValue(); 
       if (ShaderImageNode *si = dynamic_cast<ShaderImageNode*>(n)) {
-        glActiveTextureARB(GL_TEXTURE0_ARB + nr_textures); // this is not needed, in theory
+        GLStateTracker::activeTexture(GL_TEXTURE0_ARB + nr_textures); // this is not needed, in theory
         si->setTextureUnit(GL_TEXTURE0_ARB + nr_textures);
         si->setImageUnit(nr_images);
         si->displayList->callList();
@@ -1635,7 +1863,7 @@ void H3D::Shaders::renderTextures( H3DDynamicFieldsObject *dfo ) {
         ++nr_images;
       }else if( H3DSingleTextureNode *t = 
         dynamic_cast< H3DSingleTextureNode *>( n ) ) {
-          glActiveTextureARB(GL_TEXTURE0_ARB + nr_textures );
+          GLStateTracker::activeTexture(GL_TEXTURE0_ARB + nr_textures );
           t->setTextureUnit( GL_TEXTURE0_ARB + nr_textures );
           t->displayList->callList();
           ++nr_textures;
@@ -1647,7 +1875,7 @@ void H3D::Shaders::renderTextures( H3DDynamicFieldsObject *dfo ) {
       for( unsigned int i = 0; i < mfnode->size(); ++i ) {
           Node *_n = mfnode->getValueByIndex( i ); 
           if (ShaderImageNode *si = dynamic_cast<ShaderImageNode*>(_n)) {
-            glActiveTextureARB(GL_TEXTURE0_ARB + nr_textures);
+            GLStateTracker::activeTexture(GL_TEXTURE0_ARB + nr_textures);
             si->setTextureUnit(GL_TEXTURE0_ARB + nr_textures);
             si->setImageUnit(nr_images);
             si->displayList->callList();
@@ -1655,7 +1883,7 @@ void H3D::Shaders::renderTextures( H3DDynamicFieldsObject *dfo ) {
             ++nr_images;
           }else if( H3DSingleTextureNode *t = 
             dynamic_cast< H3DSingleTextureNode *>( _n ) ) {
-              glActiveTextureARB(GL_TEXTURE0_ARB + nr_textures );
+              GLStateTracker::activeTexture(GL_TEXTURE0_ARB + nr_textures );
               t->setTextureUnit( GL_TEXTURE0_ARB + nr_textures );
               t->displayList->callList();
               ++nr_textures;
@@ -1670,7 +1898,7 @@ void H3D::Shaders::renderTextures( H3DDynamicFieldsObject *dfo ) {
       Console(LogLevel::Error) << "Warning: Nr of texture image used in shader is larger than the maximum number supported(" << nr_images_supported << ")" << endl;
     }
   }
-  glActiveTextureARB(GL_TEXTURE0_ARB );
+  GLStateTracker::activeTexture(GL_TEXTURE0_ARB );
 }
 
 void H3D::Shaders::renderTextures( list<H3DSingleTextureNode*>* shader_textures, H3DInt32* nr_textures_supported ){
@@ -1679,7 +1907,7 @@ void H3D::Shaders::renderTextures( list<H3DSingleTextureNode*>* shader_textures,
   }
   unsigned int nr_textures = 0; 
   for( list<H3DSingleTextureNode*>::const_iterator it = shader_textures->begin(); it!=shader_textures->end(); ++it ) {
-    glActiveTextureARB(GL_TEXTURE0_ARB + nr_textures );
+    GLStateTracker::activeTexture(GL_TEXTURE0_ARB + nr_textures );
     (*it)->setTextureUnit(GL_TEXTURE0_ARB + nr_textures);
     (*it)->displayList->callList();
     ++nr_textures;
@@ -1688,7 +1916,7 @@ void H3D::Shaders::renderTextures( list<H3DSingleTextureNode*>* shader_textures,
       break;
     }
   }
-  glActiveTextureARB(GL_TEXTURE0_ARB );
+  GLStateTracker::activeTexture(GL_TEXTURE0_ARB );
 }
 
 void H3D::Shaders::renderShaderResources( H3DDynamicFieldsObject * dfo){
@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/ShaderImage2D.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -119,8 +120,8 @@ void ShaderImage2D::prepareShaderImage ( ){
     glGenTextures ( 1, &texture_id );
   }
   // bind to specified texture unit 
-  glActiveTexture ( texture_unit );
-  glBindTexture ( GL_TEXTURE_2D, texture_id );
+  GLStateTracker::activeTexture ( texture_unit );
+  GLStateTracker::bindTexture ( GL_TEXTURE_2D, texture_id );
 
   // texture creation , as no pixel data will be assigned, the pixel type and format 
   // does not need to be correct
@@ -129,7 +130,7 @@ void ShaderImage2D::prepareShaderImage ( ){
   // set filter
   glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
   glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
-  glBindTexture( GL_TEXTURE_2D, 0 );
+  GLStateTracker::bindTexture( GL_TEXTURE_2D, 0 );
 #endif
 }
 
@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/ShaderImage3D.h>
+#include <H3D/GLStateTracker.h>
 using namespace H3D;
 
 H3DNodeDatabase ShaderImage3D::database ( "ShaderImage3D",
@@ -96,7 +97,7 @@ void ShaderImage3D::render ( ){
   // image_unit will be the reference that shader used to access this image
   string format_s = format->getValue ( );
   GLenum format_t = stringImageFormat_map[format_s];
-  glActiveTexture ( texture_unit );
+  GLStateTracker::activeTexture ( texture_unit );
   // set up barrier before actually access the image from shaders
   glMemoryBarrier ( GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_ATOMIC_COUNTER_BARRIER_BIT
 #ifdef GL_ARB_shader_storage_buffer_object
@@ -114,7 +115,7 @@ void ShaderImage3D::prepareShaderImage ( ){
     // generate texture if do not have valid one
     glGenTextures(1,&texture_id);
   }
-  glBindTexture ( GL_TEXTURE_2D_ARRAY, texture_id );
+  GLStateTracker::bindTexture ( GL_TEXTURE_2D_ARRAY, texture_id );
   // set filter, for texture image, GL_NEAREST is required
   glTexParameteri ( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
   glTexParameteri ( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/ShaderImageNode.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -54,6 +55,6 @@ ShaderImageNode::ShaderImageNode(
 ShaderImageNode::~ShaderImageNode ( ){
   if ( texture_id )
   {
-    glDeleteTextures ( 1, &texture_id );
+    GLStateTracker::deleteTextures ( 1, &texture_id );
   }
 }
@@ -32,6 +32,7 @@
 #include <H3D/ResourceResolver.h>
 #include <fstream>
 #include <H3D/GlobalSettings.h>
+#include <H3D/GraphicsOptions.h>
 
 
 using namespace H3D;
@@ -49,9 +50,13 @@ namespace ShaderPartInternals {
   FIELDDB_ELEMENT( ShaderPart, forceReload, INPUT_OUTPUT );
 }
 
+map< string, ShaderPart::SharedShader > ShaderPart::shared_shaders;
+map< string, ShaderPart * > ShaderPart::compiling_shaders;
+
 namespace {
   const int pre_processor_max_recurse_depth= 32;
   const std::string include_marker= "#pragma h3dapi include";
+  bool max_compiler_threads_set= false;
 }
 
 ShaderPart::ShaderPart( Inst< SFNode         > _metadata,
@@ -65,6 +70,9 @@ ShaderPart::ShaderPart( Inst< SFNode         > _metadata,
   shaderString( _shader_string ),
   forceReload( _forceReload ),
   shader_handle( 0 ),
+  share_compiled_shader( false ),
+  compile_pending( false ),
+  compile_time( 0 ),
   debug_options_previous( NULL ) {
   type_name = "ShaderPart";
   database.initFields( this );
@@ -84,6 +92,16 @@ ShaderPart::ShaderPart( Inst< SFNode         > _metadata,
   forceReload->route( shaderString );
 }
 
+ShaderPart::~ShaderPart() {
+  // nodes waiting for this node to compile will compile the source
+  // themselves.
+  for( map< string, ShaderPart * >::iterator i = compiling_shaders.begin();
+       i != compiling_shaders.end(); ) {
+    if( (*i).second == this ) compiling_shaders.erase( i++ );
+    else ++i;
+  }
+}
+
 
 GLhandleARB ShaderPart::compileShader() {
   if( shaderString->isUpToDate() ) {
@@ -96,15 +114,33 @@ GLhandleARB ShaderPart::compileShader() {
 GLhandleARB ShaderPart::compileShaderPart(){
 
     //PROFILE_START("shaderpart: compile");
-    if( shader_handle ) {
-      glDeleteObjectARB( shader_handle );
-      shader_handle = 0;
-    }
+    releaseShaderHandle();
 
     const string &s = shaderString->getValue();
     if( s == "" ) return 0;
 
     const string &shader_type = type->getValue();
+
+    string key;
+    if( share_compiled_shader ) {
+      key = shader_type + "\n" + s;
+      map< string, SharedShader >::iterator i = shared_shaders.find( key );
+      if( i != shared_shaders.end() ) {
+        // the same source has already been compiled.
+        ++(*i).second.nr_users;
+        shader_handle = (*i).second.handle;
+        shared_shader_key = key;
+        compile_time = 0;
+        return shader_handle;
+      }
+      if( compiling_shaders.find( key ) != compiling_shaders.end() ) {
+        // another node is compiling the same source, wait for it.
+        shared_shader_key = key;
+        compile_pending = true;
+        return 0;
+      }
+    }
+
     if( shader_type == "FRAGMENT" ) {
       shader_handle = glCreateShaderObjectARB( GL_FRAGMENT_SHADER_ARB );
     } else if( shader_type == "VERTEX" ) {
@@ -138,7 +174,28 @@ GLhandleARB ShaderPart::compileShaderPart(){
 
     const char * shader_string = s.c_str();
     glShaderSourceARB( shader_handle, 1, &shader_string, NULL );
+    compile_start = TimeStamp();
     glCompileShaderARB( shader_handle );
+    shared_shader_key = key;
+
+    if( asyncCompilation() ) {
+      // the result is checked in isCompilePending() when the compilation
+      // has finished.
+      compile_pending = true;
+      if( share_compiled_shader ) compiling_shaders[ key ] = this;
+      return shader_handle;
+    }
+    //PROFILE_END();
+    return finishCompile();
+}
+
+GLhandleARB ShaderPart::finishCompile() {
+    compile_pending = false;
+    map< string, ShaderPart * >::iterator c = 
+      compiling_shaders.find( shared_shader_key );
+    if( c != compiling_shaders.end() && (*c).second == this ) {
+      compiling_shaders.erase( c );
+    }
 
     GLint compile_success;
     glGetObjectParameterivARB( shader_handle,
@@ -171,10 +228,98 @@ GLhandleARB ShaderPart::compileShaderPart(){
         delete [] log;
       }
     }
-    //PROFILE_END();
+
+    compile_time = TimeStamp() - compile_start;
+
+    if( shader_handle && shared_shader_key != "" ) {
+      SharedShader &shared = shared_shaders[ shared_shader_key ];
+      shared.handle = shader_handle;
+      shared.nr_users = 1;
+    } else {
+      shared_shader_key = "";
+    }
     return shader_handle;
 }
 
+bool ShaderPart::isCompilePending() {
+  if( !compile_pending ) return false;
+  if( !shader_handle ) {
+    // waiting for another node compiling the same source.
+    map< string, ShaderPart * >::iterator c = 
+      compiling_shaders.find( shared_shader_key );
+    if( c != compiling_shaders.end() && (*c).second->isCompilePending() ) {
+      return true;
+    }
+    // use the compiled shader of the other node, or compile it here if
+    // that failed.
+    compileShaderPart();
+    return compile_pending;
+  }
+#ifdef GL_COMPLETION_STATUS_ARB
+  GLint done = GL_TRUE;
+  glGetObjectParameterivARB( shader_handle, GL_COMPLETION_STATUS_ARB, &done );
+  if( done == GL_FALSE ) return true;
+#endif
+  finishCompile();
+  return false;
+}
+
+bool ShaderPart::asyncCompilation() {
+#ifdef GL_COMPLETION_STATUS_ARB
+  GraphicsOptions *options = NULL;
+  GlobalSettings *default_settings = GlobalSettings::getActive();
+  if( default_settings ) default_settings->getOptionNode( options );
+  if( !options || !options->asyncShaderCompilation->getValue() ) return false;
+
+  bool khr_supported = false;
+#ifdef GL_KHR_parallel_shader_compile
+  khr_supported = GLEW_KHR_parallel_shader_compile != 0;
+#endif
+  if( !GLEW_ARB_parallel_shader_compile && !khr_supported ) return false;
+
+  if( !max_compiler_threads_set ) {
+    // let the driver decide the number of compiler threads.
+    if( GLEW_ARB_parallel_shader_compile ) {
+      glMaxShaderCompilerThreadsARB( 0xFFFFFFFF );
+    }
+#ifdef GL_KHR_parallel_shader_compile
+    else glMaxShaderCompilerThreadsKHR( 0xFFFFFFFF );
+#endif
+    max_compiler_threads_set = true;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+void ShaderPart::releaseShaderHandle() {
+  compile_pending = false;
+  map< string, ShaderPart * >::iterator c = 
+    compiling_shaders.find( shared_shader_key );
+  if( c != compiling_shaders.end() && (*c).second == this ) {
+    compiling_shaders.erase( c );
+  }
+  if( !shader_handle ) {
+    shared_shader_key = "";
+    return;
+  }
+  if( shared_shader_key != "" ) {
+    map< string, SharedShader >::iterator i = 
+      shared_shaders.find( shared_shader_key );
+    if( i != shared_shaders.end() && --(*i).second.nr_users > 0 ) {
+      // still used by other nodes.
+      shader_handle = 0;
+      shared_shader_key = "";
+      return;
+    }
+    if( i != shared_shaders.end() ) shared_shaders.erase( i );
+    shared_shader_key = "";
+  }
+  glDeleteObjectARB( shader_handle );
+  shader_handle = 0;
+}
+
 std::string ShaderPart::shaderStringFromURL ( const std::string& shader_url ) {
   // First try to resolve the url to file contents and load via string buffer
   // Otherwise fallback on using temp files
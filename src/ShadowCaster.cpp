@@ -42,6 +42,7 @@
 #include <H3D/H3DWindowNode.h>
 #include <H3D/Scene.h>
 #include <H3D/StereoInfo.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -231,16 +232,16 @@ void ShadowCaster::renderShadows( FrameBufferTextureGenerator *fbo, int i, void
        l != shadow_caster->light->end(); l++ ) {
 
     glClear(GL_STENCIL_BUFFER_BIT );
-    glPushAttrib( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | 
+    GLStateTracker::pushAttrib( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | 
                   GL_ENABLE_BIT | GL_POLYGON_BIT | GL_STENCIL_BUFFER_BIT );
-    glDisable( GL_LIGHTING );// Turn Off Lighting
+    GLStateTracker::disable( GL_LIGHTING );// Turn Off Lighting
     glDepthMask( GL_FALSE );// Turn Off Writing To The Depth-Buffer
     glDepthFunc( GL_LESS );
-    glDisable( GL_ALPHA_TEST );
-    glEnable( GL_STENCIL_TEST );// Turn On Stencil Buffer Testing
+    GLStateTracker::disable( GL_ALPHA_TEST );
+    GLStateTracker::enable( GL_STENCIL_TEST );// Turn On Stencil Buffer Testing
     glColorMask( GL_FALSE, GL_FALSE, 
                  GL_FALSE, GL_FALSE );// Don't Draw Into The Colour Buffer
-    glEnable( GL_CULL_FACE );
+    GLStateTracker::enable( GL_CULL_FACE );
     
     const string &alg = shadow_caster->algorithm->getValue();
     glStencilFunc( GL_ALWAYS, 1, 0xFFFFFFFFL );
@@ -274,7 +275,7 @@ void ShadowCaster::renderShadows( FrameBufferTextureGenerator *fbo, int i, void
     // shadow volumes(look like the gaps between edges) so instead we
     // do not use the scale and have a default offset of 6 to compensate.
     glPolygonOffset( 0, shadow_caster->shadowDepthOffset->getValue() );
-    glEnable( GL_POLYGON_OFFSET_FILL );
+    GLStateTracker::enable( GL_POLYGON_OFFSET_FILL );
 
 
     DirectionalLight *dir_light = dynamic_cast< DirectionalLight * >( *l );
@@ -331,16 +332,16 @@ void ShadowCaster::renderShadows( FrameBufferTextureGenerator *fbo, int i, void
     if( fbo ) {
       // if using fbo the shadow texture is blended at a later stage so we disable it
       // here
-      glDisable( GL_BLEND );
+      GLStateTracker::disable( GL_BLEND );
     } else {
-      glEnable( GL_BLEND );
+      GLStateTracker::enable( GL_BLEND );
       glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
 
     }
     glStencilFunc( GL_NOTEQUAL, 0, 0xFFFFFFFFL );
     glStencilOp( GL_KEEP, GL_KEEP, GL_KEEP );
-    glDisable( GL_DEPTH_TEST );
-    glDisable( GL_CULL_FACE );
+    GLStateTracker::disable( GL_DEPTH_TEST );
+    GLStateTracker::disable( GL_CULL_FACE );
 
     ShadowCasterShaders::shaderClean();
 
@@ -359,7 +360,7 @@ void ShadowCaster::renderShadows( FrameBufferTextureGenerator *fbo, int i, void
     glPopMatrix ();
     glMatrixMode (GL_MODELVIEW);
     glPopMatrix ();
-    glPopAttrib(); 
+    GLStateTracker::popAttrib(); 
   }
 
 }
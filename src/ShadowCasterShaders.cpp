@@ -30,6 +30,7 @@
 
 #include <H3D/ShadowCasterShaders.h>
 #include <H3D/ComposedShader.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -802,9 +803,9 @@ bool ShadowCasterShaders::setPointLightPosition( const Vec3f &p ) {
 void ShadowCasterShaders::shaderToggle( bool on ) {
   if( shader_node.get() ) {
     if( on ) {
-      glUseProgramObjectARB( shader_node->getProgramHandle() ); 
+      GLStateTracker::useProgram( shader_node->getProgramHandle() ); 
     } else {
-      glUseProgramObjectARB( 0 );
+      GLStateTracker::useProgram( 0 );
     }
   }
 }
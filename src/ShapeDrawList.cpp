@@ -0,0 +1,205 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file ShapeDrawList.cpp
+/// \brief CPP file for ShapeDrawList.
+///
+//
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <H3D/ShapeDrawList.h>
+#include <H3D/X3DShapeNode.h>
+#include <H3D/Appearance.h>
+#include <H3D/GLStateTracker.h>
+
+#include <algorithm>
+
+using namespace H3D;
+
+ShapeDrawList::Statistics ShapeDrawList::current_frame;
+ShapeDrawList::Statistics ShapeDrawList::last_frame;
+GLuint64 ShapeDrawList::last_state_key = 0;
+
+namespace ShapeDrawListInternals {
+  // Fold a pointer into 16 bits. The lowest bits are dropped since
+  // they are the same for all nodes due to alignment.
+  GLuint64 foldPointer( void *p ) {
+    size_t v = (size_t)p >> 4;
+    GLuint64 folded = 0;
+    while( v ) {
+      folded ^= v & 0xffff;
+      v >>= 16;
+    }
+    return folded;
+  }
+
+  const GLuint64 shader_mask   = 0xffffULL << 48;
+  const GLuint64 texture_mask  = 0xffffULL << 32;
+  const GLuint64 material_mask = 0xffffULL << 16;
+}
+
+void ShapeDrawList::clear() {
+  opaque.clear();
+  transparent.clear();
+}
+
+void ShapeDrawList::add( X3DShapeNode *shape, const Matrix4f *matrix ) {
+  X3DAppearanceNode *a = shape->appearance->getValue();
+
+  Entry e;
+  e.shape = shape;
+  e.has_matrix = matrix != NULL;
+  if( matrix ) {
+    const Matrix4f &m = *matrix;
+    GLfloat mv[] = {
+      m[0][0], m[1][0], m[2][0], 0,
+      m[0][1], m[1][1], m[2][1], 0,
+      m[0][2], m[1][2], m[2][2], 0,
+      m[0][3], m[1][3], m[2][3], 1 };
+    std::copy( mv, mv + 16, e.matrix );
+  }
+  e.key = getStateKey( a );
+  e.depth = 0;
+
+  if( a && a->isTransparent() ) transparent.push_back( e );
+  else opaque.push_back( e );
+}
+
+void ShapeDrawList::render() {
+  if( !transparent.empty() ) {
+    // sort transparent shapes back to front by the depth of the center
+    // of their bounds in eye coordinates.
+    GLfloat mv[16];
+    glGetFloatv( GL_MODELVIEW_MATRIX, mv );
+    for( unsigned int i = 0; i < transparent.size(); ++i ) {
+      Entry &e = transparent[i];
+      Vec3f c;
+      BoxBound *bb = dynamic_cast< BoxBound * >( e.shape->bound->getValue() );
+      if( bb ) c = bb->center->getValue();
+      if( e.has_matrix ) {
+        const GLfloat *m = e.matrix;
+        c = Vec3f( m[0]*c.x + m[4]*c.y + m[8]*c.z + m[12],
+                   m[1]*c.x + m[5]*c.y + m[9]*c.z + m[13],
+                   m[2]*c.x + m[6]*c.y + m[10]*c.z + m[14] );
+      }
+      e.depth = mv[2]*c.x + mv[6]*c.y + mv[10]*c.z + mv[14];
+    }
+    std::stable_sort( transparent.begin(), transparent.end(), depthLess );
+  }
+
+  std::stable_sort( opaque.begin(), opaque.end(), stateLess );
+
+  // the matrices can contain scaling, as in MatrixTransform.
+  GLboolean norm= glIsEnabled( GL_NORMALIZE );
+  if ( !norm )
+    GLStateTracker::enable( GL_NORMALIZE );
+
+  // opaque shapes are not rendered in the passes for transparent objects.
+  if( X3DShapeNode::geometry_render_mode == X3DShapeNode::ALL ||
+      X3DShapeNode::geometry_render_mode == X3DShapeNode::SOLID ) {
+    renderEntries( opaque );
+  }
+  renderEntries( transparent );
+
+  if ( !norm )
+    GLStateTracker::disable( GL_NORMALIZE );
+}
+
+void ShapeDrawList::renderEntries( vector< Entry > &entries ) {
+  X3DShapeNode *current = NULL;
+  for( unsigned int i = 0; i < entries.size(); ++i ) {
+    Entry &e = entries[i];
+    if( !current ||
+        current->appearance->getValue() != e.shape->appearance->getValue() ) {
+      if( current ) current->postRenderAppearance();
+      current = e.shape;
+      current->preRenderAppearance();
+    }
+
+    if( e.has_matrix ) {
+      glMatrixMode( GL_MODELVIEW );
+      glPushMatrix();
+      glMultMatrixf( e.matrix );
+      e.shape->renderGeometry();
+      glPopMatrix();
+    } else {
+      e.shape->renderGeometry();
+    }
+  }
+  if( current ) current->postRenderAppearance();
+}
+
+bool ShapeDrawList::stateLess( const Entry &a, const Entry &b ) {
+  if( a.key != b.key ) return a.key < b.key;
+  X3DAppearanceNode *app_a = a.shape->appearance->getValue();
+  X3DAppearanceNode *app_b = b.shape->appearance->getValue();
+  if( app_a != app_b ) return app_a < app_b;
+  return a.shape->geometry->getValue() < b.shape->geometry->getValue();
+}
+
+bool ShapeDrawList::depthLess( const Entry &a, const Entry &b ) {
+  // eye space looks along negative z, so the smallest depth is farthest
+  // away.
+  return a.depth < b.depth;
+}
+
+GLuint64 ShapeDrawList::getStateKey( X3DAppearanceNode *a ) {
+  using namespace ShapeDrawListInternals;
+  if( !a ) return 0;
+
+  void *shader = a;
+  void *texture = a;
+  void *material = a;
+  Appearance *app = dynamic_cast< Appearance * >( a );
+  if( app ) {
+    shader = app->shaders->empty() ? NULL : app->shaders->getValueByIndex( 0 );
+    texture = app->texture->getValue();
+    material = app->material->getValue();
+  }
+
+  return
+    ( foldPointer( shader ) << 48 ) |
+    ( foldPointer( texture ) << 32 ) |
+    ( foldPointer( material ) << 16 ) |
+    foldPointer( a );
+}
+
+void ShapeDrawList::countAppearanceChange( X3DAppearanceNode *a ) {
+  using namespace ShapeDrawListInternals;
+  GLuint64 key = getStateKey( a );
+  ++current_frame.nr_appearance_changes;
+  if( ( key & shader_mask ) != ( last_state_key & shader_mask ) )
+    ++current_frame.nr_shader_changes;
+  if( ( key & texture_mask ) != ( last_state_key & texture_mask ) )
+    ++current_frame.nr_texture_changes;
+  if( ( key & material_mask ) != ( last_state_key & material_mask ) )
+    ++current_frame.nr_material_changes;
+  last_state_key = key;
+}
+
+void ShapeDrawList::beginFrame() {
+  last_frame = current_frame;
+  current_frame.reset();
+  last_state_key = 0;
+}
@@ -37,7 +37,7 @@
 #include <H3D/HapticsRenderers.h>
 #include <H3D/H3DHapticsDevice.h>
 #include <H3D/ShadowSphere.h>
-#include <H3D/GraphicsOptions.h>
+#include <H3D/GLStateTracker.h>
 
 // HAPI includes
 #include <HAPI/HapticPrimitive.h>
@@ -58,12 +58,56 @@ H3DNodeDatabase Sphere::database(
 namespace SphereInternals {
   FIELDDB_ELEMENT( Sphere, radius, INPUT_OUTPUT );
   FIELDDB_ELEMENT( Sphere, solid, INPUT_OUTPUT );
-}
 
-GLuint Sphere::vbo_id[2] = { 0, 0 };
-bool Sphere::vbo_initialized = false;
-vector< GLfloat > Sphere::sphere_data = vector< GLfloat >();
-vector< GLuint > Sphere::sphere_index_data = vector< GLuint >();
+  // The number of parts around the sphere and from pole to pole.
+  const unsigned int theta_parts = 50;
+  const unsigned int phi_parts = 25;
+
+  // Build the mesh for a sphere with radius 1. params[0] is the number
+  // of parts around the sphere and params[1] the number of parts from
+  // pole to pole. If params[2] is given the vertices are scaled by it.
+  void buildMesh( const vector< H3DFloat > &params,
+                  PrimitiveMeshCache::Mesh &mesh ) {
+    unsigned int nr_theta = (unsigned int)params[0];
+    unsigned int nr_phi = (unsigned int)params[1];
+    H3DFloat inc_theta = (H3DFloat) Constants::pi*2 / nr_theta;
+    H3DFloat inc_phi = (H3DFloat) Constants::pi / nr_phi;
+    H3DFloat double_pi = (H3DFloat) Constants::pi * 2;
+    H3DFloat r = params.size() > 2 ? params[2] : 1;
+
+    mesh.vertex_data.reserve( ( nr_theta + 1 ) * ( nr_phi + 1 ) *
+                              PrimitiveMeshCache::Mesh::components_per_vertex );
+    mesh.index_data.reserve( nr_theta * nr_phi * 6 );
+    mesh.beginPart();
+    // Iterate through the parts to create vertices.
+    for (unsigned int p = 0; p <= nr_phi; ++p ) {
+      for (unsigned int t = 0; t <= nr_theta; ++t ) {
+        H3DFloat phi = p * inc_phi;
+        bool at_seam = t == nr_theta;
+        H3DFloat theta = ( at_seam ? 0 :t * inc_theta );
+
+        H3DFloat x = - H3DSin( phi ) * H3DSin( theta );
+        H3DFloat y = H3DCos( phi );
+        H3DFloat z = - H3DSin( phi ) * H3DCos( theta );
+
+        GLuint v = mesh.addVertex(
+          Vec3f( x * r, y * r, z * r ),
+          Vec3f( x, y, z ),
+          Vec3f( at_seam ? 1 : (GLfloat) (theta / double_pi),
+                 (GLfloat) (1 - phi/ Constants::pi),
+                 0 ) );
+
+        if( !at_seam && p != nr_phi ) {
+          // Create the triangles connecting this point to the points to
+          // the east, south and south-east if the point grid is unfolded
+          // onto a flat map.
+          mesh.addTriangle( v, v + nr_theta + 1, v + 1 );
+          mesh.addTriangle( v + 1, v + nr_theta + 1, v + nr_theta + 2 );
+        }
+      }
+    }
+  }
+}
 
 Sphere::Sphere( Inst<    SFNode > _metadata,
                 Inst< SFBound > _bound,
@@ -71,7 +115,10 @@ Sphere::Sphere( Inst<    SFNode > _metadata,
                 Inst< SFBool > _solid ) :
   X3DGeometryNode( _metadata, _bound ),
   radius  ( _radius   ),
-  solid   ( _solid    ) {
+  solid   ( _solid    ),
+  mesh( NULL ),
+  instanced_mesh( NULL ),
+  instanced_mesh_radius( 0 ) {
 
   type_name = "Sphere";
   database.initFields( this );
@@ -90,170 +137,75 @@ H3DShadowObjectNode *Sphere::getShadowObject() {
   return shadow;
 }
 
+Sphere::~Sphere() {
+  PrimitiveMeshCache::releaseMesh( mesh );
+  mesh = NULL;
+  PrimitiveMeshCache::releaseMesh( instanced_mesh );
+  instanced_mesh = NULL;
+}
+
+PrimitiveMeshCache::Mesh *Sphere::getMesh() {
+  if( !mesh ) {
+    vector< H3DFloat > params( 2 );
+    params[0] = (H3DFloat)SphereInternals::theta_parts;
+    params[1] = (H3DFloat)SphereInternals::phi_parts;
+    mesh = PrimitiveMeshCache::getMesh( "Sphere", params,
+                                        &SphereInternals::buildMesh );
+  }
+  return mesh;
+}
+
 void Sphere::render() {
   GLboolean norm= glIsEnabled( GL_NORMALIZE );
   if ( !norm ) 
-    glEnable( GL_NORMALIZE );
-  bool prefer_vertex_buffer_object = false;
-  if( GLEW_ARB_vertex_buffer_object ) {
-    GraphicsOptions * go = NULL;
-    getOptionNode( go );
-    if( !go ) {
-      GlobalSettings * gs = GlobalSettings::getActive();
-      if( gs ) {
-        gs->getOptionNode( go );
-      }
-    }
-    if( go ) {
-      prefer_vertex_buffer_object = go->preferVertexBufferObject->getValue();
-    }
-  }
-
-  H3DFloat theta_parts = 50, phi_parts = 25;
-
-  H3DFloat inc_theta = (H3DFloat) Constants::pi*2 / theta_parts;
-  H3DFloat inc_phi = (H3DFloat) Constants::pi / phi_parts;
+    GLStateTracker::enable( GL_NORMALIZE );
 
   H3DFloat r = radius->getValue();
+  glMatrixMode( GL_MODELVIEW );
+  glPushMatrix();
+  glScalef( r, r, r );
+  getMesh()->render( 1, PrimitiveMeshCache::usingVertexBufferObjects( this ) );
+  glPopMatrix();
 
-  H3DFloat double_pi = (H3DFloat) Constants::pi * 2;
-
-  if( sphere_data.empty() ) {
-    // Only create and transfer data when it has been modified.
-    unsigned int nr_data_vertices = 9; // 9  floats/vertex.
-    sphere_data.resize( (unsigned int)(( theta_parts + 1 ) *
-                (phi_parts+1) * nr_data_vertices), 0 );
-    unsigned int nr_index_data = 6; // 2 triangles, 3 vertices/triangle.
-    sphere_index_data.resize( (unsigned int)(theta_parts *
-                              phi_parts *
-                              nr_index_data), 0 );
-    // Iterate through the parts to create vertices.
-    // Create sphere of radius 1.
-    for (unsigned int p = 0; p <= phi_parts; ++p ) {
-      for (unsigned int t = 0; t <= theta_parts; ++t ) {
-        H3DFloat phi = p * inc_phi;
-        bool at_seam = t == theta_parts;
-        H3DFloat theta = ( at_seam ? 0 :t * inc_theta );
+  if ( !norm ) 
+    GLStateTracker::disable( GL_NORMALIZE );
+}
 
-        H3DFloat x, y, z;
-
-        x = - H3DSin( phi ) * H3DSin( theta );
-        y = H3DCos( phi );
-        z = - H3DSin( phi ) * H3DCos( theta );
-
-        unsigned int vert_index =
-          (unsigned int)( p * ( theta_parts + 1 ) + t );
-        unsigned int base_data_index =
-          (unsigned int)( vert_index * nr_data_vertices );
-        // Vertex
-        sphere_data[ base_data_index ] = x;
-        sphere_data[ base_data_index + 1 ] = y;
-        sphere_data[ base_data_index + 2 ] = z;
-        // Normal
-        sphere_data[ base_data_index + 3 ] = x;
-        sphere_data[ base_data_index + 4 ] = y;
-        sphere_data[ base_data_index + 5 ] = z;
-        // Texture coordinate
-        sphere_data[ base_data_index + 6 ] =
-          at_seam ? 1 : (GLfloat) (theta / double_pi);
-        sphere_data[ base_data_index + 7 ] =
-          (GLfloat) (1 - phi/ Constants::pi);
-        sphere_data[ base_data_index + 8 ] = 0;
-
-        if( !at_seam && p != phi_parts ) {
-          // Create indices to define triangles.
-          // If the entire point grid is unfolded onto a flat map then
-          // the triangles created here can be seen as the ones connecting
-          // this point to the three point to the east, south and south-east.
-          // This is the reason why no indices are added for the triangles
-          // at the end of the loop
-          // (there are no more points to the east and south).
-          // First triangle.
-          unsigned int base_index =
-            (unsigned int)( ( p * theta_parts + t ) * nr_index_data );
-          sphere_index_data[ base_index ] = vert_index;
-          sphere_index_data[ base_index + 1 ] =
-            vert_index + (GLuint)theta_parts + 1;
-          sphere_index_data[ base_index + 2 ] = vert_index + 1;
-
-          // Second triangle.
-          sphere_index_data[ base_index + 3 ] = vert_index + 1;
-          sphere_index_data[ base_index + 4 ] =
-            vert_index + (GLuint)theta_parts + 1;
-          sphere_index_data[ base_index + 5 ] =
-            vert_index + (GLuint)theta_parts + 2;
-        }
-      }
-    }
+PrimitiveMeshCache::Mesh *Sphere::getInstancedMesh() {
+  H3DFloat r = radius->getValue();
+  if( instanced_mesh && instanced_mesh_radius != r ) {
+    PrimitiveMeshCache::releaseMesh( instanced_mesh );
+    instanced_mesh = NULL;
   }
-
-  GLvoid *vertex_pointer = NULL, *normal_pointer = NULL, *texture_pointer = NULL, *index_pointer = NULL;
-  if( prefer_vertex_buffer_object ) {
-    // Use vertex buffer objects to create sphere.
-    if( !vbo_initialized ) {
-      vbo_initialized = true;
-      
-
-      glGenBuffersARB( 2, vbo_id );
-
-      glBindBufferARB( GL_ARRAY_BUFFER_ARB, vbo_id[0] );
-      glBufferDataARB( GL_ARRAY_BUFFER_ARB,
-                       sphere_data.size() * sizeof(GLfloat),
-                       &(*sphere_data.begin()), GL_STATIC_DRAW_ARB );
-      glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, vbo_id[1] );
-      glBufferDataARB( GL_ELEMENT_ARRAY_BUFFER_ARB,
-                           sphere_index_data.size() * sizeof(GLuint),
-                           &(*sphere_index_data.begin()), GL_STATIC_DRAW_ARB );
-    } else {
-      glBindBufferARB( GL_ARRAY_BUFFER_ARB, vbo_id[0] );
-      glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, vbo_id[1] );
-    }
-
-    normal_pointer = (GLvoid*)(3*sizeof(GLfloat));
-    texture_pointer = (GLvoid*)(6*sizeof(GLfloat));
-  } else {
-    vector< GLfloat >::iterator start_pointer = sphere_data.begin();
-    vertex_pointer = &(*start_pointer);
-    start_pointer += 3;
-    normal_pointer = &(*start_pointer);
-    start_pointer += 3;
-    texture_pointer = &(*start_pointer);
-    index_pointer = &(*sphere_index_data.begin());
+  if( !instanced_mesh ) {
+    vector< H3DFloat > params( 3 );
+    params[0] = (H3DFloat)SphereInternals::theta_parts;
+    params[1] = (H3DFloat)SphereInternals::phi_parts;
+    params[2] = r;
+    instanced_mesh = PrimitiveMeshCache::getMesh( "Sphere", params,
+                                                  &SphereInternals::buildMesh );
+    instanced_mesh_radius = r;
   }
+  return instanced_mesh;
+}
 
-  // Enable all states for vertex buffer objects.
-  // Note that the data is interleaved since this supposedly should be
-  // faster on some systems.
-  glEnableClientState(GL_VERTEX_ARRAY);
-  glVertexPointer(3, GL_FLOAT, 9 * sizeof(GLfloat), vertex_pointer );
-  glEnableClientState(GL_NORMAL_ARRAY);
-  glNormalPointer( GL_FLOAT, 9 * sizeof(GLfloat),
-                   normal_pointer );
-  X3DTextureCoordinateNode::renderVertexBufferObjectForActiveTexture(
-    3, GL_FLOAT, 9 * sizeof(GLfloat), texture_pointer );
-
-  glMatrixMode( GL_MODELVIEW );
-  glPushMatrix();
-  glScalef( r, r, r );
-  // Draw the triangles
-  glDrawRangeElements( GL_TRIANGLES,
-                       0,
-                       (GLsizei)(( theta_parts + 1 ) * ( phi_parts + 1 ) - 1),
-                       (GLsizei)(theta_parts * phi_parts * 6),
-                       GL_UNSIGNED_INT,
-                       index_pointer );
-  glPopMatrix();
+bool Sphere::renderInstanced( GLsizei nr_instances ) {
+  getInstancedMesh()->render(
+    1, PrimitiveMeshCache::usingVertexBufferObjects( this ), nr_instances );
+  return true;
+}
 
-  // Disable state.
-  X3DTextureCoordinateNode::disableVBOForActiveTexture();
-  glDisableClientState(GL_NORMAL_ARRAY);
-  glDisableClientState(GL_VERTEX_ARRAY);
-  if( prefer_vertex_buffer_object ) {
-    glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
-    glBindBufferARB( GL_ELEMENT_ARRAY_BUFFER_ARB, 0 );
+bool Sphere::getTriangles( vector< HAPI::Collision::Triangle > &triangles ) {
+  vector< HAPI::Collision::Triangle > unit_triangles;
+  getMesh()->getTriangles( 1, unit_triangles );
+  H3DDouble r = radius->getValue();
+  triangles.reserve( triangles.size() + unit_triangles.size() );
+  for( unsigned int i = 0; i < unit_triangles.size(); ++i ) {
+    const HAPI::Collision::Triangle &t = unit_triangles[i];
+    triangles.push_back( HAPI::Collision::Triangle( t.a * r, t.b * r, t.c * r,
+                                                    t.ta, t.tb, t.tc ) );
   }
-  if ( !norm ) 
-    glEnable( GL_NORMALIZE );
+  return true;
 }
 
 void Sphere::traverseSG( TraverseInfo &ti ) {
@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/SuperShape.h>
+#include <H3D/GLStateTracker.h>
 #include "H3D/Coordinate.h"
 #include "H3D/Normal.h"
 #include "H3D/MultiTexture.h"
@@ -409,16 +410,16 @@ void SuperShape::startTexGen() {
     if( mt ) {
       size_t texture_units = mt->texture->size();
       for( size_t i = 0; i < texture_units; ++i ) {
-        glActiveTexture( GL_TEXTURE0_ARB + (unsigned int) i );
+        GLStateTracker::activeTexture( GL_TEXTURE0_ARB + (unsigned int) i );
         glTexGend( GL_S, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
         glTexGend( GL_T, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
         glTexGend( GL_R, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
         glTexGenfv( GL_S, GL_OBJECT_PLANE, sparams );
         glTexGenfv( GL_T, GL_OBJECT_PLANE, tparams );
         glTexGenfv( GL_R, GL_OBJECT_PLANE, rparams );
-        glEnable( GL_TEXTURE_GEN_S );
-        glEnable( GL_TEXTURE_GEN_T );
-        glEnable( GL_TEXTURE_GEN_R );
+        GLStateTracker::enable( GL_TEXTURE_GEN_S );
+        GLStateTracker::enable( GL_TEXTURE_GEN_T );
+        GLStateTracker::enable( GL_TEXTURE_GEN_R );
       }
     } else {
       glTexGend( GL_S, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
@@ -427,9 +428,9 @@ void SuperShape::startTexGen() {
       glTexGenfv( GL_S, GL_OBJECT_PLANE, sparams );
       glTexGenfv( GL_T, GL_OBJECT_PLANE, tparams );
       glTexGenfv( GL_R, GL_OBJECT_PLANE, rparams );
-      glEnable( GL_TEXTURE_GEN_S );
-      glEnable( GL_TEXTURE_GEN_T );
-      glEnable( GL_TEXTURE_GEN_R );
+      GLStateTracker::enable( GL_TEXTURE_GEN_S );
+      GLStateTracker::enable( GL_TEXTURE_GEN_T );
+      GLStateTracker::enable( GL_TEXTURE_GEN_R );
     }
   } else {
     stringstream s;
@@ -445,14 +446,14 @@ void SuperShape::stopTexGen() {
   if( mt ) {
     size_t texture_units = mt->texture->size();
     for( size_t i = 0; i < texture_units; ++i ) {
-      glActiveTexture( GL_TEXTURE0_ARB + (unsigned int) i );
-      glDisable( GL_TEXTURE_GEN_S );
-      glDisable( GL_TEXTURE_GEN_T );
-      glDisable( GL_TEXTURE_GEN_R );
+      GLStateTracker::activeTexture( GL_TEXTURE0_ARB + (unsigned int) i );
+      GLStateTracker::disable( GL_TEXTURE_GEN_S );
+      GLStateTracker::disable( GL_TEXTURE_GEN_T );
+      GLStateTracker::disable( GL_TEXTURE_GEN_R );
     }
   } else {
-    glDisable( GL_TEXTURE_GEN_S );
-    glDisable( GL_TEXTURE_GEN_T );
-    glDisable( GL_TEXTURE_GEN_R );
+    GLStateTracker::disable( GL_TEXTURE_GEN_S );
+    GLStateTracker::disable( GL_TEXTURE_GEN_T );
+    GLStateTracker::disable( GL_TEXTURE_GEN_R );
   }
 }
@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/TextureBackground.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -87,11 +88,11 @@ TextureBackground::TextureBackground( Inst< SFSetBind > _set_bind,
 void TextureBackground::render() {
   if( render_enabled ) {
     X3DBackgroundNode::render();
-    glPushAttrib( GL_ALL_ATTRIB_BITS );
+    GLStateTracker::pushAttrib( GL_ALL_ATTRIB_BITS );
     H3DFloat s = (H3DFloat) 0.05;
     glCullFace( GL_BACK );
-    glEnable( GL_CULL_FACE );
-    glDisable( GL_LIGHTING );
+    GLStateTracker::enable( GL_CULL_FACE );
+    GLStateTracker::disable( GL_LIGHTING );
 
     Matrix4d pm = projectionMatrix->getValue();
     H3DDouble projection_matrix[16] = { pm[0][0], pm[1][0], pm[2][0], pm[3][0],
@@ -124,7 +125,7 @@ void TextureBackground::render() {
     glColor4f( 1, 1, 1, 1 );
 
     if( front_texture  ) {
-      glPushAttrib( front_texture->getAffectedGLAttribs() );
+      GLStateTracker::pushAttrib( front_texture->getAffectedGLAttribs() );
       front_texture->preRender();
       front_texture->displayList->callList();
       glBegin( GL_QUADS );
@@ -139,11 +140,11 @@ void TextureBackground::render() {
       glVertex3f( s, -s, -s );
       glEnd();
       front_texture->postRender();
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
   
     if( back_texture ) {
-      glPushAttrib( back_texture->getAffectedGLAttribs() );
+      GLStateTracker::pushAttrib( back_texture->getAffectedGLAttribs() );
       back_texture->preRender();
       back_texture->displayList->callList();
       glBegin( GL_QUADS );
@@ -158,11 +159,11 @@ void TextureBackground::render() {
       glVertex3f( s, s, s );
       glEnd();
       back_texture->postRender();
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
 
     if( left_texture ) {
-      glPushAttrib( left_texture->getAffectedGLAttribs() );
+      GLStateTracker::pushAttrib( left_texture->getAffectedGLAttribs() );
       left_texture->preRender();
       left_texture->displayList->callList();
       glBegin( GL_QUADS );
@@ -177,11 +178,11 @@ void TextureBackground::render() {
       glVertex3f( -s, s, -s );
       glEnd();
       left_texture->postRender();
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
 
     if( right_texture ) {
-      glPushAttrib( right_texture->getAffectedGLAttribs() );
+      GLStateTracker::pushAttrib( right_texture->getAffectedGLAttribs() );
       right_texture->preRender();
       right_texture->displayList->callList();
       glBegin( GL_QUADS );
@@ -196,11 +197,11 @@ void TextureBackground::render() {
       glVertex3f( s, s, s );
       glEnd();
       right_texture->postRender();
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
 
     if( top_texture ) {
-      glPushAttrib( top_texture->getAffectedGLAttribs() );
+      GLStateTracker::pushAttrib( top_texture->getAffectedGLAttribs() );
       top_texture->preRender();
       top_texture->displayList->callList();
       glBegin( GL_QUADS );
@@ -215,11 +216,11 @@ void TextureBackground::render() {
       glVertex3f( s, s, s );
       glEnd();
       top_texture->postRender();
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
 
     if( bottom_texture ) {
-      glPushAttrib( bottom_texture->getAffectedGLAttribs() );
+      GLStateTracker::pushAttrib( bottom_texture->getAffectedGLAttribs() );
       bottom_texture->preRender();
       bottom_texture->displayList->callList();
       glBegin( GL_QUADS );
@@ -234,7 +235,7 @@ void TextureBackground::render() {
       glVertex3f( -s, -s, s );
       glEnd();
       bottom_texture->postRender();
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
 
 
@@ -242,6 +243,6 @@ void TextureBackground::render() {
     glPopMatrix(); 
     glMatrixMode( GL_PROJECTION );
     glPopMatrix();
-    glPopAttrib();
+    GLStateTracker::popAttrib();
   }
 }
@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/TextureCoordinateGenerator.h>
+#include <H3D/GLStateTracker.h>
 #include "GL/glew.h"
 
 using namespace H3D;
@@ -79,8 +80,8 @@ void TextureCoordinateGenerator::startTexGen() {
       gen_mode == "SPHERE" ) {
     glTexGend( GL_S, GL_TEXTURE_GEN_MODE, GL_SPHERE_MAP );
     glTexGend( GL_T, GL_TEXTURE_GEN_MODE, GL_SPHERE_MAP );
-    glEnable( GL_TEXTURE_GEN_S );
-    glEnable( GL_TEXTURE_GEN_T );
+    GLStateTracker::enable( GL_TEXTURE_GEN_S );
+    GLStateTracker::enable( GL_TEXTURE_GEN_T );
   } else if( gen_mode == "MATRIX" ) {
     if( params.size() < 12 ) {
       stringstream s;
@@ -98,9 +99,9 @@ void TextureCoordinateGenerator::startTexGen() {
     glTexGenfv( GL_S, GL_OBJECT_PLANE, sparams );
     glTexGenfv( GL_T, GL_OBJECT_PLANE, tparams );
     glTexGenfv( GL_R, GL_OBJECT_PLANE, rparams );
-    glEnable( GL_TEXTURE_GEN_S );
-    glEnable( GL_TEXTURE_GEN_T );
-    glEnable( GL_TEXTURE_GEN_R );
+    GLStateTracker::enable( GL_TEXTURE_GEN_S );
+    GLStateTracker::enable( GL_TEXTURE_GEN_T );
+    GLStateTracker::enable( GL_TEXTURE_GEN_R );
   } else if( gen_mode == "CAMERASPACEPOSITION" ||
              gen_mode == "COORD-EYE" ) {
     H3DFloat sparams[4] = {1,0,0,0};
@@ -116,9 +117,9 @@ void TextureCoordinateGenerator::startTexGen() {
     glTexGenfv( GL_T, GL_EYE_PLANE, tparams );
     glTexGenfv( GL_R, GL_EYE_PLANE, rparams );
     glPopMatrix();
-    glEnable( GL_TEXTURE_GEN_S );
-    glEnable( GL_TEXTURE_GEN_T );
-    glEnable( GL_TEXTURE_GEN_R );
+    GLStateTracker::enable( GL_TEXTURE_GEN_S );
+    GLStateTracker::enable( GL_TEXTURE_GEN_T );
+    GLStateTracker::enable( GL_TEXTURE_GEN_R );
   } else if( gen_mode == "COORD" ) {
     H3DFloat sparams[4] = {1,0,0,0};
     H3DFloat tparams[4] = {0,1,0,0};
@@ -129,9 +130,9 @@ void TextureCoordinateGenerator::startTexGen() {
     glTexGenfv( GL_S, GL_OBJECT_PLANE, sparams );
     glTexGenfv( GL_T, GL_OBJECT_PLANE, tparams );
     glTexGenfv( GL_R, GL_OBJECT_PLANE, rparams );
-    glEnable( GL_TEXTURE_GEN_S );
-    glEnable( GL_TEXTURE_GEN_T );
-    glEnable( GL_TEXTURE_GEN_R );
+    GLStateTracker::enable( GL_TEXTURE_GEN_S );
+    GLStateTracker::enable( GL_TEXTURE_GEN_T );
+    GLStateTracker::enable( GL_TEXTURE_GEN_R );
   } else if( gen_mode == "CAMERASPACEREFLECTIONVECTOR" ) {
     if( !GLEW_ARB_texture_cube_map ) {
       Console(LogLevel::Error) << "Warning: ARB_texture_cube_map extension not supported "
@@ -142,9 +143,9 @@ void TextureCoordinateGenerator::startTexGen() {
     glTexGend( GL_S, GL_TEXTURE_GEN_MODE, GL_REFLECTION_MAP_ARB );
     glTexGend( GL_T, GL_TEXTURE_GEN_MODE, GL_REFLECTION_MAP_ARB );
     glTexGend( GL_R, GL_TEXTURE_GEN_MODE, GL_REFLECTION_MAP_ARB );
-    glEnable( GL_TEXTURE_GEN_S );
-    glEnable( GL_TEXTURE_GEN_T );
-    glEnable( GL_TEXTURE_GEN_R );
+    GLStateTracker::enable( GL_TEXTURE_GEN_S );
+    GLStateTracker::enable( GL_TEXTURE_GEN_T );
+    GLStateTracker::enable( GL_TEXTURE_GEN_R );
   } else if( gen_mode == "CAMERASPACENORMAL" ) {
     if( !GLEW_ARB_texture_cube_map ) {
       Console(LogLevel::Error) << "Warning: ARB_texture_cube_map extension not supported "
@@ -155,9 +156,9 @@ void TextureCoordinateGenerator::startTexGen() {
     glTexGend( GL_S, GL_TEXTURE_GEN_MODE, GL_NORMAL_MAP_ARB );
     glTexGend( GL_T, GL_TEXTURE_GEN_MODE, GL_NORMAL_MAP_ARB );
     glTexGend( GL_R, GL_TEXTURE_GEN_MODE, GL_NORMAL_MAP_ARB );
-    glEnable( GL_TEXTURE_GEN_S );
-    glEnable( GL_TEXTURE_GEN_T );
-    glEnable( GL_TEXTURE_GEN_R );
+    GLStateTracker::enable( GL_TEXTURE_GEN_S );
+    GLStateTracker::enable( GL_TEXTURE_GEN_T );
+    GLStateTracker::enable( GL_TEXTURE_GEN_R );
   } else {
     stringstream s;
     s << "Unsupported mode \"" << gen_mode << "\" (in "
@@ -169,7 +170,7 @@ void TextureCoordinateGenerator::startTexGen() {
 }
 
 void TextureCoordinateGenerator::stopTexGen() {
-  glDisable( GL_TEXTURE_GEN_S );
-  glDisable( GL_TEXTURE_GEN_T );
-  glDisable( GL_TEXTURE_GEN_R );
+  GLStateTracker::disable( GL_TEXTURE_GEN_S );
+  GLStateTracker::disable( GL_TEXTURE_GEN_T );
+  GLStateTracker::disable( GL_TEXTURE_GEN_R );
 }
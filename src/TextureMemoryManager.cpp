@@ -0,0 +1,130 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file TextureMemoryManager.cpp
+/// \brief CPP file for TextureMemoryManager.
+///
+//
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <H3D/TextureMemoryManager.h>
+#include <H3D/H3DSingleTextureNode.h>
+#include <H3D/GraphicsOptions.h>
+#include <H3D/GlobalSettings.h>
+
+#include <algorithm>
+
+using namespace H3D;
+
+TextureMemoryManager::Statistics TextureMemoryManager::current_frame;
+TextureMemoryManager::Statistics TextureMemoryManager::last_frame;
+std::map< H3DSingleTextureNode *, TextureMemoryManager::TextureInfo >
+TextureMemoryManager::textures;
+unsigned int TextureMemoryManager::frame = 0;
+
+namespace TextureMemoryManagerInternals {
+  typedef std::pair< unsigned int, H3DSingleTextureNode * > LastUse;
+}
+
+void TextureMemoryManager::textureInstalled( H3DSingleTextureNode *texture,
+                                             size_t nr_bytes ) {
+  TextureInfo &info = textures[ texture ];
+  if( info.nr_bytes == 0 ) ++current_frame.nr_textures;
+  current_frame.nr_bytes += nr_bytes;
+  current_frame.nr_bytes -= info.nr_bytes;
+  if( info.evicted ) ++current_frame.nr_reinstalled;
+  info.nr_bytes = nr_bytes;
+  info.last_used_frame = frame;
+  info.evicted = false;
+}
+
+void TextureMemoryManager::textureRemoved( H3DSingleTextureNode *texture ) {
+  std::map< H3DSingleTextureNode *, TextureInfo >::iterator i =
+    textures.find( texture );
+  if( i == textures.end() ) return;
+  if( (*i).second.nr_bytes > 0 ) {
+    --current_frame.nr_textures;
+    current_frame.nr_bytes -= (*i).second.nr_bytes;
+  }
+  textures.erase( i );
+}
+
+void TextureMemoryManager::textureUsed( H3DSingleTextureNode *texture ) {
+  std::map< H3DSingleTextureNode *, TextureInfo >::iterator i =
+    textures.find( texture );
+  if( i != textures.end() ) (*i).second.last_used_frame = frame;
+}
+
+void TextureMemoryManager::evictTextures() {
+  using namespace TextureMemoryManagerInternals;
+  GraphicsOptions *options = NULL;
+  GlobalSettings *default_settings = GlobalSettings::getActive();
+  if( default_settings ) default_settings->getOptionNode( options );
+  if( !options ) return;
+  H3DInt32 budget_mb = options->textureMemoryBudget->getValue();
+  if( budget_mb <= 0 ) return;
+  size_t budget = (size_t)budget_mb * 1024 * 1024;
+  if( current_frame.nr_bytes <= budget ) return;
+
+  // the textures that can be removed, least recently used first. The
+  // scene is traversed before beginFrame() so textures traversed for
+  // the frame being rendered have the number of the frame before.
+  vector< LastUse > candidates;
+  for( std::map< H3DSingleTextureNode *, TextureInfo >::iterator i =
+         textures.begin(); i != textures.end(); ++i ) {
+    const TextureInfo &info = (*i).second;
+    if( info.nr_bytes > 0 && info.last_used_frame + 1 < frame ) {
+      candidates.push_back( LastUse( info.last_used_frame, (*i).first ) );
+    }
+  }
+  std::sort( candidates.begin(), candidates.end() );
+
+  for( unsigned int i = 0;
+       i < candidates.size() && current_frame.nr_bytes > budget; ++i ) {
+    H3DSingleTextureNode *texture = candidates[i].second;
+    if( texture->evictTexture() ) {
+      TextureInfo &info = textures[ texture ];
+      --current_frame.nr_textures;
+      current_frame.nr_bytes -= info.nr_bytes;
+      info.nr_bytes = 0;
+      info.evicted = true;
+      ++current_frame.nr_evicted;
+    }
+  }
+}
+
+void TextureMemoryManager::beginFrame() {
+  last_frame = current_frame;
+  current_frame.reset();
+  ++frame;
+}
+
+size_t TextureMemoryManager::estimateByteSize( Image *image, bool mipmaps ) {
+  size_t nr_bytes =
+    (size_t)image->width() * image->height() * image->depth() *
+    image->bitsPerPixel() / 8;
+  // a full chain of mipmaps adds at most a third.
+  if( mipmaps ) nr_bytes += nr_bytes / 3;
+  return nr_bytes;
+}
@@ -57,6 +57,7 @@ namespace TexturePropertiesInternals {
   FIELDDB_ELEMENT( TextureProperties, textureCompareFailValue, INPUT_OUTPUT );
   FIELDDB_ELEMENT( TextureProperties, textureType, INPUT_OUTPUT );
   FIELDDB_ELEMENT( TextureProperties, textureFormat, INPUT_OUTPUT );
+  FIELDDB_ELEMENT( TextureProperties, releaseImage, INPUT_OUTPUT );
 }
 
 TextureProperties::TextureProperties( 
@@ -77,7 +78,8 @@ TextureProperties::TextureProperties(
                        Inst< SFString > _textureCompareMode,
                        Inst< SFFloat  > _textureCompareFailValue,
                        Inst< SFString > _textureType,
-                       Inst< SFString > _textureFormat ):
+                       Inst< SFString > _textureFormat,
+                       Inst< SFString > _releaseImage ):
   X3DNode( _metadata ),
   anisotropicDegree ( _anisotropicDegree  ),
   borderColor ( _borderColor  ),
@@ -96,6 +98,7 @@ TextureProperties::TextureProperties(
   textureCompareFailValue( _textureCompareFailValue ),
   textureType( _textureType ),
   textureFormat( _textureFormat ),
+  releaseImage( _releaseImage ),
   propertyChanged( new Field ) {
 
   type_name = "TextureProperties";
@@ -172,6 +175,10 @@ TextureProperties::TextureProperties(
   textureFormat->addValidValue( "FLOAT" );
   textureFormat->addValidValue( "SRGB" );
   textureFormat->setValue( "NORMAL" );
+  releaseImage->addValidValue( "DEFAULT" );
+  releaseImage->addValidValue( "RELEASE" );
+  releaseImage->addValidValue( "KEEP" );
+  releaseImage->setValue( "DEFAULT" );
 
   propertyChanged->setName( "propertyChanged" );
   anisotropicDegree->route( propertyChanged );
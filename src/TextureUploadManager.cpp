@@ -0,0 +1,314 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file TextureUploadManager.cpp
+/// \brief CPP file for TextureUploadManager.
+///
+//
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <H3D/TextureUploadManager.h>
+#include <H3D/GLStateTracker.h>
+#include <H3D/GraphicsOptions.h>
+#include <H3D/GlobalSettings.h>
+
+using namespace H3D;
+
+TextureUploadManager::Statistics TextureUploadManager::current_frame;
+TextureUploadManager::Statistics TextureUploadManager::last_frame;
+std::list< TextureUploadManager::Upload * > TextureUploadManager::uploads;
+GLuint TextureUploadManager::pbo = 0;
+unsigned int TextureUploadManager::frame_bytes = 0;
+H3DTime TextureUploadManager::frame_time = 0;
+
+namespace TextureUploadManagerInternals {
+  GLenum textureBindingQuery( GLenum target ) {
+    if( target == GL_TEXTURE_RECTANGLE_ARB )
+      return GL_TEXTURE_BINDING_RECTANGLE_ARB;
+    return GL_TEXTURE_BINDING_2D;
+  }
+
+  void setPixelTransfer( const Vec4f &scale, const Vec4f &bias ) {
+    glPixelTransferf( GL_RED_SCALE, scale.x );
+    glPixelTransferf( GL_BLUE_SCALE, scale.y );
+    glPixelTransferf( GL_GREEN_SCALE, scale.z );
+    glPixelTransferf( GL_ALPHA_SCALE, scale.w );
+    glPixelTransferf( GL_RED_BIAS, bias.x );
+    glPixelTransferf( GL_BLUE_BIAS, bias.y );
+    glPixelTransferf( GL_GREEN_BIAS, bias.z );
+    glPixelTransferf( GL_ALPHA_BIAS, bias.w );
+  }
+}
+
+bool TextureUploadManager::asyncUploads() {
+  GraphicsOptions *options = NULL;
+  GlobalSettings *default_settings = GlobalSettings::getActive();
+  if( default_settings ) default_settings->getOptionNode( options );
+  return options && options->asyncTextureUpload->getValue();
+}
+
+bool TextureUploadManager::canUpload( Image *image, GLenum target,
+                                      bool generate_mipmaps ) {
+  if( image->compressionType() != Image::NO_COMPRESSION ) return false;
+  if( image->bitsPerPixel() % 8 != 0 ) return false;
+  if( target != GL_TEXTURE_2D && target != GL_TEXTURE_RECTANGLE_ARB )
+    return false;
+  // the mipmaps can only be generated when the last slice is uploaded if
+  // it can be done on the graphics card.
+  if( generate_mipmaps &&
+      ( target != GL_TEXTURE_2D || !GLEW_EXT_framebuffer_object ) )
+    return false;
+  return true;
+}
+
+void TextureUploadManager::upload( GLenum target, Image *image,
+                                   GLint internal_format, GLenum format,
+                                   GLenum type, bool generate_mipmaps,
+                                   bool transfer,
+                                   const Vec4f &transfer_scale,
+                                   const Vec4f &transfer_bias ) {
+  using namespace TextureUploadManagerInternals;
+  GLint texture_id = 0;
+  glGetIntegerv( textureBindingQuery( target ), &texture_id );
+  cancel( texture_id );
+
+  glTexImage2D( target, 0, internal_format, image->width(), image->height(),
+                0, format, type, NULL );
+
+  Upload *u = new Upload;
+  u->texture_id = texture_id;
+  u->target = target;
+  u->image.reset( image );
+  u->format = format;
+  u->type = type;
+  u->generate_mipmaps = generate_mipmaps;
+  u->transfer = transfer;
+  u->transfer_scale = transfer_scale;
+  u->transfer_bias = transfer_bias;
+  u->row = 0;
+  uploads.push_back( u );
+}
+
+bool TextureUploadManager::isPending( GLuint texture_id ) {
+  for( std::list< Upload * >::iterator i = uploads.begin();
+       i != uploads.end(); ++i ) {
+    if( (*i)->texture_id == texture_id ) return true;
+  }
+  return false;
+}
+
+void TextureUploadManager::cancel( GLuint texture_id ) {
+  for( std::list< Upload * >::iterator i = uploads.begin();
+       i != uploads.end(); ++i ) {
+    if( (*i)->texture_id == texture_id ) {
+      delete *i;
+      uploads.erase( i );
+      return;
+    }
+  }
+}
+
+void TextureUploadManager::processUploads() {
+  if( uploads.empty() ) return;
+
+  H3DInt32 max_bytes = 4194304;
+  H3DTime max_time = 0.002;
+  GraphicsOptions *options = NULL;
+  GlobalSettings *default_settings = GlobalSettings::getActive();
+  if( default_settings ) default_settings->getOptionNode( options );
+  if( options ) {
+    max_bytes = options->textureUploadBudget->getValue();
+    max_time = options->textureUploadTimeBudget->getValue();
+  }
+
+  GLint byte_alignment;
+  glGetIntegerv( GL_UNPACK_ALIGNMENT, &byte_alignment );
+
+  H3DTime time_before = frame_time;
+  TimeStamp start;
+  while( !uploads.empty() &&
+         ( max_bytes <= 0 || frame_bytes < (unsigned int)max_bytes ) &&
+         ( max_time <= 0 || frame_time < max_time ) ) {
+    Upload *u = uploads.front();
+    GLenum target = u->target;
+    unsigned int bytes_left =
+      max_bytes > 0 ? max_bytes - frame_bytes : u->image->width() *
+      u->image->height() * u->image->bitsPerPixel() / 8;
+
+    GLStateTracker::bindTexture( target, u->texture_id );
+    unsigned int nr_bytes = uploadSlice( u, bytes_left );
+    frame_bytes += nr_bytes;
+    current_frame.nr_bytes += nr_bytes;
+    ++current_frame.nr_slices;
+
+    if( u->row >= u->image->height() ) {
+      if( u->generate_mipmaps ) generateMipmaps( target );
+      ++current_frame.nr_completed;
+      uploads.pop_front();
+      delete u;
+    }
+    GLStateTracker::bindTexture( target, 0 );
+    frame_time = time_before + ( TimeStamp() - start );
+  }
+
+  glPixelStorei( GL_UNPACK_ALIGNMENT, byte_alignment );
+}
+
+unsigned int TextureUploadManager::uploadSlice( Upload *upload,
+                                                unsigned int max_bytes ) {
+  using namespace TextureUploadManagerInternals;
+  Image *image = upload->image.get();
+  unsigned int width = image->width();
+  unsigned int height = image->height();
+  unsigned int alignment = image->byteAlignment();
+  unsigned int row_bytes = width * ( image->bitsPerPixel() / 8 );
+  if( row_bytes % alignment != 0 )
+    row_bytes += alignment - row_bytes % alignment;
+
+  unsigned int nr_rows = H3DMax( max_bytes / row_bytes, 1u );
+  nr_rows = H3DMin( nr_rows, height - upload->row );
+  unsigned int nr_bytes = nr_rows * row_bytes;
+  unsigned char *data =
+    (unsigned char *)image->getImageData() + upload->row * row_bytes;
+
+  glPixelStorei( GL_UNPACK_ALIGNMENT, alignment );
+  if( upload->transfer ) {
+    GLStateTracker::pushAttrib( GL_PIXEL_MODE_BIT );
+    setPixelTransfer( upload->transfer_scale, upload->transfer_bias );
+  }
+
+  bool use_pbo = false;
+  if( GLEW_ARB_pixel_buffer_object ) {
+    if( !pbo ) glGenBuffersARB( 1, &pbo );
+    glBindBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, pbo );
+    // give the buffer new storage so that the driver does not have to
+    // wait for the transfer of the previous slice to finish.
+    glBufferDataARB( GL_PIXEL_UNPACK_BUFFER_ARB, nr_bytes, NULL,
+                     GL_STREAM_DRAW_ARB );
+    void *mapped = glMapBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB,
+                                   GL_WRITE_ONLY_ARB );
+    if( mapped ) {
+      memcpy( mapped, data, nr_bytes );
+      glUnmapBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB );
+      use_pbo = true;
+    } else {
+      glBindBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, 0 );
+    }
+  }
+
+  glTexSubImage2D( upload->target, 0, 0, upload->row, width, nr_rows,
+                   upload->format, upload->type,
+                   use_pbo ? NULL : data );
+
+  if( use_pbo ) glBindBufferARB( GL_PIXEL_UNPACK_BUFFER_ARB, 0 );
+  if( upload->transfer ) GLStateTracker::popAttrib();
+
+  upload->row += nr_rows;
+  return nr_bytes;
+}
+
+void TextureUploadManager::beginFrame() {
+  current_frame.nr_pending = (unsigned int)uploads.size();
+  last_frame = current_frame;
+  current_frame.reset();
+  frame_bytes = 0;
+  frame_time = 0;
+}
+
+bool TextureUploadManager::scaleImage2D( GLenum target, Image *image,
+                                         GLint internal_format,
+                                         GLenum format, GLenum type,
+                                         unsigned int new_width,
+                                         unsigned int new_height ) {
+  using namespace TextureUploadManagerInternals;
+  if( !GLEW_EXT_framebuffer_object || !GLEW_EXT_framebuffer_blit )
+    return false;
+  if( image->compressionType() != Image::NO_COMPRESSION ) return false;
+  if( target != GL_TEXTURE_2D && target != GL_TEXTURE_RECTANGLE_ARB )
+    return false;
+  // only formats that can be rendered to are scaled.
+  Image::PixelType pixel_type = image->pixelType();
+  if( pixel_type != Image::RGB && pixel_type != Image::RGBA &&
+      pixel_type != Image::BGR && pixel_type != Image::BGRA )
+    return false;
+
+  GLint texture_id = 0;
+  glGetIntegerv( textureBindingQuery( target ), &texture_id );
+
+  // upload the image in its own size to a temporary texture.
+  GLuint tmp_texture_id;
+  glGenTextures( 1, &tmp_texture_id );
+  GLStateTracker::bindTexture( target, tmp_texture_id );
+  glTexParameteri( target, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+  glTexParameteri( target, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+  glTexImage2D( target, 0, internal_format, image->width(), image->height(),
+                0, format, type, image->getImageData() );
+
+  GLStateTracker::bindTexture( target, texture_id );
+  glTexImage2D( target, 0, internal_format, new_width, new_height,
+                0, format, type, NULL );
+
+  GLint read_fbo, draw_fbo;
+  glGetIntegerv( GL_READ_FRAMEBUFFER_BINDING_EXT, &read_fbo );
+  glGetIntegerv( GL_DRAW_FRAMEBUFFER_BINDING_EXT, &draw_fbo );
+
+  GLuint fbo_ids[2];
+  glGenFramebuffersEXT( 2, fbo_ids );
+  glBindFramebufferEXT( GL_READ_FRAMEBUFFER_EXT, fbo_ids[0] );
+  glFramebufferTexture2DEXT( GL_READ_FRAMEBUFFER_EXT,
+                             GL_COLOR_ATTACHMENT0_EXT,
+                             target, tmp_texture_id, 0 );
+  glBindFramebufferEXT( GL_DRAW_FRAMEBUFFER_EXT, fbo_ids[1] );
+  glFramebufferTexture2DEXT( GL_DRAW_FRAMEBUFFER_EXT,
+                             GL_COLOR_ATTACHMENT0_EXT,
+                             target, texture_id, 0 );
+
+  bool complete =
+    glCheckFramebufferStatusEXT( GL_READ_FRAMEBUFFER_EXT ) ==
+    GL_FRAMEBUFFER_COMPLETE_EXT &&
+    glCheckFramebufferStatusEXT( GL_DRAW_FRAMEBUFFER_EXT ) ==
+    GL_FRAMEBUFFER_COMPLETE_EXT;
+
+  if( complete ) {
+    GLStateTracker::pushAttrib( GL_SCISSOR_BIT );
+    GLStateTracker::disable( GL_SCISSOR_TEST );
+    glBlitFramebufferEXT( 0, 0, image->width(), image->height(),
+                          0, 0, new_width, new_height,
+                          GL_COLOR_BUFFER_BIT, GL_LINEAR );
+    GLStateTracker::popAttrib();
+  }
+
+  glBindFramebufferEXT( GL_READ_FRAMEBUFFER_EXT, read_fbo );
+  glBindFramebufferEXT( GL_DRAW_FRAMEBUFFER_EXT, draw_fbo );
+  glDeleteFramebuffersEXT( 2, fbo_ids );
+  GLStateTracker::deleteTextures( 1, &tmp_texture_id );
+  GLStateTracker::bindTexture( target, texture_id );
+  return complete;
+}
+
+bool TextureUploadManager::generateMipmaps( GLenum target ) {
+  if( target != GL_TEXTURE_2D || !GLEW_EXT_framebuffer_object ) return false;
+  glGenerateMipmapEXT( target );
+  return true;
+}
@@ -30,6 +30,7 @@
 
 #include <H3D/TriangleFanSet.h>
 #include <H3D/Normal.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -136,7 +137,7 @@ void TriangleFanSet::render() {
 
     // set fog to get fog depth from fog coordinates if available
     if( GLEW_EXT_fog_coord && fog_coord_node ) {
-      glPushAttrib( GL_FOG_BIT );
+      GLStateTracker::pushAttrib( GL_FOG_BIT );
       glFogi(GL_FOG_COORDINATE_SOURCE_EXT, GL_FOG_COORDINATE_EXT);
     }    
 
@@ -297,7 +298,7 @@ void TriangleFanSet::render() {
 
     // restore previous fog attributes
     if( GLEW_EXT_fog_coord && fog_coord_node ) {
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }  
     
     // disable texture coordinate generation.
@@ -32,6 +32,7 @@
 #include <H3D/MultiTexture.h>
 #include <H3D/GlobalSettings.h>
 #include <H3D/GraphicsOptions.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -101,21 +102,21 @@ void TriangleSet2D::render() {
     if( mt ) {
       size_t texture_units = mt->texture->size();
       for( size_t i = 0; i < texture_units; ++i ) {
-        glActiveTexture( GL_TEXTURE0_ARB + (unsigned int) i );
+        GLStateTracker::activeTexture( GL_TEXTURE0_ARB + (unsigned int) i );
         glTexGend( GL_S, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
         glTexGend( GL_T, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
         glTexGenfv( GL_S, GL_OBJECT_PLANE, sparams );
         glTexGenfv( GL_T, GL_OBJECT_PLANE, tparams );
-        glEnable( GL_TEXTURE_GEN_S );
-        glEnable( GL_TEXTURE_GEN_T );
+        GLStateTracker::enable( GL_TEXTURE_GEN_S );
+        GLStateTracker::enable( GL_TEXTURE_GEN_T );
       }
     } else {
       glTexGend( GL_S, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
       glTexGend( GL_T, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
       glTexGenfv( GL_S, GL_OBJECT_PLANE, sparams );
       glTexGenfv( GL_T, GL_OBJECT_PLANE, tparams );
-      glEnable( GL_TEXTURE_GEN_S );
-      glEnable( GL_TEXTURE_GEN_T );
+      GLStateTracker::enable( GL_TEXTURE_GEN_S );
+      GLStateTracker::enable( GL_TEXTURE_GEN_T );
     }
   }
 
@@ -173,13 +174,13 @@ void TriangleSet2D::render() {
   if( bb && mt ) {
     size_t texture_units = mt->texture->size();
     for( size_t i = 0; i < texture_units; ++i ) {
-      glActiveTexture( GL_TEXTURE0_ARB + (unsigned int) i );
-      glDisable( GL_TEXTURE_GEN_S );
-      glDisable( GL_TEXTURE_GEN_T );
+      GLStateTracker::activeTexture( GL_TEXTURE0_ARB + (unsigned int) i );
+      GLStateTracker::disable( GL_TEXTURE_GEN_S );
+      GLStateTracker::disable( GL_TEXTURE_GEN_T );
     }
   } else {
-      glDisable( GL_TEXTURE_GEN_S );
-      glDisable( GL_TEXTURE_GEN_T );
+      GLStateTracker::disable( GL_TEXTURE_GEN_S );
+      GLStateTracker::disable( GL_TEXTURE_GEN_T );
   }
 }
 
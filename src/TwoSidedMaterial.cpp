@@ -31,6 +31,7 @@
 #include <H3D/TwoSidedMaterial.h>
 #include <H3D/X3DTexture2DNode.h>
 #include <H3D/X3DTexture3DNode.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -131,7 +132,7 @@ void TwoSidedMaterial::render()  {
   H3DFloat t = transparency->getValue();
   material[3] = 1 - t;
   if( isTransparent() ) {
-    glEnable( GL_BLEND );
+    GLStateTracker::enable( GL_BLEND );
     glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
   }
 
@@ -100,11 +100,56 @@ void VrmlDriver::error (const std::string& m) {
 }
 
 
-void VrmlDriver::setFieldValue( const char *v ) {
+namespace VrmlDriverInternals {
+  // Returns true if values of the given type are parsed by the numeric
+  // MF field parser of X3DStringToVector, which accepts commas as
+  // separators anywhere.
+  bool isNumericMFType( X3DTypes::X3DType type ) {
+    switch( type ) {
+    case X3DTypes::MFFLOAT:
+    case X3DTypes::MFDOUBLE:
+    case X3DTypes::MFTIME:
+    case X3DTypes::MFINT32:
+    case X3DTypes::MFVEC2F:
+    case X3DTypes::MFVEC3F:
+    case X3DTypes::MFVEC4F:
+    case X3DTypes::MFVEC2D:
+    case X3DTypes::MFVEC3D:
+    case X3DTypes::MFVEC4D:
+    case X3DTypes::MFCOLOR:
+    case X3DTypes::MFCOLORRGBA:
+    case X3DTypes::MFROTATION:
+      return true;
+    default:
+      return false;
+    }
+  }
+}
+
+void VrmlDriver::setFieldValue( const string &value ) {
   Node *node = node_stack.back();
   if ( !node ) return;
   Field *field = node->getField( field_stack.back() );
 
+  // numeric arrays without comments are passed on to the field value
+  // parser as they are, e.g. coordinates and indices of large meshes.
+  if( field && VrmlDriverInternals::isNumericMFType( field->getX3DType() ) &&
+      value.find( '#' ) == string::npos ) {
+    if( ParsableField *pfield = dynamic_cast< ParsableField * >( field ) ) {
+      try {
+        pfield->setValueFromString( value );
+      } catch( const Convert::X3DFieldConversionError & ) {
+        Console(LogLevel::Warning) << "Warning: Could not convert field " 
+                   << field->getName() << " argument in node "
+                   << node->getName() << " ( " << getOldLocationString()
+                   << " ) " << endl;
+      }
+      return;
+    }
+  }
+
+  const char *v = value.c_str();
+
   // trim field value... remove any outer quotes and trailing whitespace
   // that comes after those quotes:
   const char *p=v;
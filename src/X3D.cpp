@@ -32,11 +32,15 @@
 #ifdef HAVE_XERCES
 #include <H3D/X3DSAX2Handlers.h>
 #include <H3D/IStreamInputSource.h>
+#include <xercesc/framework/MemBufInputSource.hpp>
 #endif
 
 #include <H3D/ResourceResolver.h>
 #include <H3D/VrmlParser.h>
+#include <H3D/X3DBinary.h>
 #include <H3D/X3DGeometryNode.h>
+#include <H3D/SceneSnapshotCache.h>
+#include <H3D/MappedBuffer.h>
 #include <sstream>
 
 #ifdef HAVE_ZLIB
@@ -48,10 +52,59 @@
 
 using namespace H3D;
 
+namespace H3D {
+  namespace X3D {
+    // Create the nodes in the file given by url without using the
+    // SceneSnapshotCache.
+    Group* parseX3DFromURL( const string &url,
+                            DEFNodes *dn,
+                            DEFNodes *exported_nodes,
+                            PrototypeVector *prototypes,
+                            bool change_base_path_during_parsing );
+  }
+}
+
+#ifdef HAVE_XERCES
+namespace X3DInternals {
+  // Parse the XML file with the given name. The parser reads the file
+  // straight from a memory mapping of it if possible, so the file is
+  // never copied into memory as a whole. Otherwise it is read in chunks
+  // from an ifstream.
+  void parseXMLFile( SAX2XMLReader *parser,
+                     const string &file,
+                     const string &system_id ) {
+    XERCES_CPP_NAMESPACE_USE
+    XMLCh *system_id_ch = new XMLCh[ system_id.size() + 1 ];
+    for( unsigned int i = 0; i < system_id.size(); ++i ) {
+      system_id_ch[i] = system_id[i];
+    }
+    system_id_ch[ system_id.size() ] = '\0';
+    try {
+      AutoRef< MappedBuffer > buffer = MappedBuffer::getBuffer( file );
+      if( buffer.get() ) {
+        parser->parse( MemBufInputSource( buffer->getData(),
+                                          buffer->getSize(),
+                                          system_id_ch ) );
+      } else {
+        ifstream is( file.c_str() );
+        parser->parse( IStreamInputSource( is, system_id_ch ) );
+        is.close();
+      }
+    } catch(...) {
+      delete[] system_id_ch;
+      throw;
+    }
+    delete[] system_id_ch;
+  }
+}
+#endif
+
 Group* X3D::createX3DFromString( const string &str,
                                  DEFNodes *dn,
                                  DEFNodes *exported_nodes,
                                  PrototypeVector *prototypes  ) {
+  if( isX3DBinary( str ) )
+    return createX3DBinaryFromString( str, dn, exported_nodes, prototypes );
   if ( isVRML( str ) )
     return createVRMLFromString( str, dn, exported_nodes, prototypes );
   Group *g = new Group;
@@ -68,6 +121,77 @@ Group* X3D::createX3DFromURL( const string &url,
                               DEFNodes *exported_nodes,
                               PrototypeVector *prototypes,
                               bool change_base_path_during_parsing ) {
+  // Nodes and PROTOs that exist before parsing could be used by the file
+  // and would then be copied into the snapshot, so the cache is only used
+  // when starting from empty structures.
+  string file;
+  if( SceneSnapshotCache::getCacheDirectory() != "" &&
+      !( dn && !dn->empty() ) &&
+      !( exported_nodes && !exported_nodes->empty() ) &&
+      !( prototypes && !prototypes->empty() ) ) {
+    file = ResourceResolver::resolveURLAsLocalFile( url );
+  }
+  if( file == "" )
+    return parseX3DFromURL( url, dn, exported_nodes, prototypes,
+                            change_base_path_during_parsing );
+
+  // the nodes are created with the same base URL as when parsing.
+  string old_base = ResourceResolver::getBaseURL();
+  if( change_base_path_during_parsing ) {
+    string::size_type pos = file.find_last_of( "/\\" );
+    ResourceResolver::setBaseURL( file.substr( 0, pos + 1 ) );
+  }
+  AutoRef< Node > snapshot;
+  bool loaded = false;
+  try {
+    loaded = SceneSnapshotCache::loadSnapshot( file, snapshot, dn, prototypes );
+  } catch(...) {
+    ResourceResolver::setBaseURL( old_base );
+    throw;
+  }
+  ResourceResolver::setBaseURL( old_base );
+
+  if( Group *snapshot_group = dynamic_cast< Group * >( snapshot.get() ) ) {
+    Group *g = new Group;
+    const NodeVector &children = snapshot_group->children->getValue();
+    for( unsigned int i = 0; i < children.size(); ++i )
+      g->children->push_back( children[i] );
+    return g;
+  } else if( loaded ) {
+    // not a snapshot made by this function, parse the file instead.
+    if( dn ) dn->clear();
+    if( prototypes ) {
+      prototypes->clear();
+      prototypes->setFirstProtoDeclaration( NULL );
+    }
+  }
+
+  DEFNodes local_exported_nodes;
+  PrototypeVector local_prototypes;
+  if( !exported_nodes ) exported_nodes = &local_exported_nodes;
+  if( !prototypes ) prototypes = &local_prototypes;
+
+  Group *g = NULL;
+  vector< string > dependencies;
+  ResourceResolver::beginDependencyRecording();
+  try {
+    g = parseX3DFromURL( url, dn, exported_nodes, prototypes,
+                         change_base_path_during_parsing );
+  } catch(...) {
+    ResourceResolver::endDependencyRecording( dependencies );
+    throw;
+  }
+  bool local_only = ResourceResolver::endDependencyRecording( dependencies );
+  if( g && local_only && exported_nodes->empty() )
+    SceneSnapshotCache::saveSnapshot( file, g, prototypes, dependencies );
+  return g;
+}
+
+Group* X3D::parseX3DFromURL( const string &url,
+                             DEFNodes *dn,
+                             DEFNodes *exported_nodes,
+                             PrototypeVector *prototypes,
+                             bool change_base_path_during_parsing ) {
   // First try to resolve the url to file contents and load via string buffer
   // Otherwise fallback on using temp files
   string url_contents= ResourceResolver::resolveURLAsString ( url );
@@ -164,6 +288,19 @@ Group* X3D::createX3DFromURL( const string &url,
 #endif
 
 
+    ifstream isbinary( resolved_url.c_str(), ios::binary );
+    if( isX3DBinary( isbinary ) ) {
+      isbinary.seekg( 0 );
+      Group *g = createX3DBinaryFromStream( isbinary, dn,
+                                            exported_nodes, prototypes );
+      isbinary.close();
+      if( is_tmp_file ) 
+        ResourceResolver::releaseTmpFileName( resolved_url );
+      ResourceResolver::setBaseURL( old_base );
+      return g;
+    }
+    isbinary.close();
+
     ifstream istest( resolved_url.c_str() );
     if ( isVRML( istest ) ) {
       istest.close();
@@ -178,22 +315,8 @@ Group* X3D::createX3DFromURL( const string &url,
     istest.close();
 
     #ifdef HAVE_XERCES
-    XERCES_CPP_NAMESPACE_USE
     // else...
-    ifstream is( resolved_url.c_str() );
-    XMLCh *url_ch = new XMLCh[ url.size() + 1 ];
-    for( unsigned int i = 0; i < url.size(); ++i ) {
-      url_ch[i] = url[i];
-    }
-    url_ch[ url.size() ] = '\0'; 
-    try {
-      parser->parse( IStreamInputSource( is, url_ch ) );
-    } catch(...) {
-      delete[] url_ch;
-      throw;
-    }
-    delete[] url_ch;
-    is.close();
+    X3DInternals::parseXMLFile( parser.get(), resolved_url, url );
 #endif   
   }
   if( is_tmp_file ) 
@@ -231,18 +354,22 @@ AutoRef< Node > X3D::createX3DNodeFromString( const string &str,
                                               DEFNodes *dn,
                                               DEFNodes *exported_nodes,
                                               PrototypeVector *prototypes ) {
+  if( isX3DBinary( str ) )
+    return createX3DBinaryNodeFromString( str, dn, exported_nodes,
+                                          prototypes );
   if ( isVRML( str ) )
     return createVRMLNodeFromString( str, dn, exported_nodes, prototypes );
   else {
 #ifdef HAVE_XERCES
     auto_ptr< SAX2XMLReader > parser( getNewXMLParser() );
     X3DSAX2Handlers handler( dn, exported_nodes, prototypes );
-    stringstream s;
-    s << str;
     parser->setContentHandler(&handler);
     parser->setErrorHandler(&handler); 
     parser->setLexicalHandler( &handler );
-    parser->parse( IStreamInputSource( s, (const XMLCh*)L"<string input>" ) );
+    // parse the string where it is instead of copying it to a stream.
+    parser->parse( MemBufInputSource( (const XMLByte *)str.data(),
+                                      str.size(),
+                                      "<string input>" ) );
     return handler.getResultingNode();
 #else
   Console(LogLevel::Warning) << "H3D API compiled without HAVE_XERCES flag. X3D-XML files "
@@ -353,6 +480,20 @@ AutoRef< Node > X3D::createX3DNodeFromURL( const string &url,
 #endif
 
 
+    ifstream isbinary( resolved_url.c_str(), ios::binary );
+    if( isX3DBinary( isbinary ) ) {
+      isbinary.seekg( 0 );
+      AutoRef< Node > n = createX3DBinaryNodeFromStream( isbinary, dn,
+                                                         exported_nodes,
+                                                         prototypes );
+      isbinary.close();
+      if( is_tmp_file ) 
+        ResourceResolver::releaseTmpFileName( resolved_url );
+      ResourceResolver::setBaseURL( old_base );
+      return n;
+    }
+    isbinary.close();
+
     ifstream istest( resolved_url.c_str() );
     if ( isVRML( istest ) ) {
       istest.close();
@@ -370,17 +511,8 @@ AutoRef< Node > X3D::createX3DNodeFromURL( const string &url,
     istest.close();
 
 #ifdef HAVE_XERCES
-    XERCES_CPP_NAMESPACE_USE
     // else...
-    ifstream is( resolved_url.c_str() );
-    XMLCh *url_ch = new XMLCh[ url.size() + 1 ];
-    for( unsigned int i = 0; i < url.size(); ++i ) {
-      url_ch[i] = url[i];
-    }
-    url_ch[ url.size() ] = '\0'; 
-    parser->parse( IStreamInputSource( is, url_ch ) );
-    delete[] url_ch;
-    is.close();
+    X3DInternals::parseXMLFile( parser.get(), resolved_url, url );
 #endif   
   }
   if( is_tmp_file ) 
@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/X3DBackgroundNode.h>
+#include <H3D/GLStateTracker.h>
 #include <assert.h>
 
 using namespace H3D;
@@ -120,7 +121,7 @@ RGB getColor( H3DFloat theta,
 
 void X3DBackgroundNode::render() {
   if( render_enabled ) {
-    glPushAttrib( GL_ALL_ATTRIB_BITS );
+    GLStateTracker::pushAttrib( GL_ALL_ATTRIB_BITS );
     assert( skyColor->size() > skyAngle->size() );
     Vec3f c = Vec3f( 0, 0, 0 );
     int n = 40;
@@ -132,10 +133,10 @@ void X3DBackgroundNode::render() {
     const vector< H3DFloat > &ground_angle = groundAngle->getValue();
 
     glCullFace( GL_BACK );
-    glEnable( GL_CULL_FACE );
-    glEnable( GL_BLEND );
+    GLStateTracker::enable( GL_CULL_FACE );
+    GLStateTracker::enable( GL_BLEND );
     glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-    glDisable( GL_LIGHTING );
+    GLStateTracker::disable( GL_LIGHTING );
 
     H3DFloat alpha = 1 - transparency->getValue();
     Matrix4d pm = projectionMatrix->getValue();
@@ -238,7 +239,7 @@ void X3DBackgroundNode::render() {
     glPopMatrix();
     glMatrixMode( GL_PROJECTION );
     glPopMatrix();
-    glPopAttrib();
+    GLStateTracker::popAttrib();
   }
 }
 
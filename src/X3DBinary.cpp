@@ -0,0 +1,1048 @@
+//////////////////////////////////////////////////////////////////////////////
+//    Copyright 2004-2014, SenseGraphics AB
+//
+//    This file is part of H3D API.
+//
+//    H3D API is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    H3D API is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with H3D API; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//    A commercial license is also available. Please contact us at
+//    www.sensegraphics.com for more information.
+//
+//
+/// \file X3DBinary.cpp
+/// \brief CPP file for reading and writing the binary scene encoding.
+///
+//
+//
+//////////////////////////////////////////////////////////////////////////////
+
+#include <H3D/X3DBinary.h>
+#include <H3D/X3DTypeFunctions.h>
+#include <H3D/X3DFieldConversion.h>
+#include <H3D/H3DDynamicFieldsObject.h>
+#include <H3D/PrototypeInstance.h>
+#include <H3D/MFFloat.h>
+#include <H3D/MFDouble.h>
+#include <H3D/MFInt32.h>
+#include <H3D/MFVec2f.h>
+#include <H3D/MFVec3f.h>
+#include <H3D/MFVec4f.h>
+#include <H3D/MFVec2d.h>
+#include <H3D/MFVec3d.h>
+#include <H3D/MFVec4d.h>
+#include <H3D/MFColor.h>
+#include <H3D/MFColorRGBA.h>
+#include <H3D/MFRotation.h>
+#include <H3D/MFNode.h>
+
+#include <sstream>
+#include <cstring>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+using namespace H3D;
+
+namespace X3DBinaryInternals {
+  const char magic[] = { 'H', '3', 'D', 'B' };
+  const H3DUInt32 version = 1;
+  // The size of the header, i.e. the offset of the first node record.
+  const H3DUInt32 header_size = 16;
+  // String index for no string. Also ends the field records of a node.
+  const H3DUInt32 no_string = 0xFFFFFFFF;
+
+  // Node record tags.
+  enum NodeTag {
+    NULL_NODE = 0,
+    NEW_NODE = 1,
+    USE_NODE = 2,
+    PROTO_INSTANCE = 3
+  };
+
+  // Field value kinds. DYNAMIC_FIELD is set for fields that are added
+  // to the node when read.
+  enum ValueKind {
+    VALUE_NONE = 0,
+    VALUE_STRING = 1,
+    VALUE_ARRAY = 2,
+    VALUE_SFNODE = 3,
+    VALUE_MFNODE = 4,
+    DYNAMIC_FIELD = 0x80
+  };
+
+  // Component types of arrays.
+  enum ComponentType {
+    FLOAT_COMPONENT = 0,
+    DOUBLE_COMPONENT = 1,
+    INT32_COMPONENT = 2
+  };
+
+  // Encoding flags of arrays.
+  enum ArrayEncoding {
+    QUANTIZED = 1,
+    DEFLATED = 2
+  };
+
+  // The largest size in bytes of the values of an array, since the size
+  // is given to setValueFromVoidPtr as an unsigned int.
+  const unsigned long long max_array_size = 0x7FFFFFFF;
+  // deflate compresses at most about 1032 to 1, so a compressed array
+  // claiming a larger raw size than this times its stored size is corrupt.
+  const unsigned long long max_deflate_ratio = 1032;
+
+  inline bool isLittleEndian() {
+    H3DUInt32 i = 1;
+    return *(unsigned char *)&i == 1;
+  }
+
+  inline unsigned int componentSize( unsigned char component_type ) {
+    if( component_type == FLOAT_COMPONENT ) return sizeof( H3DFloat );
+    if( component_type == DOUBLE_COMPONENT ) return sizeof( H3DDouble );
+    if( component_type == INT32_COMPONENT ) return sizeof( H3DInt32 );
+    return 0;
+  }
+
+  // Returns true if the field is an MField of a type that is stored as
+  // an array. component_type and nr_components are set to the layout of
+  // its values.
+  template< class Type >
+  inline bool isMField( Field *f ) {
+    return dynamic_cast< MField< Type > * >( f ) != NULL;
+  }
+
+  bool getArrayType( Field *f,
+                     unsigned char &component_type,
+                     unsigned int &nr_components ) {
+    if( isMField< H3DFloat >( f ) ) {
+      component_type = FLOAT_COMPONENT; nr_components = 1;
+    } else if( isMField< H3DDouble >( f ) ) {
+      component_type = DOUBLE_COMPONENT; nr_components = 1;
+    } else if( isMField< H3DInt32 >( f ) ) {
+      component_type = INT32_COMPONENT; nr_components = 1;
+    } else if( isMField< Vec2f >( f ) ) {
+      component_type = FLOAT_COMPONENT; nr_components = 2;
+    } else if( isMField< Vec3f >( f ) ) {
+      component_type = FLOAT_COMPONENT; nr_components = 3;
+    } else if( isMField< Vec4f >( f ) ) {
+      component_type = FLOAT_COMPONENT; nr_components = 4;
+    } else if( isMField< Vec2d >( f ) ) {
+      component_type = DOUBLE_COMPONENT; nr_components = 2;
+    } else if( isMField< Vec3d >( f ) ) {
+      component_type = DOUBLE_COMPONENT; nr_components = 3;
+    } else if( isMField< Vec4d >( f ) ) {
+      component_type = DOUBLE_COMPONENT; nr_components = 4;
+    } else if( isMField< RGB >( f ) ) {
+      component_type = FLOAT_COMPONENT; nr_components = 3;
+    } else if( isMField< RGBA >( f ) ) {
+      component_type = FLOAT_COMPONENT; nr_components = 4;
+    } else if( isMField< Rotation >( f ) ) {
+      component_type = FLOAT_COMPONENT; nr_components = 4;
+    } else {
+      return false;
+    }
+
+    // the values are copied to and from memory as is, so they must not
+    // contain anything but the components.
+    MFieldClass *mf = dynamic_cast< MFieldClass * >( f );
+    return mf &&
+      mf->valueTypeSize() == nr_components * componentSize( component_type );
+  }
+
+  // Reverse the byte order of count values of size bytes each.
+  void swapBytes( char *data, unsigned int size, size_t count ) {
+    for( size_t i = 0; i < count; ++i, data += size ) {
+      for( unsigned int j = 0; j < size / 2; ++j ) {
+        std::swap( data[j], data[size - 1 - j] );
+      }
+    }
+  }
+
+  void writeByte( ostream &os, unsigned char v ) {
+    os.put( (char)v );
+  }
+
+  void writeUInt32( ostream &os, H3DUInt32 v ) {
+    char b[4] = { (char)( v & 0xFF ), (char)( ( v >> 8 ) & 0xFF ),
+                  (char)( ( v >> 16 ) & 0xFF ), (char)( ( v >> 24 ) & 0xFF ) };
+    os.write( b, 4 );
+  }
+
+  void writeString( ostream &os, const string &s ) {
+    writeUInt32( os, (H3DUInt32)s.size() );
+    os.write( s.data(), s.size() );
+  }
+
+  // Write count values of size bytes each in little endian byte order.
+  void writeLittleEndian( ostream &os, const char *data,
+                          unsigned int size, size_t count ) {
+    if( isLittleEndian() ) {
+      os.write( data, size * count );
+    } else {
+      vector< char > swapped( data, data + size * count );
+      swapBytes( &swapped[0], size, count );
+      os.write( &swapped[0], swapped.size() );
+    }
+  }
+
+  /// Writes the node records of a scene graph. The records are written
+  /// to body, the names used are collected in strings.
+  class Writer {
+  public:
+    Writer( X3D::PrototypeVector *_prototypes, bool _compress,
+            bool _quantize ) :
+      prototypes( _prototypes ),
+      compress( _compress ),
+      quantize( _quantize ) {}
+
+    void writePrototypes();
+    void writeNode( Node *node );
+    void writeRoutes();
+
+    /// Write the header, the records and the string table to os.
+    void writeAll( ostream &os );
+
+  protected:
+    H3DUInt32 stringId( const string &s );
+    Node *getDefaultNode( const string &type_name );
+    bool isWrittenProto( PrototypeInstance *pi );
+    void writeField( const string &name, Field *f, Field *default_field,
+                     bool dynamic );
+    bool arrayEquals( Field *f, Field *g );
+    void writeArray( Field *f, unsigned char component_type,
+                     unsigned int nr_components );
+    void align();
+
+    X3D::PrototypeVector *prototypes;
+    bool compress;
+    bool quantize;
+    stringstream body;
+    map< string, H3DUInt32 > string_ids;
+    vector< string > strings;
+    map< Node *, H3DUInt32 > node_ids;
+    vector< Node * > nodes;
+    map< string, AutoRef< Node > > default_nodes;
+  };
+
+  H3DUInt32 Writer::stringId( const string &s ) {
+    map< string, H3DUInt32 >::iterator i = string_ids.find( s );
+    if( i != string_ids.end() ) return (*i).second;
+    H3DUInt32 id = (H3DUInt32)strings.size();
+    string_ids[s] = id;
+    strings.push_back( s );
+    return id;
+  }
+
+  Node *Writer::getDefaultNode( const string &type_name ) {
+    map< string, AutoRef< Node > >::iterator i =
+      default_nodes.find( type_name );
+    if( i != default_nodes.end() ) return (*i).second.get();
+    Node *n = H3DNodeDatabase::createNode( type_name );
+    default_nodes[ type_name ].reset( n );
+    return n;
+  }
+
+  bool Writer::isWrittenProto( PrototypeInstance *pi ) {
+    return prototypes && pi->getProtoName() != "" &&
+      prototypes->getProtoDeclaration( pi->getProtoName() );
+  }
+
+  void Writer::align() {
+    // the header is a multiple of 8 bytes so aligning the position in
+    // the body aligns the position in the file.
+    while( (streamoff)body.tellp() % 8 != 0 ) body.put( 0 );
+  }
+
+  void Writer::writePrototypes() {
+    if( !prototypes ) {
+      writeUInt32( body, 0 );
+      return;
+    }
+    writeUInt32( body, (H3DUInt32)prototypes->size() );
+    for( X3D::PrototypeVector::const_iterator i = prototypes->begin();
+         i != prototypes->end(); ++i ) {
+      ProtoDeclaration *pd = *i;
+      writeString( body, pd->getName() );
+      writeString( body, pd->getProtoBody() );
+      const vector< string > &extra = pd->getProtoBodyExtra();
+      writeUInt32( body, (H3DUInt32)extra.size() );
+      for( unsigned int j = 0; j < extra.size(); ++j )
+        writeString( body, extra[j] );
+      const std::list< ProtoDeclaration::FieldDeclaration > &fields =
+        pd->getFieldDeclarations();
+      writeUInt32( body, (H3DUInt32)fields.size() );
+      for( std::list< ProtoDeclaration::FieldDeclaration >::const_iterator j =
+             fields.begin(); j != fields.end(); ++j ) {
+        writeString( body, (*j).name );
+        writeByte( body, (unsigned char)(*j).type );
+        writeByte( body, (unsigned char)(*j).access_type );
+        writeString( body, (*j).value );
+      }
+    }
+  }
+
+  void Writer::writeNode( Node *node ) {
+    if( !node ) {
+      writeByte( body, NULL_NODE );
+      return;
+    }
+
+    PrototypeInstance *pi = dynamic_cast< PrototypeInstance * >( node );
+    bool proto = pi && isWrittenProto( pi );
+    if( pi && !proto ) {
+      // write the nodes the instance is made of instead.
+      writeNode( pi->getPrototypedNode() );
+      return;
+    }
+
+    map< Node *, H3DUInt32 >::iterator i = node_ids.find( node );
+    if( i != node_ids.end() ) {
+      writeByte( body, USE_NODE );
+      writeUInt32( body, (*i).second );
+      return;
+    }
+    node_ids[ node ] = (H3DUInt32)nodes.size();
+    nodes.push_back( node );
+
+    Node *default_node = NULL;
+    H3DDynamicFieldsObject *dyn_f_obj = NULL;
+    if( proto ) {
+      writeByte( body, PROTO_INSTANCE );
+      writeUInt32( body, stringId( pi->getProtoName() ) );
+    } else {
+      writeByte( body, NEW_NODE );
+      writeUInt32( body, stringId( node->getTypeName() ) );
+      default_node = getDefaultNode( node->getTypeName() );
+      dyn_f_obj = dynamic_cast< H3DDynamicFieldsObject * >( node );
+    }
+    writeUInt32( body, node->hasName() ? stringId( node->getName() ) :
+                                         no_string );
+
+    H3DNodeDatabase *db = H3DNodeDatabase::lookupNodeInstance( node );
+    for( H3DNodeDatabase::FieldDBConstIterator k = db->fieldDBBegin();
+         k != db->fieldDBEnd(); ++k ) {
+      Field *f = node->getField( *k );
+      if( !f ) continue;
+      // the fields of a prototype instance are created from its
+      // declaration so only dynamic fields of other nodes are declared.
+      bool dynamic_field = false;
+      if( dyn_f_obj ) {
+        for( H3DDynamicFieldsObject::field_iterator j = dyn_f_obj->firstField();
+             j != dyn_f_obj->endField(); ++j ) {
+          if( (*j) == f ) {
+            dynamic_field = true;
+            break;
+          }
+        }
+      }
+      writeField( *k, f,
+                  default_node ? default_node->getField( *k ) : NULL,
+                  dynamic_field );
+    }
+    writeUInt32( body, no_string );
+  }
+
+  void Writer::writeField( const string &name, Field *f,
+                           Field *default_field, bool dynamic ) {
+    Field::AccessType access_type = f->getAccessType();
+    bool has_value = access_type == Field::INITIALIZE_ONLY ||
+                     access_type == Field::INPUT_OUTPUT;
+    if( !has_value && !dynamic ) return;
+
+    unsigned char kind = VALUE_NONE;
+    unsigned char component_type = 0;
+    unsigned int nr_components = 0;
+    string value;
+    if( has_value ) {
+      if( SFNode *sf_node = dynamic_cast< SFNode * >( f ) ) {
+        if( !dynamic && !sf_node->getValue() ) return;
+        kind = VALUE_SFNODE;
+      } else if( MFNode *mf_node = dynamic_cast< MFNode * >( f ) ) {
+        if( !dynamic && mf_node->size() == 0 ) return;
+        kind = VALUE_MFNODE;
+      } else if( getArrayType( f, component_type, nr_components ) ) {
+        if( !dynamic && default_field && arrayEquals( f, default_field ) )
+          return;
+        kind = VALUE_ARRAY;
+      } else if( ParsableField *p_field =
+                 dynamic_cast< ParsableField * >( f ) ) {
+        value = p_field->getValueAsString();
+        // only write the value if it is different from the default value.
+        ParsableField *default_p_field =
+          dynamic_cast< ParsableField * >( default_field );
+        if( !dynamic && default_p_field &&
+            default_p_field->getValueAsString() == value ) return;
+        kind = VALUE_STRING;
+      } else if( !dynamic ) {
+        return;
+      }
+    }
+
+    writeUInt32( body, stringId( name ) );
+    if( dynamic ) {
+      writeByte( body, kind | DYNAMIC_FIELD );
+      writeUInt32( body, stringId( f->getTypeName() ) );
+      writeByte( body, (unsigned char)access_type );
+    } else {
+      writeByte( body, kind );
+    }
+
+    if( kind == VALUE_STRING ) {
+      writeString( body, value );
+    } else if( kind == VALUE_SFNODE ) {
+      writeNode( static_cast< SFNode * >( f )->getValue() );
+    } else if( kind == VALUE_MFNODE ) {
+      MFNode *mf_node = static_cast< MFNode * >( f );
+      writeUInt32( body, (H3DUInt32)mf_node->size() );
+      for( MFNode::const_iterator n = mf_node->begin();
+           n != mf_node->end(); ++n ) {
+        writeNode( *n );
+      }
+    } else if( kind == VALUE_ARRAY ) {
+      writeArray( f, component_type, nr_components );
+    }
+  }
+
+  bool Writer::arrayEquals( Field *f, Field *g ) {
+    MFieldClass *mf = dynamic_cast< MFieldClass * >( f );
+    MFieldClass *mg = dynamic_cast< MFieldClass * >( g );
+    if( !mf || !mg || mf->valueTypeSize() != mg->valueTypeSize() ||
+        mf->size() != mg->size() ) return false;
+    if( mf->size() == 0 ) return true;
+    unsigned int nr_bytes = mf->size() * mf->valueTypeSize();
+    vector< char > a( nr_bytes ), b( nr_bytes );
+    unsigned int nr_a, nr_b;
+    mf->getValueAsVoidPtr( &a[0], nr_a, nr_bytes );
+    mg->getValueAsVoidPtr( &b[0], nr_b, nr_bytes );
+    return memcmp( &a[0], &b[0], nr_bytes ) == 0;
+  }
+
+  void Writer::writeArray( Field *f, unsigned char component_type,
+                           unsigned int nr_components ) {
+    MFieldClass *mf = dynamic_cast< MFieldClass * >( f );
+    unsigned int component_size = componentSize( component_type );
+    unsigned int nr_values = mf->size();
+    size_t nr = (size_t)nr_values * nr_components;
+    vector< char > values( nr * component_size + 1 );
+    mf->getValueAsVoidPtr( &values[0], nr_values,
+                           (unsigned int)( nr * component_size ) );
+
+    // the array in little endian byte order, quantized if asked for.
+    stringstream data;
+    unsigned char encoding = 0;
+    if( quantize && component_type == FLOAT_COMPONENT && nr > 0 ) {
+      encoding |= QUANTIZED;
+      const H3DFloat *v = (const H3DFloat *)&values[0];
+      vector< H3DFloat > range( 2 * nr_components );
+      for( unsigned int c = 0; c < nr_components; ++c ) {
+        range[c] = v[c];
+        range[nr_components + c] = v[c];
+      }
+      for( size_t i = 0; i < nr; ++i ) {
+        unsigned int c = (unsigned int)( i % nr_components );
+        if( v[i] < range[c] ) range[c] = v[i];
+        if( v[i] > range[nr_components + c] ) range[nr_components + c] = v[i];
+      }
+      writeLittleEndian( data, (const char *)&range[0], sizeof( H3DFloat ),
+                         range.size() );
+      vector< unsigned short > q( nr );
+      for( size_t i = 0; i < nr; ++i ) {
+        unsigned int c = (unsigned int)( i % nr_components );
+        H3DFloat d = range[nr_components + c] - range[c];
+        q[i] = d > 0 ?
+          (unsigned short)( ( v[i] - range[c] ) / d * 65535 + 0.5f ) : 0;
+      }
+      writeLittleEndian( data, (const char *)&q[0], sizeof( unsigned short ),
+                         nr );
+    } else {
+      writeLittleEndian( data, &values[0], component_size, nr );
+    }
+    string raw = data.str();
+
+#ifdef HAVE_ZLIB
+    vector< Bytef > compressed;
+    if( compress && !raw.empty() ) {
+      uLongf compressed_size = compressBound( (uLong)raw.size() );
+      compressed.resize( compressed_size );
+      if( compress2( &compressed[0], &compressed_size,
+                     (const Bytef *)raw.data(), (uLong)raw.size(),
+                     Z_DEFAULT_COMPRESSION ) == Z_OK &&
+          compressed_size < raw.size() ) {
+        encoding |= DEFLATED;
+        compressed.resize( compressed_size );
+      }
+    }
+#endif
+
+    writeByte( body, component_type );
+    writeByte( body, (unsigned char)nr_components );
+    writeByte( body, encoding );
+    writeByte( body, 0 );
+    writeUInt32( body, nr_values );
+#ifdef HAVE_ZLIB
+    if( encoding & DEFLATED ) {
+      writeUInt32( body, (H3DUInt32)compressed.size() );
+      align();
+      body.write( (const char *)&compressed[0], compressed.size() );
+      return;
+    }
+#endif
+    align();
+    body.write( raw.data(), raw.size() );
+  }
+
+  void Writer::writeRoutes() {
+    // only routes that can be created with a ROUTE statement are
+    // written, i.e. between fields in the database of different nodes.
+    vector< H3DUInt32 > routes;
+    for( H3DUInt32 i = 0; i < nodes.size(); ++i ) {
+      Node *node = nodes[i];
+      H3DNodeDatabase *db = H3DNodeDatabase::lookupNodeInstance( node );
+      for( H3DNodeDatabase::FieldDBConstIterator k = db->fieldDBBegin();
+           k != db->fieldDBEnd(); ++k ) {
+        Field *from = node->getField( *k );
+        if( !from ) continue;
+        Field::AccessType access_type = from->getAccessType();
+        if( access_type != Field::OUTPUT_ONLY &&
+            access_type != Field::INPUT_OUTPUT ) continue;
+        const Field::FieldSet &routes_out = from->getRoutesOut();
+        for( Field::FieldSet::const_iterator r = routes_out.begin();
+             r != routes_out.end(); ++r ) {
+          Field *to = *r;
+          Node *to_node = to->getOwner();
+          if( !to_node || to_node == node ) continue;
+          map< Node *, H3DUInt32 >::iterator j = node_ids.find( to_node );
+          if( j == node_ids.end() ) continue;
+          string to_name = to->getName();
+          if( to_node->getField( to_name ) != to ) continue;
+          access_type = to->getAccessType();
+          if( access_type != Field::INPUT_ONLY &&
+              access_type != Field::INPUT_OUTPUT ) continue;
+          routes.push_back( i );
+          routes.push_back( stringId( *k ) );
+          routes.push_back( (*j).second );
+          routes.push_back( stringId( to_name ) );
+        }
+      }
+    }
+    writeUInt32( body, (H3DUInt32)( routes.size() / 4 ) );
+    for( unsigned int i = 0; i < routes.size(); ++i )
+      writeUInt32( body, routes[i] );
+  }
+
+  void Writer::writeAll( ostream &os ) {
+    string records = body.str();
+    unsigned long long string_table_offset = header_size + records.size();
+    os.write( magic, 4 );
+    writeUInt32( os, version );
+    writeUInt32( os, (H3DUInt32)( string_table_offset & 0xFFFFFFFF ) );
+    writeUInt32( os, (H3DUInt32)( string_table_offset >> 32 ) );
+    os.write( records.data(), records.size() );
+    writeUInt32( os, (H3DUInt32)strings.size() );
+    for( unsigned int i = 0; i < strings.size(); ++i )
+      writeString( os, strings[i] );
+  }
+
+  /// Creates the nodes from binary encoded data.
+  class Reader {
+  public:
+    Reader( const char *_data, size_t _size,
+            X3D::DEFNodes *_dn,
+            X3D::PrototypeVector *_prototypes ) :
+      data( _data ),
+      pos( _data ),
+      end( _data + _size ),
+      dn( _dn ),
+      prototypes( _prototypes ? _prototypes : &local_prototypes ) {}
+
+    ~Reader() {
+      for( unsigned int i = 0; i < nodes.size(); ++i )
+        if( nodes[i] ) nodes[i]->unref();
+    }
+
+    AutoRef< Node > read();
+
+  protected:
+    const char *readBytes( size_t nr_bytes );
+    unsigned char readByte();
+    H3DUInt32 readUInt32();
+    string readString();
+    const string &getString( H3DUInt32 id );
+    Node *getNode( H3DUInt32 id );
+    void align();
+
+    void readPrototypes();
+    Node *readNode();
+    void readFields( Node *node );
+    void readValue( Field *f, unsigned char kind );
+    void readArray( Field *f );
+    void readRoutes();
+
+    const char *data;
+    const char *pos;
+    const char *end;
+    X3D::DEFNodes *dn;
+    X3D::PrototypeVector local_prototypes;
+    X3D::PrototypeVector *prototypes;
+    vector< string > strings;
+    // all nodes read, in the order they were written. Referenced until
+    // reading is done.
+    vector< Node * > nodes;
+  };
+
+  const char *Reader::readBytes( size_t nr_bytes ) {
+    if( nr_bytes > (size_t)( end - pos ) )
+      throw X3D::X3DBinaryParseError( "Unexpected end of data" );
+    const char *p = pos;
+    pos += nr_bytes;
+    return p;
+  }
+
+  unsigned char Reader::readByte() {
+    return *(const unsigned char *)readBytes( 1 );
+  }
+
+  H3DUInt32 Reader::readUInt32() {
+    const unsigned char *b = (const unsigned char *)readBytes( 4 );
+    return (H3DUInt32)b[0] | ( (H3DUInt32)b[1] << 8 ) |
+      ( (H3DUInt32)b[2] << 16 ) | ( (H3DUInt32)b[3] << 24 );
+  }
+
+  string Reader::readString() {
+    H3DUInt32 size = readUInt32();
+    return string( readBytes( size ), size );
+  }
+
+  const string &Reader::getString( H3DUInt32 id ) {
+    if( id >= strings.size() )
+      throw X3D::X3DBinaryParseError( "Invalid string index" );
+    return strings[id];
+  }
+
+  Node *Reader::getNode( H3DUInt32 id ) {
+    if( id >= nodes.size() )
+      throw X3D::X3DBinaryParseError( "Invalid node index" );
+    return nodes[id];
+  }
+
+  void Reader::align() {
+    readBytes( ( 8 - ( pos - data ) % 8 ) % 8 );
+  }
+
+  AutoRef< Node > Reader::read() {
+    if( (size_t)( end - data ) < header_size || memcmp( data, magic, 4 ) != 0 )
+      throw X3D::X3DBinaryParseError( "Missing header" );
+    pos = data + 4;
+    if( readUInt32() != version )
+      throw X3D::X3DBinaryParseError( "Unsupported version" );
+    unsigned long long string_table_offset = readUInt32();
+    string_table_offset |= (unsigned long long)readUInt32() << 32;
+    if( string_table_offset < header_size ||
+        string_table_offset > (unsigned long long)( end - data ) )
+      throw X3D::X3DBinaryParseError( "Invalid string table offset" );
+
+    const char *records_end = data + string_table_offset;
+    pos = records_end;
+    H3DUInt32 nr_strings = readUInt32();
+    strings.reserve( nr_strings );
+    for( H3DUInt32 i = 0; i < nr_strings; ++i )
+      strings.push_back( readString() );
+
+    pos = data + header_size;
+    end = records_end;
+    readPrototypes();
+    AutoRef< Node > root( readNode() );
+    readRoutes();
+    return root;
+  }
+
+  void Reader::readPrototypes() {
+    H3DUInt32 nr_prototypes = readUInt32();
+    for( H3DUInt32 i = 0; i < nr_prototypes; ++i ) {
+      string name = readString();
+      string proto_body = readString();
+      vector< string > body_extra( readUInt32() );
+      for( unsigned int j = 0; j < body_extra.size(); ++j )
+        body_extra[j] = readString();
+      ProtoDeclaration *pd =
+        new ProtoDeclaration( name, proto_body, body_extra, prototypes );
+      H3DUInt32 nr_fields = readUInt32();
+      for( H3DUInt32 j = 0; j < nr_fields; ++j ) {
+        string field_name = readString();
+        X3DTypes::X3DType type = (X3DTypes::X3DType)readByte();
+        Field::AccessType access_type = (Field::AccessType)readByte();
+        string value = readString();
+        pd->addFieldDeclaration( field_name, type, access_type, value );
+      }
+      prototypes->push_back( pd );
+      if( !prototypes->getFirstProtoDeclaration() )
+        prototypes->setFirstProtoDeclaration( pd );
+    }
+  }
+
+  Node *Reader::readNode() {
+    unsigned char tag = readByte();
+    if( tag == NULL_NODE ) return NULL;
+    if( tag == USE_NODE ) return getNode( readUInt32() );
+    if( tag != NEW_NODE && tag != PROTO_INSTANCE )
+      throw X3D::X3DBinaryParseError( "Invalid node record" );
+
+    const string &type_name = getString( readUInt32() );
+    H3DUInt32 def_id = readUInt32();
+    Node *node = NULL;
+    if( tag == NEW_NODE ) {
+      node = H3DNodeDatabase::createNode( type_name );
+      if( !node )
+        Console(LogLevel::Warning) << "Warning: Could not create \""
+                                   << type_name << "\" node. It does not "
+                                   << "exist in the H3DNodeDatabase." << endl;
+    } else {
+      ProtoDeclaration *pd = prototypes->getProtoDeclaration( type_name );
+      if( pd ) {
+        node = pd->newProtoInstance();
+      } else {
+        Console(LogLevel::Warning) << "Warning: Could not find PROTO "
+                                   << "declaration \"" << type_name << "\""
+                                   << endl;
+      }
+    }
+
+    // the node index must be reserved even if the node could not be
+    // created since later records refer to nodes by index.
+    if( node ) node->ref();
+    nodes.push_back( node );
+    if( node && def_id != no_string ) {
+      const string &def_name = getString( def_id );
+      node->setName( def_name );
+      if( dn ) dn->addNode( def_name, node );
+    }
+
+    readFields( node );
+
+    // intialize the node if it is not already initialized
+    if( node && !node->isInitialized() && node->getManualInitialize() )
+      node->initialize();
+    return node;
+  }
+
+  void Reader::readFields( Node *node ) {
+    while( true ) {
+      H3DUInt32 name_id = readUInt32();
+      if( name_id == no_string ) break;
+      const string &name = getString( name_id );
+      unsigned char kind = readByte();
+      Field *f = NULL;
+      if( kind & DYNAMIC_FIELD ) {
+        kind &= ~DYNAMIC_FIELD;
+        const string &type_name = getString( readUInt32() );
+        Field::AccessType access_type = (Field::AccessType)readByte();
+        if( H3DDynamicFieldsObject *dyn_object =
+            dynamic_cast< H3DDynamicFieldsObject * >( node ) ) {
+          f = X3DTypes::newFieldInstance( type_name.c_str() );
+          if( f ) {
+            f->setOwner( node );
+            f->setName( name );
+            dyn_object->addField( name, access_type, f );
+          } else {
+            Console(LogLevel::Warning) << "Warning: Invalid type \""
+                                       << type_name << "\" of field \""
+                                       << name << "\"" << endl;
+          }
+        }
+      } else if( node ) {
+        f = node->getField( name );
+        if( !f )
+          Console(LogLevel::Warning) << "Warning: Could not find field \""
+                                     << name << "\" in \""
+                                     << node->getTypeName() << "\" node"
+                                     << endl;
+      }
+      readValue( f, kind );
+    }
+  }
+
+  void Reader::readValue( Field *f, unsigned char kind ) {
+    if( kind == VALUE_NONE ) {
+      return;
+    } else if( kind == VALUE_STRING ) {
+      string value = readString();
+      if( !f ) return;
+      ParsableField *p_field = dynamic_cast< ParsableField * >( f );
+      if( !p_field ) {
+        Console(LogLevel::Warning) << "Warning: Cannot parse field \""
+                                   << f->getFullName() << "\"" << endl;
+        return;
+      }
+      try {
+        p_field->setValueFromString( value );
+      } catch( const X3D::Convert::X3DFieldConversionError &e ) {
+        Console(LogLevel::Warning) << "Warning: Could not convert \""
+                                   << ( value.size() < 100 ? value :
+                                        (string)"value" )
+                                   << "\" to " << e.value << " for field \""
+                                   << f->getFullName() << "\"." << endl;
+      } catch( const X3D::Convert::UnimplementedConversionType &e ) {
+        Console(LogLevel::Warning) << "Warning: Field conversion error when "
+                                   << "converting value for field \""
+                                   << f->getFullName() << "\". Conversion for "
+                                   << e.value << " not implemented" << endl;
+      }
+    } else if( kind == VALUE_SFNODE ) {
+      Node *n = readNode();
+      if( !f ) return;
+      if( SFNode *sf_node = dynamic_cast< SFNode * >( f ) ) {
+        try {
+          sf_node->setValue( n );
+        } catch( const Exception::H3DException &e ) {
+          Console(LogLevel::Warning) << "Warning: " << e << endl;
+        }
+      } else {
+        Console(LogLevel::Warning) << "Warning: Field \"" << f->getFullName()
+                                   << "\" is not an SFNode field" << endl;
+      }
+    } else if( kind == VALUE_MFNODE ) {
+      MFNode *mf_node = dynamic_cast< MFNode * >( f );
+      if( f && !mf_node )
+        Console(LogLevel::Warning) << "Warning: Field \"" << f->getFullName()
+                                   << "\" is not an MFNode field" << endl;
+      H3DUInt32 nr_nodes = readUInt32();
+      for( H3DUInt32 i = 0; i < nr_nodes; ++i ) {
+        Node *n = readNode();
+        if( mf_node && n ) {
+          try {
+            mf_node->push_back( n );
+          } catch( const Exception::H3DException &e ) {
+            Console(LogLevel::Warning) << "Warning: " << e << endl;
+          }
+        }
+      }
+    } else if( kind == VALUE_ARRAY ) {
+      readArray( f );
+    } else {
+      throw X3D::X3DBinaryParseError( "Invalid field record" );
+    }
+  }
+
+  void Reader::readArray( Field *f ) {
+    unsigned char component_type = readByte();
+    unsigned int nr_components = readByte();
+    unsigned char encoding = readByte();
+    readByte();
+    H3DUInt32 nr_values = readUInt32();
+    size_t stored_size = 0;
+    if( encoding & DEFLATED ) stored_size = readUInt32();
+    align();
+
+    unsigned int component_size = componentSize( component_type );
+    if( component_size == 0 || nr_components == 0 ||
+        ( ( encoding & QUANTIZED ) && component_type != FLOAT_COMPONENT ) )
+      throw X3D::X3DBinaryParseError( "Invalid array record" );
+
+    // the sizes come from the file so they are computed in 64 bits, in
+    // which they can not overflow since nr_values has 32 bits and
+    // nr_components 8, and checked before anything is read or allocated.
+    unsigned long long nr_64 = (unsigned long long)nr_values * nr_components;
+    unsigned long long raw_size_64 = nr_64 * component_size;
+    if( encoding & QUANTIZED )
+      raw_size_64 = 2 * nr_components * sizeof( H3DFloat ) +
+                    nr_64 * sizeof( unsigned short );
+    if( nr_64 * component_size > max_array_size )
+      throw X3D::X3DBinaryParseError( "Array too large" );
+    if( encoding & DEFLATED ) {
+      if( raw_size_64 > stored_size * max_deflate_ratio + 64 )
+        throw X3D::X3DBinaryParseError( "Invalid array record" );
+    } else {
+      if( raw_size_64 > (unsigned long long)( end - pos ) )
+        throw X3D::X3DBinaryParseError( "Unexpected end of data" );
+      stored_size = (size_t)raw_size_64;
+    }
+    size_t nr = (size_t)nr_64;
+    size_t raw_size = (size_t)raw_size_64;
+    const char *stored = readBytes( stored_size );
+
+    if( !f ) return;
+    unsigned char field_component_type;
+    unsigned int field_nr_components;
+    if( !getArrayType( f, field_component_type, field_nr_components ) ||
+        field_component_type != component_type ||
+        field_nr_components != nr_components ) {
+      Console(LogLevel::Warning) << "Warning: Array value does not match "
+                                 << "the type of field \""
+                                 << f->getFullName() << "\"" << endl;
+      return;
+    }
+
+    // buffers of H3DDouble so that the decoded components are aligned.
+    vector< H3DDouble > inflated;
+    vector< H3DDouble > decoded;
+    const char *raw = stored;
+    if( encoding & DEFLATED ) {
+#ifdef HAVE_ZLIB
+      inflated.resize( raw_size / sizeof( H3DDouble ) + 1 );
+      uLongf size = (uLongf)raw_size;
+      if( uncompress( (Bytef *)&inflated[0], &size,
+                      (const Bytef *)stored, (uLong)stored_size ) != Z_OK ||
+          size != raw_size )
+        throw X3D::X3DBinaryParseError( "Could not uncompress array" );
+      raw = (const char *)&inflated[0];
+#else
+      Console(LogLevel::Warning) << "Warning: H3D API compiled without "
+                                 << "HAVE_ZLIB flag. Compressed value of "
+                                 << "field \"" << f->getFullName()
+                                 << "\" ignored." << endl;
+      return;
+#endif
+    }
+
+    const char *values = raw;
+    if( encoding & QUANTIZED ) {
+      decoded.resize( nr * sizeof( H3DFloat ) / sizeof( H3DDouble ) + 1 );
+      H3DFloat *v = (H3DFloat *)&decoded[0];
+      vector< H3DFloat > range( 2 * nr_components );
+      memcpy( &range[0], raw, range.size() * sizeof( H3DFloat ) );
+      vector< unsigned short > q( nr + 1 );
+      memcpy( &q[0], raw + range.size() * sizeof( H3DFloat ),
+              nr * sizeof( unsigned short ) );
+      if( !isLittleEndian() ) {
+        swapBytes( (char *)&range[0], sizeof( H3DFloat ), range.size() );
+        swapBytes( (char *)&q[0], sizeof( unsigned short ), nr );
+      }
+      for( size_t i = 0; i < nr; ++i ) {
+        unsigned int c = (unsigned int)( i % nr_components );
+        v[i] = range[c] +
+          q[i] * ( range[nr_components + c] - range[c] ) / 65535;
+      }
+      values = (const char *)v;
+    } else if( !isLittleEndian() ||
+               (H3DPtrUint)raw % component_size != 0 ) {
+      // the input can not be changed and might not be aligned, the
+      // uncompressed buffer can be used as is.
+      if( raw == stored ) {
+        decoded.resize( raw_size / sizeof( H3DDouble ) + 1 );
+        memcpy( &decoded[0], raw, raw_size );
+        raw = (const char *)&decoded[0];
+      }
+      if( !isLittleEndian() )
+        swapBytes( (char *)raw, component_size, nr );
+      values = raw;
+    }
+
+    // uncompressed data in the native byte order is copied directly
+    // from the input into the field.
+    MFieldClass *mf = dynamic_cast< MFieldClass * >( f );
+    mf->setValueFromVoidPtr( values, nr_values,
+                             (unsigned int)( nr * component_size ) );
+  }
+
+  void Reader::readRoutes() {
+    H3DUInt32 nr_routes = readUInt32();
+    for( H3DUInt32 i = 0; i < nr_routes; ++i ) {
+      Node *from_node = getNode( readUInt32() );
+      const string &from_field_name = getString( readUInt32() );
+      Node *to_node = getNode( readUInt32() );
+      const string &to_field_name = getString( readUInt32() );
+      // nodes that could not be created have been reported already.
+      if( !from_node || !to_node ) continue;
+      Field *from_field = from_node->getField( from_field_name );
+      Field *to_field = to_node->getField( to_field_name );
+      if( from_field && to_field ) {
+        from_field->route( to_field );
+      } else {
+        Console(LogLevel::Warning) << "Warning: Route error. Could not find "
+                                   << "field named \""
+                                   << ( from_field ? to_field_name :
+                                        from_field_name )
+                                   << "\"" << endl;
+      }
+    }
+  }
+}
+
+bool X3D::isX3DBinary( const string &str ) {
+  return str.size() >= 4 &&
+    memcmp( str.data(), X3DBinaryInternals::magic, 4 ) == 0;
+}
+
+bool X3D::isX3DBinary( istream &is ) {
+  char header[4];
+  is.read( header, 4 );
+  return is.gcount() == 4 &&
+    memcmp( header, X3DBinaryInternals::magic, 4 ) == 0;
+}
+
+Group* X3D::createX3DBinaryFromStream( istream &in,
+                                       DEFNodes *dn,
+                                       DEFNodes *exported_nodes,
+                                       PrototypeVector *prototypes ) {
+  Group *g = new Group;
+  AutoRef< Node > n = createX3DBinaryNodeFromStream( in, dn, exported_nodes,
+                                                     prototypes );
+  if( n.get() )
+    g->children->push_back( n.get() );
+  return g;
+}
+
+Group* X3D::createX3DBinaryFromString( const string &str,
+                                       DEFNodes *dn,
+                                       DEFNodes *exported_nodes,
+                                       PrototypeVector *prototypes ) {
+  Group *g = new Group;
+  AutoRef< Node > n = createX3DBinaryNodeFromString( str, dn, exported_nodes,
+                                                     prototypes );
+  if( n.get() )
+    g->children->push_back( n.get() );
+  return g;
+}
+
+AutoRef< Node > X3D::createX3DBinaryNodeFromStream( istream &in,
+                                                    DEFNodes *dn,
+                                                    DEFNodes *exported_nodes,
+                                                    PrototypeVector *prototypes ) {
+  // read everything at once, the records are decoded from memory.
+  string data;
+  istream::pos_type start = in.tellg();
+  if( start != istream::pos_type( -1 ) && in.seekg( 0, ios::end ) ) {
+    data.resize( (size_t)( in.tellg() - start ) );
+    in.seekg( start );
+    if( !data.empty() ) in.read( &data[0], data.size() );
+  } else {
+    in.clear();
+    stringstream s;
+    s << in.rdbuf();
+    data = s.str();
+  }
+  return createX3DBinaryNodeFromString( data, dn, exported_nodes,
+                                        prototypes );
+}
+
+AutoRef< Node > X3D::createX3DBinaryNodeFromString( const string &str,
+                                                    DEFNodes *dn,
+                                                    DEFNodes *exported_nodes,
+                                                    PrototypeVector *prototypes ) {
+  X3DBinaryInternals::Reader reader( str.data(), str.size(), dn, prototypes );
+  return reader.read();
+}
+
+void X3D::writeNodeAsX3DBinary( ostream& os,
+                                Node *node,
+                                PrototypeVector *prototypes,
+                                bool compress,
+                                bool quantize ) {
+  X3DBinaryInternals::Writer writer( prototypes, compress, quantize );
+  writer.writePrototypes();
+  writer.writeNode( node );
+  writer.writeRoutes();
+  writer.writeAll( os );
+}
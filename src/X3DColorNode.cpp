@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/X3DColorNode.h>
+#include <H3D/GLStateTracker.h>
 #ifdef MACOSX
 #include <OpenGL/gl.h>
 #else
@@ -45,10 +46,10 @@ X3DColorNode::X3DColorNode(
 }
 
 void X3DColorNode::preRender() {
-  glEnable( GL_COLOR_MATERIAL );
+  GLStateTracker::enable( GL_COLOR_MATERIAL );
 }
 
 void X3DColorNode::postRender() {
-  glDisable( GL_COLOR_MATERIAL );
+  GLStateTracker::disable( GL_COLOR_MATERIAL );
 }
 
@@ -31,6 +31,7 @@
 #include <H3D/X3DComposedGeometryNode.h>
 #include <H3D/MultiTexture.h>
 #include <H3D/MultiTextureCoordinate.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -240,16 +241,16 @@ void X3DComposedGeometryNode::startTexGen(
       if( mt ) {
         size_t texture_units = mt->texture->size();
         for( size_t i = 0; i < texture_units; ++i ) {
-          glActiveTexture( GL_TEXTURE0_ARB + (unsigned int) i );
+          GLStateTracker::activeTexture( GL_TEXTURE0_ARB + (unsigned int) i );
           glTexGend( GL_S, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
           glTexGend( GL_T, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
           glTexGend( GL_R, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
           glTexGenfv( GL_S, GL_OBJECT_PLANE, sparams );
           glTexGenfv( GL_T, GL_OBJECT_PLANE, tparams );
           glTexGenfv( GL_R, GL_OBJECT_PLANE, rparams );
-          glEnable( GL_TEXTURE_GEN_S );
-          glEnable( GL_TEXTURE_GEN_T );
-          glEnable( GL_TEXTURE_GEN_R );
+          GLStateTracker::enable( GL_TEXTURE_GEN_S );
+          GLStateTracker::enable( GL_TEXTURE_GEN_T );
+          GLStateTracker::enable( GL_TEXTURE_GEN_R );
         }
       } else {
         glTexGend( GL_S, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR );
@@ -258,9 +259,9 @@ void X3DComposedGeometryNode::startTexGen(
         glTexGenfv( GL_S, GL_OBJECT_PLANE, sparams );
         glTexGenfv( GL_T, GL_OBJECT_PLANE, tparams );
         glTexGenfv( GL_R, GL_OBJECT_PLANE, rparams );
-        glEnable( GL_TEXTURE_GEN_S );
-        glEnable( GL_TEXTURE_GEN_T );
-        glEnable( GL_TEXTURE_GEN_R );
+        GLStateTracker::enable( GL_TEXTURE_GEN_S );
+        GLStateTracker::enable( GL_TEXTURE_GEN_T );
+        GLStateTracker::enable( GL_TEXTURE_GEN_R );
       }
     } else {
       tex_coord_node->startTexGenForActiveTexture();
@@ -275,15 +276,15 @@ void X3DComposedGeometryNode::stopTexGen(
       if( mt ) {
         size_t texture_units = mt->texture->size();
         for( size_t i = 0; i < texture_units; ++i ) {
-          glActiveTexture( GL_TEXTURE0_ARB + (unsigned int) i );
-          glDisable( GL_TEXTURE_GEN_S );
-          glDisable( GL_TEXTURE_GEN_T );
-          glDisable( GL_TEXTURE_GEN_R );
+          GLStateTracker::activeTexture( GL_TEXTURE0_ARB + (unsigned int) i );
+          GLStateTracker::disable( GL_TEXTURE_GEN_S );
+          GLStateTracker::disable( GL_TEXTURE_GEN_T );
+          GLStateTracker::disable( GL_TEXTURE_GEN_R );
         }
       } else {
-        glDisable( GL_TEXTURE_GEN_S );
-        glDisable( GL_TEXTURE_GEN_T );
-        glDisable( GL_TEXTURE_GEN_R );
+        GLStateTracker::disable( GL_TEXTURE_GEN_S );
+        GLStateTracker::disable( GL_TEXTURE_GEN_T );
+        GLStateTracker::disable( GL_TEXTURE_GEN_R );
       }
     } else {
       tex_coord_node->stopTexGenForActiveTexture();
@@ -29,10 +29,501 @@
 
 
 #include <H3D/X3DFieldConversion.h>
+#include <H3D/MappedBuffer.h>
+
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || \
+    ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define H3D_X3D_CONVERSION_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
 
 using namespace H3D;
 using namespace X3D;
 
+namespace X3DFieldConversionInternals {
+  typedef Convert::X3DFieldConversionError ConversionError;
+  typedef unsigned long long Mantissa;
+
+  // Returns true if c separates values, i.e. is a whitespace or a comma.
+  inline bool isSeparator( char c ) {
+    return c == ' ' || c == ',' || ( c >= '\t' && c <= '\r' );
+  }
+
+  inline bool isDigit( char c ) {
+    return c >= '0' && c <= '9';
+  }
+
+#ifdef H3D_X3D_CONVERSION_SSE2
+  // The index of the lowest set bit of a non-zero mask.
+  inline unsigned int lowestBit( unsigned int mask ) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward( &index, mask );
+    return index;
+#else
+    return __builtin_ctz( mask );
+#endif
+  }
+#endif
+
+  // Skip whitespaces and commas. end is the end of the string and is
+  // never read past.
+  inline const char *skipSeparators( const char *s, const char *end ) {
+    // most values are separated by a single character.
+    if( !isSeparator( s[0] ) ) return s;
+    ++s;
+    if( !isSeparator( s[0] ) ) return s;
+#ifdef H3D_X3D_CONVERSION_SSE2
+    // indentation and line breaks, 16 characters at a time.
+    const __m128i space = _mm_set1_epi8( ' ' );
+    const __m128i comma = _mm_set1_epi8( ',' );
+    const __m128i before_tab = _mm_set1_epi8( '\t' - 1 );
+    const __m128i after_cr = _mm_set1_epi8( '\r' + 1 );
+    while( end - s >= 16 ) {
+      __m128i c = _mm_loadu_si128( (const __m128i *)s );
+      __m128i separator = 
+        _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( c, space ),
+                                    _mm_cmpeq_epi8( c, comma ) ),
+                      _mm_and_si128( _mm_cmpgt_epi8( c, before_tab ),
+                                     _mm_cmplt_epi8( c, after_cr ) ) );
+      unsigned int mask = ~_mm_movemask_epi8( separator ) & 0xffff;
+      if( mask ) return s + lowestBit( mask );
+      s += 16;
+    }
+#endif
+    while( isSeparator( s[0] ) ) ++s;
+    return s;
+  }
+
+  // The number of values in the string, i.e. the number of sequences of
+  // characters that are not separators.
+  size_t countValues( const char *s ) {
+    size_t nr_values = 0;
+    bool in_value = false;
+    for( ; s[0] != '\0'; ++s ) {
+      bool separator = isSeparator( s[0] );
+      if( !separator && !in_value ) ++nr_values;
+      in_value = !separator;
+    }
+    return nr_values;
+  }
+
+  // Powers of ten that can be represented exactly.
+  const double exact_double_powers[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+  const float exact_float_powers[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+  // Convert the number in [start, end) with the C library, which rounds
+  // correctly. The decimal point is replaced with the one of the current
+  // locale.
+  template< class Real >
+  Real libraryConversion( const char *start, const char *end ) {
+    string number( start, end );
+    char decimal_point = localeconv()->decimal_point[0];
+    for( string::iterator i = number.begin(); i != number.end(); ++i ) {
+      if( *i == 'd' || *i == 'D' ) *i = 'e';
+      else if( *i == '.' ) *i = decimal_point;
+    }
+    return (Real)strtod( number.c_str(), NULL );
+  }
+
+#if !defined( _MSC_VER ) || _MSC_VER >= 1800
+  template<>
+  float libraryConversion< float >( const char *start, const char *end ) {
+    string number( start, end );
+    char decimal_point = localeconv()->decimal_point[0];
+    for( string::iterator i = number.begin(); i != number.end(); ++i ) {
+      if( *i == 'd' || *i == 'D' ) *i = 'e';
+      else if( *i == '.' ) *i = decimal_point;
+    }
+    return strtof( number.c_str(), NULL );
+  }
+#endif
+
+  // Compute mantissa * 10^exponent if it can be done exactly with Real
+  // arithmetic, in which case the result is correctly rounded.
+  inline bool exactConversion( Mantissa mantissa, int exponent,
+                               double &value ) {
+    if( mantissa > ( (Mantissa)1 << 53 ) ||
+        exponent < -22 || exponent > 22 ) return false;
+    value = (double)mantissa;
+    if( exponent < 0 ) value /= exact_double_powers[ -exponent ];
+    else value *= exact_double_powers[ exponent ];
+    return true;
+  }
+
+  inline bool exactConversion( Mantissa mantissa, int exponent,
+                               float &value ) {
+    if( mantissa > ( (Mantissa)1 << 24 ) ||
+        exponent < -10 || exponent > 10 ) return false;
+    value = (float)mantissa;
+    if( exponent < 0 ) value /= exact_float_powers[ -exponent ];
+    else value *= exact_float_powers[ exponent ];
+    return true;
+  }
+
+  // Parse a number on the form
+  // [sign][digits][.digits][ {d | D | e | E }[sign]digits]
+  // in the same way as Convert::getValue<double>(). Returns false if s
+  // does not start with a number. rest is set to the first character
+  // after the number.
+  template< class Real >
+  bool parseNumber( const char *s, const char *&rest, Real &value ) {
+    const char *start = s;
+    bool negative = false;
+    if( s[0] == '+' ) {
+      ++s;
+    } else if( s[0] == '-' ) {
+      ++s;
+      negative = true;
+    }
+
+    // at most 19 significant digits fit in the mantissa, the number is
+    // converted by the C library if there are more.
+    Mantissa mantissa = 0;
+    unsigned int nr_digits = 0;
+    int exponent = 0;
+    bool valid = false;
+    bool truncated = false;
+    for( ; isDigit( s[0] ); ++s ) {
+      valid = true;
+      if( nr_digits < 19 ) {
+        mantissa = 10 * mantissa + ( s[0] - '0' );
+        if( mantissa ) ++nr_digits;
+      } else {
+        ++exponent;
+        truncated = true;
+      }
+    }
+    if( s[0] == '.' ) {
+      for( ++s; isDigit( s[0] ); ++s ) {
+        valid = true;
+        if( nr_digits < 19 ) {
+          mantissa = 10 * mantissa + ( s[0] - '0' );
+          if( mantissa ) ++nr_digits;
+          --exponent;
+        } else {
+          truncated = true;
+        }
+      }
+    }
+    if( !valid ) return false;
+
+    if( s[0] == 'd' || s[0] == 'D' || s[0] == 'e' || s[0] == 'E' ) {
+      const char *e = s + 1;
+      bool exponent_negative = false;
+      if( e[0] == '+' ) {
+        ++e;
+      } else if( e[0] == '-' ) {
+        ++e;
+        exponent_negative = true;
+      }
+      // only the previous part is used if there are no digits.
+      if( isDigit( e[0] ) ) {
+        int e_value = 0;
+        for( ; isDigit( e[0] ); ++e ) {
+          if( e_value < 100000 ) e_value = 10 * e_value + ( e[0] - '0' );
+        }
+        exponent += exponent_negative ? -e_value : e_value;
+        s = e;
+      }
+    }
+    rest = s;
+
+    if( mantissa == 0 ) {
+      value = 0;
+    } else if( truncated || !exactConversion( mantissa, exponent, value ) ) {
+      value = libraryConversion< Real >( start, s );
+      return true;
+    }
+    if( negative ) value = -value;
+    return true;
+  }
+
+  // Parse an int in the same way as Convert::getValue<int>().
+  bool parseNumber( const char *s, const char *&rest, int &value ) {
+    bool valid = false;
+    unsigned int result = 0;
+    if( s[0] == '0' && s[1] == 'x' ) {
+      // hexadecimal number 0x????????
+      const char *end = s + 10;
+      for( s += 2; s < end; ++s ) {
+        unsigned int digit;
+        if( isDigit( s[0] ) ) digit = s[0] - '0';
+        else if( s[0] >= 'a' && s[0] <= 'f' ) digit = s[0] - 'a' + 10;
+        else if( s[0] >= 'A' && s[0] <= 'F' ) digit = s[0] - 'A' + 10;
+        else break;
+        result = ( result << 4 ) | digit;
+        valid = true;
+      }
+    } else {
+      bool negative = false;
+      if( s[0] == '+' ) {
+        ++s;
+      } else if( s[0] == '-' ) {
+        negative = true;
+        ++s;
+      }
+      for( ; isDigit( s[0] ); ++s ) {
+        result = 10 * result + ( s[0] - '0' );
+        valid = true;
+      }
+      if( negative ) result = 0 - result;
+    }
+    rest = s;
+    value = (int)result;
+    return valid;
+  }
+
+  // Set the components of the value types.
+  inline void setValue( float &v, const float *c ) { v = c[0]; }
+  inline void setValue( double &v, const double *c ) { v = c[0]; }
+  inline void setValue( int &v, const int *c ) { v = c[0]; }
+  inline void setValue( Vec2f &v, const H3DFloat *c ) {
+    v.x = c[0]; v.y = c[1];
+  }
+  inline void setValue( Vec3f &v, const H3DFloat *c ) {
+    v.x = c[0]; v.y = c[1]; v.z = c[2];
+  }
+  inline void setValue( Vec4f &v, const H3DFloat *c ) {
+    v.x = c[0]; v.y = c[1]; v.z = c[2]; v.w = c[3];
+  }
+  inline void setValue( Vec2d &v, const H3DDouble *c ) {
+    v.x = c[0]; v.y = c[1];
+  }
+  inline void setValue( Vec3d &v, const H3DDouble *c ) {
+    v.x = c[0]; v.y = c[1]; v.z = c[2];
+  }
+  inline void setValue( Vec4d &v, const H3DDouble *c ) {
+    v.x = c[0]; v.y = c[1]; v.z = c[2]; v.w = c[3];
+  }
+  inline void setValue( RGB &v, const H3DFloat *c ) {
+    v.r = c[0]; v.g = c[1]; v.b = c[2];
+  }
+  inline void setValue( RGBA &v, const H3DFloat *c ) {
+    v.r = c[0]; v.g = c[1]; v.b = c[2]; v.a = c[3];
+  }
+  inline void setValue( Rotation &v, const H3DFloat *c ) {
+    v.axis.x = c[0]; v.axis.y = c[1]; v.axis.z = c[2]; v.angle = c[3];
+  }
+
+  void throwVectorError( const std::type_info &type ) {
+    stringstream ss;
+    ss << type.name() << " vector";
+    throw ConversionError( ss.str() );
+  }
+
+  // The component types of external binary buffers.
+  typedef enum {
+    BUFFER_FLOAT,
+    BUFFER_DOUBLE,
+    BUFFER_INT32,
+    BUFFER_UINT32,
+    BUFFER_INT16,
+    BUFFER_UINT16,
+    BUFFER_INT8,
+    BUFFER_UINT8
+  } BufferType;
+
+  const char *buffer_type_names[] = {
+    "float", "double", "int32", "uint32", "int16", "uint16", "int8", "uint8" };
+  const size_t buffer_type_sizes[] = { 4, 8, 4, 4, 2, 2, 1, 1 };
+
+  // The buffer type with the same representation as a component type.
+  inline BufferType componentBufferType( float ) { return BUFFER_FLOAT; }
+  inline BufferType componentBufferType( double ) { return BUFFER_DOUBLE; }
+  inline BufferType componentBufferType( int ) { return BUFFER_INT32; }
+
+  inline bool isLittleEndian() {
+    const H3DUInt32 one = 1;
+    return *(const unsigned char *)&one == 1;
+  }
+
+  // Read a little endian number of the given type.
+  double readBufferNumber( const unsigned char *p, BufferType type ) {
+    unsigned char bytes[8];
+    size_t size = buffer_type_sizes[ type ];
+    if( isLittleEndian() ) {
+      memcpy( bytes, p, size );
+    } else {
+      for( size_t i = 0; i < size; ++i ) bytes[i] = p[ size - 1 - i ];
+    }
+    switch( type ) {
+    case BUFFER_FLOAT: { float v; memcpy( &v, bytes, 4 ); return v; }
+    case BUFFER_DOUBLE: { double v; memcpy( &v, bytes, 8 ); return v; }
+    case BUFFER_INT32: { H3DInt32 v; memcpy( &v, bytes, 4 ); return v; }
+    case BUFFER_UINT32: { H3DUInt32 v; memcpy( &v, bytes, 4 ); return v; }
+    case BUFFER_INT16: { short v; memcpy( &v, bytes, 2 ); return v; }
+    case BUFFER_UINT16: { unsigned short v; memcpy( &v, bytes, 2 ); return v; }
+    case BUFFER_INT8: return (signed char)bytes[0];
+    default: return bytes[0];
+    }
+  }
+
+  // A reference to values in an external binary buffer.
+  struct BufferReference {
+    string url;
+    size_t offset;
+    size_t count;
+    BufferType type;
+  };
+
+  // Remove leading and trailing whitespace.
+  string trim( const string &s ) {
+    size_t start = s.find_first_not_of( " \t\r\n" );
+    if( start == string::npos ) return "";
+    size_t end = s.find_last_not_of( " \t\r\n" );
+    return s.substr( start, end - start + 1 );
+  }
+
+  // Parse an unsigned integer that is the whole string.
+  bool parseSize( const string &s, size_t &value ) {
+    if( s.empty() || !isDigit( s[0] ) ) return false;
+    char *rest;
+    unsigned long long v = strtoull( s.c_str(), &rest, 10 );
+    if( rest[0] != '\0' || v > (size_t)-1 ) return false;
+    value = (size_t)v;
+    return true;
+  }
+
+  // Returns true if the string is a reference to an external buffer, i.e.
+  // "buffer( url, offset, count, type )". offset is in bytes, count is the
+  // number of values and type the type of the components in the buffer.
+  // type can be left out if it is the component type of the value type.
+  // Throws if the string starts with "buffer" but is not a valid reference.
+  bool parseBufferReference( const string &x3d_string,
+                             BufferType default_type,
+                             BufferReference &ref ) {
+    size_t start = x3d_string.find_first_not_of( " \t\r\n" );
+    if( start == string::npos ||
+        x3d_string.compare( start, 6, "buffer" ) != 0 ) return false;
+
+    size_t open = x3d_string.find_first_not_of( " \t\r\n", start + 6 );
+    size_t close = x3d_string.find_last_not_of( " \t\r\n" );
+    if( open == string::npos || x3d_string[ open ] != '(' ||
+        x3d_string[ close ] != ')' ) {
+      throw ConversionError( "buffer reference, expecting "
+                             "\"buffer( url, offset, count, type )\"" );
+    }
+
+    vector< string > args;
+    string inner = x3d_string.substr( open + 1, close - open - 1 );
+    size_t pos = 0;
+    while( true ) {
+      size_t comma = inner.find( ',', pos );
+      args.push_back( trim( inner.substr( pos, comma - pos ) ) );
+      if( comma == string::npos ) break;
+      pos = comma + 1;
+    }
+
+    if( ( args.size() != 3 && args.size() != 4 ) || args[0].empty() ||
+        !parseSize( args[1], ref.offset ) ||
+        !parseSize( args[2], ref.count ) ) {
+      throw ConversionError( "buffer reference, expecting "
+                             "\"buffer( url, offset, count, type )\"" );
+    }
+    ref.url = args[0];
+    ref.type = default_type;
+    if( args.size() == 4 ) {
+      unsigned int i = 0;
+      for( ; i <= BUFFER_UINT8; ++i ) {
+        if( args[3] == buffer_type_names[i] ) break;
+      }
+      if( i > BUFFER_UINT8 ) {
+        throw ConversionError( "buffer reference, unknown component type \"" +
+                               args[3] + "\"" );
+      }
+      ref.type = (BufferType)i;
+    }
+    return true;
+  }
+
+  // Read the values of a buffer reference from the mapping of the file.
+  // The values are copied directly if the components in the buffer have
+  // the same representation as in the value type, otherwise they are
+  // converted one by one.
+  template< class Type, class Component, unsigned int nr_components >
+  void bufferToVector( const BufferReference &ref, vector< Type > &values ) {
+    AutoRef< MappedBuffer > buffer = MappedBuffer::getBufferFromURL( ref.url );
+    if( !buffer.get() ) {
+      throw ConversionError( "buffer \"" + ref.url + "\", could not be read" );
+    }
+
+    size_t component_size = buffer_type_sizes[ ref.type ];
+    size_t nr_components_total = ref.count * nr_components;
+    if( ref.offset > buffer->getSize() ||
+        ( nr_components_total > 0 && 
+          ( buffer->getSize() - ref.offset ) / component_size / nr_components 
+          < ref.count ) ) {
+      throw ConversionError( "buffer \"" + ref.url +
+                             "\", file too small for the values" );
+    }
+
+    values.clear();
+    if( ref.count == 0 ) return;
+    values.resize( ref.count );
+    const unsigned char *data = buffer->getData() + ref.offset;
+    if( ref.type == componentBufferType( Component() ) &&
+        sizeof( Type ) == sizeof( Component ) * nr_components &&
+        isLittleEndian() ) {
+      memcpy( &values[0], data, ref.count * sizeof( Type ) );
+    } else {
+      Component c[ nr_components ];
+      for( size_t i = 0; i < ref.count; ++i ) {
+        for( unsigned int j = 0; j < nr_components; ++j ) {
+          c[j] = (Component)readBufferNumber( data, ref.type );
+          data += component_size;
+        }
+        setValue( values[i], c );
+      }
+    }
+  }
+
+  // Parse a vector of values with nr_components numbers each. The
+  // components of a value must be separated by whitespace or commas.
+  // The values can also be a reference to an external binary buffer,
+  // see parseBufferReference().
+  template< class Type, class Component, unsigned int nr_components >
+  void numbersToVector( const string &x3d_string, vector< Type > &values ) {
+    BufferReference ref;
+    if( parseBufferReference( x3d_string, componentBufferType( Component() ),
+                              ref ) ) {
+      bufferToVector< Type, Component, nr_components >( ref, values );
+      return;
+    }
+
+    const char *s = x3d_string.c_str();
+    const char *end = s + x3d_string.size();
+    values.clear();
+    values.reserve( countValues( s ) / nr_components );
+
+    Component c[ nr_components ];
+    Type value;
+    s = skipSeparators( s, end );
+    while( s[0] != '\0' ) {
+      for( unsigned int i = 0; i < nr_components; ++i ) {
+        const char *rest;
+        if( !parseNumber( s, rest, c[i] ) ) throwVectorError( typeid( Type ) );
+        if( i + 1 < nr_components && !isSeparator( rest[0] ) ) {
+          throwVectorError( typeid( Type ) );
+        }
+        s = skipSeparators( rest, end );
+      }
+      setValue( value, c );
+      values.push_back( value );
+    }
+  }
+}
+
 PixelImage *X3D::X3DStringTo3DImage( const string &x3d_string ) {
   typedef Convert::X3DFieldConversionError ConversionError;
   const char *s = x3d_string.c_str();
@@ -296,3 +787,108 @@ unsigned char * X3D::Convert::readImageData( const char *s,
   }
   return data;
 }
+
+namespace H3D {
+  namespace X3D {
+    template<>
+    void X3DStringToVector< vector< float > >( const string &x3d_string,
+                                               vector< float > &values ) {
+      X3DFieldConversionInternals::
+        numbersToVector< float, float, 1 >( x3d_string, values );
+    }
+
+    template<>
+    void X3DStringToVector< vector< double > >( const string &x3d_string,
+                                                vector< double > &values ) {
+      X3DFieldConversionInternals::
+        numbersToVector< double, double, 1 >( x3d_string, values );
+    }
+
+    template<>
+    void X3DStringToVector< vector< int > >( const string &x3d_string,
+                                             vector< int > &values ) {
+      X3DFieldConversionInternals::
+        numbersToVector< int, int, 1 >( x3d_string, values );
+    }
+
+    template<>
+    void X3DStringToVector< vector< Vec2f > >( const string &x3d_string,
+                                               vector< Vec2f > &values ) {
+      X3DFieldConversionInternals::
+        numbersToVector< Vec2f, H3DFloat, 2 >( x3d_string, values );
+    }
+
+    template<>
+    void X3DStringToVector< vector< Vec3f > >( const string &x3d_string,
+                                               vector< Vec3f > &values ) {
+      X3DFieldConversionInternals::
+        numbersToVector< Vec3f, H3DFloat, 3 >( x3d_string, values );
+    }
+
+    template<>
+    void X3DStringToVector< vector< Vec4f > >( const string &x3d_string,
+                                               vector< Vec4f > &values ) {
+      X3DFieldConversionInternals::
+        numbersToVector< Vec4f, H3DFloat, 4 >( x3d_string, values );
+    }
+
+    template<>
+    void X3DStringToVector< vector< Vec2d > >( const string &x3d_string,
+                                               vector< Vec2d > &values ) {
+      X3DFieldConversionInternals::
+        numbersToVector< Vec2d, H3DDouble, 2 >( x3d_string, values );
+    }
+
+    template<>
+    void X3DStringToVector< vector< Vec3d > >( const string &x3d_string,
+                                               vector< Vec3d > &values ) {
+      X3DFieldConversionInternals::
+        numbersToVector< Vec3d, H3DDouble, 3 >( x3d_string, values );
+    }
+
+    template<>
+    void X3DStringToVector< vector< Vec4d > >( const string &x3d_string,
+                                               vector< Vec4d > &values ) {
+      X3DFieldConversionInternals::
+        numbersToVector< Vec4d, H3DDouble, 4 >( x3d_string, values );
+    }
+
+    template<>
+    void X3DStringToVector< vector< RGB > >( const string &x3d_string,
+                                             vector< RGB > &values ) {
+      if( x3d_string.find( '#' ) != string::npos ) {
+        // hexadecimal colors are only handled by Convert::getValue<RGB>().
+        typedef Convert::X3DFieldConversionError ConversionError;
+        const char *s = x3d_string.c_str();
+        const char *t1;
+        values.clear();
+        try {
+          s = Convert::skipWhitespaces( s );
+          while( s[0] != '\0' ) {
+            values.push_back( Convert::getValue< RGB >( s, t1 ) );
+            s = Convert::skipWhitespacesAndCommas( t1 );
+          }
+        } catch( const ConversionError & ) {
+          X3DFieldConversionInternals::throwVectorError( typeid( RGB ) );
+        }
+      } else {
+        X3DFieldConversionInternals::
+          numbersToVector< RGB, H3DFloat, 3 >( x3d_string, values );
+      }
+    }
+
+    template<>
+    void X3DStringToVector< vector< RGBA > >( const string &x3d_string,
+                                              vector< RGBA > &values ) {
+      X3DFieldConversionInternals::
+        numbersToVector< RGBA, H3DFloat, 4 >( x3d_string, values );
+    }
+
+    template<>
+    void X3DStringToVector< vector< Rotation > >( const string &x3d_string,
+                                                  vector< Rotation > &values ) {
+      X3DFieldConversionInternals::
+        numbersToVector< Rotation, H3DFloat, 4 >( x3d_string, values );
+    }
+  }
+}
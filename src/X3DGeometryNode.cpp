@@ -40,6 +40,7 @@
 #include <H3D/HapticsRenderers.h>
 #include <H3D/ShadowGeometry.h>
 #include <H3D/H3DRenderModeGroupNode.h>
+#include <H3D/GLStateTracker.h>
 
 #ifdef HAVE_OPENHAPTICS
 #include <HAPI/HLDepthBufferShape.h>
@@ -268,9 +269,9 @@ void X3DGeometryNode::DisplayList::callList( bool build_list ) {
   glGetIntegerv( GL_CULL_FACE_MODE, &old_cull_face );
 
   if( geom->usingCulling() && geom->allowingCulling() ) {
-    glEnable( GL_CULL_FACE );
+    GLStateTracker::enable( GL_CULL_FACE );
   } else {
-    glDisable( GL_CULL_FACE );
+    GLStateTracker::disable( GL_CULL_FACE );
   }
 
   glCullFace( geom->getCullFace() );
@@ -328,8 +329,8 @@ void X3DGeometryNode::DisplayList::callList( bool build_list ) {
   }
   
   // restore previous values for culling
-  if( culling_enabled ) glEnable( GL_CULL_FACE );
-  else glDisable( GL_CULL_FACE );
+  if( culling_enabled ) GLStateTracker::enable( GL_CULL_FACE );
+  else GLStateTracker::disable( GL_CULL_FACE );
   
   glCullFace( old_cull_face );
 
@@ -416,14 +417,16 @@ void X3DGeometryNode::SFBoundTree::update() {
   vector< HAPI::Collision::Triangle > triangles;
   vector< HAPI::Collision::LineSegment > lines;
   vector< HAPI::Collision::Point > points;
-  HAPI::FeedbackBufferCollector::collectPrimitives( geometry, 
-                                                    Matrix4d( 1, 0, 0, 0,
-                                                              0, 1, 0, 0,
-                                                              0, 0, 1, 0,
-                                                              0, 0, 0, 1 ),
-                                                    triangles, 
-                                                    lines, 
-                                                    points );
+  if( !geometry->getTriangles( triangles ) ) {
+    HAPI::FeedbackBufferCollector::collectPrimitives( geometry, 
+                                                      Matrix4d( 1, 0, 0, 0,
+                                                                0, 1, 0, 0,
+                                                                0, 0, 1, 0,
+                                                                0, 0, 0, 1 ),
+                                                      triangles, 
+                                                      lines, 
+                                                      points );
+  }
   
   GeometryBoundTreeOptions *_options = NULL;
   geometry->getOptionNode( _options );
@@ -609,15 +612,17 @@ void X3DGeometryNode::createAndAddHapticShapes(
       }
     } else {
       if( radius < 0 ) {
-        HAPI::FeedbackBufferCollector::collectPrimitives(
-                                    this,
-                                    Matrix4d( 1, 0, 0, 0,
-                                              0, 1, 0, 0,
-                                              0, 0, 1, 0,
-                                              0, 0, 0, 1 ),
-                                    tris,
-                                    lines,
-                                    points );
+        if( !getTriangles( tris ) ) {
+          HAPI::FeedbackBufferCollector::collectPrimitives(
+                                      this,
+                                      Matrix4d( 1, 0, 0, 0,
+                                                0, 1, 0, 0,
+                                                0, 0, 1, 0,
+                                                0, 0, 0, 1 ),
+                                      tris,
+                                      lines,
+                                      points );
+        }
       } else {
         int nr_values = nrFeedbackBufferValues();
         if( nr_values < 0 ) nr_values = 200000;
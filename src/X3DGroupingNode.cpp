@@ -33,6 +33,11 @@
 #include <H3D/MatrixTransform.h>
 #include <H3D/X3DPointingDeviceSensorNode.h>
 #include <H3D/X3DShapeNode.h>
+#include <H3D/Shape.h>
+#include <H3D/Transform.h>
+#include <H3D/GraphicsOptions.h>
+#include <H3D/GlobalSettings.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -63,7 +68,8 @@ X3DGroupingNode::X3DGroupingNode( Inst< AddChildren    > _addChildren,
   use_union_bound( false ),
   addChildren   ( _addChildren    ),
   removeChildren( _removeChildren ),
-  children      ( _children       )
+  children      ( _children       ),
+  sort_shapes( false )
 #ifdef HAVE_PROFILER
   ,time_in_last_render( 0 ),
   time_in_last_traverseSG( 0 ),
@@ -111,8 +117,28 @@ void X3DGroupingNode::render()     {
   // not using iterators since they can become invalid if the 
   // traversal changes the children field while iterating.
   const NodeVector &c = children->getValue();
+
+  // children in instance batches are rendered together after the
+  // other children. The batches are only valid if the children have
+  // not changed since traverseSG.
+  bool use_instance_batches = 
+    !instance_batches.empty() && instanced_children.size() == c.size();
+
+  // simple shapes are put in shape_draw_list to be rendered sorted by
+  // render state after the other children.
+  shape_draw_list.clear();
+
   for( unsigned int i = 0; i < c.size(); ++i ) {
     if( c[i] ) {
+      if( use_instance_batches && instanced_children[i] ) continue;
+      if( sort_shapes ) {
+        const Matrix4f *matrix = NULL;
+        X3DShapeNode *shape = getSimpleShape( c[i], matrix );
+        if( shape ) {
+          shape_draw_list.add( shape, matrix );
+          continue;
+        }
+      }
       H3DDisplayListObject *tmp = dynamic_cast< H3DDisplayListObject* >( c[i]);
       if( tmp )
         tmp->displayList->callList();
@@ -121,6 +147,29 @@ void X3DGroupingNode::render()     {
     }
   }
 
+  if( !shape_draw_list.empty() ) {
+    shape_draw_list.render();
+    shape_draw_list.clear();
+  }
+
+  // instance batches only contain non-transparent shapes so they are
+  // not rendered in the passes for transparent objects.
+  if( use_instance_batches && 
+      ( X3DShapeNode::geometry_render_mode == X3DShapeNode::SOLID ||
+        X3DShapeNode::geometry_render_mode == X3DShapeNode::ALL ) ) {
+    // the instance matrices can contain scaling, as in MatrixTransform.
+    GLboolean norm= glIsEnabled( GL_NORMALIZE );
+    if ( !norm ) 
+      GLStateTracker::enable( GL_NORMALIZE );
+    for( unsigned int i = 0; i < instance_batches.size(); ++i ) {
+      X3DShapeNode *shape = 
+        static_cast< X3DShapeNode * >( instance_batches[i].shape.get() );
+      shape->renderInstances( instance_batches[i].matrices );
+    }
+    if ( !norm ) 
+      GLStateTracker::disable( GL_NORMALIZE );
+  }
+
 
   for( it=render_states.begin(); it!=render_states.end(); ++it ) {
     (*it)->disableGraphicsState();
@@ -165,6 +214,8 @@ void X3DGroupingNode::traverseSG( TraverseInfo &ti ) {
       c[i]->traverseSG( ti );
   }
 
+  updateRenderBatches( ti );
+
   for( it = render_states.begin(); it != render_states.end(); ++it ) {
     (*it)->disableHapticsState( ti );
   }
@@ -244,6 +295,124 @@ void X3DGroupingNode::closestPoint( const Vec3f &p,
   }
 }
 
+X3DShapeNode *X3DGroupingNode::getSimpleShape( Node *child,
+                                               const Matrix4f *&matrix ) {
+  matrix = NULL;
+  if( !child ) return NULL;
+  if( typeid( *child ) == typeid( Shape ) ) {
+    return dynamic_cast< X3DShapeNode * >( child );
+  }
+
+  MatrixTransform *t = dynamic_cast< MatrixTransform * >( child );
+  if( !t || ( typeid( *t ) != typeid( MatrixTransform ) &&
+              typeid( *t ) != typeid( Transform ) ) ) return NULL;
+
+  // lights and clip planes in the transform affect only its shape.
+  X3DGroupingNode *group = t;
+  if( !group->render_states.empty() ) return NULL;
+
+  const NodeVector &tc = t->children->getValue();
+  if( tc.size() != 1 || !tc[0] || typeid( *tc[0] ) != typeid( Shape ) ) {
+    return NULL;
+  }
+
+  // negative scaling changes the front face and zero scaling is
+  // not rendered at all, so they are left to MatrixTransform::render.
+  const Matrix4f &m = t->matrix->getValue();
+  Matrix3f m3 = m.getScaleRotationPart();
+  if( ( ( m3.getRow( 0 ) % m3.getRow( 1 ) ) * m3.getRow(2) ) <= 
+      Constants::f_epsilon ) return NULL;
+
+  matrix = &m;
+  return dynamic_cast< X3DShapeNode * >( tc[0] );
+}
+
+void X3DGroupingNode::updateRenderBatches( TraverseInfo &ti ) {
+  bool had_instance_batches = !instance_batches.empty();
+  bool had_sort_shapes = sort_shapes;
+  instance_batches.clear();
+  instanced_children.clear();
+  sort_shapes = false;
+
+  GraphicsOptions *options = NULL;
+  GlobalSettings *default_settings = GlobalSettings::getActive();
+  if( default_settings ) {
+    default_settings->getOptionNode( options );
+  }
+
+  if( !options || !ti.graphicsEnabled() ) {
+    if( had_instance_batches || had_sort_shapes ) displayList->breakCache();
+    return;
+  }
+
+  const NodeVector &c = children->getValue();
+  sort_shapes = options->sortShapes->getValue() && c.size() > 1;
+  bool use_instancing = options->useInstancing->getValue() && 
+    (H3DInt32)c.size() >= options->instancingThreshold->getValue();
+  bool sorted_transparent_shapes = false;
+
+  if( use_instancing || sort_shapes ) {
+    // Find the children that are simple shapes. Candidates for
+    // instancing are grouped by the geometry and appearance of the shape.
+    typedef std::map< std::pair< Node *, Node * >, 
+                      vector< unsigned int > > CandidateMap;
+    CandidateMap candidates;
+    unsigned int nr_transparent = 0;
+    for( unsigned int i = 0; i < c.size(); ++i ) {
+      const Matrix4f *matrix = NULL;
+      X3DShapeNode *shape = getSimpleShape( c[i], matrix );
+      if( !shape ) continue;
+
+      X3DGeometryNode *geom = shape->geometry->getValue();
+      X3DAppearanceNode *app = shape->appearance->getValue();
+      if( app && app->isTransparent() ) {
+        ++nr_transparent;
+        continue;
+      }
+      if( use_instancing && geom && matrix ) {
+        candidates[ std::make_pair( geom, app ) ].push_back( i );
+      }
+    }
+    sorted_transparent_shapes = sort_shapes && nr_transparent > 1;
+
+    H3DInt32 min_instances = 
+      H3DMax( options->instancingThreshold->getValue(), 2 );
+    for( CandidateMap::iterator i = candidates.begin(); 
+         i != candidates.end(); ++i ) {
+      const vector< unsigned int > &indices = (*i).second;
+      if( (H3DInt32)indices.size() < min_instances ) continue;
+
+      if( instanced_children.empty() ) {
+        instanced_children.resize( c.size(), false );
+      }
+      instance_batches.push_back( InstanceBatch() );
+      InstanceBatch &batch = instance_batches.back();
+      batch.matrices.reserve( indices.size() * 16 );
+      for( unsigned int j = 0; j < indices.size(); ++j ) {
+        const Matrix4f *matrix = NULL;
+        X3DShapeNode *shape = getSimpleShape( c[indices[j]], matrix );
+        if( j == 0 ) batch.shape.reset( shape );
+        const Matrix4f &m = *matrix;
+        GLfloat mv[] = { 
+          m[0][0], m[1][0], m[2][0], 0,
+          m[0][1], m[1][1], m[2][1], 0,
+          m[0][2], m[1][2], m[2][2], 0,
+          m[0][3], m[1][3], m[2][3], 1 };
+        batch.matrices.insert( batch.matrices.end(), mv, mv + 16 );
+        instanced_children[ indices[j] ] = true;
+      }
+    }
+  }
+
+  // The instance matrices are collected every frame and the order of
+  // transparent shapes depends on the viewpoint, so the group cannot be
+  // cached in a display list in those cases.
+  if( had_instance_batches || !instance_batches.empty() ||
+      sort_shapes != had_sort_shapes || sorted_transparent_shapes ) {
+    displayList->breakCache();
+  }
+}
+
 void X3DGroupingNode::SFBound::update() {
   value = Bound::SFBoundUnion( routes_in.begin(),
                                routes_in.end() );
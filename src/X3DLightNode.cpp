@@ -29,6 +29,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include <H3D/X3DLightNode.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -118,8 +119,8 @@ void X3DLightNode::enableGraphicsState() {
 
     if( light_index < (GLuint)max_lights ) {
       GLLightInfo gl_light = getGLLightInfo();
-      glPushAttrib( GL_LIGHTING_BIT );
-      glEnable( GL_LIGHT0 +light_index );
+      GLStateTracker::pushAttrib( GL_LIGHTING_BIT );
+      GLStateTracker::enable( GL_LIGHT0 +light_index );
       
       GLfloat col_d[4], col_a[4], col_s[4];
       fillGLArray( gl_light.diffuse, col_d );
@@ -165,7 +166,7 @@ void X3DLightNode::disableGraphicsState() {
   --graphics_state_counter;
   if( had_light_index.back() ) {
     if( global_light_index + 1 <= max_lights ) {
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
     --global_light_index;
   }
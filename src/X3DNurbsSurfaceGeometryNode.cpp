@@ -30,6 +30,7 @@
 
 #include <H3D/X3DNurbsSurfaceGeometryNode.h>
 #include <H3D/Coordinate.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -360,7 +361,7 @@ void X3DNurbsSurfaceGeometryNode::render( ) {
       texKnotV[3] = (GLfloat)v_knots[ vSizeToUse - 1 ];
     }
 
-    glEnable( GL_AUTO_NORMAL );
+    GLStateTracker::enable( GL_AUTO_NORMAL );
 
     gluNurbsProperty( nurbs_object, GLU_DISPLAY_MODE, GLU_FILL );
     gluBeginSurface( nurbs_object );
@@ -382,7 +383,7 @@ void X3DNurbsSurfaceGeometryNode::render( ) {
                           map2Vertex3Or4 );
 
     gluEndSurface( nurbs_object );
-    glDisable( GL_AUTO_NORMAL );
+    GLStateTracker::disable( GL_AUTO_NORMAL );
     delete [] u_knots;
     delete [] v_knots;
     delete [] withWeights;
@@ -36,6 +36,7 @@
 #include <H3D/X3DAppearanceNode.h>
 #include <H3D/X3DMaterialNode.h>
 #include <H3D/Appearance.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -89,11 +90,11 @@ void X3DParticleEmitterNode::Particle::render( ParticleSystem *ps ) {
   const vector< H3DFloat > tex_coord_key = ps->texCoordKey->getValue();
   if( isDead() ) return;
   
-  glPushAttrib( GL_COLOR_BUFFER_BIT | GL_ENABLE_BIT );
+  GLStateTracker::pushAttrib( GL_COLOR_BUFFER_BIT | GL_ENABLE_BIT );
 
-  glEnable( GL_BLEND ); 
+  GLStateTracker::enable( GL_BLEND ); 
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA ) ;
-  glEnable( GL_ALPHA_TEST );
+  GLStateTracker::enable( GL_ALPHA_TEST );
   glAlphaFunc( GL_NOTEQUAL, 0 );
   //glDisable( GL_DEPTH_TEST );
   RGBA color(1,1,1,1);
@@ -150,7 +151,7 @@ void X3DParticleEmitterNode::Particle::render( ParticleSystem *ps ) {
     // Save the old state of GL_LIGHTING 
     GLboolean lighting_enabled;
     glGetBooleanv( GL_LIGHTING, &lighting_enabled );
-    glDisable( GL_LIGHTING );
+    GLStateTracker::disable( GL_LIGHTING );
 
     // disable texturing
     X3DTextureNode *texture = X3DTextureNode::getActiveTexture();
@@ -161,30 +162,30 @@ void X3DParticleEmitterNode::Particle::render( ParticleSystem *ps ) {
     if( material ) {  
       material->render(); 
     } else if( have_color_value ) {
-      glEnable( GL_COLOR_MATERIAL );
+      GLStateTracker::enable( GL_COLOR_MATERIAL );
     }
     
-    glEnable( GL_BLEND );
+    GLStateTracker::enable( GL_BLEND );
     glBegin( GL_POINTS );
     glVertex3f( position.x, position.y, position.z );
     glEnd();
-    if( lighting_enabled ) glEnable( GL_LIGHTING );
+    if( lighting_enabled ) GLStateTracker::enable( GL_LIGHTING );
     if( texture ) texture->enableTexturing();
   } else if( type == LINE ) {
     
     // Save the old state of GL_LIGHTING 
     GLboolean lighting_enabled;
     glGetBooleanv( GL_LIGHTING, &lighting_enabled );
-    glDisable( GL_LIGHTING );
+    GLStateTracker::disable( GL_LIGHTING );
 
-    glEnable( GL_BLEND );
+    GLStateTracker::enable( GL_BLEND );
 
     // if material node is specified, use properties from there
     // otherwise, use colorRamp if specified
     if( material ) {  
       material->render(); 
     } else if( have_color_value ) {
-      glEnable( GL_COLOR_MATERIAL );
+      GLStateTracker::enable( GL_COLOR_MATERIAL );
     }
     
     Vec3f line_dir = velocity;
@@ -227,7 +228,7 @@ void X3DParticleEmitterNode::Particle::render( ParticleSystem *ps ) {
     }
     glVertex3f( p1.x, p1.y, p1.z );
     glEnd();
-    if( lighting_enabled ) glEnable( GL_LIGHTING );
+    if( lighting_enabled ) GLStateTracker::enable( GL_LIGHTING );
     if( texture && !specify_tex_coord ) texture->enableTexturing();
   } else if( type == QUAD || type == TRIANGLE ) {
 
@@ -255,7 +256,7 @@ void X3DParticleEmitterNode::Particle::render( ParticleSystem *ps ) {
     if( material ) {  
       material->render(); 
     } else if( have_color_value ) {
-      glEnable( GL_COLOR_MATERIAL );
+      GLStateTracker::enable( GL_COLOR_MATERIAL );
     }
     glBegin( GL_QUADS );
     if( specify_tex_coord ) renderTexCoord( tex_coord_index * 4, tex_coord_ramp );
@@ -316,7 +317,7 @@ void X3DParticleEmitterNode::Particle::render( ParticleSystem *ps ) {
     if( material ) {  
       material->render(); 
     } else if( have_color_value ) {
-      glEnable( GL_COLOR_MATERIAL );     
+      GLStateTracker::enable( GL_COLOR_MATERIAL );     
     }
     glBegin( GL_QUADS );
     renderTexCoord( Vec3f( 1, 1, 0 ) );
@@ -340,7 +341,7 @@ void X3DParticleEmitterNode::Particle::render( ParticleSystem *ps ) {
     }
   }
   //glEnable( GL_DEPTH_TEST );
-  glPopAttrib();
+  GLStateTracker::popAttrib();
 }
 
 
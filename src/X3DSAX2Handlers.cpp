@@ -56,6 +56,9 @@ using namespace std;
 using namespace H3D;
 using namespace X3D;
 
+bool X3DSAX2Handlers::lazy_field_values = false;
+unsigned int X3DSAX2Handlers::lazy_field_value_min_size = 256;
+
 
 SAX2XMLReader* X3D::getNewXMLParser() {
   SAX2XMLReader::ValSchemes    valScheme    = SAX2XMLReader::Val_Never;
@@ -137,6 +140,16 @@ namespace X3DSAX2HandlersInternals {
     { chLatin_S, chLatin_c, chLatin_e, chLatin_n, chLatin_e, chNull };
   static const XMLCh gscene[] =  
     { chLatin_s, chLatin_c, chLatin_e, chLatin_n, chLatin_e, chNull };
+
+  // Returns true if the value is a reference to an external buffer, i.e.
+  // its first token is "buffer", see X3D::X3DStringToVector.
+  bool isBufferReference( const XMLCh *value ) {
+    static const XMLCh gbuffer[] = { chLatin_b, chLatin_u, chLatin_f,
+                                     chLatin_f, chLatin_e, chLatin_r, chNull };
+    while( *value == chSpace || *value == chHTab ||
+           *value == chCR || *value == chLF ) ++value;
+    return XMLString::startsWith( value, gbuffer );
+  }
 }
 using namespace X3DSAX2HandlersInternals;
 
@@ -158,6 +171,15 @@ string X3DSAX2Handlers::getLocationString() {
   return s.str();
 }
 
+unsigned int X3DSAX2Handlers::getFieldId( const string &name ) {
+  std::map< string, unsigned int >::iterator i = field_ids.find( name );
+  if( i == field_ids.end() ) {
+    i = field_ids.insert( 
+          make_pair( name, H3DNodeDatabase::getFieldId( name ) ) ).first;
+  }
+  return (*i).second;
+}
+
 void X3DSAX2Handlers::handleProtoInterfaceFieldElement( const Attributes &attrs ) {
   if( proto_declaration.get() ) {
     XMLSize_t nr_attrs = attrs.getLength();
@@ -1525,7 +1547,7 @@ void X3DSAX2Handlers::startElement(const XMLCh* const uri,
               // node is defined by USE, so we ignore all fields that are not
               // USE, class, DEF, or containerField
             } else {
-              Field *field = new_node->getField( name );
+              Field *field = new_node->getField( getFieldId( name ) );
               if( !field ) {
                 Console(LogLevel::Warning) << "Warning: Couldn't find field named \"" << name 
                            << "\" in " << qname << " node " 
@@ -1550,6 +1572,18 @@ void X3DSAX2Handlers::startElement(const XMLCh* const uri,
                   // without throwing an error.
                   if( XMLString::equals( attr_value, gEmptyString ) )
                     continue;
+
+                  // buffer references are converted now, while the url
+                  // is resolved against the base URL of this file and
+                  // recorded as a dependency of it.
+                  if( lazy_field_values &&
+                      dynamic_cast< ParsableMField * >( pfield ) &&
+                      XMLString::stringLen( attr_value ) >=
+                      lazy_field_value_min_size &&
+                      !isBufferReference( attr_value ) ) {
+                    pfield->setValueFromStringOnUse( toString( attr_value ) );
+                    continue;
+                  }
       
                   try {
                     pfield->setValueFromString( toString( attr_value ) ); 
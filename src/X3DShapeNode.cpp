@@ -33,6 +33,8 @@
 #include <H3D/ShadowCaster.h>
 #include <H3D/ShadowTransform.h>
 #include <H3D/GlobalSettings.h>
+#include <H3D/ShapeDrawList.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -92,23 +94,93 @@ X3DShapeNode::X3DShapeNode(
 
 void X3DShapeNode::render() {
   X3DChildNode::render();
-  X3DAppearanceNode *a = appearance->getValue();
+  preRenderAppearance();
+  renderGeometry();
+  postRenderAppearance();
+};
+
+void X3DShapeNode::renderInstances( const vector< GLfloat > &matrices ) {
   X3DGeometryNode *g = geometry->getValue();
-  
+  GLsizei nr_instances = (GLsizei)( matrices.size() / 16 );
+  if( !g || nr_instances == 0 ) return;
+
+  preRenderAppearance();
+  ShapeDrawList::current_frame.nr_shapes += nr_instances;
+
+  bool rendered = false;
+  if( GLEW_ARB_shader_objects && GLEW_ARB_vertex_shader &&
+      GLEW_ARB_draw_instanced && GLEW_ARB_instanced_arrays ) {
+    GLhandleARB shader_program = glGetHandleARB( GL_PROGRAM_OBJECT_ARB );
+    GLint location = -1;
+    if( shader_program ) {
+      location = glGetAttribLocationARB( shader_program, "instanceMatrix" );
+    }
+    if( location >= 0 ) {
+      // the matrices are given from client memory so make sure no
+      // vertex buffer object is bound when setting the pointers.
+      if( GLEW_ARB_vertex_buffer_object ) {
+        glBindBufferARB( GL_ARRAY_BUFFER_ARB, 0 );
+      }
+      // a mat4 attribute uses four consecutive locations, one per column.
+      for( GLuint i = 0; i < 4; ++i ) {
+        glEnableVertexAttribArrayARB( location + i );
+        glVertexAttribPointerARB( location + i, 4, GL_FLOAT, GL_FALSE,
+                                  16 * sizeof(GLfloat), &matrices[4*i] );
+        glVertexAttribDivisorARB( location + i, 1 );
+      }
+
+      // set up face culling the same way as X3DGeometryNode::DisplayList
+      GLStateTracker::pushAttrib( GL_ENABLE_BIT | GL_POLYGON_BIT );
+      if( g->usingCulling() && g->allowingCulling() ) {
+        GLStateTracker::enable( GL_CULL_FACE );
+      } else {
+        GLStateTracker::disable( GL_CULL_FACE );
+      }
+      glCullFace( g->getCullFace() );
+      rendered = g->renderInstanced( nr_instances );
+      GLStateTracker::popAttrib();
+
+      for( GLuint i = 0; i < 4; ++i ) {
+        glVertexAttribDivisorARB( location + i, 0 );
+        glDisableVertexAttribArrayARB( location + i );
+      }
+    }
+  }
+
+  if( !rendered ) {
+    // no hardware instancing available, render each instance with the
+    // appearance still set up.
+    glMatrixMode( GL_MODELVIEW );
+    for( GLsizei i = 0; i < nr_instances; ++i ) {
+      glPushMatrix();
+      glMultMatrixf( &matrices[16*i] );
+      g->displayList->callList();
+      glPopMatrix();
+    }
+  }
+
+  postRenderAppearance();
+}
+
+void X3DShapeNode::preRenderAppearance() {
+  X3DAppearanceNode *a = appearance->getValue();
+
+  ShapeDrawList::countAppearanceChange( a );
+
   // appearance render
   if ( a ) {
-    glPushAttrib( a->getAffectedGLAttribs() );
+    GLStateTracker::pushAttrib( a->getAffectedGLAttribs() );
     a->preRender();
     a->displayList->callList();
   } else {
     if( X3DShapeNode::disable_lighting_if_no_app ) {
-      glPushAttrib( GL_LIGHTING_BIT );
+      GLStateTracker::pushAttrib( GL_LIGHTING_BIT );
       // setting emissive material to white in order for point
       // and light geometries to use white as color when no Material 
       // node.
       GLfloat material[] = { 1, 1, 1, 1 };
       glMaterialfv( GL_FRONT_AND_BACK, GL_EMISSION, material );
-      glDisable( GL_LIGHTING );
+      GLStateTracker::disable( GL_LIGHTING );
     }
   }
 
@@ -119,7 +191,7 @@ void X3DShapeNode::render() {
     const string &render_mode = settings->renderMode->getValue();
 
     if( render_mode != "DEFAULT" ) {
-      glPushAttrib( GL_POLYGON_BIT );
+      GLStateTracker::pushAttrib( GL_POLYGON_BIT );
 
       if( render_mode == "SOLID" ) {
         glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
@@ -130,9 +202,14 @@ void X3DShapeNode::render() {
       }
     }
   }
+}
+
+void X3DShapeNode::renderGeometry() {
+  X3DAppearanceNode *a = appearance->getValue();
+  X3DGeometryNode *g = geometry->getValue();
 
-  // Geometry render
   if ( g ) {
+    ++ShapeDrawList::current_frame.nr_shapes;
     if( geometry_render_mode == ALL ) {
       g->displayList->callList();
     } else if( geometry_render_mode == SOLID ) {
@@ -167,22 +244,27 @@ void X3DShapeNode::render() {
       } 
     }
   }
+}
+
+void X3DShapeNode::postRenderAppearance() {
+  X3DAppearanceNode *a = appearance->getValue();
 
   // restore polygon bit
+  GlobalSettings *settings = GlobalSettings::getActive();
   if( settings ) {
     const string &render_mode = settings->renderMode->getValue();
     if( render_mode != "DEFAULT" ) {
-      glPopAttrib();
+      GLStateTracker::popAttrib();
     }
   }
 
   if( a ) {
     a->postRender();
-    glPopAttrib();
+    GLStateTracker::popAttrib();
   } else if(  X3DShapeNode::disable_lighting_if_no_app  ) {
-    glPopAttrib();
+    GLStateTracker::popAttrib();
   }
-};
+}
 
 void X3DShapeNode::traverseSG( TraverseInfo &ti ) {
   if( prev_travinfoadr != &ti ) {
@@ -31,6 +31,9 @@
 #include <H3D/X3DTexture2DNode.h>
 #include <H3DUtil/Image.h>
 #include <H3D/GlobalSettings.h>
+#include <H3D/GLStateTracker.h>
+#include <H3D/TextureMemoryManager.h>
+#include <H3D/TextureUploadManager.h>
 
 using namespace H3D;
 
@@ -172,11 +175,11 @@ void X3DTexture2DNode::glTexImage( Image *i, GLenum _texture_target,
     }
   }
 
+  // check if any scaling is required.
+  bool needs_scaling = false;
+  unsigned int new_width  = i->width();
+  unsigned int new_height = i->height(); 
   if( scale_to_power_of_two && !GLEW_ARB_texture_non_power_of_two || max_dimension > 0 ) {
-    // check if any scaling is required and if so scale the image.
-    bool needs_scaling = false;
-    unsigned int new_width  = i->width();
-    unsigned int new_height = i->height(); 
 
     // Enforce global maximum texture dimension
     if ( max_dimension > 0 && new_width > (unsigned int)max_dimension ) {
@@ -197,7 +200,42 @@ void X3DTexture2DNode::glTexImage( Image *i, GLenum _texture_target,
       new_height = nextPowerOfTwo( new_height );
       needs_scaling = true;
     } 
-    if( needs_scaling ) {
+  }
+
+  TextureProperties *texture_properties = textureProperties->getValue();
+  bool generate_mipmaps = 
+    texture_properties && texture_properties->generateMipMaps->getValue();
+  
+  if( texture_properties ) {
+    GLStateTracker::pushAttrib( GL_PIXEL_MODE_BIT );
+    const Vec4f &scale = texture_properties->textureTransferScale->getValue();
+    glPixelTransferf( GL_RED_SCALE, scale.x );
+    glPixelTransferf( GL_BLUE_SCALE, scale.y );
+    glPixelTransferf( GL_GREEN_SCALE, scale.z );
+    glPixelTransferf( GL_ALPHA_SCALE, scale.w );
+
+    const Vec4f &bias = texture_properties->textureTransferBias->getValue();
+    glPixelTransferf( GL_RED_BIAS, bias.x );
+    glPixelTransferf( GL_BLUE_BIAS, bias.y );
+    glPixelTransferf( GL_GREEN_BIAS, bias.z );
+    glPixelTransferf( GL_ALPHA_BIAS, bias.w );
+  }
+
+  // true when the texture has been installed.
+  bool installed = false;
+
+  if( needs_scaling ) {
+    // scale the image on the graphics card if possible, otherwise on
+    // the CPU.
+    installed = TextureUploadManager::scaleImage2D( _texture_target, i,
+                                                    glInternalFormat( i ),
+                                                    glPixelFormat( i ),
+                                                    glPixelComponentType( i ),
+                                                    new_width, new_height );
+    if( installed ) {
+      if( generate_mipmaps ) 
+        TextureUploadManager::generateMipmaps( _texture_target );
+    } else {
       unsigned int bytes_per_pixel = i->bitsPerPixel();
       bytes_per_pixel = 
         bytes_per_pixel % 8 == 0 ? 
@@ -227,70 +265,95 @@ void X3DTexture2DNode::glTexImage( Image *i, GLenum _texture_target,
     }
   }
 
-  TextureProperties *texture_properties = textureProperties->getValue();
-  
-  if( texture_properties ) {
-    glPushAttrib( GL_PIXEL_MODE_BIT );
-    const Vec4f &scale = texture_properties->textureTransferScale->getValue();
-    glPixelTransferf( GL_RED_SCALE, scale.x );
-    glPixelTransferf( GL_BLUE_SCALE, scale.y );
-    glPixelTransferf( GL_GREEN_SCALE, scale.z );
-    glPixelTransferf( GL_ALPHA_SCALE, scale.w );
-
-    const Vec4f &bias = texture_properties->textureTransferBias->getValue();
-    glPixelTransferf( GL_RED_BIAS, bias.x );
-    glPixelTransferf( GL_BLUE_BIAS, bias.y );
-    glPixelTransferf( GL_GREEN_BIAS, bias.z );
-    glPixelTransferf( GL_ALPHA_BIAS, bias.w );
-  }
-
-  if( texture_properties && texture_properties->generateMipMaps->getValue() ) {
-    gluBuild2DMipmaps(  _texture_target, 
-                        glInternalFormat( i ),
-                        width,
-                        height,
-                        glPixelFormat( i ),
-                        glPixelComponentType( i ),
-                        image_data );
-  } else {
-    H3DInt32 border_width = 
-    texture_properties ? 
-    texture_properties->borderWidth->getValue() : 0;
-
-    if( border_width < 0 || border_width > 1 ) {
-      Console(LogLevel::Warning) << "Warning: Invalid borderWidth \"" << border_width 
-                 << "\". Must be 0 or 1 (in " << getName()
-                   << ")" << endl;
-      border_width = 0;
-    }
-
-    // install the image as a 2d texture
-    if( i->compressionType() == Image::NO_COMPRESSION ) {
+  // images that have not been scaled on the CPU can be uploaded in
+  // slices over several frames.
+  bool upload_in_slices = 
+    !installed && !free_image_data && 
+    TextureUploadManager::asyncUploads() &&
+    TextureUploadManager::canUpload( i, _texture_target, generate_mipmaps ) &&
+    ( !texture_properties || texture_properties->borderWidth->getValue() == 0 );
+
+  // mipmaps are generated on the graphics card if supported.
+  bool gpu_mipmaps = 
+    generate_mipmaps && i->compressionType() == Image::NO_COMPRESSION &&
+    _texture_target == GL_TEXTURE_2D && GLEW_EXT_framebuffer_object &&
+    ( GLEW_ARB_texture_non_power_of_two || 
+      ( isPowerOfTwo( width ) && isPowerOfTwo( height ) ) );
+
+  if( !installed ) {
+    if( generate_mipmaps && !gpu_mipmaps ) {
+      gluBuild2DMipmaps(  _texture_target, 
+                          glInternalFormat( i ),
+                          width,
+                          height,
+                          glPixelFormat( i ),
+                          glPixelComponentType( i ),
+                          image_data );
+    } else if( upload_in_slices ) {
+      Vec4f scale( 1, 1, 1, 1 );
+      Vec4f bias( 0, 0, 0, 0 );
+      if( texture_properties ) {
+        scale = texture_properties->textureTransferScale->getValue();
+        bias = texture_properties->textureTransferBias->getValue();
+      }
+      TextureUploadManager::upload( _texture_target, i,
+                                    glInternalFormat( i ),
+                                    glPixelFormat( i ),
+                                    glPixelComponentType( i ),
+                                    generate_mipmaps,
+                                    texture_properties != NULL,
+                                    scale, bias );
+    } else if( generate_mipmaps ) {
       glTexImage2D( _texture_target, 
-        0, // mipmap level
-        glInternalFormat( i ),
-        width,
-        height,
-        border_width, // border
-        glPixelFormat( i ),
-        glPixelComponentType( i ),
-        image_data );
+                    0, // mipmap level
+                    glInternalFormat( i ),
+                    width,
+                    height,
+                    0, // border
+                    glPixelFormat( i ),
+                    glPixelComponentType( i ),
+                    image_data );
+      TextureUploadManager::generateMipmaps( _texture_target );
     } else {
-      glCompressedTexImage2D( _texture_target,
-        0, // mipmap level
-        glInternalFormat( i ),
-        width,
-        height,
-        border_width, // border
-        width*height*i->bitsPerPixel() / 8,
-        image_data );
+      H3DInt32 border_width = 
+      texture_properties ? 
+      texture_properties->borderWidth->getValue() : 0;
+
+      if( border_width < 0 || border_width > 1 ) {
+        Console(LogLevel::Warning) << "Warning: Invalid borderWidth \"" << border_width 
+                   << "\". Must be 0 or 1 (in " << getName()
+                     << ")" << endl;
+        border_width = 0;
+      }
+
+      // install the image as a 2d texture
+      if( i->compressionType() == Image::NO_COMPRESSION ) {
+        glTexImage2D( _texture_target, 
+          0, // mipmap level
+          glInternalFormat( i ),
+          width,
+          height,
+          border_width, // border
+          glPixelFormat( i ),
+          glPixelComponentType( i ),
+          image_data );
+      } else {
+        glCompressedTexImage2D( _texture_target,
+          0, // mipmap level
+          glInternalFormat( i ),
+          width,
+          height,
+          border_width, // border
+          width*height*i->bitsPerPixel() / 8,
+          image_data );
+      }
     }
   }
 
   glPixelStorei( GL_UNPACK_ALIGNMENT, byte_alignment );
 
   // restore scale and bias pixel transfer components
-  if( texture_properties ) glPopAttrib();
+  if( texture_properties ) GLStateTracker::popAttrib();
 
   // free the temporary image data if necessary.
   if( free_image_data ) 
@@ -307,27 +370,48 @@ void X3DTexture2DNode::render()     {
     if( !image->imageChanged() || texture_id == 0|| texture_target_changed) {
       // the image has changed so remove the old texture and install 
       // the new
-      glDeleteTextures( 1, &texture_id );
+      TextureUploadManager::cancel( texture_id );
+      GLStateTracker::deleteTextures( 1, &texture_id );
       texture_id = 0;
       if( i ) {
         texture_id = renderImage( i, 
                                   texture_target, 
                                   scaleToPowerOfTwo->getValue() );
-       
+        TextureProperties *texture_properties = textureProperties->getValue();
+        TextureMemoryManager::textureInstalled( 
+          this, 
+          TextureMemoryManager::estimateByteSize( 
+            i, 
+            texture_properties && 
+            texture_properties->generateMipMaps->getValue() ) );
+        if( reloadable_image.get() != i ) setReloadableImage( NULL );
+        release_image_checked = false;
+      } else {
+        TextureMemoryManager::textureRemoved( this );
       }
     } else {
-      glBindTexture(  texture_target, texture_id );
+      GLStateTracker::bindTexture(  texture_target, texture_id );
       renderSubImage( i, texture_target, 
                       image->xOffset(), image->yOffset(),
                       image->changedWidth(), 
                       image->changedHeight() );
     }
-    enableTexturing();
+    if( TextureUploadManager::isPending( texture_id ) ) {
+      // the image is still being uploaded so the texture is not used
+      // yet. The display list is rendered again next frame to check.
+      displayList->breakCache();
+    } else {
+      enableTexturing();
+    }
   } else {
     if ( texture_id ) {
       // same texture as last loop, so we just bind it.
-      glBindTexture(  texture_target, texture_id );
-      enableTexturing();
+      GLStateTracker::bindTexture(  texture_target, texture_id );
+      if( TextureUploadManager::isPending( texture_id ) ) {
+        displayList->breakCache();
+      } else {
+        enableTexturing();
+      }
     }     
   }
 
@@ -335,6 +419,82 @@ void X3DTexture2DNode::render()     {
     renderTextureProperties();
   }
   imageUpdated->upToDate();
+  if( i && texture_id && !release_image_checked &&
+      !TextureUploadManager::isPending( texture_id ) ) {
+    releaseImageData();
+  }
+  TextureMemoryManager::textureUsed( this );
+}
+
+void X3DTexture2DNode::releaseImageData() {
+  release_image_checked = true;
+  if( !releaseImageAfterUpload( textureProperties->getValue() ) ) return;
+
+  Image *i = image->getValue();
+  if( reloadable_image.get() != i ) {
+    if( !ReloadableImage::canWrap( i ) ) return;
+    ReloadableImage *reloadable = newReloadableImage( i );
+    if( !reloadable ) return;
+    setReloadableImage( reloadable );
+    image->setValue( reloadable );
+    // the image has the same data so the texture is not installed again.
+    imageUpdated->upToDate();
+  }
+  reloadable_image->releaseData();
+}
+
+ReloadableImage *X3DTexture2DNode::newReloadableImage( Image *_image ) {
+  if( !textureHoldsImage( _image, textureProperties->getValue() ) ) {
+    return NULL;
+  }
+  return new ReloadableImage( _image, &readTextureImage, this, true );
+}
+
+Image *X3DTexture2DNode::readTextureImage( Image *_image, void *data ) {
+  X3DTexture2DNode *texture = static_cast< X3DTexture2DNode * >( data );
+  if( !texture->texture_id ) return NULL;
+
+  unsigned char *pixels = 
+    new unsigned char[ (size_t)_image->width() * _image->height() *
+                       _image->bitsPerPixel() / 8 ];
+
+  GLint bound_texture = 0;
+  glGetIntegerv( texture->texture_target == GL_TEXTURE_RECTANGLE_ARB ?
+                 GL_TEXTURE_BINDING_RECTANGLE_ARB : GL_TEXTURE_BINDING_2D,
+                 &bound_texture );
+  GLint pack_alignment;
+  glGetIntegerv( GL_PACK_ALIGNMENT, &pack_alignment );
+  glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+  GLStateTracker::bindTexture( texture->texture_target, texture->texture_id );
+  glGetTexImage( texture->texture_target, 0, 
+                 texture->glPixelFormat( _image ),
+                 texture->glPixelComponentType( _image ),
+                 pixels );
+  GLStateTracker::bindTexture( texture->texture_target, bound_texture );
+  glPixelStorei( GL_PACK_ALIGNMENT, pack_alignment );
+
+  return new PixelImage( _image->width(), _image->height(), 1,
+                         _image->bitsPerPixel(), _image->pixelType(),
+                         _image->pixelComponentType(),
+                         pixels, false, _image->pixelSize() );
+}
+
+bool X3DTexture2DNode::evictTexture() {
+  // the properties of bindless textures can not be set again.
+  if( !texture_id || getTextureHandle() != 0 ) return false;
+  // released image data can not be read back once the texture is deleted.
+  if( reloadable_image.get() && reloadable_image->isMainThreadOnly() &&
+      !reloadable_image->loadData() ) {
+    return false;
+  }
+  TextureUploadManager::cancel( texture_id );
+  GLStateTracker::deleteTextures( 1, &texture_id );
+  texture_id = 0;
+  // install the texture again the next time it is rendered, which the
+  // display lists must be rebuilt for.
+  imageUpdated->touch();
+  displayList->touch();
+  return true;
 }
 
 void X3DTexture2DNode::renderTextureProperties() {
@@ -380,7 +540,7 @@ void X3DTexture2DNode::renderSubImage( Image *_image, GLenum _texture_target,
 
   TextureProperties *texture_properties = textureProperties->getValue();
   if( texture_properties ) {
-    glPushAttrib( GL_PIXEL_MODE_BIT );
+    GLStateTracker::pushAttrib( GL_PIXEL_MODE_BIT );
     const Vec4f &scale = texture_properties->textureTransferScale->getValue();
     glPixelTransferf( GL_RED_SCALE, scale.x );
     glPixelTransferf( GL_BLUE_SCALE, scale.y );
@@ -401,14 +561,14 @@ void X3DTexture2DNode::renderSubImage( Image *_image, GLenum _texture_target,
                    glPixelComponentType( _image ), 
                    modified_data );
 
-  if( texture_properties ) glPopAttrib();
+  if( texture_properties ) GLStateTracker::popAttrib();
 
   delete [] modified_data;
 }
 
 
 void X3DTexture2DNode::enableTexturing() {
-  glEnable( texture_target );
+  GLStateTracker::enable( texture_target );
   Image * i = static_cast< Image * >(image->getValue());
   if( i ) {
     // need to always update blending state no matter if image are updated or not
@@ -418,21 +578,21 @@ void X3DTexture2DNode::enableTexturing() {
     if( pixel_type == Image::LUMINANCE_ALPHA ||
       pixel_type == Image::RGBA || 
       pixel_type == Image::BGRA ) {
-        glEnable( GL_BLEND );
+        GLStateTracker::enable( GL_BLEND );
         glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
     }
   }
 }
 
 void X3DTexture2DNode::disableTexturing() {
-  glDisable( texture_target );
+  GLStateTracker::disable( texture_target );
   Image * i = static_cast< Image * >(image->getValue());
   if( i ) {
     Image::PixelType pixel_type = i->pixelType();
     if( pixel_type == Image::LUMINANCE_ALPHA ||
       pixel_type == Image::RGBA || 
       pixel_type == Image::BGRA ) {
-        glDisable( GL_BLEND );
+        GLStateTracker::disable( GL_BLEND );
     }
   }
 }
@@ -494,9 +654,9 @@ Image* X3DTexture2DNode::renderToImage( H3DInt32 _width, H3DInt32 _height, bool
     }
     GLint active_texture_bind = 0;
     glGetIntegerv( GL_TEXTURE_BINDING_2D, &active_texture_bind );
-    glBindTexture( texture_target, t_id );
+    GLStateTracker::bindTexture( texture_target, t_id );
     glGetTexImage( texture_target, 0, glPixelFormat( _image ), glPixelComponentType(_image), _image->getImageData() );
-    glBindTexture( texture_target, active_texture_bind );
+    GLStateTracker::bindTexture( texture_target, active_texture_bind );
     return _image;
   }
 
@@ -31,6 +31,8 @@
 #include <H3D/X3DTexture3DNode.h>
 #include <H3DUtil/Image.h>
 #include <H3D/GlobalSettings.h>
+#include <H3D/GLStateTracker.h>
+#include <H3D/TextureMemoryManager.h>
 
 using namespace H3D;
 
@@ -224,7 +226,7 @@ void X3DTexture3DNode::glTexImage( Image *i, GLenum _texture_target,
   glPixelStorei( GL_UNPACK_ALIGNMENT, i->byteAlignment() );
 
   if( texture_properties ) {
-    glPushAttrib( GL_PIXEL_MODE_BIT );
+    GLStateTracker::pushAttrib( GL_PIXEL_MODE_BIT );
     const Vec4f &scale = texture_properties->textureTransferScale->getValue();
     glPixelTransferf( GL_RED_SCALE, scale.x );
     glPixelTransferf( GL_BLUE_SCALE, scale.y );
@@ -277,7 +279,7 @@ void X3DTexture3DNode::glTexImage( Image *i, GLenum _texture_target,
   glPixelStorei( GL_UNPACK_ALIGNMENT, byte_alignment );
 
   // restore scale and bias pixel transfer components
-  if( texture_properties ) glPopAttrib();
+  if( texture_properties ) GLStateTracker::popAttrib();
 
   if( free_image_data ) 
     free( image_data );
@@ -293,15 +295,26 @@ void X3DTexture3DNode::render()     {
     if( !image->imageChanged() || texture_id == 0|| texture_target_changed) {
       // the image has changed so remove the old texture and install 
       // the new
-      glDeleteTextures( 1, &texture_id );
+      GLStateTracker::deleteTextures( 1, &texture_id );
       texture_id = 0;
       if( i ) {
         texture_id = renderImage( i, 
                                   texture_target, 
                                   scaleToPowerOfTwo->getValue() );
+        TextureProperties *texture_properties = textureProperties->getValue();
+        TextureMemoryManager::textureInstalled( 
+          this, 
+          TextureMemoryManager::estimateByteSize( 
+            i, 
+            texture_properties && 
+            texture_properties->generateMipMaps->getValue() ) );
+        if( reloadable_image.get() != i ) setReloadableImage( NULL );
+        release_image_checked = false;
+      } else {
+        TextureMemoryManager::textureRemoved( this );
       } 
     } else {
-      glBindTexture(  texture_target, texture_id );
+      GLStateTracker::bindTexture(  texture_target, texture_id );
       renderSubImage( i, texture_target, 
                       image->xOffset(), 
                       image->yOffset(),
@@ -314,7 +327,7 @@ void X3DTexture3DNode::render()     {
   } else {
     if ( texture_id ) {
       // same texture as last loop, so we just bind it.
-      glBindTexture( texture_target, texture_id );
+      GLStateTracker::bindTexture( texture_target, texture_id );
       enableTexturing();
     }     
   }
@@ -323,6 +336,80 @@ void X3DTexture3DNode::render()     {
     renderTextureProperties();
   }
   imageUpdated->upToDate();
+  if( i && texture_id && !release_image_checked ) {
+    releaseImageData();
+  }
+  TextureMemoryManager::textureUsed( this );
+}
+
+void X3DTexture3DNode::releaseImageData() {
+  release_image_checked = true;
+  if( !releaseImageAfterUpload( textureProperties->getValue() ) ) return;
+
+  Image *i = image->getValue();
+  if( reloadable_image.get() != i ) {
+    if( !ReloadableImage::canWrap( i ) ) return;
+    ReloadableImage *reloadable = newReloadableImage( i );
+    if( !reloadable ) return;
+    setReloadableImage( reloadable );
+    image->setValue( reloadable );
+    // the image has the same data so the texture is not installed again.
+    imageUpdated->upToDate();
+  }
+  reloadable_image->releaseData();
+}
+
+ReloadableImage *X3DTexture3DNode::newReloadableImage( Image *_image ) {
+  if( !textureHoldsImage( _image, textureProperties->getValue() ) ) {
+    return NULL;
+  }
+  return new ReloadableImage( _image, &readTextureImage, this, true );
+}
+
+Image *X3DTexture3DNode::readTextureImage( Image *_image, void *data ) {
+  X3DTexture3DNode *texture = static_cast< X3DTexture3DNode * >( data );
+  if( !texture->texture_id ) return NULL;
+
+  unsigned char *pixels = 
+    new unsigned char[ (size_t)_image->width() * _image->height() *
+                       _image->depth() * _image->bitsPerPixel() / 8 ];
+
+  GLint bound_texture = 0;
+  glGetIntegerv( texture->texture_target == GL_TEXTURE_2D_ARRAY_EXT ?
+                 GL_TEXTURE_BINDING_2D_ARRAY_EXT : GL_TEXTURE_BINDING_3D,
+                 &bound_texture );
+  GLint pack_alignment;
+  glGetIntegerv( GL_PACK_ALIGNMENT, &pack_alignment );
+  glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+  GLStateTracker::bindTexture( texture->texture_target, texture->texture_id );
+  glGetTexImage( texture->texture_target, 0, 
+                 texture->glPixelFormat( _image ),
+                 texture->glPixelComponentType( _image ),
+                 pixels );
+  GLStateTracker::bindTexture( texture->texture_target, bound_texture );
+  glPixelStorei( GL_PACK_ALIGNMENT, pack_alignment );
+
+  return new PixelImage( _image->width(), _image->height(), _image->depth(),
+                         _image->bitsPerPixel(), _image->pixelType(),
+                         _image->pixelComponentType(),
+                         pixels, false, _image->pixelSize() );
+}
+
+bool X3DTexture3DNode::evictTexture() {
+  // the properties of bindless textures can not be set again.
+  if( !texture_id || getTextureHandle() != 0 ) return false;
+  // released image data can not be read back once the texture is deleted.
+  if( reloadable_image.get() && reloadable_image->isMainThreadOnly() &&
+      !reloadable_image->loadData() ) {
+    return false;
+  }
+  GLStateTracker::deleteTextures( 1, &texture_id );
+  texture_id = 0;
+  // install the texture again the next time it is rendered, which the
+  // display lists must be rebuilt for.
+  imageUpdated->touch();
+  displayList->touch();
+  return true;
 }
 
 void X3DTexture3DNode::renderTextureProperties() {
@@ -377,7 +464,7 @@ void X3DTexture3DNode::renderSubImage( Image *_image,
 
   TextureProperties *texture_properties = textureProperties->getValue();
   if( texture_properties ) {
-    glPushAttrib( GL_PIXEL_MODE_BIT );
+    GLStateTracker::pushAttrib( GL_PIXEL_MODE_BIT );
     const Vec4f &scale = texture_properties->textureTransferScale->getValue();
     glPixelTransferf( GL_RED_SCALE, scale.x );
     glPixelTransferf( GL_BLUE_SCALE, scale.y );
@@ -398,7 +485,7 @@ void X3DTexture3DNode::renderSubImage( Image *_image,
                    glPixelComponentType( _image ), 
                    modified_data );
 
-  if( texture_properties ) glPopAttrib();
+  if( texture_properties ) GLStateTracker::popAttrib();
 
   delete [] modified_data;
 }
@@ -406,14 +493,14 @@ void X3DTexture3DNode::renderSubImage( Image *_image,
 void X3DTexture3DNode::enableTexturing() {
  // texture 2d arrays cannot be enabled, only be used with shaders.
   if( texture_target != GL_TEXTURE_2D_ARRAY_EXT&&texture_target!=GL_TEXTURE_2D_MULTISAMPLE_ARRAY ) 
-    glEnable( texture_target );
+    GLStateTracker::enable( texture_target );
   Image * i = static_cast< Image * >(image->getValue());
   if( i ) {
     Image::PixelType pixel_type = i->pixelType();
     if( pixel_type == Image::LUMINANCE_ALPHA ||
       pixel_type == Image::RGBA ||
       pixel_type == Image::BGRA ) {
-        glEnable( GL_BLEND );
+        GLStateTracker::enable( GL_BLEND );
         glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     }
   }
@@ -425,14 +512,14 @@ void X3DTexture3DNode::enableTexturing() {
 void X3DTexture3DNode::disableTexturing() {
  // texture 2d arrays cannot be enabled, only be used with shaders.
   if( texture_target != GL_TEXTURE_2D_ARRAY_EXT ) 
-    glDisable( texture_target );
+    GLStateTracker::disable( texture_target );
   Image * i = static_cast< Image * >(image->getValue());
   if( i ) {
     Image::PixelType pixel_type = i->pixelType();
     if( pixel_type == Image::LUMINANCE_ALPHA ||
       pixel_type == Image::RGBA ||
       pixel_type == Image::BGRA ) {
-        glDisable( GL_BLEND );
+        GLStateTracker::disable( GL_BLEND );
     }
   }
 }
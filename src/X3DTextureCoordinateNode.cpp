@@ -31,6 +31,7 @@
 #include <H3D/X3DTextureCoordinateNode.h>
 #include <H3D/MultiTexture.h>
 #include <H3D/X3DTextureNode.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -131,17 +132,17 @@ void X3DTextureCoordinateNode::renderForActiveTexture( int index ) {
 void X3DTextureCoordinateNode::startTexGenForTextureUnit( unsigned int texture_unit  ) {
   GLint saved_texture;
   glGetIntegerv( GL_ACTIVE_TEXTURE_ARB, &saved_texture );
-  glActiveTexture( GL_TEXTURE0_ARB + texture_unit );
+  GLStateTracker::activeTexture( GL_TEXTURE0_ARB + texture_unit );
   this->startTexGen();
-  glActiveTexture( saved_texture );
+  GLStateTracker::activeTexture( saved_texture );
 }
 
 void X3DTextureCoordinateNode::stopTexGenForTextureUnit( unsigned int texture_unit  ) {
   GLint saved_texture;
   glGetIntegerv( GL_ACTIVE_TEXTURE_ARB, &saved_texture );
-  glActiveTexture( GL_TEXTURE0_ARB + texture_unit );
+  GLStateTracker::activeTexture( GL_TEXTURE0_ARB + texture_unit );
   stopTexGen();
-  glActiveTexture( saved_texture );
+  GLStateTracker::activeTexture( saved_texture );
 }
 
 
@@ -32,6 +32,7 @@
 #include <H3D/X3D.h>
 #include <H3D/FrameBufferTextureGenerator.h>
 #include <H3D/Appearance.h>
+#include <H3D/GLStateTracker.h>
 #include <assert.h>
 
 #include <H3DUtil/LoadImageFunctions.h>
@@ -475,7 +476,7 @@ GLuint X3DTextureNode::renderImage( Image *image,
   if( image ) {
     GLuint texture_id;
     glGenTextures( 1, &texture_id );
-    glBindTexture( texture_target, texture_id );
+    GLStateTracker::bindTexture( texture_target, texture_id );
 
     while( glGetError() != GL_NO_ERROR )
       ;
@@ -30,6 +30,7 @@
 
 #include <H3D/X3DTextureTransformNode.h>
 #include <H3D/MultiTexture.h>
+#include <H3D/GLStateTracker.h>
 
 using namespace H3D;
 
@@ -57,11 +58,11 @@ void X3DTextureTransformNode::preRender() {
     GLint saved_mode;
     glGetIntegerv( GL_MATRIX_MODE, &saved_mode );
     for( size_t i = 0; i < texture_units; ++i ) {
-      glActiveTexture( GL_TEXTURE0_ARB + (unsigned int) i );
+      GLStateTracker::activeTexture( GL_TEXTURE0_ARB + (unsigned int) i );
       glMatrixMode( GL_TEXTURE );
       glPushMatrix();
     }
-    glActiveTexture( saved_texture );
+    GLStateTracker::activeTexture( saved_texture );
     glMatrixMode( saved_mode );
   } else {
     GLint saved_mode;
@@ -87,11 +88,11 @@ void X3DTextureTransformNode::postRender() {
     GLint saved_mode;
     glGetIntegerv( GL_MATRIX_MODE, &saved_mode );
     for( size_t i = 0; i < texture_units; ++i ) {
-      glActiveTexture( GL_TEXTURE0_ARB + (unsigned int) i );
+      GLStateTracker::activeTexture( GL_TEXTURE0_ARB + (unsigned int) i );
       glMatrixMode( GL_TEXTURE );
       glPopMatrix();
     }
-    glActiveTexture( saved_texture );
+    GLStateTracker::activeTexture( saved_texture );
     glMatrixMode( saved_mode );
   } else {
     GLint saved_mode;
@@ -106,9 +107,9 @@ void X3DTextureTransformNode::renderForTextureUnit(
   unsigned int texture_unit ) {
   GLint saved_texture;
   glGetIntegerv( GL_ACTIVE_TEXTURE_ARB, &saved_texture );
-  glActiveTexture( GL_TEXTURE0_ARB + (unsigned int) texture_unit );
+  GLStateTracker::activeTexture( GL_TEXTURE0_ARB + (unsigned int) texture_unit );
   render();
-  glActiveTexture( saved_texture );
+  GLStateTracker::activeTexture( saved_texture );
 }
 
 void X3DTextureTransformNode::renderForTextureUnits( unsigned int start_unit,
@@ -120,5 +121,5 @@ void X3DTextureTransformNode::renderForTextureUnits( unsigned int start_unit,
     renderForTextureUnit( i );
   }
   
-  glActiveTexture( saved_texture );
+  GLStateTracker::activeTexture( saved_texture );
 }
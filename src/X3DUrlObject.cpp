@@ -52,6 +52,17 @@ string X3DUrlObject::resolveURLAsString( const string &_url ) {
   return resolveURL ( _url, true );
 }
 
+string X3DUrlObject::resolveURLAsLocalFile( const string &_url ) {
+  for( list< string >::const_iterator i = supported_inline_prefixes.begin();
+       i != supported_inline_prefixes.end(); ++i ) {
+    size_t start = 0;
+    while( start < _url.size() && isspace(_url[start]) ) ++start;
+    if( _url.compare( start, (*i).size(), *i ) == 0 ) return "";
+  }
+
+  return resolveURLAsLocalFileFromBase( url_base, _url );
+}
+
 string X3DUrlObject::resolveURL ( const string& _url, bool return_contents, bool *is_tmp_file ) {
   for( list< string >::const_iterator i = supported_inline_prefixes.begin();
        i != supported_inline_prefixes.end(); ++i ) {
@@ -75,8 +86,15 @@ string X3DUrlObject::resolveURL ( const string& _url, bool return_contents, bool
     }
   }
 
+  return resolveURLFromBase( url_base, _url, return_contents, is_tmp_file );
+}
+
+string X3DUrlObject::resolveURLFromBase( const string &_url_base,
+                                         const string &_url,
+                                         bool return_contents,
+                                         bool *is_tmp_file ) {
   string old_base = ResourceResolver::getBaseURL();
-  ResourceResolver::setBaseURL( url_base );
+  ResourceResolver::setBaseURL( _url_base );
   string result;
   if ( return_contents ) {
     result= ResourceResolver::resolveURLAsString ( _url );
@@ -87,6 +105,15 @@ string X3DUrlObject::resolveURL ( const string& _url, bool return_contents, bool
   return result;
 }
 
+string X3DUrlObject::resolveURLAsLocalFileFromBase( const string &_url_base,
+                                                    const string &_url ) {
+  string old_base = ResourceResolver::getBaseURL();
+  ResourceResolver::setBaseURL( _url_base );
+  string result = ResourceResolver::resolveURLAsLocalFile( _url );
+  ResourceResolver::setBaseURL( old_base );
+  return result;
+}
+
 void X3DUrlObject::addInlinePrefix( const string &s ) {
   supported_inline_prefixes.push_back( s + ":" );
 }
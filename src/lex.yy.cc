@@ -4420,7 +4420,7 @@ case 27:
 /* rule 27 can match eol */
 YY_RULE_SETUP
 #line 89 "vrml.l"
-driver.addLine( yytext ); *yylval=std::string(yytext); return yy::VrmlParser::token::STRING;
+driver.addLine( yytext ); yylval->assign( yytext, yyleng ); return yy::VrmlParser::token::STRING;
 	YY_BREAK
 case 28:
 /* rule 28 can match eol */
@@ -904,7 +904,7 @@ if ( !driver.insideProtoDeclaration() ) {
 #line 471 "vrml.bison"
     { 
 if ( !driver.insideProtoDeclaration() )
-  driver.setFieldValue( ((yysemantic_stack_[(1) - (1)])).c_str() );
+  driver.setFieldValue( (yysemantic_stack_[(1) - (1)]) );
 }
     break;
 
@@ -914,7 +914,7 @@ if ( !driver.insideProtoDeclaration() )
 #line 475 "vrml.bison"
     { 
 if ( !driver.insideProtoDeclaration() )
-  driver.setFieldValue( ((yysemantic_stack_[(1) - (1)])).c_str() );
+  driver.setFieldValue( (yysemantic_stack_[(1) - (1)]) );
                         }
     break;
 